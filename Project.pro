@@ -18,6 +18,19 @@ QMAKE_CXXFLAGS += -std=c++1y
 QMAKE_CXXFLAGS += -Wall
 QMAKE_CXXFLAGS += -Wextra
 
+# SSE code paths are guarded by __SSE__ and have scalar fallbacks
+contains(QT_ARCH, x86_64)|contains(QT_ARCH, i386) {
+    QMAKE_CXXFLAGS += -msse2
+}
+
+# headless build (no window, no rendering, no audio listener), used for dedicated
+# servers and simulation soak tests: qmake CONFIG+=headless
+# without simulationTickRate in settings, world logic runs as fast as possible
+headless {
+    TARGET   = ProjectHeadless
+    DEFINES += ENGINE_HEADLESS
+}
+
 LIBSPATH = D:/Libraries/
 
 QMAKE_CXXFLAGS += -isystem $${LIBSPATH}irrlicht-1.8.1
@@ -63,12 +76,14 @@ SOURCES += main.cpp \
     engine/App3D.cpp \
     engine/util/DataFile.cpp \
     engine/util/Trace.cpp \
+    engine/util/Metrics.cpp \
     engine/util/Exception.cpp \
     engine/util/Time.cpp \
     engine/util/Color.cpp \
     engine/util/AppTime.cpp \
     engine/util/QuadTree.cpp \
     engine/util/RectPacker.cpp \
+    engine/util/MaxRectsPacker.cpp \
     engine/GUI/GUIManager.cpp \
     engine/app3D/detail/GUIRenderer.cpp \
     engine/app3D/ext/CGUITTFont.cpp \
@@ -105,6 +120,7 @@ SOURCES += main.cpp \
     app/world/World.cpp \
     engine/util/Def.cpp \
     engine/util/DefDatabase.cpp \
+    engine/util/ThreadPool.cpp \
     engine/app3D/defs/ResourceDef.cpp \
     engine/app3D/defs/ModelDef.cpp \
     engine/app3D/defs/TerrainDef.cpp \
@@ -198,6 +214,7 @@ SOURCES += main.cpp \
     app/GUI/widgetPacks/SkillsAndUpgradesWindow.cpp \
     app/GUI/immediate/Tooltip.cpp \
     app/GUI/immediate/LevelUpAnimation.cpp \
+    app/GUI/immediate/MetricsOverlay.cpp \
     app/defs/parts/TurretInfo.cpp \
     app/entities/components/TurretComponent.cpp \
     engine/app3D/managers/ParticlesManager.cpp \
@@ -235,7 +252,9 @@ SOURCES += main.cpp \
     engine/app3D/physics/Armature.cpp \
     engine/app3D/IslandGenerator.cpp \
     engine/app3D/irrNodes/VerticesAndIndicesNode.cpp \
-    engine/app3D/sceneNodes/Island.cpp
+    engine/app3D/sceneNodes/Island.cpp \
+    app/world/EntitySpatialGrid.cpp \
+    app/world/WorldNavigationGraph.cpp
 
 HEADERS += \
     engine/util/Random.hpp \
@@ -250,6 +269,7 @@ HEADERS += \
     engine/App3D.hpp \
     engine/util/DataFile.hpp \
     engine/util/Trace.hpp \
+    engine/util/Metrics.hpp \
     engine/util/Exception.hpp \
     engine/util/Range.hpp \
     engine/util/Rect.hpp \
@@ -264,6 +284,7 @@ HEADERS += \
     engine/app3D/ext/irrUString.hpp \
     engine/app3D/ext/CGUITTFont.h \
     engine/util/RectPacker.hpp \
+    engine/util/MaxRectsPacker.hpp \
     engine/GUI/IGUIRenderer.hpp \
     engine/GUI/GUIManager.hpp \
     engine/app3D/detail/GUIRenderer.hpp \
@@ -304,6 +325,7 @@ HEADERS += \
     app/Global.hpp \
     app/world/World.hpp \
     engine/util/DefDatabase.hpp \
+    engine/util/ThreadPool.hpp \
     engine/util/Def.hpp \
     engine/ext/optional.hpp \
     engine/app3D/defs/ResourceDef.hpp \
@@ -402,6 +424,7 @@ HEADERS += \
     app/GUI/widgetPacks/SkillsAndUpgradesWindow.hpp \
     app/GUI/immediate/Tooltip.hpp \
     app/GUI/immediate/LevelUpAnimation.hpp \
+    app/GUI/immediate/MetricsOverlay.hpp \
     app/defs/parts/TurretInfo.hpp \
     app/entities/components/TurretComponent.hpp \
     engine/app3D/managers/ParticlesManager.hpp \
@@ -439,7 +462,29 @@ HEADERS += \
     engine/app3D/physics/Armature.hpp \
     engine/app3D/IslandGenerator.hpp \
     engine/app3D/irrNodes/VerticesAndIndicesNode.hpp \
-    engine/app3D/sceneNodes/Island.hpp
+    engine/app3D/sceneNodes/Island.hpp \
+    app/world/EntitySpatialGrid.hpp \
+    app/world/EntitiesByType.hpp \
+    app/world/WorldNavigationGraph.hpp \
+    app/entities/EntityType.hpp
 
 OTHER_FILES += \
     engine/app3D/ext/CGUITTFont.cpp.txt
+
+# benchmarks of engine and app hot paths, instead of the game: qmake CONFIG+=benchmark
+benchmark {
+    TARGET = ProjectBenchmark
+
+    SOURCES -= main.cpp
+    SOURCES += benchmarks/main.cpp \
+        benchmarks/Benchmark.cpp \
+        benchmarks/MeshBatchBenchmark.cpp \
+        benchmarks/MeshBatchChunksBenchmark.cpp \
+        benchmarks/WorldBenchmark.cpp \
+        benchmarks/FreePosFinderBenchmark.cpp \
+        benchmarks/DefDatabaseBenchmark.cpp \
+        benchmarks/RectPackerBenchmark.cpp \
+        benchmarks/BillboardBatchBenchmark.cpp
+
+    HEADERS += benchmarks/Benchmark.hpp
+}
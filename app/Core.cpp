@@ -138,7 +138,11 @@ bool Core::onUpdate()
     TRACK;
 
     updateCameraPos();
-    getWorld().update();
+
+    // with fixed time step World is updated in onFixedUpdate()
+    if(!getAppTime().isFixedTimeStepEnabled())
+        getWorld().update();
+
     getThisPlayer().update();
     getMainGUI().update();
     getSoundPool().update();
@@ -147,6 +151,15 @@ bool Core::onUpdate()
     return true;
 }
 
+bool Core::onFixedUpdate()
+{
+    TRACK;
+
+    getWorld().update();
+
+    return true;
+}
+
 void Core::updateCameraPos()
 {
     auto &sceneManager = getDevice().getSceneManager();
@@ -164,12 +177,23 @@ void Core::updateCameraPos()
 
 void Core::loadAllDefs(const engine::app3D::Settings &settings)
 {
+    auto &defDatabase = getDefDatabase();
+
+    defDatabase.openCompiledDefsCache(k_compiledDefsCachePath);
+    defDatabase.setParallelLoading(settings.parallelDefsLoading);
+
     for(const auto &elem : settings.mods.mods) {
         if(elem.enabled)
             loadDefs(elem.path);
     }
 
-    getDefDatabase().callOnLoadedAllDefs();
+    // worker threads are not needed anymore
+    defDatabase.setParallelLoading(false);
+
+    defDatabase.callOnLoadedAllDefs();
+
+    // only after everything loaded successfully
+    defDatabase.saveCompiledDefsCache();
 }
 
 void Core::loadDefs(const std::string &modPath)
@@ -180,35 +204,50 @@ void Core::loadDefs(const std::string &modPath)
     const auto &devicePtr = getDevice().getPtr();
     const auto &defsPath = "mods/" + modPath + "/defs/";
 
-    // load engine ResourceDefs
+    // defs are loaded in stages, files of all def types queued in a stage are loaded in parallel,
+    // so while loading (in expose()) defs can only refer to defs from previous stages
 
-    defDatabase.loadDefs_directory <engine::app3D::ModelDef> (defsPath + "ModelDefs", "ModelDefs");
-    defDatabase.loadDefs_directory <engine::app3D::TerrainDef> (defsPath + "TerrainDefs", "TerrainDefs");
-    defDatabase.loadDefs_directory <engine::app3D::ParticleSpriteDef> (defsPath + "ParticleSpriteDefs", "ParticleSpriteDefs");
-    defDatabase.loadDefs_directory <engine::app3D::ParticlesGroupModelDef> (defsPath + "ParticlesGroupModelDefs", "ParticlesGroupModelDefs");
-    defDatabase.loadDefs_directory <engine::app3D::ParticlesGroupDef> (defsPath + "ParticlesGroupDefs", "ParticlesGroupDefs");
-    defDatabase.loadDefs_directory <engine::app3D::SoundDef> (defsPath + "SoundDefs", "SoundDefs");
-    defDatabase.loadDefs_directory <engine::app3D::LightDef> (defsPath + "LightDefs", "LightDefs");
+    // load engine ResourceDefs
 
-    for(auto &def : defDatabase.getDefs <engine::app3D::ResourceDef> ()) {
-        def.second->setDevice(devicePtr);
-    }
+    defDatabase.queueDefs_directory <engine::app3D::ModelDef> (defsPath + "ModelDefs", "ModelDefs");
+    defDatabase.queueDefs_directory <engine::app3D::TerrainDef> (defsPath + "TerrainDefs", "TerrainDefs");
+    defDatabase.queueDefs_directory <engine::app3D::ParticleSpriteDef> (defsPath + "ParticleSpriteDefs", "ParticleSpriteDefs");
+    defDatabase.queueDefs_directory <engine::app3D::ParticlesGroupModelDef> (defsPath + "ParticlesGroupModelDefs", "ParticlesGroupModelDefs");
+    defDatabase.queueDefs_directory <engine::app3D::ParticlesGroupDef> (defsPath + "ParticlesGroupDefs", "ParticlesGroupDefs");
+    defDatabase.queueDefs_directory <engine::app3D::SoundDef> (defsPath + "SoundDefs", "SoundDefs");
+    defDatabase.queueDefs_directory <engine::app3D::LightDef> (defsPath + "LightDefs", "LightDefs");
+    defDatabase.loadQueuedDefs();
+
+    defDatabase.forEachDef <engine::app3D::ResourceDef> ([&devicePtr](const auto &def) {
+        def->setDevice(devicePtr);
+    });
 
     // load app defs
 
-    defDatabase.loadDefs_directory <EffectDef> (defsPath + "EffectDefs", "EffectDefs");
-    defDatabase.loadDefs_directory <FactionDef> (defsPath + "FactionDefs", "FactionDefs");
-    defDatabase.loadDefs_directory <FactionRelationDef> (defsPath + "FactionRelationDefs", "FactionRelationDefs");
-    defDatabase.loadDefs_directory <CachedCollisionShapeDef> (defsPath + "CachedCollisionShapeDefs", "CachedCollisionShapeDefs");
-    defDatabase.loadDefs_directory <AnimationFramesSetDef> (defsPath + "AnimationFramesSetDefs", "AnimationFramesSetDefs");
-    defDatabase.loadDefs_directory <ItemDef> (defsPath + "ItemDefs", "ItemDefs");
-    defDatabase.loadDefs_directory <MineableDef> (defsPath + "MineableDefs", "MineableDefs");
-    defDatabase.loadDefs_directory <StructureDef> (defsPath + "StructureDefs", "StructureDefs");
-    defDatabase.loadDefs_directory <CharacterDef> (defsPath + "CharacterDefs", "CharacterDefs");
-    defDatabase.loadDefs_directory <WorldPartDef> (defsPath + "WorldPartDefs", "WorldPartDefs");
-    defDatabase.loadDefs_directory <StructureRecipeDef> (defsPath + "StructureRecipeDefs", "StructureRecipeDefs");
-    defDatabase.loadDefs_directory <UpgradeDef> (defsPath + "UpgradeDefs", "UpgradeDefs");
-    defDatabase.loadDefs_directory <CraftingRecipeDef> (defsPath + "CraftingRecipeDefs", "CraftingRecipeDefs");
+    defDatabase.queueDefs_directory <EffectDef> (defsPath + "EffectDefs", "EffectDefs");
+    defDatabase.queueDefs_directory <FactionDef> (defsPath + "FactionDefs", "FactionDefs");
+    defDatabase.queueDefs_directory <CachedCollisionShapeDef> (defsPath + "CachedCollisionShapeDefs", "CachedCollisionShapeDefs");
+    defDatabase.queueDefs_directory <AnimationFramesSetDef> (defsPath + "AnimationFramesSetDefs", "AnimationFramesSetDefs");
+    defDatabase.loadQueuedDefs();
+
+    defDatabase.queueDefs_directory <FactionRelationDef> (defsPath + "FactionRelationDefs", "FactionRelationDefs");
+    defDatabase.queueDefs_directory <ItemDef> (defsPath + "ItemDefs", "ItemDefs");
+    defDatabase.loadQueuedDefs();
+
+    defDatabase.queueDefs_directory <MineableDef> (defsPath + "MineableDefs", "MineableDefs");
+    defDatabase.queueDefs_directory <StructureDef> (defsPath + "StructureDefs", "StructureDefs");
+    defDatabase.queueDefs_directory <CharacterDef> (defsPath + "CharacterDefs", "CharacterDefs");
+    defDatabase.loadQueuedDefs();
+
+    defDatabase.queueDefs_directory <WorldPartDef> (defsPath + "WorldPartDefs", "WorldPartDefs");
+    defDatabase.queueDefs_directory <StructureRecipeDef> (defsPath + "StructureRecipeDefs", "StructureRecipeDefs");
+    defDatabase.queueDefs_directory <CraftingRecipeDef> (defsPath + "CraftingRecipeDefs", "CraftingRecipeDefs");
+    defDatabase.loadQueuedDefs();
+
+    defDatabase.queueDefs_directory <UpgradeDef> (defsPath + "UpgradeDefs", "UpgradeDefs");
+    defDatabase.loadQueuedDefs();
 }
 
+const std::string Core::k_compiledDefsCachePath{"defs.cache"};
+
 } // namespace app
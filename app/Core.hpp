@@ -35,12 +35,15 @@ public:
 protected:
     void onInit(const engine::app3D::Settings &settings) override;
     bool onUpdate() override;
+    bool onFixedUpdate() override;
 
 private:
     void updateCameraPos();
     void loadAllDefs(const engine::app3D::Settings &settings);
     void loadDefs(const std::string &modPath);
 
+    static const std::string k_compiledDefsCachePath;
+
     engine::AppInfo m_appInfo;
     std::shared_ptr <EventReceiver> m_eventReceiver;
     std::unique_ptr <World> m_world;
@@ -1,6 +1,7 @@
 #include "EventReceiver.hpp"
 
 #include "engine/GUI/Event.hpp"
+#include "engine/util/Trace.hpp"
 #include "GUI/immediate/HandyWindow.hpp"
 #include "GUI/MainGUI.hpp"
 #include "entities/Character.hpp"
@@ -30,6 +31,20 @@ void EventReceiver::onEvent(engine::GUI::Event &event)
         return;
     }
 
+    if(event.getType() == engine::GUI::Event::Type::KeyboardEvent && event.getKeyCode() == irr::KEY_F11) {
+        if(engine::Trace::isRecordingChromeTrace())
+            engine::Trace::stopChromeTraceRecording();
+        else
+            engine::Trace::startChromeTraceRecording(engine::Trace::k_defaultChromeTracePath, engine::Trace::k_defaultChromeTraceFramesCount);
+
+        return;
+    }
+
+    if(event.getType() == engine::GUI::Event::Type::KeyboardEvent && event.getKeyCode() == irr::KEY_F10) {
+        mainGUI.getMetricsOverlay().toggleVisible();
+        return;
+    }
+
     // if we are in GUI mode, then we absorb all keyboard events here - we don't want
     // to control player when in GUI mode, even if some keyboard events were not handled anywhere
     // note: there are no keyboard key Up events, so KeyboardEvent means key Down,
@@ -224,6 +224,16 @@ const Tooltip &MainGUI::getTooltip() const
     return m_tooltip;
 }
 
+MetricsOverlay &MainGUI::getMetricsOverlay()
+{
+    return m_metricsOverlay;
+}
+
+const MetricsOverlay &MainGUI::getMetricsOverlay() const
+{
+    return m_metricsOverlay;
+}
+
 LevelUpAnimation &MainGUI::getLevelUpAnimation()
 {
     return m_levelUpAnimation;
@@ -311,6 +321,7 @@ void MainGUI::onDraw2DAfterWidgets()
     itemCurrentlyDragged.draw();
 
     m_tooltip.draw();
+    m_metricsOverlay.draw();
 
     if(!engine::Math::fuzzyCompare(m_screenFadeIn.getCurrentValue(), 0.f)) {
         auto &device = core.getDevice();
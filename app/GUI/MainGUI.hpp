@@ -5,6 +5,7 @@
 #include "immediate/BloodSplat.hpp"
 #include "immediate/Tooltip.hpp"
 #include "immediate/LevelUpAnimation.hpp"
+#include "immediate/MetricsOverlay.hpp"
 #include "../util/InterpolatedFloat.hpp"
 
 #include <memory>
@@ -57,6 +58,9 @@ public:
     LevelUpAnimation &getLevelUpAnimation();
     const LevelUpAnimation &getLevelUpAnimation() const;
 
+    MetricsOverlay &getMetricsOverlay();
+    const MetricsOverlay &getMetricsOverlay() const;
+
     void setCrosshairVisible(bool visible);
     void openInventoryWindow();
     void openCraftingWindow(const std::shared_ptr <Structure> &optionalWorkbench = {});
@@ -109,6 +113,7 @@ private:
     InterpolatedFloat m_screenFadeIn;
     LevelUpAnimation m_levelUpAnimation;
     Tooltip m_tooltip;
+    MetricsOverlay m_metricsOverlay;
 
     // widgets
 
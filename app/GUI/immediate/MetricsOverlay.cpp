@@ -0,0 +1,71 @@
+#include "MetricsOverlay.hpp"
+
+#include "../../Global.hpp"
+#include "../../Core.hpp"
+#include "engine/app3D/Device.hpp"
+#include "engine/util/Metrics.hpp"
+#include "engine/util/Rect.hpp"
+#include "engine/util/Color.hpp"
+#include "engine/GUI/IGUIRenderer.hpp"
+#include "engine/GUI/GUIManager.hpp"
+
+#include <cstdio>
+
+namespace app
+{
+
+MetricsOverlay::MetricsOverlay()
+    : m_visible{}
+{
+}
+
+void MetricsOverlay::draw() const
+{
+    if(!m_visible)
+        return;
+
+    const auto &metrics = engine::Metrics::getMetrics();
+    const auto &GUIRenderer = Global::getCore().getDevice().getGUIManager().getRenderer();
+
+    engine::IntRect rect{k_pos, {k_nameColumnWidth + 4 * k_columnWidth + 20, static_cast <int> (metrics.size() + 1) * k_lineHeight + 20}};
+
+    GUIRenderer.drawFilledRect(rect, engine::Color::k_black.changedAlpha(0.5f));
+
+    auto pos = rect.pos.moved(10, 10);
+
+    const auto drawRow = [&](const std::string &name, const std::string &value, const std::string &min, const std::string &avg, const std::string &max) {
+        GUIRenderer.drawText(name, pos, engine::Color::k_white);
+        GUIRenderer.drawText(value, pos.movedX(k_nameColumnWidth), engine::Color::k_white);
+        GUIRenderer.drawText(min, pos.movedX(k_nameColumnWidth + k_columnWidth), engine::Color::k_white);
+        GUIRenderer.drawText(avg, pos.movedX(k_nameColumnWidth + 2 * k_columnWidth), engine::Color::k_white);
+        GUIRenderer.drawText(max, pos.movedX(k_nameColumnWidth + 3 * k_columnWidth), engine::Color::k_white);
+
+        pos.y += k_lineHeight;
+    };
+
+    drawRow("Metric", "Frame", "Min", "Avg", "Max");
+
+    char avg[32];
+
+    for(const auto &elem : metrics) {
+        std::snprintf(avg, sizeof(avg), "%.1f", elem.avg);
+        drawRow(elem.name, std::to_string(elem.value), std::to_string(elem.min), avg, std::to_string(elem.max));
+    }
+}
+
+bool MetricsOverlay::isVisible() const
+{
+    return m_visible;
+}
+
+void MetricsOverlay::toggleVisible()
+{
+    m_visible = !m_visible;
+}
+
+const engine::IntVec2 MetricsOverlay::k_pos{10, 10};
+const int MetricsOverlay::k_lineHeight{16};
+const int MetricsOverlay::k_columnWidth{80};
+const int MetricsOverlay::k_nameColumnWidth{160};
+
+} // namespace app
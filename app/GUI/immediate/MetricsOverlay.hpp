@@ -0,0 +1,31 @@
+#ifndef APP_METRICS_OVERLAY_HPP
+#define APP_METRICS_OVERLAY_HPP
+
+#include "engine/util/Vec2.hpp"
+
+namespace app
+{
+
+// shows engine::Metrics of the last frame with rolling min/avg/max
+class MetricsOverlay
+{
+public:
+    MetricsOverlay();
+
+    void draw() const;
+
+    bool isVisible() const;
+    void toggleVisible();
+
+private:
+    static const engine::IntVec2 k_pos;
+    static const int k_lineHeight;
+    static const int k_columnWidth;
+    static const int k_nameColumnWidth;
+
+    bool m_visible;
+};
+
+} // namespace app
+
+#endif // APP_METRICS_OVERLAY_HPP
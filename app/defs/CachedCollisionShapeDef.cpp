@@ -66,20 +66,32 @@ void CachedCollisionShapeDef::expose(engine::DataFile::Node &node)
             m_collisionShape = std::make_shared <engine::app3D::SphereShape> (m_radius);
         else if(m_type == Type::Plane)
             m_collisionShape = std::make_shared <engine::app3D::StaticPlaneShape> (m_planeNormal, m_planeConstant);
-        else if(m_type == Type::ConvexHull || m_type == Type::BvhTriangleMesh) {
-            auto &resourcesManager = Global::getCore().getDevice().getResourcesManager();
-            const auto &points = resourcesManager.getMeshPoints(m_meshPath);
-
-            if(m_type == Type::ConvexHull)
-                m_collisionShape = std::make_shared <engine::app3D::ConvexHullShape> (points);
-            else
-                m_collisionShape = std::make_shared <engine::app3D::BvhTriangleMeshShape> (points);
-        }
+        else if(m_type == Type::ConvexHull || m_type == Type::BvhTriangleMesh)
+            m_collisionShape.reset(); // created from the mesh in onAddedToDatabase()
         else
             throw engine::Exception{"Collision shape type \"" + m_type.toString() + "\" not handled."};
     }
 }
 
+void CachedCollisionShapeDef::onAddedToDatabase(engine::DefDatabase &defDatabase)
+{
+    TRACK;
+
+    base::onAddedToDatabase(defDatabase);
+
+    if(m_type != Type::ConvexHull && m_type != Type::BvhTriangleMesh)
+        return;
+
+    // loading meshes goes through Irrlicht's mesh cache, which isn't thread-safe, so it's not done in expose()
+    auto &resourcesManager = Global::getCore().getDevice().getResourcesManager();
+    const auto &points = resourcesManager.getMeshPoints(m_meshPath);
+
+    if(m_type == Type::ConvexHull)
+        m_collisionShape = std::make_shared <engine::app3D::ConvexHullShape> (points);
+    else
+        m_collisionShape = std::make_shared <engine::app3D::BvhTriangleMeshShape> (points);
+}
+
 void CachedCollisionShapeDef::addPoofEffect(const engine::FloatVec3 &pos, const engine::FloatVec3 &rot) const
 {
     auto &core = Global::getCore();
@@ -32,6 +32,7 @@ public:
     CachedCollisionShapeDef();
 
     void expose(engine::DataFile::Node &node) override;
+    void onAddedToDatabase(engine::DefDatabase &defDatabase) override;
 
     void addPoofEffect(const engine::FloatVec3 &pos, const engine::FloatVec3 &rot) const;
 
@@ -85,19 +85,19 @@ void DefsCache::init()
     WorldPart_Water = defDatabase.getDef <WorldPartDef> ("WorldPart_Water");
 
     AllFactionRelations.clear();
-    for(const auto &elem : defDatabase.getDefs <FactionRelationDef> ()) {
-        AllFactionRelations.push_back(elem.second);
-    }
+    defDatabase.forEachDef <FactionRelationDef> ([this](const auto &def) {
+        AllFactionRelations.push_back(def);
+    });
 
     AllUpgrades.clear();
-    for(const auto &elem : defDatabase.getDefs <UpgradeDef> ()) {
-        AllUpgrades.push_back(elem.second);
-    }
+    defDatabase.forEachDef <UpgradeDef> ([this](const auto &def) {
+        AllUpgrades.push_back(def);
+    });
 
     AllCraftingRecipes.clear();
-    for(const auto &elem : defDatabase.getDefs <CraftingRecipeDef> ()) {
-        AllCraftingRecipes.push_back(elem.second);
-    }
+    defDatabase.forEachDef <CraftingRecipeDef> ([this](const auto &def) {
+        AllCraftingRecipes.push_back(def);
+    });
 }
 
 } // namespace app
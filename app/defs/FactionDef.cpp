@@ -1,26 +1,88 @@
 #include "FactionDef.hpp"
 
-#include "../Global.hpp"
-#include "../Core.hpp"
-#include "DefsCache.hpp"
+#include "engine/util/DefDatabase.hpp"
+
+#include <algorithm>
 
 namespace app
 {
 
-FactionRelationDef::Relation FactionDef::getRelation(const FactionDef &with) const
+FactionDef::FactionDef()
+    : m_factionIndex{-1}
+{
+}
+
+void FactionDef::onLoadedAllDefs(engine::DefDatabase &defDatabase)
 {
-    if(this == &with)
-        return FactionRelationDef::Relation::Good;
+    TRACK;
+
+    base::onLoadedAllDefs(defDatabase);
+
+    // every FactionDef computes indices from the same defName-sorted list,
+    // so they are consistent between all factions and deterministic
+
+    std::vector <std::shared_ptr <FactionDef>> allFactions;
+
+    defDatabase.forEachDef <FactionDef> ([&allFactions](const auto &def) {
+        allFactions.push_back(def);
+    });
+
+    std::sort(allFactions.begin(), allFactions.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs->getDefName() < rhs->getDefName();
+    });
+
+    const auto &getIndex = [&allFactions](const FactionDef &factionDef) {
+        const auto &it = std::find_if(allFactions.begin(), allFactions.end(), [&factionDef](const auto &elem) {
+            return elem.get() == &factionDef;
+        });
+
+        E_DASSERT(it != allFactions.end(), "Could not find faction def.");
+
+        return static_cast <int> (it - allFactions.begin());
+    };
 
-    const auto &defsCache = Global::getCore().getDefsCache();
+    m_factionIndex = getIndex(*this);
 
-    for(const auto &elem : defsCache.AllFactionRelations) {
-        if((&elem->getFirstFactionDef() == this && &elem->getSecondFactionDef() == &with) ||
-           (&elem->getFirstFactionDef() == &with && &elem->getSecondFactionDef() == this))
-            return elem->getRelation();
+    m_relations.clear();
+    m_relations.resize(allFactions.size(), FactionRelationDef::Relation::Neutral);
+    m_relations[m_factionIndex] = FactionRelationDef::Relation::Good;
+
+    std::vector <bool> relationSet(allFactions.size());
+    relationSet[m_factionIndex] = true;
+
+    defDatabase.forEachDef <FactionRelationDef> ([this, &getIndex, &relationSet](const auto &def) {
+        const auto &relationDef = *def;
+        int otherIndex{-1};
+
+        if(&relationDef.getFirstFactionDef() == this)
+            otherIndex = getIndex(relationDef.getSecondFactionDef());
+        else if(&relationDef.getSecondFactionDef() == this)
+            otherIndex = getIndex(relationDef.getFirstFactionDef());
+
+        // if there are duplicated relations, the first one wins
+        if(otherIndex >= 0 && !relationSet[otherIndex]) {
+            m_relations[otherIndex] = relationDef.getRelation();
+            relationSet[otherIndex] = true;
+        }
+    });
+
+    m_hostileToMask.clear();
+    m_hostileToMask.resize((m_relations.size() + 63) / 64);
+
+    for(size_t i = 0; i < m_relations.size(); ++i) {
+        if(m_relations[i] == FactionRelationDef::Relation::Hostile)
+            m_hostileToMask[i / 64] |= std::uint64_t{1} << (i % 64);
     }
+}
 
-    return FactionRelationDef::Relation::Neutral;
+int FactionDef::getFactionIndex() const
+{
+    return m_factionIndex;
+}
+
+const std::vector <std::uint64_t> &FactionDef::getHostileToMask() const
+{
+    return m_hostileToMask;
 }
 
 } // namespace app
@@ -5,16 +5,51 @@
 #include "engine/util/Trace.hpp"
 #include "FactionRelationDef.hpp"
 
+#include <cstdint>
+#include <vector>
+
 namespace app
 {
 
 class FactionDef : public engine::Def, public engine::Tracked <FactionDef>
 {
 public:
+    FactionDef();
+
+    void onLoadedAllDefs(engine::DefDatabase &defDatabase) override;
+
     FactionRelationDef::Relation getRelation(const FactionDef &with) const;
+    bool isHostileTo(const FactionDef &other) const;
+    int getFactionIndex() const;
+    const std::vector <std::uint64_t> &getHostileToMask() const;
+
+private:
+    using base = Def;
+
+    // precomputed in onLoadedAllDefs(), so relation lookup is a single array load
+    int m_factionIndex;
+    std::vector <FactionRelationDef::Relation> m_relations; // index: other faction's index
+    std::vector <std::uint64_t> m_hostileToMask; // bit i % 64 of word i / 64 is set if hostile to faction with index i
 };
 
+inline FactionRelationDef::Relation FactionDef::getRelation(const FactionDef &with) const
+{
+    if(unlikely(with.m_factionIndex < 0 || static_cast <size_t> (with.m_factionIndex) >= m_relations.size()))
+        return this == &with ? FactionRelationDef::Relation::Good : FactionRelationDef::Relation::Neutral;
+
+    return m_relations[with.m_factionIndex];
+}
+
+inline bool FactionDef::isHostileTo(const FactionDef &other) const
+{
+    size_t word{static_cast <size_t> (other.m_factionIndex) / 64};
+
+    if(unlikely(other.m_factionIndex < 0 || word >= m_hostileToMask.size()))
+        return false;
+
+    return (m_hostileToMask[word] >> (other.m_factionIndex % 64)) & 1u;
+}
+
 } // namespace app
 
 #endif // APP_FACTION_DEF_HPP
-
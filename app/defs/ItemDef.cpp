@@ -40,7 +40,6 @@ void ItemDef::expose(engine::DataFile::Node &node)
     if(node.getActivityType() == engine::DataFile::Activity::Type::Loading) {
         auto &core = Global::getCore();
         auto &defDatabase = core.getDefDatabase();
-        auto &GUIManager = core.getDevice().getGUIManager();
 
         m_modelDef = defDatabase.getDef <engine::app3D::ModelDef> (m_modelDef_defName);
 
@@ -59,8 +58,6 @@ void ItemDef::expose(engine::DataFile::Node &node)
         else
             m_putAwaySoundDef.reset();
 
-        m_textureInInventory = GUIManager.getRenderer().getTexture(m_textureInInventory_path);
-
         if(m_sizeInInventory.x < 0 || m_sizeInInventory.y < 0)
             throw engine::Exception{"Size in inventory can't be negative."};
 
@@ -69,6 +66,18 @@ void ItemDef::expose(engine::DataFile::Node &node)
     }
 }
 
+void ItemDef::onAddedToDatabase(engine::DefDatabase &defDatabase)
+{
+    TRACK;
+
+    base::onAddedToDatabase(defDatabase);
+
+    // texture cache isn't thread-safe, so it's not done in expose()
+    auto &GUIRenderer = Global::getCore().getDevice().getGUIManager().getRenderer();
+
+    m_textureInInventory = GUIRenderer.getTexture(m_textureInInventory_path);
+}
+
 const engine::app3D::ModelDef &ItemDef::getModelDef() const
 {
     if(!m_modelDef)
@@ -29,6 +29,7 @@ public:
     ItemDef();
 
     void expose(engine::DataFile::Node &node) override;
+    void onAddedToDatabase(engine::DefDatabase &defDatabase) override;
 
     const engine::app3D::ModelDef &getModelDef() const;
     const std::shared_ptr <engine::app3D::ModelDef> &getModelDefPtr() const;
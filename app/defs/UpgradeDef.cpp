@@ -102,16 +102,24 @@ void UpgradeDef::expose(engine::DataFile::Node &node)
     node.var(m_unlockedIconTexture_path, "unlockedIcon");
 
     if(node.getActivityType() == engine::DataFile::Activity::Type::Loading) {
-        auto &GUIRenderer = Global::getCore().getDevice().getGUIManager().getRenderer();
-
         if(m_requiredUpgradePoints < 0)
             throw engine::Exception{"Required upgrade points value can't be negative."};
-
-        m_iconTexture = GUIRenderer.getTexture(m_iconTexture_path);
-        m_unlockedIconTexture = GUIRenderer.getTexture(m_unlockedIconTexture_path);
     }
 }
 
+void UpgradeDef::onAddedToDatabase(engine::DefDatabase &defDatabase)
+{
+    TRACK;
+
+    base::onAddedToDatabase(defDatabase);
+
+    // texture cache isn't thread-safe, so it's not done in expose()
+    auto &GUIRenderer = Global::getCore().getDevice().getGUIManager().getRenderer();
+
+    m_iconTexture = GUIRenderer.getTexture(m_iconTexture_path);
+    m_unlockedIconTexture = GUIRenderer.getTexture(m_unlockedIconTexture_path);
+}
+
 void UpgradeDef::onLoadedAllDefs(engine::DefDatabase &defDatabase)
 {
     m_requiredUpgrade.onLoadedAllDefs();
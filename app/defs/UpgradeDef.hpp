@@ -56,6 +56,7 @@ public:
     UpgradeDef();
 
     void expose(engine::DataFile::Node &node) override;
+    void onAddedToDatabase(engine::DefDatabase &defDatabase) override;
     void onLoadedAllDefs(engine::DefDatabase &defDatabase) override;
 
     int drawEffects(const engine::IntVec2 &pos) const;
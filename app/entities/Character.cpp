@@ -72,6 +72,11 @@ Character::Character(int entityID, const std::shared_ptr <CharacterDef> &def, bo
     }
 }
 
+EntityType Character::getEntityType() const
+{
+    return EntityType::Character;
+}
+
 bool Character::wantsEverInWorldUpdate() const
 {
     return true;
@@ -243,9 +248,7 @@ void Character::onSpawnedInWorld()
         auto &device = core.getDevice();
         const auto &rot = getInWorldRotation();
 
-        m_characterModel = device.getSceneManager().addModel(m_def->getModelDefPtr());
-        m_characterModel->setPosition(pos + getFlyingAnimationOffset());
-        m_characterModel->setRotation(rot);
+        m_characterModel = device.getSceneManager().addModel(m_def->getModelDefPtr(), pos + getFlyingAnimationOffset(), rot);
     }
 
     if(isKilled())
@@ -26,6 +26,7 @@ class Character : public Entity, public engine::Tracked <Character>
 public:
     Character(int entityID, const std::shared_ptr <CharacterDef> &def, bool isPlayer);
 
+    EntityType getEntityType() const override;
     bool wantsEverInWorldUpdate() const override;
     void setInWorldPosition(const engine::FloatVec3 &pos) override;
     void setInWorldRotation(const engine::FloatVec3 &rot) override;
@@ -74,7 +74,13 @@ void Entity::onRemovedFromWorld()
 
 void Entity::setInWorldPosition(const engine::FloatVec3 &pos)
 {
+    const auto previousPos = m_pos;
+
     m_pos = pos;
+
+    // keep World's spatial index up to date
+    if(m_isInWorld)
+        Global::getCore().getWorld().onEntityMoved(*this, previousPos);
 }
 
 void Entity::setInWorldRotation(const engine::FloatVec3 &rot)
@@ -100,6 +106,16 @@ bool Entity::wantsToBeRemovedFromWorld() const
     return false;
 }
 
+bool Entity::wantsToSleep() const
+{
+    return false;
+}
+
+bool Entity::wakesUpWhenCharacterIsNear() const
+{
+    return false;
+}
+
 void Entity::onItemUsedOnMe(Entity &doer, const Item &item)
 {
 }
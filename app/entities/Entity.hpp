@@ -4,6 +4,7 @@
 #include "engine/util/Trace.hpp"
 #include "engine/util/Vec2.hpp"
 #include "engine/util/Vec3.hpp"
+#include "EntityType.hpp"
 
 namespace app
 {
@@ -23,11 +24,14 @@ public:
 
     explicit Entity(int entityID);
 
+    virtual EntityType getEntityType() const = 0;
     virtual bool wantsEverInWorldUpdate() const = 0;
     virtual void setInWorldPosition(const engine::FloatVec3 &pos);
     virtual void setInWorldRotation(const engine::FloatVec3 &rot);
     virtual bool canBuildOnTopOfIt() const;
     virtual bool wantsToBeRemovedFromWorld() const;
+    virtual bool wantsToSleep() const; // checked after onInWorldUpdate(), sleeping entities are not updated until woken up by World
+    virtual bool wakesUpWhenCharacterIsNear() const;
     virtual std::vector <std::pair <engine::FloatVec3, engine::FloatVec3>> trySnapToMe(const StructureDef &structureDef, const engine::FloatVec3 &designatedPos) const;
     virtual bool canBeDeconstructed(const Character &doer) const;
     virtual bool canBeRevived(const Character &doer) const;
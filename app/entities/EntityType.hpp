@@ -0,0 +1,36 @@
+#ifndef APP_ENTITY_TYPE_HPP
+#define APP_ENTITY_TYPE_HPP
+
+#include <cstddef>
+
+namespace app
+{
+
+class Character;
+class Structure;
+class Item;
+class Mineable;
+
+enum class EntityType
+{
+    Character,
+    Structure,
+    Item,
+    Mineable
+};
+
+constexpr std::size_t k_entityTypesCount{4};
+
+// compile-time mapping from entity class to its EntityType, so typed
+// iteration doesn't need dynamic_cast
+
+template <typename T> struct EntityTypeOf;
+
+template <> struct EntityTypeOf <Character> { static constexpr EntityType value{EntityType::Character}; };
+template <> struct EntityTypeOf <Structure> { static constexpr EntityType value{EntityType::Structure}; };
+template <> struct EntityTypeOf <Item> { static constexpr EntityType value{EntityType::Item}; };
+template <> struct EntityTypeOf <Mineable> { static constexpr EntityType value{EntityType::Mineable}; };
+
+} // namespace app
+
+#endif // APP_ENTITY_TYPE_HPP
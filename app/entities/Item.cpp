@@ -46,6 +46,11 @@ Item::Item(int entityID, const std::shared_ptr <ItemDef> &def, int stack)
     }
 }
 
+EntityType Item::getEntityType() const
+{
+    return EntityType::Item;
+}
+
 bool Item::wantsEverInWorldUpdate() const
 {
     E_DASSERT(m_def, "Item def is nullptr.");
@@ -86,6 +91,19 @@ bool Item::wantsToBeRemovedFromWorld() const
     return !m_stack || m_isPickedUp;
 }
 
+bool Item::wantsToSleep() const
+{
+    // nothing to copy from rigid body if it's not simulated,
+    // World wakes us up when the body gets activated again
+    return m_rigidBody && !m_rigidBody->isActive();
+}
+
+bool Item::wakesUpWhenCharacterIsNear() const
+{
+    // so it can be picked up
+    return true;
+}
+
 std::string Item::getName() const
 {
     E_DASSERT(m_def, "Item def is nullptr.");
@@ -148,9 +166,7 @@ void Item::onSpawnedInWorld()
 
     E_DASSERT(m_def, "Item def is nullptr.");
 
-    m_model = device.getSceneManager().addModel(m_def->getModelDefPtr());
-    m_model->setPosition(pos);
-    m_model->setRotation(rot);
+    m_model = device.getSceneManager().addModel(m_def->getModelDefPtr(), pos, rot);
 
     const auto &cachedCollisionShapeDef = m_def->getCachedCollisionShapeDef();
     const auto &shape = cachedCollisionShapeDef.getCollisionShapePtr();
@@ -210,7 +226,7 @@ void Item::onUsedOnSomething(const engine::FloatVec3 &sourcePos, const engine::F
 
         if(&doer == &thisPlayerCharacter &&
            !entityPtr->isKilled() &&
-           entityPtr->getFactionDef().getRelation(doer.getFactionDef()) == FactionRelationDef::Relation::Hostile) {
+           entityPtr->getFactionDef().isHostileTo(doer.getFactionDef())) {
             soundPool.play(defsCache.Sound_HitTarget);
             mainGUI.onHitTarget();
         }
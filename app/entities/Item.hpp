@@ -18,10 +18,13 @@ class Item : public Entity, public engine::Tracked <Item>
 public:
     Item(int entityID, const std::shared_ptr <ItemDef> &def, int stack = 1);
 
+    EntityType getEntityType() const override;
     bool wantsEverInWorldUpdate() const override;
     void setInWorldPosition(const engine::FloatVec3 &pos) override;
     void setInWorldRotation(const engine::FloatVec3 &rot) override;
     bool wantsToBeRemovedFromWorld() const override;
+    bool wantsToSleep() const override;
+    bool wakesUpWhenCharacterIsNear() const override;
     std::string getName() const override;
     void onInWorldUpdate() override;
     void onSpawnedInWorld() override;
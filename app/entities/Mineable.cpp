@@ -77,6 +77,11 @@ Mineable::Mineable(int entityID, const std::shared_ptr <MineableDef> &def)
     initResources();
 }
 
+EntityType Mineable::getEntityType() const
+{
+    return EntityType::Mineable;
+}
+
 bool Mineable::wantsEverInWorldUpdate() const
 {
     E_DASSERT(m_def, "Mineable def is nullptr.");
@@ -111,6 +116,11 @@ bool Mineable::wantsToBeRemovedFromWorld() const
     return m_durability <= 0 && !hasAnyResources();
 }
 
+bool Mineable::wantsToSleep() const
+{
+    return m_rigidBody && !m_rigidBody->isActive();
+}
+
 bool Mineable::blocksWorldPartFreePosFinderField() const
 {
     return true;
@@ -163,9 +173,7 @@ void Mineable::onSpawnedInWorld()
 
     E_DASSERT(m_def, "Mineable def is nullptr.");
 
-    m_model = device.getSceneManager().addModel(m_def->getRandomModelDefPtr());
-    m_model->setPosition(pos);
-    m_model->setRotation(rot);
+    m_model = device.getSceneManager().addModel(m_def->getRandomModelDefPtr(), pos, rot);
 
     const auto &cachedCollisionShapeDef = m_def->getCachedCollisionShapeDef();
     const auto &shape = cachedCollisionShapeDef.getCollisionShapePtr();
@@ -35,10 +35,12 @@ class Mineable : public Entity, public engine::Tracked <Mineable>
 public:
     Mineable(int entityID, const std::shared_ptr <MineableDef> &def);
 
+    EntityType getEntityType() const override;
     bool wantsEverInWorldUpdate() const override;
     void setInWorldPosition(const engine::FloatVec3 &pos) override;
     void setInWorldRotation(const engine::FloatVec3 &rot) override;
     bool wantsToBeRemovedFromWorld() const override;
+    bool wantsToSleep() const override;
     bool blocksWorldPartFreePosFinderField() const override;
     std::shared_ptr <EffectDef> getOnHitEffectDefPtr() const override;
     std::string getName() const override;
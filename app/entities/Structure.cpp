@@ -55,6 +55,11 @@ Structure::Structure(int entityID, const std::shared_ptr <StructureDef> &def)
         m_searchableItemContainer = std::make_shared <MultiSlotItemContainer> (k_searchableItemContainerSize);
 }
 
+EntityType Structure::getEntityType() const
+{
+    return EntityType::Structure;
+}
+
 bool Structure::wantsEverInWorldUpdate() const
 {
     E_DASSERT(m_def, "Structure def is nullptr.");
@@ -210,9 +215,7 @@ void Structure::onSpawnedInWorld()
 
     E_DASSERT(m_def, "Structure def is nullptr.");
 
-    m_model = device.getSceneManager().addModel(m_def->getModelDefPtr());
-    m_model->setPosition(pos);
-    m_model->setRotation(rot);
+    m_model = device.getSceneManager().addModel(m_def->getModelDefPtr(), pos, rot);
 
     const auto &cachedCollisionShapeDef = m_def->getCachedCollisionShapeDef();
     const auto &shape = cachedCollisionShapeDef.getCollisionShapePtr();
@@ -488,9 +491,7 @@ void Structure::turret_onSpawnedInWorld(const engine::FloatVec3 &inWorldPos, con
 
     float offset{m_def->getTurretInfo().getDistanceToHead()};
 
-    m_turretHeadModel = device.getSceneManager().addModel(turretInfo.getHeadModelDefPtr());
-    m_turretHeadModel->setPosition(inWorldPos.movedY(offset));
-    m_turretHeadModel->setRotation(m_turretHeadRot);
+    m_turretHeadModel = device.getSceneManager().addModel(turretInfo.getHeadModelDefPtr(), inWorldPos.movedY(offset), m_turretHeadRot);
 
     const auto &cachedCollisionShapeDef = turretInfo.getHeadCachedCollisionShapeDef();
     const auto &shape = cachedCollisionShapeDef.getCollisionShapePtr();
@@ -23,6 +23,7 @@ class Structure : public Entity, public engine::Tracked <Structure>
 public:
     Structure(int entityID, const std::shared_ptr <StructureDef> &def);
 
+    EntityType getEntityType() const override;
     bool wantsEverInWorldUpdate() const override;
     void setInWorldPosition(const engine::FloatVec3 &pos) override;
     void setInWorldRotation(const engine::FloatVec3 &rot) override;
@@ -7,6 +7,7 @@
 #include "../character/CharacterStatsOrSkillsRelatedFormulas.hpp"
 #include "engine/app3D/IrrlichtConversions.hpp"
 #include "../Character.hpp"
+#include "../Structure.hpp"
 
 namespace app
 {
@@ -48,19 +49,16 @@ void FlyingNPCComponent::calculateNewTarget()
     int bestPriority{-1};
     float bestDist{};
 
-    world.forEachEntity([&bestPriority, &bestDist, &bestEntityID, &myPos, this](auto &entity) {
+    const auto &considerEntity = [&bestPriority, &bestDist, &bestEntityID, &myPos, this](auto &entity) {
         int entityPriority{entity.getAIPotentialTargetPriority()};
 
         // has negative priority?
         if(entityPriority < 0)
             return;
 
+        // query guarantees that it's in max range
         float dist{entity.getInWorldPosition().getDistanceSq(myPos)};
 
-        // is out of max range?
-        if(dist > k_maxTargetableEntityDistance * k_maxTargetableEntityDistance)
-            return;
-
         // is it even a good target?
         if(!this->isGoodTarget(entity))
             return;
@@ -77,7 +75,11 @@ void FlyingNPCComponent::calculateNewTarget()
             bestDist = dist;
             bestEntityID = entity.getEntityID();
         }
-    });
+    };
+
+    // only Characters and Structures can be AI targets (see getAIPotentialTargetPriority())
+    world.queryEntitiesOfTypeInRadius <Character> (myPos, k_maxTargetableEntityDistance, considerEntity);
+    world.queryEntitiesOfTypeInRadius <Structure> (myPos, k_maxTargetableEntityDistance, considerEntity);
 
     if(bestEntityID >= 0)
         setTarget(Target::Entity, world.getEntityPtr(bestEntityID));
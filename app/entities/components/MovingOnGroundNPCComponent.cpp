@@ -6,6 +6,7 @@
 #include "../../Core.hpp"
 #include "../character/CharacterStatsOrSkillsRelatedFormulas.hpp"
 #include "../Character.hpp"
+#include "../Structure.hpp"
 
 namespace app
 {
@@ -55,19 +56,16 @@ void MovingOnGroundNPCComponent::calculateNewTarget()
         int bestPriority{-1};
         float bestDist{};
 
-        world.forEachEntity([&bestReachable, &bestPriority, &bestDist, &bestEntityID, &myPos, &character, this](auto &entity) {
+        const auto &considerEntity = [&bestReachable, &bestPriority, &bestDist, &bestEntityID, &myPos, &character, this](auto &entity) {
             int entityPriority{entity.getAIPotentialTargetPriority()};
 
             // has negative priority?
             if(entityPriority < 0)
                 return;
 
+            // query guarantees that it's in max range
             float dist{entity.getInWorldPosition().getDistanceSq(myPos)};
 
-            // is out of max range?
-            if(dist > k_maxTargetableEntityDistance * k_maxTargetableEntityDistance)
-                return;
-
             // is it even a good target?
             if(!this->isGoodTarget(entity))
                 return;
@@ -88,25 +86,26 @@ void MovingOnGroundNPCComponent::calculateNewTarget()
                 bestDist = dist;
                 bestEntityID = entity.getEntityID();
             }
-        });
+        };
+
+        // only Characters and Structures can be AI targets (see getAIPotentialTargetPriority())
+        world.queryEntitiesOfTypeInRadius <Character> (myPos, k_maxTargetableEntityDistance, considerEntity);
+        world.queryEntitiesOfTypeInRadius <Structure> (myPos, k_maxTargetableEntityDistance, considerEntity);
     }
     else {
         int bestPriority{-1};
         float bestDist{};
 
-        world.forEachEntity([&bestPriority, &bestDist, &bestEntityID, &myPos, this](auto &entity) {
+        const auto &considerEntity = [&bestPriority, &bestDist, &bestEntityID, &myPos, this](auto &entity) {
             int entityPriority{entity.getAIPotentialTargetPriority()};
 
             // has negative priority?
             if(entityPriority < 0)
                 return;
 
+            // query guarantees that it's in max range
             float dist{entity.getInWorldPosition().getDistanceSq(myPos)};
 
-            // is out of max range?
-            if(dist > k_maxTargetableEntityDistance * k_maxTargetableEntityDistance)
-                return;
-
             // is it even a good target?
             if(!this->isGoodTarget(entity))
                 return;
@@ -123,7 +122,11 @@ void MovingOnGroundNPCComponent::calculateNewTarget()
                 bestDist = dist;
                 bestEntityID = entity.getEntityID();
             }
-        });
+        };
+
+        // only Characters and Structures can be AI targets (see getAIPotentialTargetPriority())
+        world.queryEntitiesOfTypeInRadius <Character> (myPos, k_maxTargetableEntityDistance, considerEntity);
+        world.queryEntitiesOfTypeInRadius <Structure> (myPos, k_maxTargetableEntityDistance, considerEntity);
     }
 
     if(bestEntityID >= 0)
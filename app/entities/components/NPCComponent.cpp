@@ -112,9 +112,7 @@ bool NPCComponent::targetEntityExpired() const
 
 bool NPCComponent::isGoodTarget(const Entity &entity) const
 {
-    const auto &relation = getCharacter().getFactionDef().getRelation(entity.getFactionDef());
-
-    return relation == FactionRelationDef::Relation::Hostile &&
+    return getCharacter().getFactionDef().isHostileTo(entity.getFactionDef()) &&
            !entity.isKilled() &&
            entity.isInWorld();
 }
@@ -160,7 +160,7 @@ void TurretComponent::calculateNewTarget()
     int bestPriority{-1};
     float bestDist{};
 
-    world.forEachEntity([&bestPriority, &bestDist, &bestEntityID, &myPos, &turretHeadPos, this](auto &entity) {
+    const auto &considerEntity = [&bestPriority, &bestDist, &bestEntityID, &myPos, &turretHeadPos, this](auto &entity) {
         int entityPriority{entity.getAIPotentialTargetPriority()};
 
         // has negative priority?
@@ -199,7 +199,11 @@ void TurretComponent::calculateNewTarget()
             bestDist = dist;
             bestEntityID = entity.getEntityID();
         }
-    });
+    };
+
+    // only Characters and Structures can be AI targets (see getAIPotentialTargetPriority())
+    world.queryEntitiesOfTypeInRadius <Character> (myPos, k_maxDistanceToTarget, considerEntity);
+    world.queryEntitiesOfTypeInRadius <Structure> (myPos, k_maxDistanceToTarget, considerEntity);
 
     if(bestEntityID >= 0)
         m_targetEntity = world.getEntityPtr(bestEntityID);
@@ -325,12 +329,10 @@ float TurretComponent::getYAngle(const engine::FloatVec3 &pos1, const engine::Fl
 
 bool TurretComponent::isGoodTarget(const Entity &entity) const
 {
-    const auto &relation = m_structure.getFactionDef().getRelation(entity.getFactionDef());
-
     const auto &structureInWorldPos = m_structure.getInWorldPosition();
     const auto &entityInWorldPos = entity.getInWorldPosition();
 
-    return relation == FactionRelationDef::Relation::Hostile &&
+    return m_structure.getFactionDef().isHostileTo(entity.getFactionDef()) &&
            !entity.isKilled() &&
            entity.isInWorld() &&
            structureInWorldPos.getDistanceSq(entityInWorldPos) <= k_maxDistanceToTarget * k_maxDistanceToTarget &&
@@ -34,12 +34,10 @@ void UnlockedStructures::unlockUnlockedByDefault()
     E_DASSERT(m_unlocked.empty(), "This method does not check duplicates, so it requires 0 unlocked structure defs yet.");
 
     const auto &defDatabase = Global::getCore().getDefDatabase();
-    const auto &allDefs = defDatabase.getDefs <StructureRecipeDef> ();
-
-    for(const auto &elem : allDefs) {
-        if(elem.second->isUnlockedByDefault())
-            unlock(elem.second);
-    }
+    defDatabase.forEachDef <StructureRecipeDef> ([this](const auto &def) {
+        if(def->isUnlockedByDefault())
+            unlock(def);
+    });
 }
 
 } // namespace app
@@ -74,12 +74,10 @@ void UnlockedUpgrades::unlockUnlockedByDefault()
 {
     auto &defDatabase = Global::getCore().getDefDatabase();
 
-    for(const auto &elem : defDatabase.getDefs <UpgradeDef> ()) {
-        E_DASSERT(elem.second, "Upgrade def is nullptr.");
-
-        if(elem.second->isUnlockedByDefault())
-            tryUnlock(elem.second, false);
-    }
+    defDatabase.forEachDef <UpgradeDef> ([this](const auto &def) {
+        if(def->isUnlockedByDefault())
+            tryUnlock(def, false);
+    });
 }
 
 } // namespace app
@@ -0,0 +1,92 @@
+#ifndef APP_ENTITIES_BY_TYPE_HPP
+#define APP_ENTITIES_BY_TYPE_HPP
+
+#include "engine/util/LogManager.hpp"
+#include "../entities/EntityType.hpp"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace app
+{
+
+/* Dense per-EntityType lists of entities, used by World for typed iteration without
+ * hash map traversal or dynamic_cast. Entities are not owned. Removal swaps with the last
+ * entity of the list, so iteration order is not stable. Functions passed to forEach functions
+ * must not add or remove entities.
+ * TEntity is Entity in the game; it needs getEntityType() and getEntityID().
+ */
+template <typename TEntity> class EntitiesByType
+{
+public:
+    void add(TEntity &entity);
+    void remove(const TEntity &entity);
+
+    template <typename Func> void forEach(Func &&func) const;
+    template <typename T, typename Func> void forEachOfType(Func &&func) const;
+
+private:
+    struct DenseEntityList
+    {
+        std::vector <TEntity*> entities;
+        std::unordered_map <int, size_t> indices; // key: entityID, value: index in entities
+    };
+
+    std::array <DenseEntityList, k_entityTypesCount> m_lists; // index: EntityType
+};
+
+template <typename TEntity> void EntitiesByType <TEntity>::add(TEntity &entity)
+{
+    auto &list = m_lists[static_cast <size_t> (entity.getEntityType())];
+
+    list.indices.emplace(entity.getEntityID(), list.entities.size());
+    list.entities.push_back(&entity);
+}
+
+template <typename TEntity> void EntitiesByType <TEntity>::remove(const TEntity &entity)
+{
+    auto &list = m_lists[static_cast <size_t> (entity.getEntityType())];
+    auto indexIt = list.indices.find(entity.getEntityID());
+
+    if(indexIt == list.indices.end())
+        return;
+
+    auto index = indexIt->second;
+
+    // swap with the last one, so removal is O(1)
+
+    if(index != list.entities.size() - 1) {
+        list.entities[index] = list.entities.back();
+        list.indices[list.entities[index]->getEntityID()] = index;
+    }
+
+    list.entities.pop_back();
+    list.indices.erase(indexIt);
+}
+
+template <typename TEntity> template <typename Func> void EntitiesByType <TEntity>::forEach(Func &&func) const
+{
+    for(const auto &list : m_lists) {
+        for(auto *entity : list.entities) {
+            E_DASSERT(entity, "Entity is nullptr.");
+            func(*entity);
+        }
+    }
+}
+
+template <typename TEntity> template <typename T, typename Func> void EntitiesByType <TEntity>::forEachOfType(Func &&func) const
+{
+    const auto &list = m_lists[static_cast <size_t> (EntityTypeOf <T>::value)];
+
+    for(auto *entity : list.entities) {
+        E_DASSERT(entity, "Entity is nullptr.");
+
+        // list guarantees entity type, so static_cast is safe here
+        func(static_cast <T&> (*entity));
+    }
+}
+
+} // namespace app
+
+#endif // APP_ENTITIES_BY_TYPE_HPP
@@ -0,0 +1,111 @@
+#include "EntitySpatialGrid.hpp"
+
+namespace app
+{
+
+EntitySpatialGrid::EntitySpatialGrid(const engine::FloatRect &bounds, float cellSize)
+    : m_bounds{bounds},
+      m_cellSize{cellSize}
+{
+    TRACK;
+
+    if(m_cellSize <= 0.f)
+        throw engine::Exception{"Entity spatial grid cell size must be positive."};
+
+    m_cellsCount.x = std::max(1, static_cast <int> (std::ceil(m_bounds.size.x / m_cellSize)));
+    m_cellsCount.y = std::max(1, static_cast <int> (std::ceil(m_bounds.size.y / m_cellSize)));
+
+    m_buckets.resize(m_cellsCount.x * m_cellsCount.y * k_entityTypesCount);
+}
+
+void EntitySpatialGrid::add(Entity &entity)
+{
+    int bucketIndex{getBucketIndex(entity.getInWorldPosition(), entity.getEntityType())};
+    auto &bucket = m_buckets[bucketIndex];
+
+    const auto &inserted = m_locations.emplace(entity.getEntityID(), Location{bucketIndex, bucket.size()});
+
+    if(!inserted.second) {
+        E_WARNING("Entity with ID \"%d\" is already present in entity spatial grid.", entity.getEntityID());
+        return;
+    }
+
+    bucket.push_back(&entity);
+}
+
+void EntitySpatialGrid::remove(const Entity &entity)
+{
+    auto it = m_locations.find(entity.getEntityID());
+
+    if(it == m_locations.end())
+        return;
+
+    removeFromBucket(it->second);
+    m_locations.erase(it);
+}
+
+void EntitySpatialGrid::onEntityMoved(Entity &entity, const engine::FloatVec3 &previousPos)
+{
+    auto type = entity.getEntityType();
+    int bucketIndex{getBucketIndex(entity.getInWorldPosition(), type)};
+
+    // most of the time entity stays in the same cell, so we don't even have to look it up
+    if(bucketIndex == getBucketIndex(previousPos, type))
+        return;
+
+    auto it = m_locations.find(entity.getEntityID());
+
+    if(it == m_locations.end())
+        return;
+
+    removeFromBucket(it->second);
+
+    auto &bucket = m_buckets[bucketIndex];
+
+    it->second = {bucketIndex, bucket.size()};
+    bucket.push_back(&entity);
+}
+
+bool EntitySpatialGrid::isEmpty() const
+{
+    return m_locations.empty();
+}
+
+void EntitySpatialGrid::removeFromBucket(const Location &location)
+{
+    E_DASSERT(location.bucketIndex >= 0 && static_cast <size_t> (location.bucketIndex) < m_buckets.size(), "Bucket index out of bounds.");
+
+    auto &bucket = m_buckets[location.bucketIndex];
+
+    E_DASSERT(location.indexInBucket < bucket.size(), "Index in bucket out of bounds.");
+
+    // swap with the last one, so removal is O(1)
+
+    if(location.indexInBucket != bucket.size() - 1) {
+        bucket[location.indexInBucket] = bucket.back();
+
+        auto it = m_locations.find(bucket[location.indexInBucket]->getEntityID());
+        E_DASSERT(it != m_locations.end(), "Moved entity has no location.");
+
+        it->second.indexInBucket = location.indexInBucket;
+    }
+
+    bucket.pop_back();
+}
+
+engine::IntVec2 EntitySpatialGrid::getCellPos(const engine::FloatVec2 &pos) const
+{
+    // positions out of bounds are clamped to the closest border cell
+
+    return {engine::Math::clamp(static_cast <int> (std::floor((pos.x - m_bounds.pos.x) / m_cellSize)), 0, m_cellsCount.x - 1),
+            engine::Math::clamp(static_cast <int> (std::floor((pos.y - m_bounds.pos.y) / m_cellSize)), 0, m_cellsCount.y - 1)};
+}
+
+int EntitySpatialGrid::getBucketIndex(const engine::FloatVec3 &pos, EntityType type) const
+{
+    const auto &cellPos = getCellPos({pos.x, pos.z}); // 2d vs 3d
+
+    return (cellPos.y * m_cellsCount.x + cellPos.x) * k_entityTypesCount + static_cast <int> (type);
+}
+
+} // namespace app
@@ -0,0 +1,130 @@
+#ifndef APP_ENTITY_SPATIAL_GRID_HPP
+#define APP_ENTITY_SPATIAL_GRID_HPP
+
+#include "engine/util/Trace.hpp"
+#include "engine/util/Rect.hpp"
+#include "engine/util/Vec2.hpp"
+#include "engine/util/Vec3.hpp"
+#include "../entities/Entity.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace app
+{
+
+/* Uniform grid over World bounds (XZ plane) used to answer "which entities are near this position"
+ * questions without visiting every entity in the world. Entities outside bounds are kept in the
+ * closest border cell, so queries never miss them. The grid is kept up to date by World (entities
+ * are added, removed, and moved from Entity::setInWorldPosition). Functions passed to queries
+ * must not add, remove or move entities.
+ * Each cell keeps a separate bucket per EntityType, so typed queries only touch entities
+ * of the requested type.
+ */
+class EntitySpatialGrid : public engine::Tracked <EntitySpatialGrid>
+{
+public:
+    EntitySpatialGrid(const engine::FloatRect &bounds, float cellSize);
+
+    void add(Entity &entity);
+    void remove(const Entity &entity);
+    void onEntityMoved(Entity &entity, const engine::FloatVec3 &previousPos);
+    bool isEmpty() const;
+
+    template <typename Func> void forEachEntityInRect(const engine::FloatRect &rect, Func &&func) const;
+    template <typename Func> void forEachEntityInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const;
+    template <typename T, typename Func> void forEachEntityOfTypeInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const;
+
+private:
+    struct Location
+    {
+        int bucketIndex{};
+        size_t indexInBucket{};
+    };
+
+    template <typename Func> void forEachBucketInRect(const engine::FloatRect &rect, size_t typesFrom, size_t typesTo, Func &&func) const;
+
+    void removeFromBucket(const Location &location);
+    engine::IntVec2 getCellPos(const engine::FloatVec2 &pos) const;
+    int getBucketIndex(const engine::FloatVec3 &pos, EntityType type) const;
+
+    engine::FloatRect m_bounds;
+    float m_cellSize;
+    engine::IntVec2 m_cellsCount;
+    std::vector <std::vector <Entity*>> m_buckets; // k_entityTypesCount buckets per cell
+    std::unordered_map <int, Location> m_locations; // key: entityID
+};
+
+template <typename Func> void EntitySpatialGrid::forEachEntityInRect(const engine::FloatRect &rect, Func &&func) const
+{
+    TRACK;
+
+    forEachBucketInRect(rect, 0, k_entityTypesCount, [&rect, &func](const auto &bucket) {
+        for(auto *entity : bucket) {
+            E_DASSERT(entity, "Entity is nullptr.");
+
+            const auto &pos = entity->getInWorldPosition();
+
+            if(rect.contains({pos.x, pos.z})) // 2d vs 3d
+                func(*entity);
+        }
+    });
+}
+
+template <typename Func> void EntitySpatialGrid::forEachEntityInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const
+{
+    TRACK;
+
+    float radiusSq{radius * radius};
+
+    forEachBucketInRect({pos.moved(-radius, -radius), {radius * 2.f, radius * 2.f}}, 0, k_entityTypesCount, [&pos, radiusSq, &func](const auto &bucket) {
+        for(auto *entity : bucket) {
+            E_DASSERT(entity, "Entity is nullptr.");
+
+            const auto &entityPos = entity->getInWorldPosition();
+
+            if(pos.getDistanceSq({entityPos.x, entityPos.z}) <= radiusSq) // 2d vs 3d
+                func(*entity);
+        }
+    });
+}
+
+template <typename T, typename Func> void EntitySpatialGrid::forEachEntityOfTypeInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const
+{
+    TRACK;
+
+    float radiusSq{radius * radius};
+    auto type = static_cast <size_t> (EntityTypeOf <T>::value);
+
+    forEachBucketInRect({pos.moved(-radius, -radius), {radius * 2.f, radius * 2.f}}, type, type + 1, [&pos, radiusSq, &func](const auto &bucket) {
+        for(auto *entity : bucket) {
+            E_DASSERT(entity, "Entity is nullptr.");
+
+            const auto &entityPos = entity->getInWorldPosition();
+
+            // bucket guarantees entity type, so static_cast is safe here
+            if(pos.getDistanceSq({entityPos.x, entityPos.z}) <= radiusSq) // 2d vs 3d
+                func(static_cast <T&> (*entity));
+        }
+    });
+}
+
+template <typename Func> void EntitySpatialGrid::forEachBucketInRect(const engine::FloatRect &rect, size_t typesFrom, size_t typesTo, Func &&func) const
+{
+    const auto &from = getCellPos(rect.pos);
+    const auto &to = getCellPos({rect.getMaxX(), rect.getMaxY()});
+
+    for(int y = from.y; y <= to.y; ++y) {
+        for(int x = from.x; x <= to.x; ++x) {
+            size_t firstBucket{(y * m_cellsCount.x + x) * k_entityTypesCount};
+
+            for(size_t i = typesFrom; i < typesTo; ++i) {
+                func(m_buckets[firstBucket + i]);
+            }
+        }
+    }
+}
+
+} // namespace app
+
+#endif // APP_ENTITY_SPATIAL_GRID_HPP
@@ -9,12 +9,14 @@
 #include "engine/app3D/Settings.hpp"
 #include "engine/util/DefDatabase.hpp"
 #include "engine/util/DataFile.hpp"
+#include "engine/util/Metrics.hpp"
 #include "../defs/DefsCache.hpp"
 #include "../defs/CachedCollisionShapeDef.hpp"
 #include "../defs/StructureDef.hpp"
 #include "../defs/WorldPartDef.hpp"
 #include "../entities/Entity.hpp"
 #include "../entities/Structure.hpp"
+#include "../entities/Character.hpp"
 #include "../Global.hpp"
 #include "../Core.hpp"
 #include "WorldPart.hpp"
@@ -36,7 +38,9 @@ void WorldPartsParams::expose(engine::DataFile::Node &node)
 }
 
 World::World(const engine::app3D::Settings &settings)
-    : m_uniqueEntityID{},
+    : m_isUpdatingEntities{},
+      m_uniqueEntityID{},
+      m_pathFindingBudget{k_pathFindingNodeExpansionsPerFrame},
       m_birdsAmbience{Global::getCore().getDevice().getResourcesManager().getPathToResource(k_birdsAmbiencePath)}
 {
     TRACK;
@@ -121,6 +125,14 @@ World::World(const engine::app3D::Settings &settings)
         }
     }
 
+    createWorldPartsTileTable();
+
+    m_navigationGraph = std::make_unique <WorldNavigationGraph> (*this, m_worldParts);
+
+    // entities outside of m_bounds are still handled by the grid (they are kept in border cells)
+    m_entitySpatialGrid = std::make_unique <EntitySpatialGrid> (m_bounds, k_entitySpatialGridCellSize);
+    m_sleepingEntitiesSpatialGrid = std::make_unique <EntitySpatialGrid> (m_bounds, k_sleepingEntitiesSpatialGridCellSize);
+
     for(const auto &elem : m_worldParts) {
         E_DASSERT(elem, "World part is nullptr.");
         elem->generateEntities(*this);
@@ -133,24 +145,45 @@ void World::update()
 {
     TRACK;
 
+    m_pathFindingBudget = k_pathFindingNodeExpansionsPerFrame;
+
     m_dateTimeManager.update();
     m_spawnManager.update();
 
+    wakeUpEntities();
+
+    // only active (not sleeping) entities are visited here
+    m_isUpdatingEntities = true;
+
     for(auto it = m_entities_wantUpdate.begin(); it != m_entities_wantUpdate.end();) {
         E_DASSERT(it->second, "Entity is nullptr.");
 
         if(it->second->wantsToBeRemovedFromWorld()) {
+            if(it->second->blocksWorldPartFreePosFinderField())
+                releaseWorldPartFreePosFinderFieldAt(it->second->getInWorldPosition());
+
             it->second->onRemovedFromWorld();
 
             removeFromQuickAccessCachedEntities(*it->second);
+            forgetEntityActivity(*it->second);
+            m_entitySpatialGrid->remove(*it->second);
             it = m_entities_wantUpdate.erase(it);
         }
         else {
             it->second->onInWorldUpdate();
-            ++it;
+            E_COUNTER_ADD("Entities updated", 1);
+
+            if(tryPutEntityToSleep(*it->second)) {
+                m_entities_sleeping.emplace(it->first, it->second);
+                it = m_entities_wantUpdate.erase(it);
+            }
+            else
+                ++it;
         }
     }
 
+    m_isUpdatingEntities = false;
+
     updateElectricitySystems();
 }
 
@@ -162,7 +195,8 @@ void World::addEntity(const std::shared_ptr <Entity> &entity)
     auto ID = entity->getEntityID();
 
     if(m_entities_wantUpdate.find(ID) == m_entities_wantUpdate.end() &&
-       m_entities_dontWantUpdate.find(ID) == m_entities_dontWantUpdate.end()) {
+       m_entities_dontWantUpdate.find(ID) == m_entities_dontWantUpdate.end() &&
+       m_entities_sleeping.find(ID) == m_entities_sleeping.end()) {
         if(entity->wantsEverInWorldUpdate())
             m_entities_wantUpdate.emplace(ID, entity);
         else
@@ -170,6 +204,9 @@ void World::addEntity(const std::shared_ptr <Entity> &entity)
 
         addToQuickAccessCachedEntities(entity);
 
+        E_DASSERT(m_entitySpatialGrid, "Entity spatial grid is nullptr.");
+        m_entitySpatialGrid->add(*entity);
+
         if(entity->blocksWorldPartFreePosFinderField())
             useWorldPartFreePosFinderFieldAt(entity->getInWorldPosition());
 
@@ -190,16 +227,13 @@ void World::removeEntity(int entityID)
     if(it1 != m_entities_dontWantUpdate.end()) {
         E_DASSERT(it1->second, "Entity is nullptr.");
 
-        if(it1->second->blocksWorldPartFreePosFinderField()) {
-            auto *worldPart = getWorldPart(it1->second->getInWorldPosition());
-
-            if(worldPart)
-                worldPart->setFreePosFinderDirty();
-        }
+        if(it1->second->blocksWorldPartFreePosFinderField())
+            releaseWorldPartFreePosFinderFieldAt(it1->second->getInWorldPosition());
 
         it1->second->onRemovedFromWorld();
 
         removeFromQuickAccessCachedEntities(*it1->second);
+        m_entitySpatialGrid->remove(*it1->second);
         m_entities_dontWantUpdate.erase(it1);
 
         return;
@@ -210,17 +244,33 @@ void World::removeEntity(int entityID)
     if(it2 != m_entities_wantUpdate.end()) {
         E_DASSERT(it2->second, "Entity is nullptr.");
 
-        if(it2->second->blocksWorldPartFreePosFinderField()) {
-            auto *worldPart = getWorldPart(it2->second->getInWorldPosition());
-
-            if(worldPart)
-                worldPart->setFreePosFinderDirty();
-        }
+        if(it2->second->blocksWorldPartFreePosFinderField())
+            releaseWorldPartFreePosFinderFieldAt(it2->second->getInWorldPosition());
 
         it2->second->onRemovedFromWorld();
 
         removeFromQuickAccessCachedEntities(*it2->second);
+        forgetEntityActivity(*it2->second);
+        m_entitySpatialGrid->remove(*it2->second);
         m_entities_wantUpdate.erase(it2);
+
+        return;
+    }
+
+    const auto &it3 = m_entities_sleeping.find(entityID);
+
+    if(it3 != m_entities_sleeping.end()) {
+        E_DASSERT(it3->second, "Entity is nullptr.");
+
+        if(it3->second->blocksWorldPartFreePosFinderField())
+            releaseWorldPartFreePosFinderFieldAt(it3->second->getInWorldPosition());
+
+        it3->second->onRemovedFromWorld();
+
+        removeFromQuickAccessCachedEntities(*it3->second);
+        forgetEntityActivity(*it3->second);
+        m_entitySpatialGrid->remove(*it3->second);
+        m_entities_sleeping.erase(it3);
     }
 }
 
@@ -236,6 +286,11 @@ bool World::entityExists(int entityID) const
     if(it2 != m_entities_wantUpdate.end())
         return true;
 
+    const auto &it3 = m_entities_sleeping.find(entityID);
+
+    if(it3 != m_entities_sleeping.end())
+        return true;
+
     return false;
 }
 
@@ -264,6 +319,13 @@ const std::shared_ptr <Entity> &World::getEntityPtr(int entityID) const
         return it2->second;
     }
 
+    const auto &it3 = m_entities_sleeping.find(entityID);
+
+    if(it3 != m_entities_sleeping.end()) {
+        E_DASSERT(it3->second, "Entity is nullptr.");
+        return it3->second;
+    }
+
     throw engine::Exception{"Could not find entity with ID \"" + std::to_string(entityID) + "\"."};
 }
 
@@ -275,21 +337,7 @@ int World::getUniqueEntityID()
 
 WorldPart *World::getWorldPart(const engine::FloatVec2 &pos) const
 {
-    auto it = std::find_if(m_worldParts.begin(), m_worldParts.end(), [&pos](const auto &elem) {
-        E_DASSERT(elem, "World part is nullptr.");
-
-        const auto &tilePosition = elem->getTilePosition();
-
-        return pos.x >= tilePosition.x * WorldPart::k_terrainSize &&
-               pos.x <= (tilePosition.x + 1) * WorldPart::k_terrainSize &&
-               pos.y >= tilePosition.y * WorldPart::k_terrainSize &&
-               pos.y <= (tilePosition.y + 1) * WorldPart::k_terrainSize;
-    });
-
-    if(it != m_worldParts.end())
-        return it->get();
-
-    return nullptr;
+    return getWorldPartAtTilePosition(posToTilePosition(pos));
 }
 
 WorldPart *World::getWorldPart(const engine::FloatVec3 &pos) const
@@ -316,6 +364,37 @@ float World::getHeight(const engine::FloatVec3 &pos) const
     return getHeight({pos.x, pos.z});
 }
 
+void World::getHeights(const std::vector <engine::FloatVec2> &positions, std::vector <float> &outHeights) const
+{
+    TRACK;
+
+    outHeights.resize(positions.size());
+
+    // positions are usually close to each other, so we resolve
+    // WorldPart only when tile position changes
+
+    WorldPart *worldPart{};
+    engine::IntVec2 worldPartTilePosition;
+    bool first{true};
+
+    for(size_t i = 0; i < positions.size(); ++i) {
+        const auto &tilePosition = posToTilePosition(positions[i]);
+
+        if(first || tilePosition != worldPartTilePosition) {
+            first = false;
+            worldPartTilePosition = tilePosition;
+            worldPart = getWorldPartAtTilePosition(tilePosition);
+        }
+
+        if(worldPart) {
+            outHeights[i] = worldPart->getHeight(positions[i].moved(-tilePosition.x * WorldPart::k_terrainSize,
+                                                                    -tilePosition.y * WorldPart::k_terrainSize));
+        }
+        else
+            outHeights[i] = 0.f;
+    }
+}
+
 float World::getSlope(const engine::FloatVec2 &pos) const
 {
     auto *worldPart = getWorldPart(pos);
@@ -374,20 +453,59 @@ const engine::FloatVec2 &World::getPlayerStartingPosition() const
     return m_playerStartingPosition;
 }
 
-void World::forEachEntity(std::function <void(Entity &)> func) const
+void World::onEntityMoved(Entity &entity, const engine::FloatVec3 &previousPos)
 {
-    if(!func)
-        throw engine::Exception{"Function is nullptr."};
+    if(m_entitySpatialGrid)
+        m_entitySpatialGrid->onEntityMoved(entity, previousPos);
 
-    for(auto it = m_entities_wantUpdate.begin(); it != m_entities_wantUpdate.end(); ++it) {
-        E_DASSERT(it->second, "Entity is nullptr.");
-        func(*it->second);
+    // awake entities report every frame even if they didn't leave their field; toggling its
+    // usage would invalidate free pos finder's path caches each time
+    if(entity.blocksWorldPartFreePosFinderField() &&
+       !isSameWorldPartFreePosFinderField(previousPos, entity.getInWorldPosition())) {
+        releaseWorldPartFreePosFinderFieldAt(previousPos);
+        useWorldPartFreePosFinderFieldAt(entity.getInWorldPosition());
     }
 
-    for(auto it = m_entities_dontWantUpdate.begin(); it != m_entities_dontWantUpdate.end(); ++it) {
-        E_DASSERT(it->second, "Entity is nullptr.");
-        func(*it->second);
-    }
+    // sleeping entities don't move by themselves, so something else moved it
+    if(!m_entities_sleeping.empty() && isEntitySleeping(entity.getEntityID()))
+        wakeUpEntity(entity.getEntityID());
+}
+
+void World::wakeUpEntity(int entityID)
+{
+    // we can't modify active entities container while iterating over it
+    if(m_isUpdatingEntities)
+        m_entitiesToWakeUp.push_back(entityID);
+    else
+        wakeUpEntity_internal(entityID);
+}
+
+void World::wakeUpEntityAfter(int entityID, double ms)
+{
+    m_entitiesWakeUpTimers.emplace(Global::getCore().getAppTime().getElapsedMs() + ms, entityID);
+}
+
+bool World::isEntitySleeping(int entityID) const
+{
+    return m_entities_sleeping.find(entityID) != m_entities_sleeping.end();
+}
+
+WorldNavigationGraph &World::getNavigationGraph()
+{
+    if(!m_navigationGraph)
+        throw engine::Exception{"Navigation graph is nullptr."};
+
+    return *m_navigationGraph;
+}
+
+int World::getPathFindingBudget() const
+{
+    return m_pathFindingBudget;
+}
+
+void World::consumePathFindingBudget(int nodesExpanded)
+{
+    m_pathFindingBudget = std::max(0, m_pathFindingBudget - nodesExpanded);
 }
 
 void World::playAmbientMusic(bool play)
@@ -431,6 +549,184 @@ World::~World()
 {
 }
 
+void World::wakeUpEntities()
+{
+    TRACK;
+
+    auto &core = Global::getCore();
+    double now{core.getAppTime().getElapsedMs()};
+
+    // timers
+
+    while(!m_entitiesWakeUpTimers.empty() && m_entitiesWakeUpTimers.top().first <= now) {
+        wakeUpEntity_internal(m_entitiesWakeUpTimers.top().second);
+        m_entitiesWakeUpTimers.pop();
+    }
+
+    // woken up during last update
+
+    for(auto entityID : m_entitiesToWakeUp) {
+        wakeUpEntity_internal(entityID);
+    }
+
+    m_entitiesToWakeUp.clear();
+
+    if(m_entities_sleeping.empty())
+        return;
+
+    // rigid bodies activated by physics engine
+
+    for(auto userIndex : core.getDevice().getPhysicsManager().getMovedRigidBodiesUserIndices()) {
+        wakeUpEntity_internal(userIndex);
+    }
+
+    // characters nearby
+
+    E_DASSERT(m_sleepingEntitiesSpatialGrid, "Sleeping entities spatial grid is nullptr.");
+
+    if(!m_sleepingEntitiesSpatialGrid->isEmpty()) {
+        forEachEntityOfType <Character> ([this](const Character &character) {
+            const auto &pos = character.getInWorldPosition();
+
+            m_sleepingEntitiesSpatialGrid->forEachEntityInRadius({pos.x, pos.z}, k_wakeUpEntitiesNearCharacterRadius, [this](const Entity &entity) {
+                m_entitiesToWakeUp.push_back(entity.getEntityID());
+            });
+        });
+
+        // grid can't be modified while it's queried, so entities are woken up here
+        for(auto entityID : m_entitiesToWakeUp) {
+            wakeUpEntity_internal(entityID);
+        }
+
+        m_entitiesToWakeUp.clear();
+    }
+}
+
+void World::wakeUpEntity_internal(int entityID)
+{
+    auto it = m_entities_sleeping.find(entityID);
+
+    if(it == m_entities_sleeping.end())
+        return;
+
+    E_DASSERT(it->second, "Entity is nullptr.");
+    E_DASSERT(m_sleepingEntitiesSpatialGrid, "Sleeping entities spatial grid is nullptr.");
+
+    m_sleepingEntitiesSpatialGrid->remove(*it->second);
+
+    // so entities woken up by nearby characters don't fall asleep right away
+    m_entitiesKeptAwakeUntil[entityID] = Global::getCore().getAppTime().getElapsedMs() + k_minAwakeTimeMs;
+
+    m_entities_wantUpdate.emplace(entityID, std::move(it->second));
+    m_entities_sleeping.erase(it);
+}
+
+bool World::tryPutEntityToSleep(Entity &entity)
+{
+    if(!entity.wantsToSleep() || entity.wantsToBeRemovedFromWorld())
+        return false;
+
+    auto it = m_entitiesKeptAwakeUntil.find(entity.getEntityID());
+
+    if(it != m_entitiesKeptAwakeUntil.end()) {
+        if(it->second > Global::getCore().getAppTime().getElapsedMs())
+            return false;
+
+        m_entitiesKeptAwakeUntil.erase(it);
+    }
+
+    if(entity.wakesUpWhenCharacterIsNear()) {
+        E_DASSERT(m_sleepingEntitiesSpatialGrid, "Sleeping entities spatial grid is nullptr.");
+        m_sleepingEntitiesSpatialGrid->add(entity);
+    }
+
+    return true;
+}
+
+void World::forgetEntityActivity(const Entity &entity)
+{
+    // wake up timers of removed entities are just ignored when they fire
+
+    m_entitiesKeptAwakeUntil.erase(entity.getEntityID());
+
+    if(m_sleepingEntitiesSpatialGrid)
+        m_sleepingEntitiesSpatialGrid->remove(entity);
+}
+
+void World::createWorldPartsTileTable()
+{
+    TRACK;
+
+    m_worldPartsTileTable.clear();
+    m_worldPartsTileTableRect = {};
+
+    if(m_worldParts.empty())
+        return;
+
+    engine::IntVec2 minTilePos;
+    engine::IntVec2 maxTilePos;
+    auto first = true;
+
+    for(const auto &elem : m_worldParts) {
+        E_DASSERT(elem, "World part is nullptr.");
+
+        const auto &tilePosition = elem->getTilePosition();
+
+        if(first) {
+            minTilePos = tilePosition;
+            maxTilePos = tilePosition;
+            first = false;
+        }
+        else {
+            minTilePos.x = std::min(minTilePos.x, tilePosition.x);
+            minTilePos.y = std::min(minTilePos.y, tilePosition.y);
+            maxTilePos.x = std::max(maxTilePos.x, tilePosition.x);
+            maxTilePos.y = std::max(maxTilePos.y, tilePosition.y);
+        }
+    }
+
+    m_worldPartsTileTableRect = {minTilePos, maxTilePos - minTilePos + engine::IntVec2{1, 1}};
+    m_worldPartsTileTable.resize(m_worldPartsTileTableRect.size.x * m_worldPartsTileTableRect.size.y, nullptr);
+
+    for(const auto &elem : m_worldParts) {
+        const auto &tilePosition = elem->getTilePosition() - minTilePos;
+        auto &slot = m_worldPartsTileTable[tilePosition.y * m_worldPartsTileTableRect.size.x + tilePosition.x];
+
+        // keep the first one, like linear search did
+        if(!slot)
+            slot = elem.get();
+    }
+}
+
+engine::IntVec2 World::posToTilePosition(const engine::FloatVec2 &pos) const
+{
+    engine::IntVec2 tilePosition{static_cast <int> (std::floor(pos.x / WorldPart::k_terrainSize)),
+                                 static_cast <int> (std::floor(pos.y / WorldPart::k_terrainSize))};
+
+    // WorldPart bounds are inclusive, so position exactly on the far world edge
+    // belongs to the last WorldPart, not to the (nonexistent) next one
+
+    const auto &farTilePosition = m_worldPartsTileTableRect.pos + m_worldPartsTileTableRect.size;
+
+    if(tilePosition.x == farTilePosition.x && pos.x == farTilePosition.x * WorldPart::k_terrainSize)
+        --tilePosition.x;
+
+    if(tilePosition.y == farTilePosition.y && pos.y == farTilePosition.y * WorldPart::k_terrainSize)
+        --tilePosition.y;
+
+    return tilePosition;
+}
+
+WorldPart *World::getWorldPartAtTilePosition(const engine::IntVec2 &tilePosition) const
+{
+    if(!m_worldPartsTileTableRect.contains(tilePosition))
+        return nullptr;
+
+    const auto &local = tilePosition - m_worldPartsTileTableRect.pos;
+
+    return m_worldPartsTileTable[local.y * m_worldPartsTileTableRect.size.x + local.x];
+}
+
 void World::useWorldPartFreePosFinderFieldAt(const engine::FloatVec2 &pos)
 {
     auto *worldPart = getWorldPart(pos);
@@ -448,6 +744,41 @@ void World::useWorldPartFreePosFinderFieldAt(const engine::FloatVec3 &pos)
     useWorldPartFreePosFinderFieldAt({pos.x, pos.z});
 }
 
+void World::releaseWorldPartFreePosFinderFieldAt(const engine::FloatVec2 &pos)
+{
+    auto *worldPart = getWorldPart(pos);
+
+    if(worldPart) {
+        const auto &tilePosition = worldPart->getTilePosition();
+
+        worldPart->releaseFreePosFinderFieldAt(pos.moved(-tilePosition.x * WorldPart::k_terrainSize,
+                                                         -tilePosition.y * WorldPart::k_terrainSize));
+    }
+}
+
+void World::releaseWorldPartFreePosFinderFieldAt(const engine::FloatVec3 &pos)
+{
+    releaseWorldPartFreePosFinderFieldAt({pos.x, pos.z});
+}
+
+bool World::isSameWorldPartFreePosFinderField(const engine::FloatVec3 &first, const engine::FloatVec3 &second) const
+{
+    auto *worldPart = getWorldPart(first);
+
+    if(worldPart != getWorldPart(second))
+        return false;
+
+    // both positions are outside of any WorldPart, so there is no field to update
+    if(!worldPart)
+        return true;
+
+    const auto &tilePosition = worldPart->getTilePosition();
+    engine::FloatVec2 offset{-tilePosition.x * WorldPart::k_terrainSize, -tilePosition.y * WorldPart::k_terrainSize};
+
+    return worldPart->isSameFreePosFinderField(engine::FloatVec2{first.x, first.z} + offset,
+                                               engine::FloatVec2{second.x, second.z} + offset);
+}
+
 void World::updateElectricitySystems()
 {
     // we need a copy because the container can be modified
@@ -473,6 +804,8 @@ void World::addToQuickAccessCachedEntities(const std::shared_ptr <Entity> &entit
     if(!entity)
         return;
 
+    m_entitiesByType.add(*entity);
+
     auto structure = std::dynamic_pointer_cast <Structure> (entity);
 
     if(structure && structure->getDef().usesElectricity())
@@ -481,6 +814,8 @@ void World::addToQuickAccessCachedEntities(const std::shared_ptr <Entity> &entit
 
 void World::removeFromQuickAccessCachedEntities(const Entity &entity)
 {
+    m_entitiesByType.remove(entity);
+
     auto it1 = m_structuresUsingElectricity.find(entity.getEntityID());
 
     if(it1 != m_structuresUsingElectricity.end())
@@ -488,5 +823,10 @@ void World::removeFromQuickAccessCachedEntities(const Entity &entity)
 }
 
 const std::string World::k_birdsAmbiencePath = "music/birds.ogg";
+const float World::k_entitySpatialGridCellSize{100.f};
+const float World::k_sleepingEntitiesSpatialGridCellSize{10.f};
+const float World::k_wakeUpEntitiesNearCharacterRadius{4.f};
+const double World::k_minAwakeTimeMs{1000.0};
+const int World::k_pathFindingNodeExpansionsPerFrame{4000};
 
 } // namespace app
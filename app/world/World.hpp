@@ -9,9 +9,13 @@
 #include "GroundType.hpp"
 #include "DateTimeManager.hpp"
 #include "SpawnManager.hpp"
+#include "EntitySpatialGrid.hpp"
+#include "EntitiesByType.hpp"
+#include "WorldNavigationGraph.hpp"
 
 #include <vector>
 #include <memory>
+#include <queue>
 #include <unordered_map>
 
 namespace engine { namespace app3D { class Water; class RigidBody; class Settings; } }
@@ -44,6 +48,7 @@ public:
     WorldPart *getWorldPart(const engine::FloatVec3 &pos) const;
     float getHeight(const engine::FloatVec2 &pos) const;
     float getHeight(const engine::FloatVec3 &pos) const;
+    void getHeights(const std::vector <engine::FloatVec2> &positions, std::vector <float> &outHeights) const;
     float getSlope(const engine::FloatVec2 &pos) const;
     float getSlope(const engine::FloatVec3 &pos) const;
     GroundType getGroundType(const engine::FloatVec2 &pos) const;
@@ -53,7 +58,19 @@ public:
     const engine::FloatRect &getBounds() const;
     const engine::FloatVec2 &getPlayerStartingPosition() const;
 
-    void forEachEntity(std::function <void(Entity &)> func) const;
+    template <typename Func> void forEachEntity(Func &&func) const;
+    template <typename T, typename Func> void forEachEntityOfType(Func &&func) const;
+    template <typename Func> void queryEntitiesInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const;
+    template <typename Func> void queryEntitiesInRadius(const engine::FloatVec3 &pos, float radius, Func &&func) const;
+    template <typename T, typename Func> void queryEntitiesOfTypeInRadius(const engine::FloatVec3 &pos, float radius, Func &&func) const;
+    template <typename Func> void queryEntitiesInRect(const engine::FloatRect &rect, Func &&func) const;
+    void onEntityMoved(Entity &entity, const engine::FloatVec3 &previousPos);
+    void wakeUpEntity(int entityID);
+    void wakeUpEntityAfter(int entityID, double ms);
+    bool isEntitySleeping(int entityID) const;
+    WorldNavigationGraph &getNavigationGraph();
+    int getPathFindingBudget() const;
+    void consumePathFindingBudget(int nodesExpanded);
     void playAmbientMusic(bool play);
 
     std::shared_ptr <ElectricitySystem> addElectricitySystem(std::shared_ptr <Structure> structureMember);
@@ -64,31 +81,108 @@ public:
     ~World();
 
 private:
+    void createWorldPartsTileTable();
+    engine::IntVec2 posToTilePosition(const engine::FloatVec2 &pos) const;
+    WorldPart *getWorldPartAtTilePosition(const engine::IntVec2 &tilePosition) const;
     void useWorldPartFreePosFinderFieldAt(const engine::FloatVec2 &pos);
     void useWorldPartFreePosFinderFieldAt(const engine::FloatVec3 &pos);
+    void releaseWorldPartFreePosFinderFieldAt(const engine::FloatVec2 &pos);
+    void releaseWorldPartFreePosFinderFieldAt(const engine::FloatVec3 &pos);
+    bool isSameWorldPartFreePosFinderField(const engine::FloatVec3 &first, const engine::FloatVec3 &second) const;
     void updateElectricitySystems();
+    void wakeUpEntities();
+    void wakeUpEntity_internal(int entityID);
+    bool tryPutEntityToSleep(Entity &entity);
+    void forgetEntityActivity(const Entity &entity);
 
     void addToQuickAccessCachedEntities(const std::shared_ptr <Entity> &entity);
     void removeFromQuickAccessCachedEntities(const Entity &entity);
 
     static const std::string k_birdsAmbiencePath;
+    static const float k_entitySpatialGridCellSize;
+    static const float k_sleepingEntitiesSpatialGridCellSize;
+    static const float k_wakeUpEntitiesNearCharacterRadius;
+    static const double k_minAwakeTimeMs;
+    static const int k_pathFindingNodeExpansionsPerFrame;
 
     DateTimeManager m_dateTimeManager;
     SpawnManager m_spawnManager;
     std::shared_ptr <engine::app3D::RigidBody> m_staticInfinitePlane;
     std::unordered_map <int, std::shared_ptr <Entity>> m_entities_wantUpdate;
     std::unordered_map <int, std::shared_ptr <Entity>> m_entities_dontWantUpdate;
+    std::unordered_map <int, std::shared_ptr <Entity>> m_entities_sleeping; // want update, but are not updated until woken up
     std::vector <std::unique_ptr <WorldPart>> m_worldParts;
+    std::vector <WorldPart*> m_worldPartsTileTable; // dense, indexed by tile position (see m_worldPartsTileTableRect)
+    engine::IntRect m_worldPartsTileTableRect;
+    std::unique_ptr <EntitySpatialGrid> m_entitySpatialGrid;
+    std::unique_ptr <WorldNavigationGraph> m_navigationGraph;
+    std::unique_ptr <EntitySpatialGrid> m_sleepingEntitiesSpatialGrid; // only sleeping entities which wake up when character is near
+    std::unordered_map <int, double> m_entitiesKeptAwakeUntil; // key: entityID, value: app time (ms)
+    std::priority_queue <std::pair <double, int>, std::vector <std::pair <double, int>>, std::greater <std::pair <double, int>>> m_entitiesWakeUpTimers; // app time (ms), entityID
+    std::vector <int> m_entitiesToWakeUp; // deferred while entities are updated
+    bool m_isUpdatingEntities;
     std::vector <std::shared_ptr <ElectricitySystem>> m_electricitySystems;
     int m_uniqueEntityID;
+    int m_pathFindingBudget; // node expansions left in this frame, shared by all NPCs
     engine::Music m_birdsAmbience;
     engine::FloatRect m_bounds;
     engine::FloatVec2 m_playerStartingPosition;
 
     // quick-access cached entities
     std::unordered_map <int, std::shared_ptr <Structure>> m_structuresUsingElectricity;
+    EntitiesByType <Entity> m_entitiesByType;
 };
 
+template <typename Func> void World::forEachEntity(Func &&func) const
+{
+    m_entitiesByType.forEach(func);
+}
+
+template <typename T, typename Func> void World::forEachEntityOfType(Func &&func) const
+{
+    m_entitiesByType.forEachOfType <T> (func);
+}
+
+template <typename Func> void World::queryEntitiesInRadius(const engine::FloatVec2 &pos, float radius, Func &&func) const
+{
+    E_DASSERT(m_entitySpatialGrid, "Entity spatial grid is nullptr.");
+
+    m_entitySpatialGrid->forEachEntityInRadius(pos, radius, func);
+}
+
+template <typename Func> void World::queryEntitiesInRadius(const engine::FloatVec3 &pos, float radius, Func &&func) const
+{
+    E_DASSERT(m_entitySpatialGrid, "Entity spatial grid is nullptr.");
+
+    float radiusSq{radius * radius};
+
+    // grid checks distance on XZ plane only, so we still have to check real 3D distance
+    m_entitySpatialGrid->forEachEntityInRadius({pos.x, pos.z}, radius, [&pos, radiusSq, &func](auto &entity) {
+        if(entity.getInWorldPosition().getDistanceSq(pos) <= radiusSq)
+            func(entity);
+    });
+}
+
+template <typename T, typename Func> void World::queryEntitiesOfTypeInRadius(const engine::FloatVec3 &pos, float radius, Func &&func) const
+{
+    E_DASSERT(m_entitySpatialGrid, "Entity spatial grid is nullptr.");
+
+    float radiusSq{radius * radius};
+
+    // grid checks distance on XZ plane only, so we still have to check real 3D distance
+    m_entitySpatialGrid->forEachEntityOfTypeInRadius <T> ({pos.x, pos.z}, radius, [&pos, radiusSq, &func](auto &entity) {
+        if(entity.getInWorldPosition().getDistanceSq(pos) <= radiusSq)
+            func(entity);
+    });
+}
+
+template <typename Func> void World::queryEntitiesInRect(const engine::FloatRect &rect, Func &&func) const
+{
+    E_DASSERT(m_entitySpatialGrid, "Entity spatial grid is nullptr.");
+
+    m_entitySpatialGrid->forEachEntityInRect(rect, func);
+}
+
 template <typename T> T &World::getEntityAndCast(int entityID) const
 {
     auto &entity = getEntity(entityID);
@@ -0,0 +1,401 @@
+#include "WorldNavigationGraph.hpp"
+
+#include "World.hpp"
+#include "WorldPart.hpp"
+#include "WorldPartFreePosFinder.hpp"
+#include "engine/util/Math.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace app
+{
+
+WorldNavigationGraph::WorldNavigationGraph(const World &world, const std::vector <std::unique_ptr <WorldPart>> &worldParts)
+{
+    TRACK;
+
+    for(const auto &elem : worldParts) {
+        E_DASSERT(elem, "World part is nullptr.");
+        m_worldParts[elem.get()];
+    }
+
+    // portals between each pair of adjacent WorldParts (every border is visited once)
+
+    for(const auto &elem : worldParts) {
+        const auto &tilePosition = elem->getTilePosition();
+
+        engine::FloatVec2 rightNeighborPos{(tilePosition.x + 1.5f) * WorldPart::k_terrainSize, (tilePosition.y + 0.5f) * WorldPart::k_terrainSize};
+        engine::FloatVec2 bottomNeighborPos{(tilePosition.x + 0.5f) * WorldPart::k_terrainSize, (tilePosition.y + 1.5f) * WorldPart::k_terrainSize};
+
+        const auto *rightNeighbor = world.getWorldPart(rightNeighborPos);
+        const auto *bottomNeighbor = world.getWorldPart(bottomNeighborPos);
+
+        if(rightNeighbor)
+            createPortals(*elem, *rightNeighbor, true);
+
+        if(bottomNeighbor)
+            createPortals(*elem, *bottomNeighbor, false);
+    }
+
+    for(const auto &elem : worldParts) {
+        createRegions(*elem);
+        connectNodesInWorldPart(*elem);
+    }
+}
+
+std::experimental::optional <engine::FloatVec2> WorldNavigationGraph::getNextPortal(const WorldPart &from, const engine::FloatVec2 &fromPos, const WorldPart &to, const engine::FloatVec2 &toPos)
+{
+    TRACK;
+
+    // A* on portal nodes, with two virtual nodes: start (fromPos) and goal (toPos)
+
+    const auto &fromInfoIt = m_worldParts.find(&from);
+    const auto &toInfoIt = m_worldParts.find(&to);
+
+    if(fromInfoIt == m_worldParts.end() || toInfoIt == m_worldParts.end() || &from == &to)
+        return std::experimental::optional <engine::FloatVec2> {};
+
+    int nodesCount = m_nodes.size();
+    int startNode{nodesCount};
+    int goalNode{nodesCount + 1};
+
+    m_scoreGWorkingVar.assign(nodesCount + 2, std::numeric_limits <float>::max());
+    m_cameFromWorkingVar.assign(nodesCount + 2, -1);
+    m_goalCostWorkingVar.assign(nodesCount, -1.f);
+
+    int fromRegion{getRegion(from, fromPos)};
+    int toRegion{getRegion(to, toPos)};
+
+    // nodes in other region of the target WorldPart are not connected to the goal
+
+    for(auto node : toInfoIt->second.nodes) {
+        if(toRegion < 0 || m_nodes[node].region == toRegion)
+            m_goalCostWorkingVar[node] = m_nodes[node].pos.getDistance(toPos);
+    }
+
+    const auto &getHeuristic = [this, &toPos, nodesCount](int node) {
+        if(node >= nodesCount)
+            return 0.f;
+
+        return m_nodes[node].pos.getDistance(toPos);
+    };
+
+    // (F score, node)
+    std::priority_queue <std::pair <float, int>, std::vector <std::pair <float, int>>, std::greater <std::pair <float, int>>> openSet;
+
+    const auto &relax = [this, &openSet, &getHeuristic](int node, int neighbor, float cost) {
+        float tentativeScoreG{m_scoreGWorkingVar[node] + cost};
+
+        if(tentativeScoreG < m_scoreGWorkingVar[neighbor]) {
+            m_scoreGWorkingVar[neighbor] = tentativeScoreG;
+            m_cameFromWorkingVar[neighbor] = node;
+            openSet.emplace(tentativeScoreG + getHeuristic(neighbor), neighbor);
+        }
+    };
+
+    m_scoreGWorkingVar[startNode] = 0.f;
+    openSet.emplace(getHeuristic(startNode), startNode);
+
+    while(!openSet.empty()) {
+        auto current = openSet.top();
+        openSet.pop();
+
+        int node{current.second};
+
+        if(node == goalNode)
+            break;
+
+        // skip outdated entries (node was already reached with lower score)
+        if(current.first > m_scoreGWorkingVar[node] + getHeuristic(node))
+            continue;
+
+        if(node == startNode) {
+            for(auto node2 : fromInfoIt->second.nodes) {
+                if(fromRegion < 0 || m_nodes[node2].region == fromRegion)
+                    relax(node, node2, fromPos.getDistance(m_nodes[node2].pos));
+            }
+
+            continue;
+        }
+
+        for(const auto &edge : m_nodes[node].edges) {
+            relax(node, edge.to, edge.cost);
+        }
+
+        if(m_goalCostWorkingVar[node] >= 0.f)
+            relax(node, goalNode, m_goalCostWorkingVar[node]);
+    }
+
+    if(m_cameFromWorkingVar[goalNode] < 0)
+        return std::experimental::optional <engine::FloatVec2> {};
+
+    // we need the first portal crossing on the path, so we look for the node
+    // which came from its other side (path is reconstructed backwards)
+
+    int crossingNode{-1};
+    int current{m_cameFromWorkingVar[goalNode]};
+    int iterationsGuard{};
+
+    while(current != startNode) {
+        ++iterationsGuard;
+        E_DASSERT(iterationsGuard < 1000000, "Probably infinite loop.");
+        E_DASSERT(current >= 0 && current < nodesCount, "Node index out of bounds.");
+
+        int previous{m_cameFromWorkingVar[current]};
+
+        if(previous != startNode && m_nodes[previous].otherSide == current)
+            crossingNode = current;
+
+        current = previous;
+    }
+
+    if(crossingNode < 0)
+        return std::experimental::optional <engine::FloatVec2> {};
+
+    return m_nodes[crossingNode].pos;
+}
+
+void WorldNavigationGraph::createPortals(const WorldPart &first, const WorldPart &second, bool horizontal)
+{
+    const auto &firstFinder = first.getFreePosFinder();
+    const auto &secondFinder = second.getFreePosFinder();
+
+    int size{firstFinder.getSize()};
+
+    if(size != secondFinder.getSize()) {
+        E_WARNING("Adjacent world parts have different free pos finder sizes, they won't be connected in navigation graph.");
+        return;
+    }
+
+    // horizontal: second is on the right of first, otherwise it's below
+
+    const auto &getFirstTile = [size, horizontal](int i) {
+        return horizontal ? engine::IntVec2{size - 1, i} : engine::IntVec2{i, size - 1};
+    };
+
+    const auto &getSecondTile = [horizontal](int i) {
+        return horizontal ? engine::IntVec2{0, i} : engine::IntVec2{i, 0};
+    };
+
+    const auto &addPortal = [&](int runStart, int runEnd) {
+        int middle{(runStart + runEnd) / 2};
+
+        int firstNode{addNode(first, getFirstTile(middle))};
+        int secondNode{addNode(second, getSecondTile(middle))};
+
+        m_nodes[firstNode].otherSide = secondNode;
+        m_nodes[secondNode].otherSide = firstNode;
+
+        float cost{m_nodes[firstNode].pos.getDistance(m_nodes[secondNode].pos)};
+
+        m_nodes[firstNode].edges.push_back({secondNode, cost});
+        m_nodes[secondNode].edges.push_back({firstNode, cost});
+    };
+
+    int runStart{-1};
+
+    for(int i = 0; i <= size; ++i) {
+        bool walkable{i < size &&
+                      firstFinder.isStaticallyPassThroughAble(getFirstTile(i)) &&
+                      secondFinder.isStaticallyPassThroughAble(getSecondTile(i))};
+
+        if(walkable && runStart < 0)
+            runStart = i;
+        else if(!walkable && runStart >= 0) {
+            // long runs are split into a few portals, so paths don't have to go through the middle of long coasts
+
+            for(int from = runStart; from < i; from += k_maxPortalWidth) {
+                addPortal(from, std::min(from + k_maxPortalWidth, i) - 1);
+            }
+
+            runStart = -1;
+        }
+    }
+}
+
+int WorldNavigationGraph::addNode(const WorldPart &worldPart, const engine::IntVec2 &localTile)
+{
+    const auto &tilePosition = worldPart.getTilePosition();
+    const auto &localPos = worldPart.getFreePosFinder().getTileCenter(localTile);
+
+    m_nodes.emplace_back();
+
+    auto &node = m_nodes.back();
+
+    node.worldPart = &worldPart;
+    node.localTile = localTile;
+    node.pos = localPos.moved(tilePosition.x * WorldPart::k_terrainSize, tilePosition.y * WorldPart::k_terrainSize);
+    node.region = -1;
+    node.otherSide = -1;
+
+    int index = m_nodes.size() - 1;
+
+    m_worldParts[&worldPart].nodes.push_back(index);
+
+    return index;
+}
+
+void WorldNavigationGraph::createRegions(const WorldPart &worldPart)
+{
+    TRACK;
+
+    // coarse grid cell is walkable if any of its fields is walkable (so narrow passages are not lost),
+    // it's an optimistic estimation, but paths are refined by WorldPartFreePosFinder anyway
+
+    auto &info = m_worldParts[&worldPart];
+    const auto &finder = worldPart.getFreePosFinder();
+
+    int size{finder.getSize()};
+
+    info.fieldsPerCoarseCell = std::max(1, (size + k_coarseGridSize - 1) / k_coarseGridSize);
+    info.coarseSize = (size + info.fieldsPerCoarseCell - 1) / info.fieldsPerCoarseCell;
+    info.regions.assign(info.coarseSize * info.coarseSize, -1);
+
+    std::vector <bool> walkable(info.regions.size());
+
+    for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+            if(finder.isStaticallyPassThroughAble(engine::IntVec2{x, y})) {
+                const auto &cell = localTileToCoarseCell(info, {x, y});
+                walkable[cell.y * info.coarseSize + cell.x] = true;
+            }
+        }
+    }
+
+    // flood fill
+
+    int regionsCount{};
+    std::vector <int> queue;
+
+    for(size_t i = 0; i < walkable.size(); ++i) {
+        if(!walkable[i] || info.regions[i] >= 0)
+            continue;
+
+        queue.clear();
+        queue.push_back(i);
+        info.regions[i] = regionsCount;
+
+        for(size_t j = 0; j < queue.size(); ++j) {
+            int cell{queue[j]};
+            int x{cell % info.coarseSize};
+            int y{cell / info.coarseSize};
+
+            int neighbors[4]{x > 0 ? cell - 1 : -1,
+                             x < info.coarseSize - 1 ? cell + 1 : -1,
+                             y > 0 ? cell - info.coarseSize : -1,
+                             y < info.coarseSize - 1 ? cell + info.coarseSize : -1};
+
+            for(auto neighbor : neighbors) {
+                if(neighbor >= 0 && walkable[neighbor] && info.regions[neighbor] < 0) {
+                    info.regions[neighbor] = regionsCount;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+
+        ++regionsCount;
+    }
+}
+
+void WorldNavigationGraph::connectNodesInWorldPart(const WorldPart &worldPart)
+{
+    TRACK;
+
+    auto &info = m_worldParts[&worldPart];
+
+    E_DASSERT(info.coarseSize, "Coarse size is 0.");
+
+    float coarseCellSize{WorldPart::k_terrainSize / info.coarseSize};
+
+    for(auto node : info.nodes) {
+        const auto &cell = localTileToCoarseCell(info, m_nodes[node].localTile);
+        m_nodes[node].region = info.regions[cell.y * info.coarseSize + cell.x];
+    }
+
+    // BFS on coarse grid from each node, cost is the number of steps (but never less than straight line distance)
+
+    std::vector <int> steps;
+    std::vector <int> queue;
+
+    for(auto node : info.nodes) {
+        if(m_nodes[node].region < 0)
+            continue;
+
+        const auto &startCell = localTileToCoarseCell(info, m_nodes[node].localTile);
+        int start{startCell.y * info.coarseSize + startCell.x};
+
+        steps.assign(info.regions.size(), -1);
+        queue.clear();
+        queue.push_back(start);
+        steps[start] = 0;
+
+        for(size_t j = 0; j < queue.size(); ++j) {
+            int cell{queue[j]};
+            int x{cell % info.coarseSize};
+            int y{cell / info.coarseSize};
+
+            int neighbors[4]{x > 0 ? cell - 1 : -1,
+                             x < info.coarseSize - 1 ? cell + 1 : -1,
+                             y > 0 ? cell - info.coarseSize : -1,
+                             y < info.coarseSize - 1 ? cell + info.coarseSize : -1};
+
+            for(auto neighbor : neighbors) {
+                if(neighbor >= 0 && info.regions[neighbor] >= 0 && steps[neighbor] < 0) {
+                    steps[neighbor] = steps[cell] + 1;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+
+        for(auto node2 : info.nodes) {
+            if(node2 == node || m_nodes[node2].region != m_nodes[node].region)
+                continue;
+
+            const auto &cell = localTileToCoarseCell(info, m_nodes[node2].localTile);
+            int cellSteps{steps[cell.y * info.coarseSize + cell.x]};
+
+            E_DASSERT(cellSteps >= 0, "Node in the same region was not reached.");
+
+            float cost{std::max(cellSteps * coarseCellSize, m_nodes[node].pos.getDistance(m_nodes[node2].pos))};
+
+            m_nodes[node].edges.push_back({node2, cost});
+        }
+    }
+}
+
+int WorldNavigationGraph::getRegion(const WorldPart &worldPart, const engine::FloatVec2 &pos) const
+{
+    const auto &it = m_worldParts.find(&worldPart);
+
+    if(it == m_worldParts.end() || !it->second.coarseSize)
+        return -1;
+
+    const auto &info = it->second;
+    const auto &tilePosition = worldPart.getTilePosition();
+
+    int size{worldPart.getFreePosFinder().getSize()};
+    float fieldSize{WorldPart::k_terrainSize / size};
+
+    engine::IntVec2 localTile{engine::Math::clamp(static_cast <int> (std::floor((pos.x - tilePosition.x * WorldPart::k_terrainSize) / fieldSize)), 0, size - 1),
+                              engine::Math::clamp(static_cast <int> (std::floor((pos.y - tilePosition.y * WorldPart::k_terrainSize) / fieldSize)), 0, size - 1)};
+
+    const auto &cell = localTileToCoarseCell(info, localTile);
+
+    return info.regions[cell.y * info.coarseSize + cell.x];
+}
+
+engine::IntVec2 WorldNavigationGraph::localTileToCoarseCell(const WorldPartInfo &info, const engine::IntVec2 &localTile) const
+{
+    E_DASSERT(info.fieldsPerCoarseCell, "Fields per coarse cell is 0.");
+
+    return {std::min(localTile.x / info.fieldsPerCoarseCell, info.coarseSize - 1),
+            std::min(localTile.y / info.fieldsPerCoarseCell, info.coarseSize - 1)};
+}
+
+const int WorldNavigationGraph::k_coarseGridSize{100};
+const int WorldNavigationGraph::k_maxPortalWidth{125};
+
+} // namespace app
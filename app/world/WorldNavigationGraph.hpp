@@ -0,0 +1,80 @@
+#ifndef APP_WORLD_NAVIGATION_GRAPH_HPP
+#define APP_WORLD_NAVIGATION_GRAPH_HPP
+
+#include "engine/ext/optional.hpp"
+#include "engine/util/Trace.hpp"
+#include "engine/util/Vec2.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace app
+{
+
+class World;
+class WorldPart;
+
+/* Abstract (HPA*-style) graph used for paths between WorldParts. Nodes are portals: runs of
+ * tiles walkable on both sides of a border between two adjacent WorldParts (long runs are split).
+ * Every portal has a node on each side, and nodes in the same WorldPart are connected if they are
+ * in the same connected region, with cost estimated on a coarse walkability grid.
+ * It's built once from static walkability (slope and water), so it does not know about entities.
+ * Long-range queries run on this graph, and only the path to the next portal is refined
+ * by WorldPartFreePosFinder.
+ */
+class WorldNavigationGraph : public engine::Tracked <WorldNavigationGraph>
+{
+public:
+    WorldNavigationGraph(const World &world, const std::vector <std::unique_ptr <WorldPart>> &worldParts);
+
+    // returns position on the other side of the next portal (just outside of 'from' WorldPart)
+    std::experimental::optional <engine::FloatVec2> getNextPortal(const WorldPart &from, const engine::FloatVec2 &fromPos, const WorldPart &to, const engine::FloatVec2 &toPos);
+
+private:
+    struct Edge
+    {
+        int to{};
+        float cost{};
+    };
+
+    struct Node
+    {
+        const WorldPart *worldPart{};
+        engine::IntVec2 localTile;
+        engine::FloatVec2 pos; // world pos
+        int region{};
+        int otherSide{};
+        std::vector <Edge> edges;
+    };
+
+    struct WorldPartInfo
+    {
+        std::vector <int> nodes;
+        std::vector <int> regions; // coarse grid, -1 if not walkable
+        int coarseSize{};
+        int fieldsPerCoarseCell{};
+    };
+
+    void createPortals(const WorldPart &first, const WorldPart &second, bool horizontal);
+    int addNode(const WorldPart &worldPart, const engine::IntVec2 &localTile);
+    void createRegions(const WorldPart &worldPart);
+    void connectNodesInWorldPart(const WorldPart &worldPart);
+    int getRegion(const WorldPart &worldPart, const engine::FloatVec2 &pos) const;
+    engine::IntVec2 localTileToCoarseCell(const WorldPartInfo &info, const engine::IntVec2 &localTile) const;
+
+    static const int k_coarseGridSize;
+    static const int k_maxPortalWidth;
+
+    std::vector <Node> m_nodes;
+    std::unordered_map <const WorldPart*, WorldPartInfo> m_worldParts;
+
+    // working vars, (so they don't reallocate memory each time they are used)
+    std::vector <float> m_scoreGWorkingVar;
+    std::vector <int> m_cameFromWorkingVar;
+    std::vector <float> m_goalCostWorkingVar;
+};
+
+} // namespace app
+
+#endif // APP_WORLD_NAVIGATION_GRAPH_HPP
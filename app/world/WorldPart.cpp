@@ -207,17 +207,36 @@ std::pair <engine::FloatVec3, bool> WorldPart::getPathFoundNextCheckpoint_worldP
     engine::FloatVec3 checkpoint;
     bool clearWay{};
 
+    // if the target is in another WorldPart, then we go to the next portal on the path found in navigation graph
+    // (free pos finder will path find to the closest tile in bounds, and then go directly to the portal's other side)
+
+    if(!engine::FloatRect{offset, {k_terrainSize, k_terrainSize}}.contains(to)) {
+        auto &world = Global::getCore().getWorld();
+        const auto *targetWorldPart = world.getWorldPart(to);
+
+        if(targetWorldPart) {
+            const auto &portal = world.getNavigationGraph().getNextPortal(*this, from, *targetWorldPart, to);
+
+            if(portal) {
+                std::tie(checkpoint, clearWay) = m_freePosFinder->getPathFoundNextCheckpoint(from - offset, *portal - offset);
+
+                if(clearWay)
+                    return std::make_pair(checkpoint + offset3d, clearWay);
+            }
+        }
+    }
+
     std::tie(checkpoint, clearWay) = m_freePosFinder->getPathFoundNextCheckpoint(from - offset, to - offset);
 
     return std::make_pair(checkpoint + offset3d, clearWay);
 }
 
-void WorldPart::setFreePosFinderDirty()
+void WorldPart::releaseFreePosFinderFieldAt(const engine::FloatVec2 &pos)
 {
     if(!m_freePosFinder)
         throw engine::Exception{"Free pos finder is nullptr."};
 
-    m_freePosFinder->setDirty();
+    m_freePosFinder->releaseFieldAt(pos);
 }
 
 void WorldPart::useFreePosFinderFieldAt(const engine::FloatVec2 &pos)
@@ -228,6 +247,22 @@ void WorldPart::useFreePosFinderFieldAt(const engine::FloatVec2 &pos)
     m_freePosFinder->useFieldAt(pos);
 }
 
+bool WorldPart::isSameFreePosFinderField(const engine::FloatVec2 &first, const engine::FloatVec2 &second) const
+{
+    if(!m_freePosFinder)
+        throw engine::Exception{"Free pos finder is nullptr."};
+
+    return m_freePosFinder->isSameField(first, second);
+}
+
+const WorldPartFreePosFinder &WorldPart::getFreePosFinder() const
+{
+    if(!m_freePosFinder)
+        throw engine::Exception{"Free pos finder is nullptr."};
+
+    return *m_freePosFinder;
+}
+
 WorldPartDef &WorldPart::getDef() const
 {
     if(!m_worldPartDef)
@@ -254,7 +289,7 @@ void WorldPart::addTerrainAndWater()
     m_terrain->setPosition(offset);
 
     m_topography = std::make_shared <WorldPartTopographyInfo> (*m_terrain);
-    m_freePosFinder = std::make_shared <WorldPartFreePosFinder> (*m_terrain, m_topography, offset);
+    m_freePosFinder = std::make_shared <WorldPartFreePosFinder> (*m_terrain, m_topography);
 
     m_water = sceneManager.addWater(terrainDef);
     m_water->setPosition({m_tilePosition.x * k_terrainSize + k_terrainSize * 0.5f, k_waterHeight, m_tilePosition.y * k_terrainSize + k_terrainSize * 0.5f});
@@ -35,8 +35,10 @@ public:
     GroundType getGroundType(const engine::FloatVec2 &pos) const;
     std::experimental::optional <engine::FloatVec3> getRandomPosMatching_worldPos(const PlacementPredicates &predicates);
     std::pair <engine::FloatVec3, bool> getPathFoundNextCheckpoint_worldPos(const engine::FloatVec2 &from, const engine::FloatVec2 &to);
-    void setFreePosFinderDirty();
     void useFreePosFinderFieldAt(const engine::FloatVec2 &pos);
+    void releaseFreePosFinderFieldAt(const engine::FloatVec2 &pos);
+    bool isSameFreePosFinderField(const engine::FloatVec2 &first, const engine::FloatVec2 &second) const;
+    const WorldPartFreePosFinder &getFreePosFinder() const;
     WorldPartDef &getDef() const;
 
     static const float k_terrainSize;
@@ -2,27 +2,28 @@
 
 #include "engine/app3D/sceneNodes/Terrain.hpp"
 #include "engine/app3D/defs/TerrainDef.hpp"
-#include "../entities/Entity.hpp"
+#include "engine/util/Metrics.hpp"
 #include "../Global.hpp"
 #include "../Core.hpp"
 #include "World.hpp"
 #include "WorldPartTopographyInfo.hpp"
 
-#include <queue>
+#include <algorithm>
 
 namespace app
 {
 
-WorldPartFreePosFinder::WorldPartFreePosFinder(const engine::app3D::Terrain &terrain, const std::shared_ptr <WorldPartTopographyInfo> &topography, const engine::FloatVec3 &entitiesInWorldPosOffset)
-    : m_AStarComparator{*this},
-      m_entitiesInWorldPosOffset{entitiesInWorldPosOffset},
-      m_dirty{},
-      m_topography{topography},
+WorldPartFreePosFinder::WorldPartFreePosFinder(const engine::app3D::Terrain &terrain, const std::shared_ptr <WorldPartTopographyInfo> &topography)
+    : m_topography{topography},
       m_terrainDef{terrain.getDefPtr()},
       m_size{},
       m_boolTrue{1},
-      m_neighborNodesWorkingVar(4, 0),
-      m_openSetWorkingVar(m_AStarComparator)
+      m_hasSuspendedSearch{},
+      m_suspendedSearchStartNode{},
+      m_suspendedSearchEndNode{},
+      m_suspendedSearchIterations{},
+      m_nextCachedPathID{},
+      m_neighborNodesWorkingVar(4, 0)
 {
     TRACK;
 
@@ -35,30 +36,38 @@ WorldPartFreePosFinder::WorldPartFreePosFinder(const engine::app3D::Terrain &ter
         throw engine::Exception{"Terrain scale can't be 0."};
 
     m_size = size;
-    m_fields.reserve(m_size * m_size);
 
-    for(int y = 0; y < size; ++y) {
-        for(int x = 0; x < size; ++x) {
-            engine::FloatVec2 pos{x * k_fieldSize + k_fieldSize / 2.f, y * k_fieldSize + k_fieldSize / 2.f};
+    createFields([&terrain](const engine::FloatVec2 &pos) {
+        return terrain.getHeight(pos);
+    });
+}
 
-            auto height = terrain.getHeight(pos);
-            m_fields.emplace_back();
-            m_fields.back().height = height;
-            m_fields.back().pos = {pos.x, height, pos.y};
-            m_fields.back().isSlopeWalkable = m_topography->getSlope({m_fields.back().pos.x, m_fields.back().pos.z}) <= k_maxWalkableSlope;
-        }
-    }
+WorldPartFreePosFinder::WorldPartFreePosFinder(int size, const std::function <float(const engine::FloatVec2 &)> &getHeight)
+    : m_size{size},
+      m_getHeight{getHeight},
+      m_boolTrue{1},
+      m_hasSuspendedSearch{},
+      m_suspendedSearchStartNode{},
+      m_suspendedSearchEndNode{},
+      m_suspendedSearchIterations{},
+      m_nextCachedPathID{},
+      m_neighborNodesWorkingVar(4, 0)
+{
+    TRACK;
 
-    createFieldsIndicesRandomShuffled();
+    if(m_size <= 0)
+        throw engine::Exception{"Size must be > 0."};
+
+    if(!m_getHeight)
+        throw engine::Exception{"Get height function is empty."};
+
+    createFields(m_getHeight);
 }
 
 std::experimental::optional <engine::FloatVec3> WorldPartFreePosFinder::getRandomPosMatching(const PlacementPredicates &predicates)
 {
     TRACK;
 
-    if(m_dirty)
-        recalculateUsedFields();
-
     // TODO FIXME: assuming that entity takes exactly 1 tile
 
     for(size_t i = 0; i < m_fieldsIndicesRandomShuffled.size(); ++i) {
@@ -68,7 +77,7 @@ std::experimental::optional <engine::FloatVec3> WorldPartFreePosFinder::getRando
 
         auto &field = m_fields[index];
 
-        if(field.isUsed)
+        if(field.usedCount)
             continue;
 
         if(predicates.getOnlyAboveWaterLevel() && field.height <= WorldPart::k_waterHeight)
@@ -77,14 +86,10 @@ std::experimental::optional <engine::FloatVec3> WorldPartFreePosFinder::getRando
         if(predicates.getOnlyBelowWaterLevel() && field.height >= WorldPart::k_waterHeight)
             continue;
 
-        E_DASSERT(m_topography, "Topography is nullptr.");
-
-        if(!predicates.getSlopeRange().isInRange(m_topography->getSlope({field.pos.x, field.pos.z})))
+        if(m_topography && !predicates.getSlopeRange().isInRange(m_topography->getSlope({field.pos.x, field.pos.z})))
             continue;
 
-        if(!predicates.isAllowedGround1() || !predicates.isAllowedGround2() || !predicates.isAllowedGround3()) {
-            E_DASSERT(m_terrainDef, "Terrain def is nullptr.");
-
+        if(m_terrainDef && (!predicates.isAllowedGround1() || !predicates.isAllowedGround2() || !predicates.isAllowedGround3())) {
             int groundType{m_terrainDef->getMostDominantGroundTextureIndex({field.pos.x, field.pos.z})};
 
             if(groundType == 0 && !predicates.isAllowedGround1())
@@ -110,9 +115,6 @@ std::pair <engine::FloatVec3, bool> WorldPartFreePosFinder::getPathFoundNextChec
 {
     TRACK;
 
-    if(m_dirty)
-        recalculateUsedFields();
-
     // this method returns a pair: position and a bool indicating whether there is a
     // clear way to returned position. If this bool is false, then it means that this
     // method used 'best effort' method to get to the target and does not guarantee
@@ -143,21 +145,24 @@ std::pair <engine::FloatVec3, bool> WorldPartFreePosFinder::getPathFoundNextChec
     if(!goStraightToTarget) {
         // now we run path finding algorithm (note that we try to reach toClosest, and not toTile)
 
-        bool found{runPathFindingAlgorithmOnFields(fromTile, toClosest)};
+        const auto *pathEntry = findPath(tileToNode(fromTile), tileToNode(toClosest));
 
-        if(found) {
+        if(pathEntry) {
             // we start looking for a checkpoint from the next tile after fromTile,
             // note that fromTile != toClosest (we checked it before) so we can safely
             // start from the next tile after fromTile
 
-            auto currentTile = getField(fromTile).goesTo;
+            const auto &it = m_cachedPaths.find(pathEntry->pathID);
+            E_DASSERT(it != m_cachedPaths.end(), "Could not find cached path.");
 
-            int iterationsGuard{};
+            const auto &path = it->second;
+            size_t index{pathEntry->indexInPath + 1};
 
-            while(currentTile != toClosest) {
-                ++iterationsGuard;
-                E_DASSERT(iterationsGuard < 1000000, "Probably infinite loop.");
+            E_DASSERT(index < path.size(), "Index in path out of bounds.");
+
+            auto currentTile = nodeToTile(path[index]);
 
+            while(currentTile != toClosest) {
                 // we search for first tile that touches any non-walkable tile,
                 // and then we'll go directly to it (it will be our 'checkpoint')
                 if(!isPassThroughAble(currentTile.movedX(-1)) ||
@@ -166,7 +171,10 @@ std::pair <engine::FloatVec3, bool> WorldPartFreePosFinder::getPathFoundNextChec
                    !isPassThroughAble(currentTile.movedY(1)))
                     break;
 
-                currentTile = getField(currentTile).goesTo;
+                ++index;
+                E_DASSERT(index < path.size(), "Index in path out of bounds.");
+
+                currentTile = nodeToTile(path[index]);
             }
 
             if(currentTile == toTile) {
@@ -182,11 +190,11 @@ std::pair <engine::FloatVec3, bool> WorldPartFreePosFinder::getPathFoundNextChec
             }
         }
         else
-            goStraightToTarget = true; // best effort
+            goStraightToTarget = true; // best effort (no path or out of path finding budget for this frame)
     }
 
     if(goStraightToTarget) {
-        float height{Global::getCore().getWorld().getHeight(to)};
+        float height{m_getHeight ? m_getHeight(to) : Global::getCore().getWorld().getHeight(to)};
         engine::FloatVec3 ret{to.x, height, to.y};
         return std::make_pair(ret, clearWay);
     }
@@ -198,48 +206,114 @@ void WorldPartFreePosFinder::useFieldAt(const engine::FloatVec2 &pos)
 {
     const auto &tile = realPosToTile(pos);
 
-    if(isInBounds(tile))
-        getField(tile).isUsed = true;
+    if(!isInBounds(tile))
+        return;
+
+    // TODO FIXME: assuming that entity takes exactly 1 tile
+
+    auto &field = getField(tile);
+
+    ++field.usedCount;
+
+    if(field.usedCount == 1)
+        onFieldUsageChanged(tileToNode(tile));
+}
+
+void WorldPartFreePosFinder::releaseFieldAt(const engine::FloatVec2 &pos)
+{
+    const auto &tile = realPosToTile(pos);
+
+    if(!isInBounds(tile))
+        return;
+
+    auto &field = getField(tile);
+
+    if(!field.usedCount) {
+        E_WARNING("Tried to release free pos finder field which is not used.");
+        return;
+    }
+
+    --field.usedCount;
+
+    if(!field.usedCount)
+        onFieldUsageChanged(tileToNode(tile));
 }
 
-void WorldPartFreePosFinder::setDirty()
+bool WorldPartFreePosFinder::isSameField(const engine::FloatVec2 &first, const engine::FloatVec2 &second) const
 {
-    m_dirty = true;
+    return realPosToTile(first) == realPosToTile(second);
 }
 
-bool WorldPartFreePosFinder::AStarComparator::operator () (int lhs, int rhs)
+int WorldPartFreePosFinder::getSize() const
 {
-    // std::tie has too big overhead in debug mode
-    //return std::tie(this->m_fields[lhs].scoreF, lhs) < std::tie(this->m_fields[rhs].scoreF, rhs);
+    return m_size;
+}
 
-    if(freePosFinder.m_fields[lhs].scoreF == freePosFinder.m_fields[rhs].scoreF)
-        return lhs < rhs;
-    else
-        return freePosFinder.m_fields[lhs].scoreF < freePosFinder.m_fields[rhs].scoreF;
+bool WorldPartFreePosFinder::isStaticallyPassThroughAble(const engine::IntVec2 &tile) const
+{
+    if(!isInBounds(tile))
+        return false;
+
+    return isStaticallyPassThroughAble(getField(tile));
+}
+
+engine::FloatVec2 WorldPartFreePosFinder::getTileCenter(const engine::IntVec2 &tile) const
+{
+    return {tile.x * k_fieldSize + k_fieldSize / 2.f,
+            tile.y * k_fieldSize + k_fieldSize / 2.f};
 }
 
-void WorldPartFreePosFinder::recalculateUsedFields()
+void WorldPartFreePosFinder::createFields(const std::function <float(const engine::FloatVec2 &)> &getHeight)
 {
     TRACK;
 
-    for(auto &field : m_fields) {
-        field.isUsed = false;
+    m_fields.reserve(m_size * m_size);
+
+    for(int y = 0; y < m_size; ++y) {
+        for(int x = 0; x < m_size; ++x) {
+            engine::FloatVec2 pos{x * k_fieldSize + k_fieldSize / 2.f, y * k_fieldSize + k_fieldSize / 2.f};
+
+            auto height = getHeight(pos);
+            m_fields.emplace_back();
+            m_fields.back().height = height;
+            m_fields.back().pos = {pos.x, height, pos.y};
+            m_fields.back().isSlopeWalkable = !m_topography || m_topography->getSlope({pos.x, pos.y}) <= k_maxWalkableSlope;
+        }
     }
 
-    const auto &world = Global::getCore().getWorld();
+    m_scoreF.resize(m_fields.size());
+    m_scoreG.resize(m_fields.size());
+    m_scoreH.resize(m_fields.size());
+    m_cameFrom.resize(m_fields.size());
+    m_openSetHeapIndex.resize(m_fields.size());
+    m_isInClosedSet.resize(m_fields.size());
+    m_isInOpenSet.resize(m_fields.size());
 
-    world.forEachEntity([this](auto &entity) {
-        if(entity.blocksWorldPartFreePosFinderField()) {
-            const auto &tile = this->realPosToTile(entity.getInWorldPosition() - this->m_entitiesInWorldPosOffset);
+    createFieldsIndicesRandomShuffled();
+}
 
-            // TODO FIXME: assuming that entity takes exactly 1 tile
+void WorldPartFreePosFinder::onFieldUsageChanged(int node)
+{
+    // suspended search could have already visited this node
+    m_hasSuspendedSearch = false;
 
-            if(this->isInBounds(tile))
-                this->getField(tile).isUsed = true;
-        }
-    });
+    // any change can make previously unreachable target reachable (or reachable within iterations limit)
+    m_cachedNoPath.clear();
+
+    // cached paths not going through this node are still valid
+    // (if it became free, they may not be optimal anymore, but that's fine)
+
+    const auto &it = m_cachedPathsThroughNode.find(node);
+
+    if(it == m_cachedPathsThroughNode.end())
+        return;
 
-    m_dirty = false;
+    auto pathIDs = std::move(it->second);
+    m_cachedPathsThroughNode.erase(it);
+
+    for(auto pathID : pathIDs) {
+        removeCachedPath(pathID);
+    }
 }
 
 void WorldPartFreePosFinder::createFieldsIndicesRandomShuffled()
@@ -258,164 +332,442 @@ void WorldPartFreePosFinder::createFieldsIndicesRandomShuffled()
     });
 }
 
+const WorldPartFreePosFinder::CachedPathEntry *WorldPartFreePosFinder::findPath(int startNode, int endNode)
+{
+    TRACK;
+
+    // many NPCs (e.g. the whole night wave) go to the same place, and every NPC asks
+    // for a path from every tile it walks through, so most requests are answered from cache
+
+    auto key = getPathKey(startNode, endNode);
+
+    const auto &it = m_cachedPathEntries.find(key);
+
+    if(it != m_cachedPathEntries.end())
+        return &it->second;
+
+    if(m_cachedNoPath.find(key) != m_cachedNoPath.end())
+        return nullptr;
+
+    auto result = runPathFindingAlgorithmOnFields(startNode, endNode);
+
+    if(result == PathFindingResult::NotFound) {
+        m_cachedNoPath.insert(key);
+        return nullptr;
+    }
+
+    if(result == PathFindingResult::OutOfBudget)
+        return nullptr;
+
+    if(m_cachedPaths.size() >= k_maxCachedPaths)
+        clearPathsCache();
+
+    int pathID{m_nextCachedPathID++};
+    auto &path = m_cachedPaths[pathID];
+
+    reconstructPathFindingAlgorithmPath(startNode, endNode, path);
+
+    // every node (except the last one) is a start of a subpath to endNode
+
+    for(size_t i = 0; i + 1 < path.size(); ++i) {
+        m_cachedPathEntries[getPathKey(path[i], endNode)] = {pathID, i};
+    }
+
+    for(auto node : path) {
+        m_cachedPathsThroughNode[node].push_back(pathID);
+    }
+
+    const auto &entryIt = m_cachedPathEntries.find(key);
+    E_DASSERT(entryIt != m_cachedPathEntries.end(), "Could not find just added path.");
+
+    return &entryIt->second;
+}
+
 /* A lot of work and testing has been put in making this algorithm.
  * Already tested candidates include:
  *  - Simple BFS (flood fill) using std::queue of IntVec2 - huge overhead even if end node is in straight line from start node. Too many nodes had to be checked before reaching target.
  *  - Simple BFS (flood fill) using std::deque of ints (exact field index) - faster than previous BFS, but still too slow. Too many nodes had to be checked before reaching target.
  *  - A* with std::set of IntVec2 for openset and closedset - adding/removing elements from std::set was the bottleneck. Too slow.
  *  - A* with heap in std::vector for openset (std::make_heap, std::push_heap, std::pop_heap); closedset implemented as O(1) expirable bools in each node - rebuilding whole heap (std::make_heap) when having to update F score for a node in the middle of the heap was the bottleneck.
- *    (if not for having to rebuild whole heap in O(n) it would be the fastest method probably).
- *  - Optimized A* with std::set of ints (exact field index) for openset; O(1) expirable bool for is-in-openset and is-in-closedset operations - this is the fastest method, and the one that is used currently. More info can be found in comments in the code.
+ *  - Optimized A* with std::set of ints (exact field index) for openset; O(1) expirable bool for is-in-openset and is-in-closedset operations.
+ * Currently used: A* with own binary heap which tracks index of each node in the heap, so updating F score is just sifting one node up in O(log n)
+ * (this removes the bottleneck of the std::make_heap version). Scores are kept in separate arrays, and we still use O(1) expirable bools.
+ * The search can be suspended when per-frame budget (shared between all NPCs) runs out, and resumed in the next frame.
+ * It runs backwards (from end node to start node), so the search tree is rooted at the goal and a suspended search can be resumed
+ * even if the NPC has moved in the meantime (only the heuristic has to be updated).
  */
-bool WorldPartFreePosFinder::runPathFindingAlgorithmOnFields(const engine::IntVec2 &start, const engine::IntVec2 &end)
+WorldPartFreePosFinder::PathFindingResult WorldPartFreePosFinder::runPathFindingAlgorithmOnFields(int startNode, int endNode)
 {
     TRACK;
 
-    // A* implementation
+    // A* implementation (backwards, see above)
 
-    E_DASSERT(isInBounds(start), "Start is out of bounds.");
-    E_DASSERT(isInBounds(end), "End is out of bounds.");
+    E_DASSERT(startNode >= 0 && static_cast <size_t> (startNode) < m_fields.size(), "Start is out of bounds.");
+    E_DASSERT(endNode >= 0 && static_cast <size_t> (endNode) < m_fields.size(), "End is out of bounds.");
     E_DASSERT(m_size, "Size is 0.");
     E_DASSERT(m_neighborNodesWorkingVar.size() == 4, "Neighbor nodes working var size is not 4.");
 
-    if(!isPassThroughAble(end)) // early-out
-        return false;
+    if(!isPassThroughAble(m_fields[endNode])) // early-out
+        return PathFindingResult::NotFound;
 
-    ++m_boolTrue; // expirable bool current true value
+    // without World there is no shared per-frame budget, only the iterations limit
+    auto *world = m_getHeight ? nullptr : &Global::getCore().getWorld();
+    int budget{world ? world->getPathFindingBudget() : k_maxPathFindingAlgorithmIterations};
 
-    if(m_boolTrue == std::numeric_limits <int>::max()) {
-        // all expirable bools should be set to 0 here,
-        // otherwise collisions can occur (very rare case though)
+    if(budget <= 0)
+        return PathFindingResult::OutOfBudget;
 
-        for(auto &elem : m_fields) {
-            elem.isInClosedSet = 0;
-            elem.isInOpenSet = 0;
-        }
+    int iterations{};
+
+    if(m_hasSuspendedSearch && m_suspendedSearchEndNode == endNode) {
+        // resume search from the previous frame, all its state is still valid
+        iterations = m_suspendedSearchIterations;
+
+        if(startNode != m_suspendedSearchStartNode) {
+            // the NPC has moved (or it's a different NPC going to the same place)
+
+            if(isReachedBySuspendedSearch(startNode))
+                return PathFindingResult::Found; // suspended search is kept, it's still valid for other start nodes
 
-        m_boolTrue = 1;
+            m_suspendedSearchStartNode = startNode;
+            openSetUpdateHeuristic(startNode);
+        }
     }
+    else {
+        ++m_boolTrue; // expirable bool current true value
 
-    int startNode{start.y * m_size + start.x};
-    int endNode{end.y * m_size + end.x};
+        if(m_boolTrue == std::numeric_limits <int>::max()) {
+            // all expirable bools should be set to 0 here,
+            // otherwise collisions can occur (very rare case though)
 
-    m_fields[startNode].scoreF = 0.f;
-    m_fields[startNode].scoreG = 0.f;
-    m_fields[startNode].scoreH = 0.f;
+            std::fill(m_isInClosedSet.begin(), m_isInClosedSet.end(), 0);
+            std::fill(m_isInOpenSet.begin(), m_isInOpenSet.end(), 0);
 
-    m_openSetWorkingVar.clear();
-    m_openSetWorkingVar.insert(startNode);
+            m_boolTrue = 1;
+        }
 
-    m_fields[startNode].isInOpenSet = m_boolTrue;
+        m_scoreF[endNode] = 0.f;
+        m_scoreG[endNode] = 0.f;
+        m_scoreH[endNode] = 0.f;
 
-    int iterations{};
+        m_openSetWorkingVar.clear();
+        openSetPush(endNode);
+    }
+
+    m_hasSuspendedSearch = false;
+
+    const auto &start = nodeToTile(startNode);
+    int iterationsInThisCall{};
+    auto result = PathFindingResult::NotFound;
 
     while(!m_openSetWorkingVar.empty()) {
+        if(iterationsInThisCall == budget) {
+            // out of budget, we'll continue in next frame (if someone asks for the same path)
+
+            m_hasSuspendedSearch = true;
+            m_suspendedSearchStartNode = startNode;
+            m_suspendedSearchEndNode = endNode;
+            m_suspendedSearchIterations = iterations;
+
+            result = PathFindingResult::OutOfBudget;
+            break;
+        }
+
         ++iterations;
+        ++iterationsInThisCall;
 
         if(iterations == k_maxPathFindingAlgorithmIterations) // there is an iterations limit
-            return false;
+            break;
 
-        // get node with lowest F score and remove it from the set
-        auto node = *m_openSetWorkingVar.begin();
-        m_openSetWorkingVar.erase(m_openSetWorkingVar.begin());
+        // get node with lowest F score and remove it from the open set
+        auto node = openSetPop();
 
-        // change expirable bool to false
-        m_fields[node].isInOpenSet = 0;
-
-        // did we reach our goal?
-        if(node == endNode) {
-            reconstructPathFindingAlgorithmPath(start, end);
-            return true;
+        // did we reach our goal? (start node, because we search backwards)
+        if(node == startNode) {
+            result = PathFindingResult::Found;
+            break;
         }
 
         // change expirable bool to true
-        m_fields[node].isInClosedSet = m_boolTrue;
+        m_isInClosedSet[node] = m_boolTrue;
 
         // calculate neighbor nodes
 
         size_t neighborsCount{};
 
-        if(node % m_size && isPassThroughAble(m_fields[node - 1])) { // left node
+        if(node % m_size && isPassThroughAbleOrStart(node - 1, startNode)) { // left node
             m_neighborNodesWorkingVar[neighborsCount] = node - 1;
             ++neighborsCount;
         }
 
-        if(node % m_size != m_size - 1 && isPassThroughAble(m_fields[node + 1])) { // right node
+        if(node % m_size != m_size - 1 && isPassThroughAbleOrStart(node + 1, startNode)) { // right node
             m_neighborNodesWorkingVar[neighborsCount] = node + 1;
             ++neighborsCount;
         }
 
-        if(node >= m_size && isPassThroughAble(m_fields[node - m_size])) { // up node
+        if(node >= m_size && isPassThroughAbleOrStart(node - m_size, startNode)) { // up node
             m_neighborNodesWorkingVar[neighborsCount] = node - m_size;
             ++neighborsCount;
         }
 
-        if(node + m_size < m_size * m_size && isPassThroughAble(m_fields[node + m_size])) { // down node
+        if(node + m_size < m_size * m_size && isPassThroughAbleOrStart(node + m_size, startNode)) { // down node
             m_neighborNodesWorkingVar[neighborsCount] = node + m_size;
             ++neighborsCount;
         }
 
-        float nodeScoreG{m_fields[node].scoreG};
+        float nodeScoreG{m_scoreG[node]};
 
         for(size_t i = 0; i < neighborsCount; ++i) {
             const auto &node2 = m_neighborNodesWorkingVar[i];
 
             // skip if already in closed set
-            if(m_fields[node2].isInClosedSet == m_boolTrue)
+            if(m_isInClosedSet[node2] == m_boolTrue)
                 continue;
 
             float tentativeScoreG{nodeScoreG + 1.f}; // distance between tiles is always 1 (not k_fieldSize)
 
             // if not in open set, add it
-            if(m_fields[node2].isInOpenSet != m_boolTrue) {
-                float distSq{engine::IntVec2{node2 % m_size, node2 / m_size}.getDistanceSq(end)};
-
-                auto &node2Field = m_fields[node2];
+            if(m_isInOpenSet[node2] != m_boolTrue) {
+                float distSq{nodeToTile(node2).getDistanceSq(start)};
 
                 // we use dist^4 as our heuristic so our algorithm will try to go directly at the target direction (good for open fields)
-                node2Field.scoreH = distSq * distSq;
-                node2Field.scoreG = tentativeScoreG;
-                node2Field.scoreF = node2Field.scoreG + node2Field.scoreH;
-                node2Field.cameFrom = {node % m_size, node / m_size};
-
-                // insert and mark as present in open set
-                m_openSetWorkingVar.insert(node2);
-                node2Field.isInOpenSet = m_boolTrue;
-            }
-            else if(tentativeScoreG < m_fields[node2].scoreG) {
-                // node2 is already in open set, but we have to update it
-                // (we have to remove it from the set, update it, and then add it again)
-
-                m_openSetWorkingVar.erase(m_openSetWorkingVar.find(node2));
+                m_scoreH[node2] = distSq * distSq;
+                m_scoreG[node2] = tentativeScoreG;
+                m_scoreF[node2] = tentativeScoreG + m_scoreH[node2];
+                m_cameFrom[node2] = node;
 
-                auto &node2Field = m_fields[node2];
+                openSetPush(node2);
+            }
+            else if(tentativeScoreG < m_scoreG[node2]) {
+                // node2 is already in open set, but we have to update it,
+                // F score can only decrease here, so the node can only go up in the heap
 
-                node2Field.cameFrom = {node % m_size, node / m_size};
-                node2Field.scoreG = tentativeScoreG;
-                node2Field.scoreF = node2Field.scoreG + node2Field.scoreH;
+                m_cameFrom[node2] = node;
+                m_scoreG[node2] = tentativeScoreG;
+                m_scoreF[node2] = tentativeScoreG + m_scoreH[node2];
 
-                m_openSetWorkingVar.insert(node2);
+                openSetSiftUp(m_openSetHeapIndex[node2]);
             }
         }
     }
 
-    return false;
+    if(world)
+        world->consumePathFindingBudget(iterationsInThisCall);
+
+    E_COUNTER_ADD("A* nodes expanded", iterationsInThisCall);
+
+    return result;
 }
 
-void WorldPartFreePosFinder::reconstructPathFindingAlgorithmPath(const engine::IntVec2 &start, engine::IntVec2 current)
+void WorldPartFreePosFinder::reconstructPathFindingAlgorithmPath(int startNode, int endNode, std::vector <int> &outPath) const
 {
     TRACK;
 
+    outPath.clear();
+
+    // search was backwards, so following came-from nodes gives the path from start to end
+
+    int current{startNode};
     int iterationsGuard{};
 
-    while(start != current) {
+    while(current != endNode) {
         ++iterationsGuard;
         E_DASSERT(iterationsGuard < 1000000, "Probably infinite loop.");
 
-        auto &field = getField(current);
-        getField(field.cameFrom).goesTo = current;
-        current = field.cameFrom;
+        outPath.push_back(current);
+        current = m_cameFrom[current];
+    }
+
+    outPath.push_back(endNode);
+}
+
+bool WorldPartFreePosFinder::isReachedBySuspendedSearch(int startNode)
+{
+    // nodes in the open set come from a node in the closed set, so their came-from chain is complete too
+
+    if(m_isInClosedSet[startNode] == m_boolTrue || m_isInOpenSet[startNode] == m_boolTrue)
+        return true;
+
+    // start node can be a used field (not pass-through-able), then it's never added to the open set,
+    // but it can be connected to an already closed neighbor
+
+    const auto &tile = nodeToTile(startNode);
+
+    for(const auto &neighbor : {tile.movedX(-1), tile.movedX(1), tile.movedY(-1), tile.movedY(1)}) {
+        if(!isInBounds(neighbor))
+            continue;
+
+        int neighborNode{tileToNode(neighbor)};
+
+        if(m_isInClosedSet[neighborNode] == m_boolTrue) {
+            m_cameFrom[startNode] = neighborNode;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorldPartFreePosFinder::removeCachedPath(int pathID)
+{
+    const auto &it = m_cachedPaths.find(pathID);
+
+    // it could have been already removed
+    if(it == m_cachedPaths.end())
+        return;
+
+    const auto &path = it->second;
+
+    E_DASSERT(!path.empty(), "Cached path is empty.");
+
+    int endNode{path.back()};
+
+    for(auto node : path) {
+        const auto &entryIt = m_cachedPathEntries.find(getPathKey(node, endNode));
+
+        // entry could have been overwritten by a newer path
+        if(entryIt != m_cachedPathEntries.end() && entryIt->second.pathID == pathID)
+            m_cachedPathEntries.erase(entryIt);
+
+        // node's list can be already gone (when it's the node which invalidated this path)
+        const auto &throughIt = m_cachedPathsThroughNode.find(node);
+
+        if(throughIt != m_cachedPathsThroughNode.end()) {
+            auto &pathIDs = throughIt->second;
+            const auto &idIt = std::find(pathIDs.begin(), pathIDs.end(), pathID);
+
+            if(idIt != pathIDs.end()) {
+                *idIt = pathIDs.back();
+                pathIDs.pop_back();
+            }
+
+            if(pathIDs.empty())
+                m_cachedPathsThroughNode.erase(throughIt);
+        }
     }
+
+    m_cachedPaths.erase(it);
+}
+
+void WorldPartFreePosFinder::clearPathsCache()
+{
+    m_cachedPaths.clear();
+    m_cachedPathEntries.clear();
+    m_cachedNoPath.clear();
+    m_cachedPathsThroughNode.clear();
+}
+
+std::uint64_t WorldPartFreePosFinder::getPathKey(int startNode, int endNode) const
+{
+    return (static_cast <std::uint64_t> (startNode) << 32) | static_cast <std::uint32_t> (endNode);
+}
+
+bool WorldPartFreePosFinder::openSetLess(int lhs, int rhs) const
+{
+    // std::tie has too big overhead in debug mode
+
+    if(m_scoreF[lhs] == m_scoreF[rhs])
+        return lhs < rhs;
+    else
+        return m_scoreF[lhs] < m_scoreF[rhs];
+}
+
+void WorldPartFreePosFinder::openSetPush(int node)
+{
+    m_isInOpenSet[node] = m_boolTrue;
+    m_openSetHeapIndex[node] = m_openSetWorkingVar.size();
+    m_openSetWorkingVar.push_back(node);
+
+    openSetSiftUp(m_openSetWorkingVar.size() - 1);
+}
+
+int WorldPartFreePosFinder::openSetPop()
+{
+    E_DASSERT(!m_openSetWorkingVar.empty(), "Open set is empty.");
+
+    int node{m_openSetWorkingVar.front()};
+
+    m_openSetWorkingVar.front() = m_openSetWorkingVar.back();
+    m_openSetHeapIndex[m_openSetWorkingVar.front()] = 0;
+    m_openSetWorkingVar.pop_back();
+
+    if(!m_openSetWorkingVar.empty())
+        openSetSiftDown(0);
+
+    // change expirable bool to false
+    m_isInOpenSet[node] = 0;
+
+    return node;
+}
+
+void WorldPartFreePosFinder::openSetUpdateHeuristic(int startNode)
+{
+    // heuristic is the distance to the start node, so all F scores change and the heap has to be rebuilt
+
+    const auto &start = nodeToTile(startNode);
+
+    for(auto node : m_openSetWorkingVar) {
+        float distSq{nodeToTile(node).getDistanceSq(start)};
+
+        m_scoreH[node] = distSq * distSq;
+        m_scoreF[node] = m_scoreG[node] + m_scoreH[node];
+    }
+
+    for(size_t i = m_openSetWorkingVar.size() / 2; i > 0; --i) {
+        openSetSiftDown(i - 1);
+    }
+}
+
+void WorldPartFreePosFinder::openSetSiftUp(size_t index)
+{
+    E_DASSERT(index < m_openSetWorkingVar.size(), "Index out of bounds.");
+
+    int node{m_openSetWorkingVar[index]};
+
+    while(index) {
+        size_t parent{(index - 1) / 2};
+        int parentNode{m_openSetWorkingVar[parent]};
+
+        if(!openSetLess(node, parentNode))
+            break;
+
+        m_openSetWorkingVar[index] = parentNode;
+        m_openSetHeapIndex[parentNode] = index;
+        index = parent;
+    }
+
+    m_openSetWorkingVar[index] = node;
+    m_openSetHeapIndex[node] = index;
+}
+
+void WorldPartFreePosFinder::openSetSiftDown(size_t index)
+{
+    E_DASSERT(index < m_openSetWorkingVar.size(), "Index out of bounds.");
+
+    int node{m_openSetWorkingVar[index]};
+    size_t size{m_openSetWorkingVar.size()};
+
+    while(true) {
+        size_t child{index * 2 + 1};
+
+        if(child >= size)
+            break;
+
+        if(child + 1 < size && openSetLess(m_openSetWorkingVar[child + 1], m_openSetWorkingVar[child]))
+            ++child;
+
+        int childNode{m_openSetWorkingVar[child]};
+
+        if(!openSetLess(childNode, node))
+            break;
+
+        m_openSetWorkingVar[index] = childNode;
+        m_openSetHeapIndex[childNode] = index;
+        index = child;
+    }
+
+    m_openSetWorkingVar[index] = node;
+    m_openSetHeapIndex[node] = index;
 }
 
 WorldPartFreePosFinder::Field &WorldPartFreePosFinder::getField(const engine::IntVec2 &tile)
@@ -437,12 +789,23 @@ bool WorldPartFreePosFinder::isInBounds(const engine::IntVec2 &tile) const
     return tile.x >= 0 && tile.x < m_size && tile.y >= 0 && tile.y < m_size;
 }
 
+bool WorldPartFreePosFinder::isStaticallyPassThroughAble(const Field &field) const
+{
+    return field.height < WorldPart::k_waterHeight || field.isSlopeWalkable;
+}
+
 bool WorldPartFreePosFinder::isPassThroughAble(const Field &field) const
 {
     if(field.height < WorldPart::k_waterHeight)
         return true;
 
-    return !field.isUsed && field.isSlopeWalkable;
+    return !field.usedCount && field.isSlopeWalkable;
+}
+
+bool WorldPartFreePosFinder::isPassThroughAbleOrStart(int node, int startNode) const
+{
+    // NPC can stand on a used field, but it still has to be reachable by the backwards search
+    return node == startNode || isPassThroughAble(m_fields[node]);
 }
 
 bool WorldPartFreePosFinder::isPassThroughAble(const engine::IntVec2 &tile) const
@@ -453,6 +816,18 @@ bool WorldPartFreePosFinder::isPassThroughAble(const engine::IntVec2 &tile) cons
     return isPassThroughAble(getField(tile));
 }
 
+engine::IntVec2 WorldPartFreePosFinder::nodeToTile(int node) const
+{
+    E_DASSERT(m_size, "Size is 0.");
+
+    return {node % m_size, node / m_size};
+}
+
+int WorldPartFreePosFinder::tileToNode(const engine::IntVec2 &tile) const
+{
+    return tile.y * m_size + tile.x;
+}
+
 engine::IntVec2 WorldPartFreePosFinder::realPosToTile(const engine::FloatVec2 &pos) const
 {
     return {static_cast <int> (std::floor(pos.x / k_fieldSize)),
@@ -475,5 +850,6 @@ engine::IntVec2 WorldPartFreePosFinder::getClosestTileInBoundsToTile(const engin
 const float WorldPartFreePosFinder::k_fieldSize{1.f};
 const float WorldPartFreePosFinder::k_maxWalkableSlope{0.4f};
 const int WorldPartFreePosFinder::k_maxPathFindingAlgorithmIterations{1600};
+const size_t WorldPartFreePosFinder::k_maxCachedPaths{512};
 
 } // namespace app
@@ -5,6 +5,12 @@
 #include "PlacementPredicates.hpp"
 #include "WorldPart.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 namespace engine { namespace app3D { class Terrain; class TerrainDef; } }
 
 namespace app
@@ -15,50 +21,73 @@ class WorldPartTopographyInfo;
 class WorldPartFreePosFinder
 {
 public:
-    WorldPartFreePosFinder(const engine::app3D::Terrain &terrain, const std::shared_ptr <WorldPartTopographyInfo> &topography, const engine::FloatVec3 &entitiesInWorldPosOffset);
+    WorldPartFreePosFinder(const engine::app3D::Terrain &terrain, const std::shared_ptr <WorldPartTopographyInfo> &topography);
+
+    // without Terrain and World (e.g. in benchmarks): every field has walkable slope, placement predicates
+    // don't check slope and ground, and path finding isn't limited by World's per-frame budget
+    WorldPartFreePosFinder(int size, const std::function <float(const engine::FloatVec2 &)> &getHeight);
 
     std::experimental::optional <engine::FloatVec3> getRandomPosMatching(const PlacementPredicates &predicates);
     std::pair <engine::FloatVec3, bool> getPathFoundNextCheckpoint(const engine::FloatVec2 &from, const engine::FloatVec2 &to);
     void useFieldAt(const engine::FloatVec2 &pos);
-    void setDirty();
+    void releaseFieldAt(const engine::FloatVec2 &pos);
+    bool isSameField(const engine::FloatVec2 &first, const engine::FloatVec2 &second) const;
+
+    // static walkability (ignores used fields), used to build navigation graph between WorldParts
+    int getSize() const;
+    bool isStaticallyPassThroughAble(const engine::IntVec2 &tile) const;
+    engine::FloatVec2 getTileCenter(const engine::IntVec2 &tile) const;
 
 private:
     struct Field
     {
         float height{};
-        bool isUsed{};
+        int usedCount{}; // number of entities occupying this field
         bool isSlopeWalkable{};
         engine::FloatVec3 pos;
-
-        // A* or BFS
-        float scoreF{}, scoreG{}, scoreH{};
-        engine::IntVec2 cameFrom, goesTo;
-        //bool visited{};
-
-        // expirable bools
-        int isInClosedSet{};
-        int isInOpenSet{};
     };
 
-    struct AStarComparator
+    enum class PathFindingResult
     {
-        bool operator () (int lhs, int rhs);
-
-        WorldPartFreePosFinder &freePosFinder;
+        Found,
+        NotFound,
+        OutOfBudget
     };
 
-    friend struct AStarComparator;
+    struct CachedPathEntry
+    {
+        int pathID{};
+        size_t indexInPath{};
+    };
 
-    void recalculateUsedFields();
+    void createFields(const std::function <float(const engine::FloatVec2 &)> &getHeight);
+    void onFieldUsageChanged(int node);
     void createFieldsIndicesRandomShuffled();
-    bool runPathFindingAlgorithmOnFields(const engine::IntVec2 &start, const engine::IntVec2 &end);
-    void reconstructPathFindingAlgorithmPath(const engine::IntVec2 &start, engine::IntVec2 current);
+    const CachedPathEntry *findPath(int startNode, int endNode);
+    PathFindingResult runPathFindingAlgorithmOnFields(int startNode, int endNode);
+    void reconstructPathFindingAlgorithmPath(int startNode, int endNode, std::vector <int> &outPath) const;
+    bool isReachedBySuspendedSearch(int startNode);
+    void removeCachedPath(int pathID);
+    void clearPathsCache();
+    std::uint64_t getPathKey(int startNode, int endNode) const;
+
+    // binary heap (open set), ordered by F score
+    bool openSetLess(int lhs, int rhs) const;
+    void openSetPush(int node);
+    int openSetPop();
+    void openSetUpdateHeuristic(int startNode);
+    void openSetSiftUp(size_t index);
+    void openSetSiftDown(size_t index);
 
     Field &getField(const engine::IntVec2 &tile);
     const Field &getField(const engine::IntVec2 &tile) const;
     bool isInBounds(const engine::IntVec2 &tile) const;
+    bool isStaticallyPassThroughAble(const Field &field) const;
     bool isPassThroughAble(const Field &field) const;
     bool isPassThroughAble(const engine::IntVec2 &tile) const;
+    bool isPassThroughAbleOrStart(int node, int startNode) const;
+    engine::IntVec2 nodeToTile(int node) const;
+    int tileToNode(const engine::IntVec2 &tile) const;
     engine::IntVec2 realPosToTile(const engine::FloatVec2 &pos) const;
     engine::IntVec2 realPosToTile(const engine::FloatVec3 &pos) const;
     engine::IntVec2 getClosestTileInBoundsToTile(const engine::IntVec2 &tile) const;
@@ -66,21 +95,42 @@ private:
     static const float k_fieldSize;
     static const float k_maxWalkableSlope;
     static const int k_maxPathFindingAlgorithmIterations;
+    static const size_t k_maxCachedPaths;
 
-    const AStarComparator m_AStarComparator;
-    const engine::FloatVec3 m_entitiesInWorldPosOffset;
-
-    bool m_dirty;
     std::vector <int> m_fieldsIndicesRandomShuffled;
     std::vector <Field> m_fields;
     std::shared_ptr <WorldPartTopographyInfo> m_topography;
     std::shared_ptr <engine::app3D::TerrainDef> m_terrainDef;
     int m_size;
+    std::function <float(const engine::FloatVec2 &)> m_getHeight; // only if created without Terrain, then World isn't used either
+
+    // A* state, kept as structure of arrays (index: node), so the hot loop touches only what it needs
+    std::vector <float> m_scoreF;
+    std::vector <float> m_scoreG;
+    std::vector <float> m_scoreH;
+    std::vector <int> m_cameFrom;
+    std::vector <int> m_openSetHeapIndex; // valid only if node is in open set
+    std::vector <int> m_isInClosedSet; // expirable bools
+    std::vector <int> m_isInOpenSet; // expirable bools
     int m_boolTrue; // for expirable bools
 
+    // search which ran out of per-frame budget, it's resumed if a path to the same end node is requested again
+    // (from any start node, because the search runs backwards)
+    bool m_hasSuspendedSearch;
+    int m_suspendedSearchStartNode;
+    int m_suspendedSearchEndNode;
+    int m_suspendedSearchIterations;
+
+    // paths cache, every path is accessible from each of its nodes (so it can be reused while walking it)
+    std::unordered_map <int, std::vector <int>> m_cachedPaths; // key: path ID, value: nodes from start to end
+    std::unordered_map <std::uint64_t, CachedPathEntry> m_cachedPathEntries; // key: (start node, end node)
+    std::unordered_set <std::uint64_t> m_cachedNoPath; // key: (start node, end node)
+    std::unordered_map <int, std::vector <int>> m_cachedPathsThroughNode; // value: path IDs
+    int m_nextCachedPathID;
+
     // working vars, (so they don't reallocate memory each time they are used)
     std::vector <int> m_neighborNodesWorkingVar;
-    std::set <int, AStarComparator> m_openSetWorkingVar;
+    std::vector <int> m_openSetWorkingVar;
 };
 
 } // namespace app
@@ -0,0 +1,94 @@
+#include "Benchmark.hpp"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+namespace benchmarks
+{
+
+Benchmark::Registrar::Registrar(const std::string &name, Func func)
+{
+    getEntries().push_back({name, func});
+}
+
+int Benchmark::runAll(int argc, char *argv[])
+{
+    auto entries = getEntries();
+
+    std::sort(entries.begin(), entries.end(), [](const auto &first, const auto &second) {
+        return first.name < second.name;
+    });
+
+    int ret{};
+
+    for(const auto &elem : entries) {
+        bool selected{argc <= 1};
+
+        for(int i = 1; i < argc && !selected; ++i) {
+            if(elem.name.find(argv[i]) != std::string::npos)
+                selected = true;
+        }
+
+        if(!selected)
+            continue;
+
+        std::printf("--- %s ---\n", elem.name.c_str());
+
+        try {
+            Benchmark benchmark;
+            elem.func(benchmark);
+        }
+        catch(const std::exception &e) {
+            std::printf("Benchmark failed: %s\n", e.what());
+            ret = 1;
+        }
+
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    return ret;
+}
+
+void Benchmark::measure(const std::string &label, int iterations, const std::function <void()> &func)
+{
+    std::vector <qint64> nsecs;
+    nsecs.reserve(iterations);
+
+    func();
+
+    for(int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+
+        func();
+
+        nsecs.push_back(timer.nsecsElapsed());
+    }
+
+    if(nsecs.empty())
+        return;
+
+    std::sort(nsecs.begin(), nsecs.end());
+
+    std::printf("%-72s min %11.4f ms, median %11.4f ms (%d iterations)\n",
+                label.c_str(), nsecs.front() / 1000000.0, nsecs[nsecs.size() / 2] / 1000000.0, iterations);
+}
+
+void Benchmark::report(const std::string &label, double value, const std::string &unit)
+{
+    std::printf("%-72s %15.3f %s\n", label.c_str(), value, unit.c_str());
+}
+
+std::vector <Benchmark::Entry> &Benchmark::getEntries()
+{
+    // function local, so it's constructed before the first Registrar uses it
+    static std::vector <Entry> entries;
+
+    return entries;
+}
+
+} // namespace benchmarks
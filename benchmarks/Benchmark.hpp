@@ -0,0 +1,57 @@
+#ifndef BENCHMARKS_BENCHMARK_HPP
+#define BENCHMARKS_BENCHMARK_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+
+/* Benchmarks are registered by static Benchmark::Registrar objects and run by
+ * the benchmark target (qmake CONFIG+=benchmark). Results are printed to stdout.
+ */
+class Benchmark
+{
+public:
+    typedef void (*Func)(Benchmark &benchmark);
+
+    class Registrar
+    {
+    public:
+        Registrar(const std::string &name, Func func);
+    };
+
+    // runs benchmarks whose names contain any of the arguments (all if there are none),
+    // returns exit code
+    static int runAll(int argc, char *argv[]);
+
+    // calls func 'iterations' times (after one warm-up call) and reports the fastest and the median call
+    void measure(const std::string &label, int iterations, const std::function <void()> &func);
+
+    // reports a value which isn't time, e.g. draw calls or occupancy
+    void report(const std::string &label, double value, const std::string &unit);
+
+    // prevents the compiler from optimizing out the computation of 'value'
+    template <class T> static void keep(const T &value);
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Func func;
+    };
+
+    Benchmark() = default;
+
+    static std::vector <Entry> &getEntries();
+};
+
+template <class T> void Benchmark::keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace benchmarks
+
+#endif // BENCHMARKS_BENCHMARK_HPP
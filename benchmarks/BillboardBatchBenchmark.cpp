@@ -0,0 +1,87 @@
+#include "Benchmark.hpp"
+#include "../engine/app3D/irrNodes/BillboardBatch.hpp"
+#include "../engine/util/Random.hpp"
+
+#include <vector>
+
+namespace benchmarks
+{
+
+/* Expansion of a full batch (BillboardBatch::k_maxVertices is 50000, so 12500 billboards) to quads
+ * facing the camera:
+ * before - two normalized cross products per billboard on vector3df (like the old updateBillboards),
+ * after  - closed form right and up vectors from SoA positions, scalar path and SSE path.
+ */
+
+static void expandBillboards_crossProducts(const engine::app3D::irrNodes::BillboardBatch::BillboardsSoA &billboards, const irr::core::vector3df &camPos, irr::video::S3DVertex *outVertices)
+{
+    for(size_t i = 0; i < billboards.posX.size(); ++i) {
+        irr::core::vector3df pos{billboards.posX[i], billboards.posY[i], billboards.posZ[i]};
+        irr::core::vector3df cameraDiff{pos - camPos};
+
+        if(billboards.cameraDiffYFactor[i] == 0.f)
+            cameraDiff.Y = 0.f;
+
+        auto crossA = cameraDiff.crossProduct({0.f, 1.f, 0.f}).normalize();
+        auto crossB = cameraDiff.crossProduct(crossA).normalize();
+
+        crossA *= billboards.halfWidth[i];
+        crossB *= billboards.halfHeight[i];
+
+        auto *quad = outVertices + i * 4;
+
+        quad[0].Pos = pos + crossA - crossB;
+        quad[1].Pos = pos - crossA - crossB;
+        quad[2].Pos = pos - crossA + crossB;
+        quad[3].Pos = pos + crossA + crossB;
+    }
+}
+
+// per-frame update of a batch near its vertices limit: cross products against SoA scalar and SSE paths
+static void expandBillboards(Benchmark &benchmark)
+{
+    using engine::app3D::irrNodes::BillboardBatch;
+
+    const int k_billboardsCount{12500};
+    const int k_iterations{500};
+
+    BillboardBatch::BillboardsSoA billboards;
+
+    for(int i = 0; i < k_billboardsCount; ++i) {
+        billboards.posX.push_back(engine::Random::rangeInclusive(-100.f, 100.f));
+        billboards.posY.push_back(engine::Random::rangeInclusive(0.f, 10.f));
+        billboards.posZ.push_back(engine::Random::rangeInclusive(-100.f, 100.f));
+        billboards.halfWidth.push_back(engine::Random::rangeInclusive(0.25f, 1.f));
+        billboards.halfHeight.push_back(engine::Random::rangeInclusive(0.25f, 1.f));
+
+        // some horizontal billboards, like particles lying on the ground
+        billboards.cameraDiffYFactor.push_back(i % 10 ? 1.f : 0.f);
+    }
+
+    const irr::core::vector3df camPos{5.f, 30.f, -120.f};
+
+    std::vector <irr::video::S3DVertex> outVertices(k_billboardsCount * 4);
+
+    benchmark.measure("cross products, 12500 billboards", k_iterations, [&]() {
+        expandBillboards_crossProducts(billboards, camPos, outVertices.data());
+        Benchmark::keep(outVertices.back().Pos.X);
+    });
+
+    benchmark.measure("SoA scalar, 12500 billboards", k_iterations, [&]() {
+        BillboardBatch::expandBillboards(billboards, camPos, outVertices.data(), false);
+        Benchmark::keep(outVertices.back().Pos.X);
+    });
+
+#ifdef __SSE__
+    benchmark.measure("SoA SSE, 12500 billboards", k_iterations, [&]() {
+        BillboardBatch::expandBillboards(billboards, camPos, outVertices.data());
+        Benchmark::keep(outVertices.back().Pos.X);
+    });
+#else
+    benchmark.report("SSE path not compiled in (no __SSE__)", 0.0, "");
+#endif
+}
+
+static const Benchmark::Registrar k_expandBillboardsRegistrar{"BillboardBatch::expandBillboards", &expandBillboards};
+
+} // namespace benchmarks
@@ -0,0 +1,135 @@
+#include "Benchmark.hpp"
+#include "../engine/app3D/defs/ModelDef.hpp"
+#include "../engine/app3D/defs/TerrainDef.hpp"
+#include "../engine/app3D/defs/ParticleSpriteDef.hpp"
+#include "../engine/app3D/defs/ParticlesGroupModelDef.hpp"
+#include "../engine/app3D/defs/ParticlesGroupDef.hpp"
+#include "../engine/app3D/defs/SoundDef.hpp"
+#include "../engine/app3D/defs/LightDef.hpp"
+#include "../engine/util/DefDatabase.hpp"
+#include "../engine/util/ThreadPool.hpp"
+#include "../engine/util/Exception.hpp"
+
+#include <QDir>
+#include <QDirIterator>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+
+/* Startup def loading over the mods tree, run from workingDirectory (like the game).
+ * App defs need a running Core (textures, collision shapes), so two things are measured:
+ * - YAML parsing of every def file in the tree, which is most of the loading time,
+ * - loading engine ResourceDefs of every mod with DefDatabase (the first stage of Core::loadDefs),
+ * each sequentially and on worker threads. The compiled defs cache is not used.
+ */
+
+static const std::string k_modsPath{"mods"};
+
+static std::vector <std::string> getModPaths()
+{
+    std::vector <std::string> modPaths;
+
+    for(const auto &elem : QDir{k_modsPath.c_str()}.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        modPaths.push_back(k_modsPath + '/' + elem.toStdString());
+    }
+
+    if(modPaths.empty())
+        throw engine::Exception{"No mods found in \"" + k_modsPath + "\", benchmark must be run from workingDirectory."};
+
+    return modPaths;
+}
+
+static std::vector <std::string> getDefFilePaths()
+{
+    std::vector <std::string> filePaths;
+    QDirIterator dirIt{k_modsPath.c_str(), QDirIterator::Subdirectories};
+
+    while(dirIt.hasNext()) {
+        dirIt.next();
+
+        const auto &fileInfo = dirIt.fileInfo();
+
+        if(fileInfo.isFile() && fileInfo.suffix().toStdString() == "yaml")
+            filePaths.push_back(dirIt.filePath().toStdString());
+    }
+
+    std::sort(filePaths.begin(), filePaths.end());
+
+    return filePaths;
+}
+
+static void parseYAMLFile(const std::string &filePath)
+{
+    std::ifstream in{filePath};
+    YAML::Parser parser{in};
+    YAML::Node doc;
+
+    parser.GetNextDocument(doc);
+    Benchmark::keep(doc.size());
+}
+
+static void loadResourceDefs(const std::vector <std::string> &modPaths, bool parallel)
+{
+    engine::DefDatabase defDatabase;
+
+    defDatabase.setParallelLoading(parallel);
+
+    for(const auto &elem : modPaths) {
+        const auto &defsPath = elem + "/defs/";
+
+        defDatabase.queueDefs_directory <engine::app3D::ModelDef> (defsPath + "ModelDefs", "ModelDefs");
+        defDatabase.queueDefs_directory <engine::app3D::TerrainDef> (defsPath + "TerrainDefs", "TerrainDefs");
+        defDatabase.queueDefs_directory <engine::app3D::ParticleSpriteDef> (defsPath + "ParticleSpriteDefs", "ParticleSpriteDefs");
+        defDatabase.queueDefs_directory <engine::app3D::ParticlesGroupModelDef> (defsPath + "ParticlesGroupModelDefs", "ParticlesGroupModelDefs");
+        defDatabase.queueDefs_directory <engine::app3D::ParticlesGroupDef> (defsPath + "ParticlesGroupDefs", "ParticlesGroupDefs");
+        defDatabase.queueDefs_directory <engine::app3D::SoundDef> (defsPath + "SoundDefs", "SoundDefs");
+        defDatabase.queueDefs_directory <engine::app3D::LightDef> (defsPath + "LightDefs", "LightDefs");
+        defDatabase.loadQueuedDefs();
+    }
+}
+
+// DefDatabase parallel loading against sequential loading
+static void defsLoading(Benchmark &benchmark)
+{
+    const int k_iterations{10};
+
+    const auto &modPaths = getModPaths();
+    const auto &filePaths = getDefFilePaths();
+
+    benchmark.report("def files", filePaths.size(), "files");
+
+    benchmark.measure("parse all def files, sequential", k_iterations, [&filePaths]() {
+        for(const auto &elem : filePaths) {
+            parseYAMLFile(elem);
+        }
+    });
+
+    {
+        engine::ThreadPool threadPool{engine::ThreadPool::getDefaultWorkerThreadsCount()};
+
+        benchmark.report("worker threads", threadPool.getWorkerThreadsCount(), "threads");
+
+        benchmark.measure("parse all def files, parallel", k_iterations, [&filePaths, &threadPool]() {
+            threadPool.parallelFor(filePaths.size(), [&filePaths](size_t index) {
+                parseYAMLFile(filePaths[index]);
+            });
+        });
+    }
+
+    benchmark.measure("load ResourceDefs of all mods, sequential", k_iterations, [&modPaths]() {
+        loadResourceDefs(modPaths, false);
+    });
+
+    benchmark.measure("load ResourceDefs of all mods, parallel", k_iterations, [&modPaths]() {
+        loadResourceDefs(modPaths, true);
+    });
+}
+
+static const Benchmark::Registrar k_defsLoadingRegistrar{"DefDatabase loading", &defsLoading};
+
+} // namespace benchmarks
@@ -0,0 +1,142 @@
+#include "Benchmark.hpp"
+#include "../app/world/WorldPartFreePosFinder.hpp"
+#include "../app/world/WorldPart.hpp"
+#include "../engine/util/Random.hpp"
+#include "../engine/util/Math.hpp"
+#include "../engine/util/Vec2.hpp"
+
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+
+// how fields were updated before ref-counting: any change marked them dirty,
+// and the next query cleared them and walked every entity in the WorldPart
+static int rescanFields(const std::vector <engine::FloatVec2> &entities, int size, std::vector <int> &usedCount, std::vector <bool> &wasUsed)
+{
+    int changed{};
+
+    for(size_t i = 0; i < usedCount.size(); ++i) {
+        wasUsed[i] = usedCount[i] > 0;
+        usedCount[i] = 0;
+    }
+
+    for(const auto &elem : entities) {
+        usedCount[static_cast <int> (elem.y) * size + static_cast <int> (elem.x)] = 1;
+    }
+
+    for(size_t i = 0; i < usedCount.size(); ++i) {
+        if((usedCount[i] > 0) != wasUsed[i])
+            ++changed;
+    }
+
+    return changed;
+}
+
+// mining and building churn on a WorldPart sized finder: every step moves one entity, half of them
+// to a random field (mined here, built there) and half within a small distance (like a walking NPC)
+static void freePosFinderChurn(Benchmark &benchmark)
+{
+    const int k_size{static_cast <int> (app::WorldPart::k_terrainSize)};
+    const int k_steps{200};
+    const int k_pathsCount{50};
+    const float k_height{app::WorldPart::k_waterHeight + 5.f};
+
+    auto getRandomPos = [k_size]() {
+        return engine::FloatVec2{engine::Random::rangeExclusive(0.f, static_cast <float> (k_size)),
+                                 engine::Random::rangeExclusive(0.f, static_cast <float> (k_size))};
+    };
+
+    auto getNextPos = [k_size, &getRandomPos](const engine::FloatVec2 &pos) {
+        if(engine::Random::rangeInclusive(0, 1))
+            return getRandomPos();
+
+        return engine::FloatVec2{engine::Math::clamp(pos.x + engine::Random::rangeInclusive(-0.5f, 0.5f), 0.f, k_size - 0.01f),
+                                 engine::Math::clamp(pos.y + engine::Random::rangeInclusive(-0.5f, 0.5f), 0.f, k_size - 0.01f)};
+    };
+
+    for(int entitiesCount : {2000, 10000, 50000}) {
+        std::vector <engine::FloatVec2> entities(entitiesCount);
+
+        for(auto &elem : entities) {
+            elem = getRandomPos();
+        }
+
+        std::string suffix{", " + std::to_string(k_steps) + " steps, " + std::to_string(entitiesCount) + " entities"};
+
+        {
+            auto rescanEntities = entities;
+            std::vector <int> usedCount(k_size * k_size);
+            std::vector <bool> wasUsed(k_size * k_size);
+
+            benchmark.measure("full rescan" + suffix, 5, [&]() {
+                int changed{};
+
+                for(int i = 0; i < k_steps; ++i) {
+                    auto &pos = rescanEntities[engine::Random::rangeExclusive(0, entitiesCount)];
+
+                    pos = getNextPos(pos);
+                    changed += rescanFields(rescanEntities, k_size, usedCount, wasUsed);
+                }
+
+                Benchmark::keep(changed);
+            });
+        }
+
+        app::WorldPartFreePosFinder finder{k_size, [k_height](const engine::FloatVec2 &) {
+            return k_height;
+        }};
+
+        for(const auto &elem : entities) {
+            finder.useFieldAt(elem);
+        }
+
+        // the same as World::onEntityMoved
+        auto moveRandomEntity = [&]() {
+            auto &pos = entities[engine::Random::rangeExclusive(0, entitiesCount)];
+            auto nextPos = getNextPos(pos);
+
+            if(!finder.isSameField(pos, nextPos)) {
+                finder.releaseFieldAt(pos);
+                finder.useFieldAt(nextPos);
+            }
+
+            pos = nextPos;
+        };
+
+        benchmark.measure("ref-counted fields" + suffix, 5, [&]() {
+            for(int i = 0; i < k_steps; ++i) {
+                moveRandomEntity();
+            }
+        });
+
+        // NPCs walking to their targets ask for a path every frame, so cached paths are invalidated
+        // by moved entities and found again
+        std::vector <std::pair <engine::FloatVec2, engine::FloatVec2>> paths(k_pathsCount);
+
+        for(auto &elem : paths) {
+            elem.first = getRandomPos();
+            elem.second = {engine::Math::clamp(elem.first.x + engine::Random::rangeInclusive(-30.f, 30.f), 0.f, k_size - 0.01f),
+                           engine::Math::clamp(elem.first.y + engine::Random::rangeInclusive(-30.f, 30.f), 0.f, k_size - 0.01f)};
+        }
+
+        benchmark.measure("ref-counted fields + " + std::to_string(k_pathsCount) + " cached paths" + suffix, 5, [&]() {
+            float sum{};
+
+            for(int i = 0; i < k_steps; ++i) {
+                moveRandomEntity();
+
+                for(const auto &elem : paths) {
+                    sum += finder.getPathFoundNextCheckpoint(elem.first, elem.second).first.x;
+                }
+            }
+
+            Benchmark::keep(sum);
+        });
+    }
+}
+
+static const Benchmark::Registrar k_freePosFinderChurnRegistrar{"WorldPartFreePosFinder churn", &freePosFinderChurn};
+
+} // namespace benchmarks
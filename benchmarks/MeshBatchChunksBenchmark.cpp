@@ -0,0 +1,170 @@
+#include "Benchmark.hpp"
+#include "../engine/app3D/irrNodes/MeshBatch.hpp"
+#include "../engine/app3D/managers/MeshBatchManager.hpp"
+#include "../engine/util/Metrics.hpp"
+#include "../engine/util/Exception.hpp"
+#include "../engine/util/Random.hpp"
+
+#include <irrlicht/irrlicht.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmarks
+{
+
+// MeshBatchManager needs a full Device (shaders, packed textures), so this keeps its batches
+// on Irrlicht null device, routing meshes with MeshBatchManager's chunks and batch selection
+
+class StandInMeshBatchManager
+{
+public:
+    StandInMeshBatchManager(irr::scene::ISceneManager &sceneManager, irr::video::ITexture &textureAtlas, bool useChunks);
+
+    void add(irr::scene::IMesh &mesh, const irr::core::vector3df &pos);
+    void remove(int index);
+    int getMeshCount() const;
+
+private:
+    struct BatchedMesh
+    {
+        std::pair <int, int> chunk;
+        int batchSecondLevelIndex{-1};
+        std::shared_ptr <int> batchedMeshIndex;
+    };
+
+    irr::scene::ISceneManager &m_sceneManager;
+    irr::video::ITexture &m_textureAtlas;
+    bool m_useChunks; // without chunks everything is in one chunk, like before chunks were added
+    std::map <std::pair <int, int>, std::vector <engine::app3D::irrNodes::MeshBatch *>> m_chunks;
+    std::vector <BatchedMesh> m_meshes;
+};
+
+StandInMeshBatchManager::StandInMeshBatchManager(irr::scene::ISceneManager &sceneManager, irr::video::ITexture &textureAtlas, bool useChunks)
+    : m_sceneManager(sceneManager),
+      m_textureAtlas(textureAtlas),
+      m_useChunks{useChunks}
+{
+}
+
+void StandInMeshBatchManager::add(irr::scene::IMesh &mesh, const irr::core::vector3df &pos)
+{
+    using engine::app3D::MeshBatchManager;
+
+    BatchedMesh batchedMesh;
+
+    if(m_useChunks)
+        batchedMesh.chunk = MeshBatchManager::getChunk({pos.X, pos.Y, pos.Z});
+
+    auto &batches = m_chunks[batchedMesh.chunk];
+
+    batchedMesh.batchSecondLevelIndex = MeshBatchManager::findBatchWithFreeSpace(batches);
+
+    if(batchedMesh.batchSecondLevelIndex < 0) {
+        batches.push_back(new engine::app3D::irrNodes::MeshBatch{m_sceneManager, m_textureAtlas, irr::video::EMT_SOLID, irr::video::EMT_SOLID});
+        batches.back()->drop();
+        batchedMesh.batchSecondLevelIndex = static_cast <int> (batches.size() - 1);
+    }
+
+    std::vector <engine::FloatRect> textureAtlasRects(mesh.getMeshBufferCount(), engine::FloatRect{0.f, 0.f, 1.f, 1.f});
+
+    batchedMesh.batchedMeshIndex = batches[batchedMesh.batchSecondLevelIndex]->addMesh(mesh, textureAtlasRects, false, pos, {}, {1.f, 1.f, 1.f});
+    m_meshes.push_back(batchedMesh);
+}
+
+void StandInMeshBatchManager::remove(int index)
+{
+    const auto &it = m_chunks.find(m_meshes[index].chunk);
+
+    if(it == m_chunks.end())
+        throw engine::Exception{"Mesh chunk not found."};
+
+    it->second[m_meshes[index].batchSecondLevelIndex]->removeMesh(*m_meshes[index].batchedMeshIndex);
+
+    engine::app3D::MeshBatchManager::removeEmptyBatchesAtEnd(it->second);
+
+    if(it->second.empty())
+        m_chunks.erase(it);
+
+    // swap with the last one, like MeshBatchManager::removeMesh
+    std::swap(m_meshes[index], m_meshes.back());
+    m_meshes.pop_back();
+}
+
+int StandInMeshBatchManager::getMeshCount() const
+{
+    return static_cast <int> (m_meshes.size());
+}
+
+static std::int64_t getLastFrameMetric(const std::string &name)
+{
+    for(const auto &elem : engine::Metrics::getMetrics()) {
+        if(elem.name == name)
+            return elem.value;
+    }
+
+    return 0;
+}
+
+// large base: draw calls and rebuilt vertices per frame while structures are demolished and built
+static void meshBatchChunks(Benchmark &benchmark)
+{
+    const int k_gridSize{100};
+    const float k_spacing{4.f};
+    const int k_churnFrames{300};
+
+    for(bool useChunks : {false, true}) {
+        auto *device = irr::createDevice(irr::video::EDT_NULL);
+
+        if(!device)
+            throw engine::Exception{"Could not create Irrlicht null device."};
+
+        auto &sceneManager = *device->getSceneManager();
+        auto *textureAtlas = device->getVideoDriver()->addTexture({16, 16}, "atlas");
+        auto *mesh = sceneManager.getGeometryCreator()->createCubeMesh({2.f, 2.f, 2.f});
+
+        // camera at the edge of the base, looking at it
+        auto *camera = sceneManager.addCameraSceneNode(nullptr, {k_gridSize * k_spacing / 2.f, 20.f, -20.f}, {k_gridSize * k_spacing / 2.f, 0.f, k_gridSize * k_spacing / 2.f});
+        camera->setFarValue(150.f);
+
+        StandInMeshBatchManager manager{sceneManager, *textureAtlas, useChunks};
+
+        for(int y = 0; y < k_gridSize; ++y) {
+            for(int x = 0; x < k_gridSize; ++x) {
+                manager.add(*mesh, {x * k_spacing, 1.f, y * k_spacing});
+            }
+        }
+
+        std::string suffix{useChunks ? ", chunks" : ", no chunks"};
+
+        // first frame builds all batches
+        sceneManager.drawAll();
+        engine::Metrics::frameLap();
+
+        benchmark.report("draw calls per frame" + suffix, getLastFrameMetric("Mesh batch draw calls"), "");
+
+        std::int64_t rebuiltVertices{};
+
+        benchmark.measure("demolish and build one structure per frame" + suffix, k_churnFrames, [&]() {
+            manager.remove(engine::Random::rangeExclusive(0, manager.getMeshCount()));
+            manager.add(*mesh, {engine::Random::rangeExclusive(0.f, k_gridSize * k_spacing), 1.f, engine::Random::rangeExclusive(0.f, k_gridSize * k_spacing)});
+
+            sceneManager.drawAll();
+            engine::Metrics::frameLap();
+
+            rebuiltVertices += getLastFrameMetric("Mesh batch rebuilt vertices");
+        });
+
+        benchmark.report("rebuilt vertices per frame" + suffix, static_cast <double> (rebuiltVertices) / (k_churnFrames + 1), "");
+
+        mesh->drop();
+        device->drop();
+    }
+}
+
+static const Benchmark::Registrar k_meshBatchChunksRegistrar{"MeshBatch chunks", &meshBatchChunks};
+
+} // namespace benchmarks
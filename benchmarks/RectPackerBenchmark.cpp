@@ -0,0 +1,138 @@
+#include "Benchmark.hpp"
+#include "../engine/util/RectPacker.hpp"
+#include "../engine/util/MaxRectsPacker.hpp"
+#include "../engine/util/Random.hpp"
+#include "../engine/util/Exception.hpp"
+
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+
+static std::vector <engine::IntVec2> getTextureSizes(int count)
+{
+    // mostly power of two textures, like the ones in mods, with some odd sized ones
+    std::vector <engine::IntVec2> sizes(count);
+
+    for(auto &elem : sizes) {
+        if(engine::Random::rangeInclusive(0, 3)) {
+            elem.x = 16 << engine::Random::rangeInclusive(0, 4);
+            elem.y = 16 << engine::Random::rangeInclusive(0, 4);
+        }
+        else {
+            elem.x = engine::Random::rangeInclusive(8, 300);
+            elem.y = engine::Random::rangeInclusive(8, 300);
+        }
+    }
+
+    return sizes;
+}
+
+static bool packRectPacker(const std::vector <engine::IntVec2> &sizes, int count, int pageSize)
+{
+    engine::RectPacker packer{pageSize};
+
+    for(int i = 0; i < count; ++i) {
+        packer.add(sizes[i].x, sizes[i].y);
+    }
+
+    return packer.pack();
+}
+
+static bool packMaxRectsPacker(const std::vector <engine::IntVec2> &sizes, int count, int pageSize, bool allowRotation)
+{
+    engine::MaxRectsPacker packer{pageSize, 0, allowRotation, 1};
+
+    for(int i = 0; i < count; ++i) {
+        packer.add(sizes[i].x, sizes[i].y);
+    }
+
+    return packer.pack();
+}
+
+// occupancy of a single page filled with as many of the textures (in order) as it fits
+template <typename Pack> static float getMaxOccupancy(const std::vector <engine::IntVec2> &sizes, int pageSize, Pack &&pack)
+{
+    int fits{};
+    int doesntFit{static_cast <int> (sizes.size()) + 1};
+
+    while(doesntFit - fits > 1) {
+        int count{(fits + doesntFit) / 2};
+
+        if(pack(count))
+            fits = count;
+        else
+            doesntFit = count;
+    }
+
+    double area{};
+
+    for(int i = 0; i < fits; ++i) {
+        area += sizes[i].x * sizes[i].y;
+    }
+
+    return area / (static_cast <double> (pageSize) * pageSize);
+}
+
+// RectPacker against MaxRectsPacker: page occupancy and time of packing
+static void rectPackers(Benchmark &benchmark)
+{
+    const int k_pageSize{2048};
+    const int k_iterations{20};
+
+    const auto &sizes = getTextureSizes(1000);
+
+    benchmark.report("RectPacker, max occupancy of 2048 page", 100.0 * getMaxOccupancy(sizes, k_pageSize, [&](int count) {
+        return packRectPacker(sizes, count, k_pageSize);
+    }), "%");
+
+    benchmark.report("MaxRectsPacker, max occupancy of 2048 page", 100.0 * getMaxOccupancy(sizes, k_pageSize, [&](int count) {
+        return packMaxRectsPacker(sizes, count, k_pageSize, false);
+    }), "%");
+
+    benchmark.report("MaxRectsPacker with rotation, max occupancy of 2048 page", 100.0 * getMaxOccupancy(sizes, k_pageSize, [&](int count) {
+        return packMaxRectsPacker(sizes, count, k_pageSize, true);
+    }), "%");
+
+    {
+        // all textures, spilled into multiple pages (RectPacker can't do this)
+        engine::MaxRectsPacker packer{k_pageSize, 0, false, 64};
+
+        for(const auto &elem : sizes) {
+            packer.add(elem.x, elem.y);
+        }
+
+        if(!packer.pack())
+            throw engine::Exception{"Textures did not fit in pages."};
+
+        benchmark.report("MaxRectsPacker, 2048 pages for all textures", packer.getPagesCount(), "pages");
+        benchmark.report("MaxRectsPacker, occupancy of all pages", 100.0 * packer.getOccupancy(), "%");
+    }
+
+    // big enough page, so both packers fit everything
+    const int k_bigPageSize{16384};
+
+    for(int count : {100, 1000}) {
+        std::string suffix{", " + std::to_string(count) + " textures"};
+
+        benchmark.measure("RectPacker, pack" + suffix, k_iterations, [&]() {
+            if(!packRectPacker(sizes, count, k_bigPageSize))
+                throw engine::Exception{"Textures did not fit."};
+        });
+
+        benchmark.measure("MaxRectsPacker, pack" + suffix, k_iterations, [&]() {
+            if(!packMaxRectsPacker(sizes, count, k_bigPageSize, false))
+                throw engine::Exception{"Textures did not fit."};
+        });
+
+        benchmark.measure("MaxRectsPacker with rotation, pack" + suffix, k_iterations, [&]() {
+            if(!packMaxRectsPacker(sizes, count, k_bigPageSize, true))
+                throw engine::Exception{"Textures did not fit."};
+        });
+    }
+}
+
+static const Benchmark::Registrar k_rectPackersRegistrar{"RectPacker vs MaxRectsPacker", &rectPackers};
+
+} // namespace benchmarks
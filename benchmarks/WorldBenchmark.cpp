@@ -0,0 +1,175 @@
+#include "Benchmark.hpp"
+#include "../app/world/EntitiesByType.hpp"
+#include "../engine/util/Random.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace benchmarks
+{
+
+// Entity constructor needs Core, so World's EntitiesByType is filled with these instead
+
+class StandInEntity
+{
+public:
+    StandInEntity(app::EntityType entityType, int entityID);
+
+    app::EntityType getEntityType() const;
+    int getEntityID() const;
+    float getX() const;
+
+    virtual ~StandInEntity() = default;
+
+private:
+    app::EntityType m_entityType;
+    int m_entityID;
+    float m_x;
+};
+
+class StandInCharacter : public StandInEntity
+{
+public:
+    explicit StandInCharacter(int entityID);
+
+    bool isHostile() const;
+
+private:
+    bool m_hostile;
+};
+
+StandInEntity::StandInEntity(app::EntityType entityType, int entityID)
+    : m_entityType{entityType},
+      m_entityID{entityID},
+      m_x{engine::Random::rangeInclusive(-500.f, 500.f)}
+{
+}
+
+app::EntityType StandInEntity::getEntityType() const
+{
+    return m_entityType;
+}
+
+int StandInEntity::getEntityID() const
+{
+    return m_entityID;
+}
+
+float StandInEntity::getX() const
+{
+    return m_x;
+}
+
+StandInCharacter::StandInCharacter(int entityID)
+    : StandInEntity{app::EntityType::Character, entityID},
+      m_hostile{engine::Random::rangeInclusive(0, 1) == 1}
+{
+}
+
+bool StandInCharacter::isHostile() const
+{
+    return m_hostile;
+}
+
+} // namespace benchmarks
+
+namespace app
+{
+
+template <> struct EntityTypeOf <benchmarks::StandInCharacter> { static constexpr EntityType value{EntityType::Character}; };
+
+} // namespace app
+
+namespace benchmarks
+{
+
+// how World stored and visited entities before EntitiesByType
+static void forEachEntity_hashMaps(const std::unordered_map <int, std::shared_ptr <StandInEntity>> &wantUpdate,
+                                   const std::unordered_map <int, std::shared_ptr <StandInEntity>> &dontWantUpdate,
+                                   std::function <void(StandInEntity &)> func)
+{
+    for(const auto &elem : wantUpdate) {
+        func(*elem.second);
+    }
+
+    for(const auto &elem : dontWantUpdate) {
+        func(*elem.second);
+    }
+}
+
+// World::forEachEntity: std::function over hash maps against EntitiesByType
+static void forEachEntity(Benchmark &benchmark)
+{
+    for(int entitiesCount : {1000, 10000, 100000}) {
+        std::unordered_map <int, std::shared_ptr <StandInEntity>> wantUpdate, dontWantUpdate;
+        app::EntitiesByType <StandInEntity> entitiesByType;
+
+        // mostly mineables and structures, like a built up island
+        for(int i = 0; i < entitiesCount; ++i) {
+            std::shared_ptr <StandInEntity> entity;
+            int roll{i % 10};
+
+            if(roll == 0)
+                entity = std::make_shared <StandInCharacter> (i);
+            else if(roll <= 3)
+                entity = std::make_shared <StandInEntity> (app::EntityType::Structure, i);
+            else if(roll <= 5)
+                entity = std::make_shared <StandInEntity> (app::EntityType::Item, i);
+            else
+                entity = std::make_shared <StandInEntity> (app::EntityType::Mineable, i);
+
+            entitiesByType.add(*entity);
+
+            if(entity->getEntityType() == app::EntityType::Character || entity->getEntityType() == app::EntityType::Structure)
+                wantUpdate.emplace(i, std::move(entity));
+            else
+                dontWantUpdate.emplace(i, std::move(entity));
+        }
+
+        std::string suffix{", " + std::to_string(entitiesCount) + " entities"};
+        int iterations{entitiesCount >= 100000 ? 50 : 500};
+
+        benchmark.measure("all entities, std::function, hash maps" + suffix, iterations, [&]() {
+            float sum{};
+            forEachEntity_hashMaps(wantUpdate, dontWantUpdate, [&sum](StandInEntity &entity) {
+                sum += entity.getX();
+            });
+            Benchmark::keep(sum);
+        });
+
+        benchmark.measure("all entities, EntitiesByType::forEach" + suffix, iterations, [&]() {
+            float sum{};
+            entitiesByType.forEach([&sum](StandInEntity &entity) {
+                sum += entity.getX();
+            });
+            Benchmark::keep(sum);
+        });
+
+        benchmark.measure("hostile characters, std::function + dynamic_cast" + suffix, iterations, [&]() {
+            int count{};
+            forEachEntity_hashMaps(wantUpdate, dontWantUpdate, [&count](StandInEntity &entity) {
+                auto *character = dynamic_cast <StandInCharacter*> (&entity);
+
+                if(character && character->isHostile())
+                    ++count;
+            });
+            Benchmark::keep(count);
+        });
+
+        benchmark.measure("hostile characters, EntitiesByType::forEachOfType" + suffix, iterations, [&]() {
+            int count{};
+            entitiesByType.forEachOfType <StandInCharacter> ([&count](StandInCharacter &character) {
+                if(character.isHostile())
+                    ++count;
+            });
+            Benchmark::keep(count);
+        });
+    }
+}
+
+static const Benchmark::Registrar k_forEachEntityRegistrar{"World::forEachEntity", &forEachEntity};
+
+} // namespace benchmarks
@@ -0,0 +1,17 @@
+/* Benchmarks of engine and app hot paths, built with: qmake CONFIG+=benchmark
+ * Usage: ProjectBenchmark [name filter...]
+ */
+
+#include "Benchmark.hpp"
+#include "../engine/util/Trace.hpp"
+
+int main(int argc, char *argv[])
+{
+    engine::Trace::initProfiler();
+
+    int ret{benchmarks::Benchmark::runAll(argc, argv)};
+
+    engine::Trace::checkMemoryLeaks();
+
+    return ret;
+}
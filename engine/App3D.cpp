@@ -5,10 +5,16 @@
 #include "util/DefDatabase.hpp"
 #include "util/Exception.hpp"
 #include "util/LogManager.hpp"
+#include "util/Metrics.hpp"
 #include "util/Trace.hpp"
 
 #include <QApplication>
 
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
 namespace engine
 {
 
@@ -67,6 +73,11 @@ bool App3D::onUpdate()
     return false;
 }
 
+bool App3D::onFixedUpdate()
+{
+    return true;
+}
+
 void App3D::init(int argc, char *argv[])
 {
     TRACK;
@@ -91,9 +102,19 @@ void App3D::init(int argc, char *argv[])
         throw Exception{"Could not load settings.", e};
     }
 
+    if(settings.asyncLogging) {
+        E_INFO("Switching to async logging.");
+        LogManager::setAsyncMode(true);
+    }
+
     m_defDatabase = std::make_shared <DefDatabase> ();
 
-    m_device = app3D::Device::create(settings, m_defDatabase);
+    if(settings.simulationTickRate > 0) {
+        E_INFO("Using fixed simulation tick rate (%d Hz).", settings.simulationTickRate);
+        m_appTime.setFixedTimeStep(1000.0 / settings.simulationTickRate);
+    }
+
+    m_device = app3D::Device::create(settings, m_defDatabase, m_appTime);
 
     E_RASSERT(m_device, "Device is nullptr.");
 
@@ -105,6 +126,31 @@ void App3D::init(int argc, char *argv[])
     catch(const std::exception &e) {
         throw Exception{"Could not initialize app.", e};
     }
+
+    // --chrome-trace[=framesCount] records first frames to Chrome trace file
+    // --metrics-csv[=everyNFrames] dumps metrics to CSV file
+    for(int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        std::string chromeTraceFlag{"--chrome-trace"};
+        std::string metricsCSVFlag{"--metrics-csv"};
+
+        if(!arg.compare(0, chromeTraceFlag.size(), chromeTraceFlag)) {
+            int framesCount{Trace::k_defaultChromeTraceFramesCount};
+
+            if(arg.size() > chromeTraceFlag.size() + 1 && arg[chromeTraceFlag.size()] == '=')
+                framesCount = std::atoi(arg.c_str() + chromeTraceFlag.size() + 1);
+
+            Trace::startChromeTraceRecording(Trace::k_defaultChromeTracePath, framesCount);
+        }
+        else if(!arg.compare(0, metricsCSVFlag.size(), metricsCSVFlag)) {
+            int everyNFrames{Metrics::k_defaultCSVDumpIntervalFrames};
+
+            if(arg.size() > metricsCSVFlag.size() + 1 && arg[metricsCSVFlag.size()] == '=')
+                everyNFrames = std::atoi(arg.c_str() + metricsCSVFlag.size() + 1);
+
+            Metrics::startCSVDump(Metrics::k_defaultCSVPath, everyNFrames);
+        }
+    }
 }
 
 void App3D::loop()
@@ -114,11 +160,31 @@ void App3D::loop()
     while(true) {
         try {
             Trace::profilerLap();
+            Metrics::frameLap();
 
             m_appTime.update();
 
             auto &device = getDevice();
 
+            // fixed time step simulation (if enabled) runs 0 or more times per frame,
+            // before device update, so scene nodes can interpolate to the newest state
+
+            bool quit{};
+            int fixedStepsCount{};
+
+            while(m_appTime.beginFixedStep()) {
+                ++fixedStepsCount;
+                device.fixedUpdate(m_appTime);
+                quit = !onFixedUpdate();
+                m_appTime.endFixedStep();
+
+                if(quit)
+                    break;
+            }
+
+            if(quit)
+                break;
+
             if(!device.update(m_appTime))
                 break;
 
@@ -126,6 +192,12 @@ void App3D::loop()
                 break;
 
             device.draw();
+
+#ifdef ENGINE_HEADLESS
+            // nothing is rendered (and there's no vsync), so don't spin between simulation ticks
+            if(m_appTime.isFixedTimeStepEnabled() && !fixedStepsCount)
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+#endif
         }
         catch(const std::exception &e) {
             // we're catching all exceptions here; it's better
@@ -133,6 +205,9 @@ void App3D::loop()
             // with an exception
 
             E_ERROR("Exception caught in main App3D loop (continuing execution): %s", e.what());
+
+            if(m_appTime.isInFixedStep())
+                m_appTime.endFixedStep();
         }
     }
 
@@ -36,6 +36,7 @@ public:
 protected:
     virtual void onInit(const app3D::Settings &settings);
     virtual bool onUpdate();
+    virtual bool onFixedUpdate();
 
 private:
     void init(int argc, char *argv[]);
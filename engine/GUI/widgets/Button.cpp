@@ -13,9 +13,17 @@ namespace engine
 namespace GUI
 {
 
+static std::shared_ptr <app3D::SoundDef> getClickSoundDef(const DefDatabase &defDatabase, const std::string &defName)
+{
+    // buttons are created often (and only on the main thread), so the def is resolved by index after the first one
+    static DefDatabase::Handle <app3D::SoundDef> cachedHandle;
+
+    return defDatabase.getDef(defName, cachedHandle);
+}
+
 Button::Button(WidgetContainer *parent, const std::shared_ptr <IGUIRenderer> &renderer, const IntRect &rect)
     : Widget{parent, renderer, rect},
-      m_clickSound{renderer->getDefDatabase().getDef <app3D::SoundDef> (k_clickSoundDefName)},
+      m_clickSound{getClickSoundDef(renderer->getDefDatabase(), k_clickSoundDefName)},
       m_mouseOverAccumulator{},
       m_pressed{},
       m_drawBackground{true}
@@ -31,7 +31,7 @@ namespace app3D
  * Irrlicht resources holders, and that they all work.
  */
 
-std::shared_ptr <Device> Device::create(const Settings &settings, const std::shared_ptr <DefDatabase> &defDatabase)
+std::shared_ptr <Device> Device::create(const Settings &settings, const std::shared_ptr <DefDatabase> &defDatabase, const AppTime &appTime)
 {
     TRACK;
 
@@ -43,6 +43,7 @@ std::shared_ptr <Device> Device::create(const Settings &settings, const std::sha
 
     ptr->m_ptr = ptr;
     ptr->m_defDatabase = defDatabase;
+    ptr->m_appTime = &appTime;
     ptr->init(settings);
 
     return ptr;
@@ -57,20 +58,38 @@ bool Device::update(const AppTime &appTime)
 
     getShadersManager().clearPointLights(); // Lights update method will re-add point lights
 
-    getPhysicsManager().update(appTime);
+    // with fixed time step physics is updated in fixedUpdate()
+    if(!appTime.isFixedTimeStepEnabled())
+        getPhysicsManager().update(appTime);
+
     getSceneManager().update(appTime);
     getGUIRenderer().update();
     getGUIManager().update(appTime);
     getParticlesManager().update();
+
+#ifndef ENGINE_HEADLESS
     updateAudioListener();
+#endif
 
     return true;
 }
 
+void Device::fixedUpdate(const AppTime &appTime)
+{
+    TRACK;
+
+    getPhysicsManager().update(appTime);
+}
+
 void Device::draw()
 {
     TRACK;
 
+#ifdef ENGINE_HEADLESS
+    // headless build doesn't render anything
+    return;
+#endif
+
     auto &irrDevice = getIrrDevice();
     auto &videoDriver = *irrDevice.getVideoDriver();
     auto &sceneManager = getSceneManager();
@@ -288,6 +307,12 @@ DefDatabase &Device::getDefDatabase() const
     return *m_defDatabase;
 }
 
+const AppTime &Device::getAppTime() const
+{
+    E_DASSERT(m_appTime, "App time is nullptr.");
+    return *m_appTime;
+}
+
 Device::~Device()
 {
     dropIrrObjects();
@@ -298,6 +323,7 @@ Device::~Device()
 
 Device::Device()
     : m_irrDevice{},
+      m_appTime{},
       m_fogColor{k_defaultFogColor},
       m_fogMinDist{k_defaultFogMinDist},
       m_fogMaxDist{k_defaultFogMaxDist}
@@ -320,6 +346,11 @@ void Device::init(const Settings &settings)
 
     m_videoSettings = settings.video3D;
 
+#ifdef ENGINE_HEADLESS
+    E_INFO("Headless build. Irrlicht null driver will be used (no window, no rendering).");
+
+    m_videoModes.push_back({settings.video3D.width, settings.video3D.height});
+#else
     if(!irr::IrrlichtDevice::isDriverSupported(irr::video::EDT_OPENGL))
         throw Exception{"OpenGL driver is not supported."};
 
@@ -353,6 +384,7 @@ void Device::init(const Settings &settings)
 
     m_irrDevice->drop();
     m_irrDevice = nullptr;
+#endif
 
     m_eventManager = std::make_unique <EventManager> ();
 
@@ -362,6 +394,7 @@ void Device::init(const Settings &settings)
 
     E_RASSERT(m_irrDevice, "Irrlicht device is nullptr.");
 
+#ifndef ENGINE_HEADLESS
     const auto &driver = *m_irrDevice->getVideoDriver();
 
     if(!driver.queryFeature(irr::video::EVDF_MIP_MAP))
@@ -396,6 +429,7 @@ void Device::init(const Settings &settings)
      *     E_INFO("Deferred rendering available.");
      * else not supported
      */
+#endif
 
     m_resourcesManager = std::make_unique <ResourcesManager> (*this, settings);
     m_GUIRenderer = std::make_shared <detail::GUIRenderer> (*this);
@@ -464,7 +498,11 @@ void Device::createIrrlichtDevice(int width, int height, bool fullscreen, int an
     }
 
     irr::SIrrlichtCreationParameters creationParams;
+#ifdef ENGINE_HEADLESS
+    creationParams.DriverType = irr::video::EDT_NULL;
+#else
     creationParams.DriverType = irr::video::EDT_OPENGL;
+#endif
     creationParams.WindowSize = {static_cast <irr::u32> (width), static_cast <irr::u32> (height)};
     creationParams.Fullscreen = fullscreen;
     creationParams.AntiAlias = antialiasing;
@@ -39,12 +39,15 @@ public:
     Device &operator = (const Device &) = delete;
 
     // the only way to create Device instance is to use this method
-    static std::shared_ptr <Device> create(const Settings &settings, const std::shared_ptr <DefDatabase> &defDatabase);
+    static std::shared_ptr <Device> create(const Settings &settings, const std::shared_ptr <DefDatabase> &defDatabase, const AppTime &appTime);
 
     // called each frame
     bool update(const AppTime &appTime);
     void draw();
 
+    // called each fixed time step (only if fixed time step is enabled)
+    void fixedUpdate(const AppTime &appTime);
+
     // misc
     void setFog(const Color &color = k_defaultFogColor, float minDist = k_defaultFogMinDist, float maxDist = k_defaultFogMaxDist);
     void setFPPCameraControl(bool controlFPPCamera = true);
@@ -70,6 +73,7 @@ public:
     ParticlesManager &getParticlesManager();
     CursorManager &getCursorManager();
     DefDatabase &getDefDatabase() const;
+    const AppTime &getAppTime() const;
 
     ~Device();
 
@@ -91,6 +95,7 @@ private:
     std::weak_ptr <Device> m_ptr;
     irr::IrrlichtDevice *m_irrDevice;
     std::shared_ptr <DefDatabase> m_defDatabase;
+    const AppTime *m_appTime;
     std::shared_ptr <detail::GUIRenderer> m_GUIRenderer;
     std::unique_ptr <EventManager> m_eventManager;
     std::shared_ptr <GUI::GUIManager> m_GUIManager;
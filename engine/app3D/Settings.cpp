@@ -45,6 +45,9 @@ void Settings::expose(DataFile::Node &node)
     node.var(audio, "audio");
     node.var(mods, "mods");
     node.var(appVersion, "appVersion");
+    node.var(simulationTickRate, "simulationTickRate", 0);
+    node.var(asyncLogging, "asyncLogging", true);
+    node.var(parallelDefsLoading, "parallelDefsLoading", true);
 }
 
 void Settings::load()
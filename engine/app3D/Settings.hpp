@@ -62,6 +62,9 @@ struct Settings : public DataFile::Saveable
     Audio audio;
     Mods mods;
     Version appVersion;
+    int simulationTickRate{}; // fixed simulation ticks per second, 0 means once per frame
+    bool asyncLogging{true};
+    bool parallelDefsLoading{true};
 };
 
 } // namespace app3D
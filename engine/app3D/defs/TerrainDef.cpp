@@ -1,8 +1,12 @@
 #include "TerrainDef.hpp"
 
+#include "../../ext/PerlinNoise.hpp"
+#include "../../util/Math.hpp"
 #include "../Device.hpp"
 #include "../managers/ResourcesManager.hpp"
 
+#include <limits>
+
 namespace engine
 {
 namespace app3D
@@ -24,7 +28,8 @@ TerrainDef::TerrainDef()
       m_normalMap{},
       m_splatMap{},
       m_normalMapImage{},
-      m_splatMapImage{}
+      m_splatMapImage{},
+      m_heightFieldSize{}
 {
 }
 
@@ -80,33 +85,18 @@ void TerrainDef::reloadIrrObjects()
     auto &rmg = device.getResourcesManager();
 
     if(!isFlat()) {
-        m_heightMap = &rmg.loadIrrTexture(k_terrainTexturesDirectory + m_resourcePath + "/heightMap" + k_terrainTexturesExtension, true);
-        m_normalMap = &rmg.loadIrrTexture(k_terrainTexturesDirectory + m_resourcePath + "/normalMap" + k_terrainTexturesExtension, true);
-        m_splatMap = &rmg.loadIrrTexture(k_terrainTexturesDirectory + m_resourcePath + "/splatMap" + k_terrainTexturesExtension, true);
-
-        auto &driver = *device.getIrrDevice().getVideoDriver();
-
-        m_normalMapImage = driver.createImageFromData(
-           m_normalMap->getColorFormat(),
-           m_normalMap->getSize(),
-           m_normalMap->lock(),
-           false);
-
-        m_normalMap->unlock();
+        const auto &pathPrefix = k_terrainTexturesDirectory + m_resourcePath;
 
-        if(!m_normalMapImage)
-            throw Exception{"Could not create normal map image."};
+        m_heightMap = &rmg.loadIrrTexture(pathPrefix + "/heightMap" + k_terrainTexturesExtension, true);
+        m_normalMap = &rmg.loadIrrTexture(pathPrefix + "/normalMap" + k_terrainTexturesExtension, true);
+        m_splatMap = &rmg.loadIrrTexture(pathPrefix + "/splatMap" + k_terrainTexturesExtension, true);
 
-        m_splatMapImage = driver.createImageFromData(
-           m_splatMap->getColorFormat(),
-           m_splatMap->getSize(),
-           m_splatMap->lock(),
-           false);
+        // images are loaded from files instead of locked textures, because
+        // textures created by null driver (headless build) don't have any data
+        m_normalMapImage = &rmg.loadIrrImage(pathPrefix + "/normalMap" + k_terrainTexturesExtension);
+        m_splatMapImage = &rmg.loadIrrImage(pathPrefix + "/splatMap" + k_terrainTexturesExtension);
 
-        m_splatMap->unlock();
-
-        if(!m_splatMapImage)
-            throw Exception{"Could not create splat map image."};
+        createHeightField(rmg.loadIrrImage(pathPrefix + "/heightMap" + k_terrainTexturesExtension));
     }
 
     m_texture1 = &rmg.loadIrrTexture(m_texture1Path, true);
@@ -281,8 +271,135 @@ int TerrainDef::getMostDominantGroundTextureIndex(const FloatVec2 &pos) const
     }
 }
 
+int TerrainDef::getHeightFieldSize() const
+{
+    return m_heightFieldSize;
+}
+
+const std::vector <float> &TerrainDef::getHeightField() const
+{
+    return m_heightField;
+}
+
+FloatVec3 TerrainDef::getHeightFieldScale() const
+{
+    if(!m_heightFieldSize)
+        throw Exception{"Height field is empty."};
+
+    return {m_scale / m_heightFieldSize,
+            m_scale / k_heightMapHeightUnitsPerScale,
+            m_scale / m_heightFieldSize};
+}
+
+float TerrainDef::getHeight(const FloatVec2 &pos) const
+{
+    if(isFlat())
+        return 0.f;
+
+    const auto &scale = getHeightFieldScale();
+
+    float x{pos.x / scale.x};
+    float z{pos.y / scale.z};
+
+    auto fieldX = static_cast <int> (std::floor(x));
+    auto fieldZ = static_cast <int> (std::floor(z));
+
+    // the same as ITerrainSceneNode::getHeight() (returns lowest float if out of bounds)
+    if(fieldX < 0 || fieldX >= m_heightFieldSize - 1 ||
+       fieldZ < 0 || fieldZ >= m_heightFieldSize - 1)
+        return std::numeric_limits <float>::lowest();
+
+    float a{m_heightField[fieldX * m_heightFieldSize + fieldZ]};
+    float b{m_heightField[(fieldX + 1) * m_heightFieldSize + fieldZ]};
+    float c{m_heightField[fieldX * m_heightFieldSize + fieldZ + 1]};
+    float d{m_heightField[(fieldX + 1) * m_heightFieldSize + fieldZ + 1]};
+
+    float dx{x - fieldX};
+    float dz{z - fieldZ};
+
+    float height{};
+
+    if(dx > dz)
+        height = a + (d - b) * dz + (b - a) * dx;
+    else
+        height = a + (d - c) * dx + (c - a) * dz;
+
+    return height * scale.y;
+}
+
+void TerrainDef::createHeightField(const irr::video::IImage &heightMapImage)
+{
+    TRACK;
+
+    const auto &dimension = heightMapImage.getDimension();
+
+    if(!dimension.Width || dimension.Width != dimension.Height)
+        throw Exception{"Height map of terrain \"" + getDefName() + "\" is not square."};
+
+    m_heightFieldSize = static_cast <int> (dimension.Width);
+    m_heightField.resize(m_heightFieldSize * m_heightFieldSize);
+
+    // heights are calculated the same way Irrlicht's terrain scene node does it
+    // (height map is mirrored along x axis, then smoothed)
+
+    for(int x = 0; x < m_heightFieldSize; ++x) {
+        for(int z = 0; z < m_heightFieldSize; ++z) {
+            m_heightField[x * m_heightFieldSize + z] = heightMapImage.getPixel(m_heightFieldSize - x - 1, z).getLightness();
+        }
+    }
+
+    for(int i = 0; i < m_smoothFactor; ++i) {
+        for(int x = 1; x < m_heightFieldSize - 1; ++x) {
+            for(int z = 1; z < m_heightFieldSize - 1; ++z) {
+                int index{x * m_heightFieldSize + z};
+
+                m_heightField[index] = (m_heightField[index - 1] +
+                                        m_heightField[index + 1] +
+                                        m_heightField[index - m_heightFieldSize] +
+                                        m_heightField[index + m_heightFieldSize]) * 0.25f;
+            }
+        }
+    }
+
+    if(!Math::fuzzyCompare(m_slopeDistortion, 0.f)) {
+        // second value: higher - more pointy, third: height
+        PerlinNoise noise{0.5f, 0.08f, m_slopeDistortion, 3, 34573}; // 34573 is arbitrarly chosen seed
+
+        const auto &normalMap = getNormalMapImage();
+        auto normalMapWidth = static_cast <int> (normalMap.getDimension().Width);
+
+        for(int x = 0; x < m_heightFieldSize; ++x) {
+            for(int z = 0; z < m_heightFieldSize; ++z) {
+                int normalMapXPos{normalMapWidth - x};
+
+                if(normalMapXPos >= normalMapWidth)
+                    --normalMapXPos;
+
+                int normalMapZPos{z};
+
+                E_DASSERT(normalMapXPos >= 0 && normalMapXPos < normalMapWidth &&
+                          normalMapZPos >= 0 && normalMapZPos < static_cast <int> (normalMap.getDimension().Height), "Pixel coords out of bounds.");
+
+                auto normal = static_cast <int> (normalMap.getPixel(normalMapXPos, normalMapZPos).getBlue());
+
+                if(normal > k_slopeDistortionNormalMapBlueColorTransitionRange.to)
+                    continue;
+
+                float factor{1.f};
+
+                if(normal > k_slopeDistortionNormalMapBlueColorTransitionRange.from)
+                    factor = (k_slopeDistortionNormalMapBlueColorTransitionRange.to - normal) / static_cast <float> (k_slopeDistortionNormalMapBlueColorTransitionRange.getLength());
+
+                m_heightField[x * m_heightFieldSize + z] += std::fabs(noise.GetHeight(x, z)) * factor;
+            }
+        }
+    }
+}
+
 const std::string TerrainDef::k_terrainTexturesDirectory = "terrain/";
 const std::string TerrainDef::k_terrainTexturesExtension = ".bmp";
+const float TerrainDef::k_heightMapHeightUnitsPerScale{1024.f};
+const IntRange TerrainDef::k_slopeDistortionNormalMapBlueColorTransitionRange{175, 225};
 
 } // namespace app3D
 } // namespace engine
@@ -2,12 +2,16 @@
 #define ENGINE_APP_3D_TERRAIN_DEF_HPP
 
 #include "../../util/Vec2.hpp"
+#include "../../util/Vec3.hpp"
+#include "../../util/Range.hpp"
 #include "../../util/Color.hpp"
 #include "../../util/Trace.hpp"
 #include "ResourceDef.hpp"
 
 #include <irrlicht/irrlicht.h>
 
+#include <vector>
+
 namespace engine
 {
 namespace app3D
@@ -48,11 +52,22 @@ public:
     irr::video::IImage &getSplatMapImage() const;
     int getMostDominantGroundTextureIndex(const FloatVec2 &pos) const;
 
+    // CPU height field (the same heights are used by the render mesh), it's available
+    // without terrain scene node, so it also works in headless build
+    int getHeightFieldSize() const;
+    const std::vector <float> &getHeightField() const;
+    FloatVec3 getHeightFieldScale() const;
+    float getHeight(const FloatVec2 &pos) const; // pos relative to terrain position
+
 private:
     using base = ResourceDef;
 
+    void createHeightField(const irr::video::IImage &heightMapImage);
+
     static const std::string k_terrainTexturesDirectory;
     static const std::string k_terrainTexturesExtension;
+    static const float k_heightMapHeightUnitsPerScale;
+    static const IntRange k_slopeDistortionNormalMapBlueColorTransitionRange;
 
     std::string m_resourcePath;
     std::string m_texture1Path;
@@ -77,6 +92,8 @@ private:
     irr::video::ITexture *m_splatMap;
     irr::video::IImage *m_normalMapImage;
     irr::video::IImage *m_splatMapImage;
+    int m_heightFieldSize;
+    std::vector <float> m_heightField; // index: x * size + z (the same as in Irrlicht terrain mesh)
 };
 
 } // namespace app3D
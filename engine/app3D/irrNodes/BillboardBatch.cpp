@@ -2,8 +2,16 @@
 
 #include "../../util/LogManager.hpp"
 #include "../../util/Math.hpp"
+#include "../../util/Metrics.hpp"
 #include "../../util/Trace.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 namespace engine
 {
 namespace app3D
@@ -18,6 +26,8 @@ BillboardBatch::BillboardBatch(irr::scene::ISceneManager &sceneManager, irr::vid
         m_defaultMaterialType{defaultMaterialType},
         m_defaultDeferredRenderingMaterialType{defaultDeferredRenderingMaterialType},
         m_updateNextFrame{true},
+        m_billboardsChanged{},
+        m_rewriteIndices{},
         m_frameCounter{}
 {
     TRACK;
@@ -39,8 +49,19 @@ void BillboardBatch::render()
     TRACK;
 
     ++m_frameCounter;
-    if(m_frameCounter == k_updateFrameFreq)
-        m_updateNextFrame = true;
+
+    // billboards barely change their facing and order if the camera moved only a bit
+    if(m_frameCounter >= k_updateFrameFreq) {
+        m_frameCounter = 0;
+
+        E_DASSERT(SceneManager->getActiveCamera(), "No active camera.");
+
+        const auto &camPos = SceneManager->getActiveCamera()->getPosition();
+
+        if(m_billboardsChanged ||
+           camPos.getDistanceFromSQ(m_lastUpdateCameraPos) >= k_minCameraMovementToUpdate * k_minCameraMovementToUpdate)
+            m_updateNextFrame = true;
+    }
 
     if(m_updateNextFrame) {
         m_updateNextFrame = false;
@@ -100,6 +121,13 @@ std::shared_ptr <int> BillboardBatch::addBillboard(const FloatRect &textureAtlas
     m_billboards.push_back(Billboard{});
     m_billboards.getLast().color = vertexColor;
 
+    m_billboardsSoA.posX.push_back(0.f);
+    m_billboardsSoA.posY.push_back(0.f);
+    m_billboardsSoA.posZ.push_back(0.f);
+    m_billboardsSoA.halfWidth.push_back(0.5f);
+    m_billboardsSoA.halfHeight.push_back(0.5f);
+    m_billboardsSoA.cameraDiffYFactor.push_back(1.f);
+
     auto vertexIndex = static_cast <irr::s32> (m_meshBuffer.Vertices.size());
 
     m_radius = m_boundingBox.getExtent().getLength() / 2.f;
@@ -132,7 +160,7 @@ std::shared_ptr <int> BillboardBatch::addBillboard(const FloatRect &textureAtlas
     auto index = static_cast <int> (m_billboards.size() - 1);
 
     m_billboards.getLast().index = std::make_shared <int> (index);
-    m_billboardSortingArray.resize(m_billboards.size());
+    m_billboardSortingArray.push_back(index);
     m_billboardSortingCompareArray.resize(m_billboards.size());
 
     m_updateNextFrame = true;
@@ -150,6 +178,7 @@ std::shared_ptr <int> BillboardBatch::addHorizontalBillboard(const FloatRect &te
     E_DASSERT(*index >= 0 && static_cast <irr::u32> (*index) < m_billboards.size(), "Index out of bounds.");
 
     m_billboards[*index].horizontal = true;
+    m_billboardsSoA.cameraDiffYFactor[*index] = 0.f;
 
     return index;
 }
@@ -159,7 +188,12 @@ void BillboardBatch::setBillboardPosition(int index, const irr::core::vector3df
     if(index < 0 || static_cast <irr::u32> (index) >= m_billboards.size())
         return;
 
-    m_billboards[index].pos = pos;
+    if(m_billboardsSoA.posX[index] != pos.X || m_billboardsSoA.posY[index] != pos.Y || m_billboardsSoA.posZ[index] != pos.Z) {
+        m_billboardsSoA.posX[index] = pos.X;
+        m_billboardsSoA.posY[index] = pos.Y;
+        m_billboardsSoA.posZ[index] = pos.Z;
+        m_billboardsChanged = true;
+    }
 }
 
 void BillboardBatch::setBillboardScale(int index, const irr::core::dimension2df &scale)
@@ -167,7 +201,11 @@ void BillboardBatch::setBillboardScale(int index, const irr::core::dimension2df
     if(index < 0 || static_cast <irr::u32> (index) >= m_billboards.size())
         return;
 
-    m_billboards[index].scale = scale;
+    if(m_billboardsSoA.halfWidth[index] != scale.Width * 0.5f || m_billboardsSoA.halfHeight[index] != scale.Height * 0.5f) {
+        m_billboardsSoA.halfWidth[index] = scale.Width * 0.5f;
+        m_billboardsSoA.halfHeight[index] = scale.Height * 0.5f;
+        m_billboardsChanged = true;
+    }
 }
 
 void BillboardBatch::removeBillboard(int index)
@@ -193,6 +231,11 @@ void BillboardBatch::removeBillboard(int index)
     if(static_cast <irr::u32> (index) != lastIndex)
         *m_billboards[index].index = index;
 
+    for(auto *soa : {&m_billboardsSoA.posX, &m_billboardsSoA.posY, &m_billboardsSoA.posZ, &m_billboardsSoA.halfWidth, &m_billboardsSoA.halfHeight, &m_billboardsSoA.cameraDiffYFactor}) {
+        (*soa)[index] = soa->back();
+        soa->pop_back();
+    }
+
     for(int i = 0; i < 6; ++i) {
         m_meshBuffer.Indices.erase(m_meshBuffer.Indices.size() - 1);
     }
@@ -209,9 +252,18 @@ void BillboardBatch::removeBillboard(int index)
     E_DASSERT(!m_billboardSortingArray.empty(), "Billboard sorting array is empty.");
     E_DASSERT(!m_billboardSortingCompareArray.empty(), "Billboard sorting compare array is empty.");
 
-    m_billboardSortingArray.resize(m_billboards.size());
+    // the last billboard took the place of the removed one; the previous order is kept,
+    // so the next sort is still incremental
+
+    auto &order = m_billboardSortingArray;
+
+    order.erase(std::remove(order.begin(), order.end(), index), order.end());
+    std::replace(order.begin(), order.end(), static_cast <int> (lastIndex), index);
+
     m_billboardSortingCompareArray.resize(m_billboards.size());
 
+    // the index buffer was truncated, so it no longer matches the order
+    m_rewriteIndices = true;
     m_updateNextFrame = true;
 }
 
@@ -229,7 +281,7 @@ void BillboardBatch::applyVertexShadows(const irr::core::vector3df &lightDir, ir
     // TODO: either remove, or make it actually useful
 
     for(irr::u32 i = 0; i < m_billboards.size(); ++i) {
-        irr::core::vector3df normal{m_billboards[i].pos};
+        irr::core::vector3df normal{m_billboardsSoA.posX[i], m_billboardsSoA.posY[i], m_billboardsSoA.posZ[i]};
         normal.normalize();
 
         irr::f32 light{-lightDir.dotProduct(normal) * intensity + ambient};
@@ -272,6 +324,47 @@ bool BillboardBatch::BillboardSortComparator::operator () (int a, int b) const
     return m_compare[a] > m_compare[b];
 }
 
+bool BillboardBatch::sortBillboards()
+{
+    TRACK;
+
+    auto &order = m_billboardSortingArray;
+    BillboardSortComparator billboardSortComparator{m_billboardSortingCompareArray};
+
+    // the previous order is nearly sorted, so insertion sort is close to linear;
+    // it gives up if the order changed a lot (e.g. camera teleported)
+
+    size_t moves{};
+    size_t maxMoves{order.size() * k_maxInsertionSortMovesPerBillboard};
+    bool changed{};
+
+    for(size_t i = 1; i < order.size() && moves <= maxMoves; ++i) {
+        int billboard{order[i]};
+        size_t j{i};
+
+        while(j > 0 && billboardSortComparator(billboard, order[j - 1])) {
+            order[j] = order[j - 1];
+            --j;
+        }
+
+        if(j != i) {
+            order[j] = billboard;
+            moves += i - j;
+            changed = true;
+        }
+    }
+
+    if(moves <= maxMoves) {
+        E_COUNTER_ADD("Billboards insertion sort moves", moves);
+        return changed;
+    }
+
+    std::sort(order.begin(), order.end(), billboardSortComparator);
+    E_COUNTER_ADD("Billboards sorted", order.size());
+
+    return true;
+}
+
 void BillboardBatch::updateBillboards()
 {
     TRACK;
@@ -288,58 +381,131 @@ void BillboardBatch::updateBillboards()
 
     const auto &camPos = SceneManager->getActiveCamera()->getPosition();
 
-    for(irr::u32 i = 0; i < m_billboards.size(); ++i) {
-        auto distance = camPos.getDistanceFromSQ(m_billboards[i].pos);
+    m_lastUpdateCameraPos = camPos;
+    m_billboardsChanged = false;
 
-        m_billboardSortingArray[i] = i;
-        m_billboardSortingCompareArray[i] = distance;
+    for(irr::u32 i = 0; i < m_billboards.size(); ++i) {
+        m_billboardSortingCompareArray[i] = camPos.getDistanceFromSQ({m_billboardsSoA.posX[i], m_billboardsSoA.posY[i], m_billboardsSoA.posZ[i]});
     }
 
-    BillboardSortComparator billboardSortComparator{m_billboardSortingCompareArray};
-    std::sort(m_billboardSortingArray.begin(), m_billboardSortingArray.end(), billboardSortComparator);
-
-    for(size_t i = 0; i < m_billboardSortingArray.size(); ++i) {
-        auto indexBase = i * 6;
-        auto valueBase = m_billboardSortingArray[i] * 4;
-
-        m_meshBuffer.Indices[indexBase] = valueBase;
-        m_meshBuffer.Indices[indexBase + 1] = valueBase + 1;
-        m_meshBuffer.Indices[indexBase + 2] = valueBase + 2;
-        m_meshBuffer.Indices[indexBase + 3] = valueBase + 2;
-        m_meshBuffer.Indices[indexBase + 4] = valueBase + 3;
-        m_meshBuffer.Indices[indexBase + 5] = valueBase;
+    if(sortBillboards() || m_rewriteIndices) {
+        m_rewriteIndices = false;
+
+        for(size_t i = 0; i < m_billboardSortingArray.size(); ++i) {
+            auto indexBase = i * 6;
+            auto valueBase = m_billboardSortingArray[i] * 4;
+
+            m_meshBuffer.Indices[indexBase] = valueBase;
+            m_meshBuffer.Indices[indexBase + 1] = valueBase + 1;
+            m_meshBuffer.Indices[indexBase + 2] = valueBase + 2;
+            m_meshBuffer.Indices[indexBase + 3] = valueBase + 2;
+            m_meshBuffer.Indices[indexBase + 4] = valueBase + 3;
+            m_meshBuffer.Indices[indexBase + 5] = valueBase;
+        }
     }
 
-    for(irr::u32 i = 0; i < m_billboards.size(); ++i) {
-        auto vertexIndex = static_cast <irr::s32> (i * 4);
+    expandBillboards(m_billboardsSoA, camPos, m_meshBuffer.Vertices.pointer());
+}
 
-        irr::core::vector3df billPos{m_billboards[i].pos};
+void BillboardBatch::expandBillboards(const BillboardsSoA &billboards, const irr::core::vector3df &camPos, irr::video::S3DVertex *outVertices, bool allowSSE)
+{
+    TRACK;
 
-        AbsoluteTransformation.transformVect(billPos);
+    // the node is always drawn with identity world transform, so positions are already in world space
 
-        irr::core::vector3df cameraDiff;
+    /*
+        With d = pos - camPos (d.Y = 0 for horizontal billboards) and l = |(d.X, d.Z)|,
+        normalize(d x up) and normalize(d x right) reduce to:
+            right = (-d.Z, 0, d.X) / l
+            up = (d.Y * d.X, -l^2, d.Y * d.Z) / (l * |d|)
+        If l is 0, both are zero vectors and the quad collapses, like with vector3df::normalize().
+    */
 
-        if(m_billboards[i].horizontal)
-            cameraDiff = m_billboards[i].pos - irr::core::vector3df{camPos.X, m_billboards[i].pos.Y, camPos.Z};
-        else
-            cameraDiff = m_billboards[i].pos - camPos;
+    int count{static_cast <int> (billboards.posX.size())};
+    int i{};
+
+#ifdef __SSE__
+    if(allowSSE) {
+        const __m128 camX{_mm_set1_ps(camPos.X)};
+        const __m128 camY{_mm_set1_ps(camPos.Y)};
+        const __m128 camZ{_mm_set1_ps(camPos.Z)};
+        const __m128 zero{_mm_setzero_ps()};
+
+        alignas(16) float out[8][4];
+
+        for(; i + 4 <= count; i += 4) {
+            __m128 posX{_mm_loadu_ps(&billboards.posX[i])};
+            __m128 posY{_mm_loadu_ps(&billboards.posY[i])};
+            __m128 posZ{_mm_loadu_ps(&billboards.posZ[i])};
+
+            __m128 diffX{_mm_sub_ps(posX, camX)};
+            __m128 diffY{_mm_mul_ps(_mm_sub_ps(posY, camY), _mm_loadu_ps(&billboards.cameraDiffYFactor[i]))};
+            __m128 diffZ{_mm_sub_ps(posZ, camZ)};
+
+            __m128 horizontalLengthSq{_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffZ, diffZ))};
+            __m128 horizontalLength{_mm_sqrt_ps(horizontalLengthSq)};
+            __m128 length{_mm_sqrt_ps(_mm_add_ps(horizontalLengthSq, _mm_mul_ps(diffY, diffY)))};
+            __m128 valid{_mm_cmpgt_ps(horizontalLength, zero)};
+
+            // masking also discards inf and NaN from lanes with zero length
+            __m128 rightFactor{_mm_and_ps(valid, _mm_div_ps(_mm_loadu_ps(&billboards.halfWidth[i]), horizontalLength))};
+            __m128 upFactor{_mm_and_ps(valid, _mm_div_ps(_mm_loadu_ps(&billboards.halfHeight[i]), _mm_mul_ps(horizontalLength, length)))};
+
+            _mm_store_ps(out[0], posX);
+            _mm_store_ps(out[1], posY);
+            _mm_store_ps(out[2], posZ);
+            _mm_store_ps(out[3], _mm_mul_ps(_mm_sub_ps(zero, diffZ), rightFactor));
+            _mm_store_ps(out[4], _mm_mul_ps(diffX, rightFactor));
+            _mm_store_ps(out[5], _mm_mul_ps(_mm_mul_ps(diffY, diffX), upFactor));
+            _mm_store_ps(out[6], _mm_mul_ps(_mm_sub_ps(zero, horizontalLengthSq), upFactor));
+            _mm_store_ps(out[7], _mm_mul_ps(_mm_mul_ps(diffY, diffZ), upFactor));
+
+            for(int j = 0; j < 4; ++j) {
+                setQuadPositions(outVertices + (i + j) * 4,
+                                 {out[0][j], out[1][j], out[2][j]},
+                                 {out[3][j], 0.f, out[4][j]},
+                                 {out[5][j], out[6][j], out[7][j]});
+            }
+        }
+    }
+#endif
 
-        irr::core::vector3df upVector{0.f, 1.f, 0.f};
-        irr::core::vector3df crossA{cameraDiff.crossProduct(upVector).normalize()};
-        irr::core::vector3df crossB{cameraDiff.crossProduct(crossA).normalize()};
+    for(; i < count; ++i) {
+        float diffX{billboards.posX[i] - camPos.X};
+        float diffY{(billboards.posY[i] - camPos.Y) * billboards.cameraDiffYFactor[i]};
+        float diffZ{billboards.posZ[i] - camPos.Z};
 
-        crossA *= m_billboards[i].scale.Width * 0.5f;
-        crossB *= m_billboards[i].scale.Height * 0.5f;
+        float horizontalLengthSq{diffX * diffX + diffZ * diffZ};
+        float horizontalLength{std::sqrt(horizontalLengthSq)};
+        float length{std::sqrt(horizontalLengthSq + diffY * diffY)};
 
-        m_meshBuffer.Vertices[vertexIndex].Pos = billPos + crossA - crossB;
-        m_meshBuffer.Vertices[vertexIndex + 1].Pos = billPos - crossA - crossB;
-        m_meshBuffer.Vertices[vertexIndex + 2].Pos = billPos - crossA + crossB;
-        m_meshBuffer.Vertices[vertexIndex + 3].Pos = billPos + crossA + crossB;
+        float rightFactor{};
+        float upFactor{};
+
+        if(horizontalLength > 0.f) {
+            rightFactor = billboards.halfWidth[i] / horizontalLength;
+            upFactor = billboards.halfHeight[i] / (horizontalLength * length);
+        }
+
+        setQuadPositions(outVertices + i * 4,
+                         {billboards.posX[i], billboards.posY[i], billboards.posZ[i]},
+                         {-diffZ * rightFactor, 0.f, diffX * rightFactor},
+                         {diffY * diffX * upFactor, -horizontalLengthSq * upFactor, diffY * diffZ * upFactor});
     }
 }
 
+void BillboardBatch::setQuadPositions(irr::video::S3DVertex *quad, const irr::core::vector3df &pos, const irr::core::vector3df &right, const irr::core::vector3df &up)
+{
+    quad[0].Pos = pos + right - up;
+    quad[1].Pos = pos - right - up;
+    quad[2].Pos = pos - right + up;
+    quad[3].Pos = pos + right + up;
+}
+
 const int BillboardBatch::k_maxVertices{50000};
 const int BillboardBatch::k_updateFrameFreq{5};
+const float BillboardBatch::k_minCameraMovementToUpdate{0.1f};
+const int BillboardBatch::k_maxInsertionSortMovesPerBillboard{8};
 
 } // namespace irrNodes
 } // namespace app3D
@@ -19,6 +19,17 @@ namespace irrNodes
 class BillboardBatch : public irr::scene::ISceneNode, public Tracked <BillboardBatch>
 {
 public:
+    // positions and half sizes as SoA, so quads can be expanded 4 at a time
+    struct BillboardsSoA
+    {
+        std::vector <float> posX;
+        std::vector <float> posY;
+        std::vector <float> posZ;
+        std::vector <float> halfWidth;
+        std::vector <float> halfHeight;
+        std::vector <float> cameraDiffYFactor; // 0 for horizontal billboards, so they only rotate around Y axis
+    };
+
     BillboardBatch(irr::scene::ISceneManager &sceneManager, irr::video::ITexture &textureAtlas, irr::video::E_MATERIAL_TYPE defaultMaterialType, irr::video::E_MATERIAL_TYPE defaultDeferredRenderingMaterialType);
 
     void OnRegisterSceneNode() override;
@@ -36,12 +47,14 @@ public:
     void applyVertexShadows(const irr::core::vector3df &lightDir, irr::f32 intensity, irr::f32 ambient);
     void resetVertexShadows();
 
+    // writes quad positions of billboards facing the camera to outVertices (4 per billboard);
+    // without allowSSE only the scalar path is used
+    static void expandBillboards(const BillboardsSoA &billboards, const irr::core::vector3df &camPos, irr::video::S3DVertex *outVertices, bool allowSSE = true);
+
 private:
     struct Billboard
     {
         std::shared_ptr <int> index;
-        irr::core::vector3df pos;
-        irr::core::dimension2df scale{1.f, 1.f};
         irr::f32 roll{};
         irr::video::SColor color;
         bool horizontal{};
@@ -58,10 +71,15 @@ private:
         const std::vector <float> &m_compare;
     };
 
+    bool sortBillboards();
     void updateBillboards();
 
+    static void setQuadPositions(irr::video::S3DVertex *quad, const irr::core::vector3df &pos, const irr::core::vector3df &right, const irr::core::vector3df &up);
+
     static const int k_maxVertices;
     static const int k_updateFrameFreq;
+    static const float k_minCameraMovementToUpdate;
+    static const int k_maxInsertionSortMovesPerBillboard;
 
     irr::f32 m_radius;
     bool m_deferredRendering;
@@ -70,11 +88,17 @@ private:
     irr::core::aabbox3df m_boundingBox;
     irr::video::SMaterial m_material;
     irr::core::array <Billboard> m_billboards;
-    std::vector <int> m_billboardSortingArray;
+
+    BillboardsSoA m_billboardsSoA;
+
+    std::vector <int> m_billboardSortingArray; // back to front order from the previous update
     std::vector <float> m_billboardSortingCompareArray;
     irr::scene::SMeshBuffer m_meshBuffer;
     bool m_updateNextFrame;
+    bool m_billboardsChanged;
+    bool m_rewriteIndices;
     int m_frameCounter;
+    irr::core::vector3df m_lastUpdateCameraPos;
 };
 
 } // namespace irrNodes
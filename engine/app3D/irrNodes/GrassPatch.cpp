@@ -1,9 +1,20 @@
 #include "GrassPatch.hpp"
 
 #include "../../util/Exception.hpp"
+#include "../../util/Math.hpp"
+#include "../../util/Metrics.hpp"
+#include "../../util/ThreadPool.hpp"
+#include "../../util/Trace.hpp"
 #include "../../util/WindGenerator.hpp"
 #include "../IrrlichtConversions.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 namespace engine
 {
 namespace app3D
@@ -11,12 +22,60 @@ namespace app3D
 namespace irrNodes
 {
 
+GrassPatch::VerticesGenerator::VerticesGenerator()
+    : m_threadPool{std::make_unique <ThreadPool> (ThreadPool::getDefaultWorkerThreadsCount())}
+{
+}
+
+void GrassPatch::VerticesGenerator::queue(GrassPatch &patch)
+{
+    m_queuedPatches.push_back(&patch);
+}
+
+void GrassPatch::VerticesGenerator::dequeue(GrassPatch &patch)
+{
+    m_queuedPatches.erase(std::remove(m_queuedPatches.begin(), m_queuedPatches.end(), &patch), m_queuedPatches.end());
+}
+
+void GrassPatch::VerticesGenerator::generateQueued(const irr::scene::ICameraSceneNode &camera)
+{
+    TRACK;
+
+    if(m_queuedPatches.empty())
+        return;
+
+    E_DASSERT(m_threadPool, "Thread pool is nullptr.");
+
+    const auto &frustum = *camera.getViewFrustum();
+    const auto &camPos = camera.getAbsolutePosition();
+
+    // patches only write their own vertices, so they don't need any synchronization
+    m_threadPool->parallelFor(m_queuedPatches.size(), [this, &frustum, &camPos](size_t index) {
+        m_queuedPatches[index]->generateVertices(frustum, camPos);
+    });
+
+    for(auto *elem : m_queuedPatches) {
+        elem->m_verticesQueued = false;
+        elem->m_redrawNextLoop = false;
+    }
+
+    E_COUNTER_ADD("Grass patches generated", m_queuedPatches.size());
+
+    m_queuedPatches.clear();
+}
+
+GrassPatch::VerticesGenerator::~VerticesGenerator()
+{
+}
+
 GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITerrainSceneNode &terrain, irr::scene::ISceneNode &parent,
                        const FloatVec2 &pos, const FloatVec2 &terrainSize,
                        irr::video::IImage &normalMapImage, irr::video::IImage &splatMapImage,
-                       const Color &grassColor, const IntVec2 &texturesInTextureCount, const std::shared_ptr <WindGenerator> &windGenerator)
+                       const Color &grassColor, const IntVec2 &texturesInTextureCount, const std::shared_ptr <WindGenerator> &windGenerator,
+                       const std::shared_ptr <VerticesGenerator> &verticesGenerator)
     :   ISceneNode(&parent, &sceneManager, -1),
         m_windGenerator{windGenerator},
+        m_verticesGenerator{verticesGenerator},
         m_pos{pos.x, 0.f, pos.y},
         m_terrainSize{terrainSize},
         m_grassColor{grassColor},
@@ -28,11 +87,16 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
         m_lastWindChangeTime{},
         m_lastDrawCount{},
         m_timeBetweenAnimationFrames{k_defaultTimeBetweenAnimationFrames},
-        m_redrawNextLoop{true}
+        m_redrawNextLoop{true},
+        m_verticesQueued{},
+        m_particlesCount{}
 {
     if(!m_windGenerator)
         throw Exception{"Wind generator is nullptr."};
 
+    if(!m_verticesGenerator)
+        throw Exception{"Grass vertices generator is nullptr."};
+
     if(texturesInTextureCount.x <= 0 || texturesInTextureCount.y <= 0)
         throw Exception{"There must be at least one texture."};
 
@@ -46,9 +110,7 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
     randGenerator.seed(100 * pos.x + pos.y);
 
     int particleCount{k_grassQuadsCount};
-    m_particles.resize(particleCount);
-
-    m_boundingBox.reset(0, 0, 0);
+    std::vector <GrassParticle> particles(particleCount);
 
     float prevX{};
     float prevZ{};
@@ -72,13 +134,13 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
             z = Random::rangeInclusive(-k_grassPatchSize / 2.f, k_grassPatchSize / 2.f, randGenerator);
         }
 
-        m_particles[i].pos.X = x;
-        m_particles[i].pos.Z = z;
-        m_particles[i].sprite.Width = Random::rangeExclusive(0, m_texturesInTextureCount.Width, randGenerator);
-        m_particles[i].sprite.Height = Random::rangeExclusive(0, m_texturesInTextureCount.Height, randGenerator);
+        particles[i].pos.X = x;
+        particles[i].pos.Z = z;
+        particles[i].sprite.Width = Random::rangeExclusive(0, m_texturesInTextureCount.Width, randGenerator);
+        particles[i].sprite.Height = Random::rangeExclusive(0, m_texturesInTextureCount.Height, randGenerator);
 
-        float percentX{(pos.x + m_particles[i].pos.X) / m_terrainSize.x};
-        float percentY{(pos.y + m_particles[i].pos.Z) / m_terrainSize.y};
+        float percentX{(pos.x + particles[i].pos.X) / m_terrainSize.x};
+        float percentY{(pos.y + particles[i].pos.Z) / m_terrainSize.y};
         auto normalMapX = static_cast <int> (m_normalMapImage.getDimension().Width - percentX * m_normalMapImage.getDimension().Width);
         auto splatMapX = static_cast <int> (m_splatMapImage.getDimension().Width - percentX * m_splatMapImage.getDimension().Width);
 
@@ -87,7 +149,7 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
            splatMapX >= static_cast <int> (m_splatMapImage.getDimension().Width)) {
             --particleCount;
             --i;
-            m_particles.resize(particleCount);
+            particles.resize(particleCount);
             continue;
         }
 
@@ -107,17 +169,17 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
            static_cast <int> (normalMapCol.getBlue()) < k_normalMapUpVectorThreshold) {
             --particleCount;
             --i;
-            m_particles.resize(particleCount);
+            particles.resize(particleCount);
             continue;
         }
 
-        float height{m_terrain.getHeight(absPos.X + m_particles[i].pos.X, absPos.Z + m_particles[i].pos.Z)};
+        float height{m_terrain.getHeight(absPos.X + particles[i].pos.X, absPos.Z + particles[i].pos.Z)};
         irr::core::dimension2df size{1.2f, 1.1f + Random::rangeInclusive(0.f, 0.2f, randGenerator)};
 
-        m_particles[i].height = size.Height;
-        m_particles[i].flex = size.Height * k_heightToFlexFactor;
-        m_particles[i].pos.Y = height + (size.Height * 0.5f);
-        m_particles[i].color = IrrlichtConversions::toColor(m_grassColor);
+        particles[i].height = size.Height;
+        particles[i].flex = size.Height * k_heightToFlexFactor;
+        particles[i].pos.Y = height + (size.Height * 0.5f);
+        particles[i].color = IrrlichtConversions::toColor(m_grassColor);
 
         float rotation{};
 
@@ -132,15 +194,7 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
         irr::core::vector3df dimensions{0.5f * size.Width, -0.5f * size.Height, 0.f};
         mat.rotateVect(dimensions);
 
-        if(!i)
-            m_boundingBox.reset(m_particles[i].pos);
-        else
-            m_boundingBox.addInternalPoint(m_particles[i].pos);
-
-        m_particles[i].points[0] = m_particles[i].pos + irr::core::vector3df{dimensions.X, dimensions.Y, dimensions.Z};
-        m_particles[i].points[1] = m_particles[i].pos + irr::core::vector3df{dimensions.X, -dimensions.Y, dimensions.Z};
-        m_particles[i].points[2] = m_particles[i].pos - irr::core::vector3df{dimensions.X, dimensions.Y, dimensions.Z};
-        m_particles[i].points[3] = m_particles[i].pos - irr::core::vector3df{dimensions.X, -dimensions.Y, dimensions.Z};
+        particles[i].offset = dimensions;
 
         prevX = x;
         prevZ = z;
@@ -148,6 +202,7 @@ GrassPatch::GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITer
         hasPrev = true;
     }
 
+    buildCells(particles);
     allocateBuffers();
 }
 
@@ -193,11 +248,17 @@ const irr::core::aabbox3d <irr::f32> &GrassPatch::getBoundingBox() const
 void GrassPatch::OnRegisterSceneNode()
 {
     if(IsVisible) {
-        if(!m_particles.empty()) {
+        if(m_particlesCount) {
             const auto &camPos = SceneManager->getActiveCamera()->getPosition();
 
-            if((m_boundingBox.getCenter() + getAbsolutePosition()).getDistanceFrom(camPos) < std::sqrt(m_drawDistSq) + (m_boundingBox.getExtent() / 2.f).getLength())
+            if((m_boundingBox.getCenter() + getAbsolutePosition()).getDistanceFrom(camPos) < std::sqrt(m_drawDistSq) + (m_boundingBox.getExtent() / 2.f).getLength()) {
                 SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_SOLID);
+
+                if(m_redrawNextLoop && !m_verticesQueued && !SceneManager->isCulled(this)) {
+                    m_verticesGenerator->queue(*this);
+                    m_verticesQueued = true;
+                }
+            }
         }
 
         ISceneNode::OnRegisterSceneNode();
@@ -246,143 +307,154 @@ void GrassPatch::render()
     if(!camera || !driver)
         return;
 
-    if(!m_redrawNextLoop) {
-        E_DASSERT(m_vertices.size() >= m_lastDrawCount * 4, "Invalid vertices count.");
-        E_DASSERT(m_indices.size() >= m_lastDrawCount * 6, "Invalid indices count.");
+    if(m_redrawNextLoop) {
+        // vertices of this patch are generated together with all other queued patches
+        if(m_verticesQueued)
+            m_verticesGenerator->generateQueued(*camera);
+        else
+            generateVertices(*camera->getViewFrustum(), camera->getAbsolutePosition());
 
-        driver->setTransform(irr::video::ETS_WORLD, AbsoluteTransformation);
-        driver->setMaterial(m_material);
-        driver->drawIndexedTriangleList(m_vertices.data(), m_lastDrawCount * 4,
-                                        m_indices.data(), m_lastDrawCount * 2);
-	}
-    else {
-        const auto &camPos = camera->getAbsolutePosition();
-        const auto &camBox = camera->getViewFrustum()->getBoundingBox();
-        const auto &pos = getAbsolutePosition();
+        m_redrawNextLoop = false;
+    }
 
-        int drawCount{};
+    E_DASSERT(m_vertices.size() >= m_lastDrawCount * 4, "Invalid vertices count.");
+    E_DASSERT(m_indices.size() >= m_lastDrawCount * 6, "Invalid indices count.");
 
-        for(size_t i = 0; i < m_particles.size(); ++i) {
-            int index{drawCount * 4};
-            auto &thisParticle = m_particles[i];
-            const auto &particleAbsPos = thisParticle.pos + pos;
+    driver->setTransform(irr::video::ETS_WORLD, AbsoluteTransformation);
+    driver->setMaterial(m_material);
+    driver->drawIndexedTriangleList(m_vertices.data(), m_lastDrawCount * 4,
+                                    m_indices.data(), m_lastDrawCount * 2);
+}
 
-            if(!camBox.isPointInside(particleAbsPos))
-                continue;
+GrassPatch::~GrassPatch()
+{
+    if(m_verticesQueued)
+        m_verticesGenerator->dequeue(*this);
+}
 
-            float dist{camPos.getDistanceFromSQ(particleAbsPos)};
-            float offsetY{};
+const float GrassPatch::k_grassPatchSize{50.f};
 
-            if(dist > m_drawDistSq)
-                continue;
-            else if(dist > m_drawDistSq / 2.f)
-                offsetY = -(1.f - (m_drawDistSq - dist) / (m_drawDistSq / 2.f)) * thisParticle.height;
+void GrassPatch::setWindRes(int res)
+{
+    m_windGridRes = res < 2 ? 2 : res;
+    m_windGrid.resize((m_windGridRes + 1) * (m_windGridRes + 1));
+}
 
-            float gridSize{k_grassPatchSize / m_windGridRes};
+void GrassPatch::buildCells(const std::vector <GrassParticle> &particles)
+{
+    m_particlesCount = static_cast <int> (particles.size());
 
-            float xGridFloat{(thisParticle.pos.X + k_grassPatchSize / 2.f) / gridSize};
-            float zGridFloat{(thisParticle.pos.Z + k_grassPatchSize / 2.f) / gridSize};
+    float cellSize{k_grassPatchSize / k_cellsPerSide};
 
-            if(thisParticle.pos.X + k_grassPatchSize / 2.f > k_grassPatchSize)
-                std::cout << i << " outside by: " << thisParticle.pos.X + k_grassPatchSize / 2.f - k_grassPatchSize << std::endl;
+    const auto &getCellIndex = [cellSize](const irr::core::vector3df &pos) {
+        auto x = static_cast <int> ((pos.X + k_grassPatchSize / 2.f) / cellSize);
+        auto z = static_cast <int> ((pos.Z + k_grassPatchSize / 2.f) / cellSize);
 
-            if(thisParticle.pos.Z + k_grassPatchSize / 2.f > k_grassPatchSize)
-                std::cout << i << " outside by: " << thisParticle.pos.Z + k_grassPatchSize / 2.f - k_grassPatchSize << std::endl;
+        return Math::clamp(x, 0, k_cellsPerSide - 1) * k_cellsPerSide + Math::clamp(z, 0, k_cellsPerSide - 1);
+    };
 
-            if(xGridFloat < 0.f)
-                xGridFloat = 0.f;
+    // stable, so particles sharing position (crossed quads) stay next to each other
+    std::vector <int> order(particles.size());
 
-            if(zGridFloat < 0.f)
-                zGridFloat = 0.f;
+    for(size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast <int> (i);
+    }
 
-            auto xGrid = static_cast <int> (xGridFloat);
-            auto zGrid = static_cast <int> (zGridFloat);
+    std::stable_sort(order.begin(), order.end(), [&particles, &getCellIndex](int lhs, int rhs) {
+        return getCellIndex(particles[lhs].pos) < getCellIndex(particles[rhs].pos);
+    });
 
-            float xNext{std::fmod(xGridFloat, 1.f)}; // it's [0;1] distance to this int cell
-            float zNext{std::fmod(zGridFloat, 1.f)}; // it's [0;1] distance to this int cell
+    auto &p = m_particles;
 
-            int topLeft{xGrid * (m_windGridRes + 1) + zGrid};
-            int topRight{xGrid * (m_windGridRes + 1) + zGrid + 1};
-            int botLeft{(xGrid + 1) * (m_windGridRes + 1) + zGrid};
-            int botRight{(xGrid + 1) * (m_windGridRes + 1) + zGrid + 1};
+    for(auto *elem : {&p.posX, &p.posY, &p.posZ, &p.offsetX, &p.offsetZ, &p.halfHeight, &p.height,
+                      &p.windWeights[0], &p.windWeights[1], &p.windWeights[2], &p.windWeights[3]}) {
+        elem->resize(m_particlesCount);
+    }
 
-            E_DASSERT(topLeft >= 0 && topLeft < static_cast <int> (m_windGrid.size()), "Index out of bounds.");
-            E_DASSERT(topRight >= 0 && topRight < static_cast <int> (m_windGrid.size()), "Index out of bounds.");
-            E_DASSERT(botLeft >= 0 && botLeft < static_cast <int> (m_windGrid.size()), "Index out of bounds.");
-            E_DASSERT(botRight >= 0 && botRight < static_cast <int> (m_windGrid.size()), "Index out of bounds.");
+    p.windIndex.resize(m_particlesCount);
+    p.color.resize(m_particlesCount);
+    p.bottomColor.resize(m_particlesCount);
+    p.texCoordsIndex.resize(m_particlesCount);
 
-            const auto &wind1 = m_windGrid[topLeft];
-            const auto &wind2 = m_windGrid[botLeft];
-            const auto &wind3 = m_windGrid[topRight];
-            const auto &wind4 = m_windGrid[botRight];
+    m_cells.clear();
+    m_boundingBox.reset(0, 0, 0);
 
-            const auto &wind2D = (wind1 * (1.f - xNext) * (1.f - zNext) +
-                                  wind2 * xNext * (1.f - zNext) +
-                                  wind3 * (1.f - xNext) * zNext +
-                                  wind4 * xNext * zNext) * thisParticle.flex;
+    float gridSize{k_grassPatchSize / m_windGridRes};
+    int prevCellIndex{-1};
 
-            irr::core::vector3df windFin{wind2D.X, 0.f, wind2D.Y};
+    for(int i = 0; i < m_particlesCount; ++i) {
+        const auto &particle = particles[order[i]];
 
-            irr::video::SColor botCol{thisParticle.color.getAlpha(),
-                                      static_cast <irr::u32> (thisParticle.color.getRed() * k_colorMultiplierForBottomVertices),
-                                      static_cast <irr::u32> (thisParticle.color.getGreen() * k_colorMultiplierForBottomVertices),
-                                      static_cast <irr::u32> (thisParticle.color.getBlue() * k_colorMultiplierForBottomVertices)};
+        p.posX[i] = particle.pos.X;
+        p.posY[i] = particle.pos.Y;
+        p.posZ[i] = particle.pos.Z;
+        p.offsetX[i] = particle.offset.X;
+        p.offsetZ[i] = particle.offset.Z;
+        p.halfHeight[i] = particle.height * 0.5f;
+        p.height[i] = particle.height;
 
-            m_vertices[0 + index].Pos = thisParticle.points[0];
-            m_vertices[0 + index].Pos.Y += offsetY;
-            m_vertices[0 + index].Color = botCol;
+        // particles never move, so only wind grid values change between frames
 
-            m_vertices[1 + index].Pos = thisParticle.points[1] + windFin;
-            m_vertices[1 + index].Pos.Y += offsetY;
-            m_vertices[1 + index].Color = thisParticle.color;
+        float xGridFloat{Math::clamp((particle.pos.X + k_grassPatchSize / 2.f) / gridSize, 0.f, static_cast <float> (m_windGridRes))};
+        float zGridFloat{Math::clamp((particle.pos.Z + k_grassPatchSize / 2.f) / gridSize, 0.f, static_cast <float> (m_windGridRes))};
 
-            m_vertices[2 + index].Pos = thisParticle.points[2] + windFin;
-            m_vertices[2 + index].Pos.Y += offsetY;
-            m_vertices[2 + index].Color = thisParticle.color;
+        int xGrid{std::min(static_cast <int> (xGridFloat), m_windGridRes - 1)};
+        int zGrid{std::min(static_cast <int> (zGridFloat), m_windGridRes - 1)};
 
-            m_vertices[3 + index].Pos = thisParticle.points[3];
-            m_vertices[3 + index].Pos.Y += offsetY;
-            m_vertices[3 + index].Color = botCol;
+        float xNext{xGridFloat - xGrid}; // it's [0;1] distance to this int cell
+        float zNext{zGridFloat - zGrid}; // it's [0;1] distance to this int cell
 
-            auto texCoordsArrPos = (m_texturesInTextureCount.Width * thisParticle.sprite.Height) + thisParticle.sprite.Width;
+        p.windIndex[i] = xGrid * (m_windGridRes + 1) + zGrid;
+        p.windWeights[0][i] = (1.f - xNext) * (1.f - zNext) * particle.flex;
+        p.windWeights[1][i] = (1.f - xNext) * zNext * particle.flex;
+        p.windWeights[2][i] = xNext * (1.f - zNext) * particle.flex;
+        p.windWeights[3][i] = xNext * zNext * particle.flex;
 
-            m_vertices[0 + index].TCoords.set(m_vertex1TexCoords[texCoordsArrPos], m_vertex2TexCoords[texCoordsArrPos]);
-            m_vertices[1 + index].TCoords.set(m_vertex1TexCoords[texCoordsArrPos], m_vertex3TexCoords[texCoordsArrPos]);
-            m_vertices[2 + index].TCoords.set(m_vertex4TexCoords[texCoordsArrPos], m_vertex3TexCoords[texCoordsArrPos]);
-            m_vertices[3 + index].TCoords.set(m_vertex4TexCoords[texCoordsArrPos], m_vertex2TexCoords[texCoordsArrPos]);
+        E_DASSERT(p.windIndex[i] >= 0 && p.windIndex[i] + m_windGridRes + 2 < static_cast <int> (m_windGrid.size()), "Index out of bounds.");
 
-            ++drawCount;
-        }
+        p.color[i] = particle.color;
+        p.bottomColor[i].set(particle.color.getAlpha(),
+                             static_cast <irr::u32> (particle.color.getRed() * k_colorMultiplierForBottomVertices),
+                             static_cast <irr::u32> (particle.color.getGreen() * k_colorMultiplierForBottomVertices),
+                             static_cast <irr::u32> (particle.color.getBlue() * k_colorMultiplierForBottomVertices));
 
-        E_DASSERT(static_cast <int> (m_vertices.size()) >= drawCount * 4, "Invalid vertices count.");
-        E_DASSERT(static_cast <int> (m_indices.size()) >= drawCount * 6, "Invalid indices count.");
+        p.texCoordsIndex[i] = m_texturesInTextureCount.Width * particle.sprite.Height + particle.sprite.Width;
 
-        driver->setTransform(irr::video::ETS_WORLD, AbsoluteTransformation);
-        driver->setMaterial(m_material);
-        driver->drawIndexedTriangleList(m_vertices.data(), drawCount * 4,
-                                        m_indices.data(), drawCount * 2);
+        int cellIndex{getCellIndex(particle.pos)};
 
-        m_lastDrawCount = drawCount;
-	}
-}
+        if(cellIndex != prevCellIndex) {
+            m_cells.emplace_back();
+            m_cells.back().particlesBegin = i;
+            m_cells.back().boundingBox.reset(particle.pos);
+            prevCellIndex = cellIndex;
+        }
 
-const float GrassPatch::k_grassPatchSize{50.f};
+        auto &cell = m_cells.back();
 
-void GrassPatch::setWindRes(int res)
-{
-    m_windGridRes = res < 2 ? 2 : res;
-    m_windGrid.resize((m_windGridRes + 1) * (m_windGridRes + 1));
+        cell.particlesEnd = i + 1;
+        cell.boundingBox.addInternalPoint(particle.pos + particle.offset);
+        cell.boundingBox.addInternalPoint(particle.pos - particle.offset);
+        cell.boundingBox.addInternalPoint(particle.pos + irr::core::vector3df{particle.offset.X, -particle.offset.Y, particle.offset.Z});
+        cell.boundingBox.addInternalPoint(particle.pos - irr::core::vector3df{particle.offset.X, -particle.offset.Y, particle.offset.Z});
+    }
+
+    for(size_t i = 0; i < m_cells.size(); ++i) {
+        if(!i)
+            m_boundingBox = m_cells[i].boundingBox;
+        else
+            m_boundingBox.addInternalBox(m_cells[i].boundingBox);
+    }
 }
 
 void GrassPatch::allocateBuffers()
 {
-    m_vertices.resize(m_particles.size() * 4);
+    m_vertices.resize(m_particlesCount * 4);
 
     for(auto &elem : m_vertices) {
         elem.Normal.set(0.f, 1.f, 0.f);
     }
 
-    m_indices.resize(m_particles.size() * 6);
+    m_indices.resize(m_particlesCount * 6);
 
     int vertexIndex{};
 
@@ -398,9 +470,211 @@ void GrassPatch::allocateBuffers()
     }
 }
 
+void GrassPatch::generateVertices(const irr::scene::SViewFrustum &frustum, const irr::core::vector3df &camPos)
+{
+    TRACK;
+
+    const auto &pos = getAbsolutePosition();
+
+    // particles are in local space (the node has only translation)
+    irr::core::vector3df camLocalPos{camPos - pos};
+
+    int drawCount{};
+
+    for(const auto &elem : m_cells) {
+        irr::core::aabbox3df box{elem.boundingBox.MinEdge + pos, elem.boundingBox.MaxEdge + pos};
+
+        if(isCulled(box, frustum) || getMinDistanceSq(box, camPos) > m_drawDistSq)
+            continue;
+
+        // grass sinks into the ground only in the second half of draw distance
+        bool fullyGrown{getMaxDistanceSq(box, camPos) <= m_drawDistSq / 2.f};
+
+        drawCount = generateCellVertices(elem, camLocalPos, fullyGrown, drawCount);
+    }
+
+    E_DASSERT(static_cast <int> (m_vertices.size()) >= drawCount * 4, "Invalid vertices count.");
+    E_DASSERT(static_cast <int> (m_indices.size()) >= drawCount * 6, "Invalid indices count.");
+
+    m_lastDrawCount = drawCount;
+}
+
+int GrassPatch::generateCellVertices(const Cell &cell, const irr::core::vector3df &camLocalPos, bool fullyGrown, int drawCount)
+{
+    const auto &p = m_particles;
+    const auto *wind = m_windGrid.data();
+
+    int windIndexOffsets[4]{0, 1, m_windGridRes + 1, m_windGridRes + 2};
+    float halfDrawDistSq{m_drawDistSq / 2.f};
+
+    int i{cell.particlesBegin};
+
+#ifdef __SSE__
+    {
+        const __m128 zero{_mm_setzero_ps()};
+        const __m128 camX{_mm_set1_ps(camLocalPos.X)};
+        const __m128 camY{_mm_set1_ps(camLocalPos.Y)};
+        const __m128 camZ{_mm_set1_ps(camLocalPos.Z)};
+        const __m128 drawDistSq{_mm_set1_ps(m_drawDistSq)};
+        const __m128 halfDrawDistSqVec{_mm_set1_ps(halfDrawDistSq)};
+        const __m128 invHalfDrawDistSq{_mm_set1_ps(1.f / halfDrawDistSq)};
+
+        alignas(16) float out[8][4];
+
+        for(; i + 4 <= cell.particlesEnd; i += 4) {
+            __m128 posX{_mm_loadu_ps(&p.posX[i])};
+            __m128 posY{_mm_loadu_ps(&p.posY[i])};
+            __m128 posZ{_mm_loadu_ps(&p.posZ[i])};
+            __m128 offsetY{zero};
+            int visibleMask{0xF};
+
+            if(!fullyGrown) {
+                __m128 diffX{_mm_sub_ps(posX, camX)};
+                __m128 diffY{_mm_sub_ps(posY, camY)};
+                __m128 diffZ{_mm_sub_ps(posZ, camZ)};
+                __m128 dist{_mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)), _mm_mul_ps(diffZ, diffZ))};
+
+                visibleMask = _mm_movemask_ps(_mm_cmple_ps(dist, drawDistSq));
+
+                if(!visibleMask)
+                    continue;
+
+                // the same as the scalar formula, which simplifies to -max(0, (dist - halfDrawDistSq) / halfDrawDistSq) * height
+                __m128 sink{_mm_max_ps(zero, _mm_mul_ps(_mm_sub_ps(dist, halfDrawDistSqVec), invHalfDrawDistSq))};
+
+                offsetY = _mm_sub_ps(zero, _mm_mul_ps(sink, _mm_loadu_ps(&p.height[i])));
+            }
+
+            __m128 windX{zero};
+            __m128 windZ{zero};
+
+            for(int k = 0; k < 4; ++k) {
+                const auto &w0 = wind[p.windIndex[i] + windIndexOffsets[k]];
+                const auto &w1 = wind[p.windIndex[i + 1] + windIndexOffsets[k]];
+                const auto &w2 = wind[p.windIndex[i + 2] + windIndexOffsets[k]];
+                const auto &w3 = wind[p.windIndex[i + 3] + windIndexOffsets[k]];
+
+                __m128 weight{_mm_loadu_ps(&p.windWeights[k][i])};
+
+                windX = _mm_add_ps(windX, _mm_mul_ps(weight, _mm_set_ps(w3.X, w2.X, w1.X, w0.X)));
+                windZ = _mm_add_ps(windZ, _mm_mul_ps(weight, _mm_set_ps(w3.Y, w2.Y, w1.Y, w0.Y)));
+            }
+
+            __m128 offsetX{_mm_loadu_ps(&p.offsetX[i])};
+            __m128 offsetZ{_mm_loadu_ps(&p.offsetZ[i])};
+            __m128 halfHeight{_mm_loadu_ps(&p.halfHeight[i])};
+            __m128 centerY{_mm_add_ps(posY, offsetY)};
+
+            _mm_store_ps(out[0], _mm_add_ps(posX, offsetX));
+            _mm_store_ps(out[1], _mm_add_ps(posZ, offsetZ));
+            _mm_store_ps(out[2], _mm_sub_ps(posX, offsetX));
+            _mm_store_ps(out[3], _mm_sub_ps(posZ, offsetZ));
+            _mm_store_ps(out[4], windX);
+            _mm_store_ps(out[5], windZ);
+            _mm_store_ps(out[6], _mm_sub_ps(centerY, halfHeight));
+            _mm_store_ps(out[7], _mm_add_ps(centerY, halfHeight));
+
+            for(int j = 0; j < 4; ++j) {
+                if(visibleMask & (1 << j)) {
+                    writeQuad(drawCount, i + j, out[0][j], out[1][j], out[2][j], out[3][j], out[4][j], out[5][j], out[6][j], out[7][j]);
+                    ++drawCount;
+                }
+            }
+        }
+    }
+#endif
+
+    for(; i < cell.particlesEnd; ++i) {
+        float offsetY{};
+
+        if(!fullyGrown) {
+            float dist{camLocalPos.getDistanceFromSQ({p.posX[i], p.posY[i], p.posZ[i]})};
+
+            if(dist > m_drawDistSq)
+                continue;
+            else if(dist > halfDrawDistSq)
+                offsetY = -(1.f - (m_drawDistSq - dist) / halfDrawDistSq) * p.height[i];
+        }
+
+        float windX{};
+        float windZ{};
+
+        for(int k = 0; k < 4; ++k) {
+            const auto &w = wind[p.windIndex[i] + windIndexOffsets[k]];
+
+            windX += p.windWeights[k][i] * w.X;
+            windZ += p.windWeights[k][i] * w.Y;
+        }
+
+        float centerY{p.posY[i] + offsetY};
+
+        writeQuad(drawCount, i,
+                  p.posX[i] + p.offsetX[i], p.posZ[i] + p.offsetZ[i],
+                  p.posX[i] - p.offsetX[i], p.posZ[i] - p.offsetZ[i],
+                  windX, windZ,
+                  centerY - p.halfHeight[i], centerY + p.halfHeight[i]);
+
+        ++drawCount;
+    }
+
+    return drawCount;
+}
+
+void GrassPatch::writeQuad(int quadIndex, int particle, float frontX, float frontZ, float backX, float backZ, float windX, float windZ, float bottomY, float topY)
+{
+    auto *vertices = &m_vertices[quadIndex * 4];
+
+    vertices[0].Pos.set(frontX, bottomY, frontZ);
+    vertices[1].Pos.set(frontX + windX, topY, frontZ + windZ);
+    vertices[2].Pos.set(backX + windX, topY, backZ + windZ);
+    vertices[3].Pos.set(backX, bottomY, backZ);
+
+    vertices[0].Color = m_particles.bottomColor[particle];
+    vertices[1].Color = m_particles.color[particle];
+    vertices[2].Color = m_particles.color[particle];
+    vertices[3].Color = m_particles.bottomColor[particle];
+
+    int texCoordsIndex{m_particles.texCoordsIndex[particle]};
+
+    vertices[0].TCoords.set(m_vertex1TexCoords[texCoordsIndex], m_vertex2TexCoords[texCoordsIndex]);
+    vertices[1].TCoords.set(m_vertex1TexCoords[texCoordsIndex], m_vertex3TexCoords[texCoordsIndex]);
+    vertices[2].TCoords.set(m_vertex4TexCoords[texCoordsIndex], m_vertex3TexCoords[texCoordsIndex]);
+    vertices[3].TCoords.set(m_vertex4TexCoords[texCoordsIndex], m_vertex2TexCoords[texCoordsIndex]);
+}
+
+bool GrassPatch::isCulled(const irr::core::aabbox3df &box, const irr::scene::SViewFrustum &frustum)
+{
+    // frustum planes point outwards
+    for(int i = 0; i < irr::scene::SViewFrustum::VF_PLANE_COUNT; ++i) {
+        if(box.classifyPlaneRelation(frustum.planes[i]) == irr::core::ISREL3D_FRONT)
+            return true;
+    }
+
+    return false;
+}
+
+float GrassPatch::getMinDistanceSq(const irr::core::aabbox3df &box, const irr::core::vector3df &point)
+{
+    irr::core::vector3df diff{std::max(0.f, std::max(box.MinEdge.X - point.X, point.X - box.MaxEdge.X)),
+                              std::max(0.f, std::max(box.MinEdge.Y - point.Y, point.Y - box.MaxEdge.Y)),
+                              std::max(0.f, std::max(box.MinEdge.Z - point.Z, point.Z - box.MaxEdge.Z))};
+
+    return diff.getLengthSQ();
+}
+
+float GrassPatch::getMaxDistanceSq(const irr::core::aabbox3df &box, const irr::core::vector3df &point)
+{
+    irr::core::vector3df diff{std::max(std::abs(point.X - box.MinEdge.X), std::abs(point.X - box.MaxEdge.X)),
+                              std::max(std::abs(point.Y - box.MinEdge.Y), std::abs(point.Y - box.MaxEdge.Y)),
+                              std::max(std::abs(point.Z - box.MinEdge.Z), std::abs(point.Z - box.MaxEdge.Z))};
+
+    return diff.getLengthSQ();
+}
+
 const float GrassPatch::k_defaultDrawDist{100.f};
 const irr::u32 GrassPatch::k_defaultTimeBetweenAnimationFrames{60u};
 const int GrassPatch::k_grassQuadsCount{6000};
+const int GrassPatch::k_cellsPerSide{5};
 const int GrassPatch::k_splatMapGreenColorThreshold{160};
 const int GrassPatch::k_normalMapUpVectorThreshold{236};
 const int GrassPatch::k_windRes{20};
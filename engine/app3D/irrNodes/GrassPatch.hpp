@@ -8,8 +8,9 @@
 #include <irrlicht.h>
 
 #include <memory>
+#include <vector>
 
-namespace engine { class WindGenerator; }
+namespace engine { class WindGenerator; class ThreadPool; }
 
 namespace engine
 {
@@ -21,10 +22,34 @@ namespace irrNodes
 class GrassPatch : public irr::scene::ISceneNode
 {
 public:
+    /* Shared by all grass patches of a terrain. Patches which need new vertices queue themselves
+     * when they are registered for rendering, and the first of them to be rendered
+     * generates vertices of all queued patches in parallel.
+     */
+    class VerticesGenerator
+    {
+    public:
+        VerticesGenerator();
+        VerticesGenerator(const VerticesGenerator &) = delete;
+
+        VerticesGenerator &operator = (const VerticesGenerator &) = delete;
+
+        void queue(GrassPatch &patch);
+        void dequeue(GrassPatch &patch);
+        void generateQueued(const irr::scene::ICameraSceneNode &camera);
+
+        ~VerticesGenerator();
+
+    private:
+        std::unique_ptr <ThreadPool> m_threadPool;
+        std::vector <GrassPatch*> m_queuedPatches;
+    };
+
     GrassPatch(irr::scene::ISceneManager &sceneManager, irr::scene::ITerrainSceneNode &terrain, irr::scene::ISceneNode &parent,
                const FloatVec2 &pos, const FloatVec2 &terrainSize,
                irr::video::IImage &normalMapImage, irr::video::IImage &splatMapImage,
-               const Color &grassColor, const IntVec2 &texturesInTextureCount, const std::shared_ptr <WindGenerator> &windGenerator);
+               const Color &grassColor, const IntVec2 &texturesInTextureCount, const std::shared_ptr <WindGenerator> &windGenerator,
+               const std::shared_ptr <VerticesGenerator> &verticesGenerator);
 
     irr::video::SMaterial &getMaterial(irr::u32 i) override;
     irr::u32 getMaterialCount() const override;
@@ -33,6 +58,8 @@ public:
     void OnAnimate(irr::u32 timeMs) override;
     void render() override;
 
+    ~GrassPatch() override;
+
     static const float k_grassPatchSize;
 
 private:
@@ -41,18 +68,52 @@ private:
         irr::video::SColor color;
         irr::core::vector3df pos;
         irr::core::dimension2d <irr::s32> sprite;
-        irr::core::vector3df points[4];
+        irr::core::vector3df offset; // from pos to the bottom corner of the quad
         irr::f32 height{};
         irr::f32 flex{};
     };
 
+    // particles are sorted by cells, so whole cells can be culled at once
+    struct Cell
+    {
+        irr::core::aabbox3df boundingBox; // contains whole quads
+        int particlesBegin{};
+        int particlesEnd{};
+    };
+
+    // kept as SoA, so 4 particles can be animated at a time
+    struct Particles
+    {
+        std::vector <float> posX;
+        std::vector <float> posY;
+        std::vector <float> posZ;
+        std::vector <float> offsetX;
+        std::vector <float> offsetZ;
+        std::vector <float> halfHeight;
+        std::vector <float> height;
+        std::vector <int> windIndex; // wind grid point with the lowest coords
+        std::vector <float> windWeights[4]; // bilinear interpolation weights multiplied by flex
+        std::vector <irr::video::SColor> color;
+        std::vector <irr::video::SColor> bottomColor;
+        std::vector <int> texCoordsIndex;
+    };
+
     void setTexturesInTexture(const IntVec2 &count);
     void setWindRes(int res);
+    void buildCells(const std::vector <GrassParticle> &particles);
     void allocateBuffers();
+    void generateVertices(const irr::scene::SViewFrustum &frustum, const irr::core::vector3df &camPos);
+    int generateCellVertices(const Cell &cell, const irr::core::vector3df &camLocalPos, bool fullyGrown, int drawCount);
+    void writeQuad(int quadIndex, int particle, float frontX, float frontZ, float backX, float backZ, float windX, float windZ, float bottomY, float topY);
+
+    static bool isCulled(const irr::core::aabbox3df &box, const irr::scene::SViewFrustum &frustum);
+    static float getMinDistanceSq(const irr::core::aabbox3df &box, const irr::core::vector3df &point);
+    static float getMaxDistanceSq(const irr::core::aabbox3df &box, const irr::core::vector3df &point);
 
     static const float k_defaultDrawDist;
     static const irr::u32 k_defaultTimeBetweenAnimationFrames;
     static const int k_grassQuadsCount;
+    static const int k_cellsPerSide;
     static const int k_splatMapGreenColorThreshold;
     static const int k_normalMapUpVectorThreshold;
     static const int k_windRes;
@@ -60,6 +121,7 @@ private:
     static const float k_colorMultiplierForBottomVertices;
 
     std::shared_ptr <WindGenerator> m_windGenerator;
+    std::shared_ptr <VerticesGenerator> m_verticesGenerator;
     irr::core::vector3df m_pos;
     FloatVec2 m_terrainSize;
     Color m_grassColor;
@@ -76,9 +138,12 @@ private:
     irr::u32 m_lastDrawCount;
     irr::u32 m_timeBetweenAnimationFrames;
     bool m_redrawNextLoop;
+    bool m_verticesQueued;
 
     irr::core::dimension2d <irr::s32> m_texturesInTextureCount;
-    std::vector <GrassParticle> m_particles;
+    Particles m_particles;
+    int m_particlesCount;
+    std::vector <Cell> m_cells;
 
     irr::video::SMaterial m_material;
     std::vector <irr::video::S3DVertex> m_vertices;
@@ -2,10 +2,17 @@
 
 #include "../../util/Exception.hpp"
 #include "../../util/LogManager.hpp"
+#include "../../util/Metrics.hpp"
 #include "../../util/Trace.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <numeric>
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 namespace engine
 {
 namespace app3D
@@ -19,7 +26,11 @@ MeshBatch::MeshBatch(irr::scene::ISceneManager &sceneManager, irr::video::ITextu
         m_defaultMaterialType{defaultMaterialType},
         m_defaultDeferredRenderingMaterialType{defaultDeferredRenderingMaterialType},
         m_recalculateMeshBuffer{},
-        m_reportedBadTexCoords{}
+        m_reportedBadTexCoords{},
+        m_freeVerticesCount{},
+        m_freeIndicesCount{},
+        m_boundingBoxDirty{},
+        m_meshBuffer{irr::video::EVT_STANDARD, irr::video::EIT_16BIT}
 {
     TRACK;
 
@@ -40,6 +51,14 @@ void MeshBatch::OnRegisterSceneNode()
 {
     TRACK;
 
+    // empty chunk batches are kept for reuse, but they shouldn't cost a draw call
+    if(m_meshes.empty())
+        return;
+
+    // rebuilt before culling, because the bounding box depends on transformed vertices
+    updateMeshes();
+    updateBoundingBox();
+
     SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_SOLID);
 }
 
@@ -47,13 +66,13 @@ void MeshBatch::render()
 {
     TRACK;
 
-    updateMeshes();
-
     auto &driver = *SceneManager->getVideoDriver();
 
     driver.setTransform(irr::video::ETS_WORLD, irr::core::matrix4{});
     driver.setMaterial(m_material);
     driver.drawMeshBuffer(&m_meshBuffer);
+
+    E_COUNTER_ADD("Mesh batch draw calls", 1);
 }
 
 irr::video::SMaterial &MeshBatch::getMaterial(irr::u32)
@@ -68,9 +87,8 @@ irr::u32 MeshBatch::getMaterialCount() const
 
 const irr::core::aabbox3df &MeshBatch::getBoundingBox() const
 {
-    // TODO: find a better way to define infinite bounding box?
-    static const irr::core::aabbox3df box{{-10000.f, -10000.f, -10000.f}, {10000.f, 10000.f, 10000.f}};
-    return box;
+    // recalculated from meshes' boxes before culling, whenever any mesh was added, moved or removed
+    return m_boundingBox;
 }
 
 void MeshBatch::updateMaterial(bool useDeferredRendering)
@@ -109,7 +127,7 @@ void MeshBatch::updateMaterial(bool useDeferredRendering)
     m_material.Lighting = wantsLighting;
 }
 
-std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vector <FloatRect> &textureAtlasRects, bool forceAllUpNormals)
+std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vector <FloatRect> &textureAtlasRects, bool forceAllUpNormals, const irr::core::vector3df &pos, const irr::core::vector3df &rot, const irr::core::vector3df &scale)
 {
     TRACK;
 
@@ -122,15 +140,21 @@ std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vec
         meshVertexCount += mesh.getMeshBuffer(i)->getVertexCount();
     }
 
-   if(getVertexCount() + meshVertexCount > k_maxVertices)
-       throw Exception{"Mesh batch has reached maximum vertex count."};
+    if(getVertexCount() + meshVertexCount > k_maxVertices)
+        throw Exception{"Mesh batch has reached maximum vertex count."};
 
     m_meshes.resize(m_meshes.size() + 1);
 
     auto index = static_cast <int> (m_meshes.size() - 1);
+    auto &newMesh = m_meshes.back();
+
+    newMesh.index = std::make_shared <int> (index);
 
-    m_meshes.back().index = std::make_shared <int> (index);
-    m_meshes.back().verticesStartIndex = static_cast <int> (m_meshBuffer.Vertices.size());
+    // transform is known up front, so the vertices are transformed only once
+    newMesh.pos = pos;
+    newMesh.rot = rot;
+    newMesh.scale = scale;
+    newMesh.rotationMatrix.setRotationDegrees(rot);
 
     int totalVertexCount = 0; // needed if there is more than one mesh buffer per mesh
 
@@ -138,6 +162,14 @@ std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vec
     FloatVec2 badTexCoordsValue;
     int badTexCoordsVertexIndex{-1};
 
+    newMesh.vertices.reserve(meshVertexCount);
+
+    auto &untransformed = newMesh.untransformedVertices;
+
+    for(auto *elem : {&untransformed.posX, &untransformed.posY, &untransformed.posZ, &untransformed.normalX, &untransformed.normalY, &untransformed.normalZ}) {
+        elem->reserve(meshVertexCount);
+    }
+
     for(irr::u32 i = 0; i < mesh.getMeshBufferCount(); ++i) {
         E_DASSERT(mesh.getMeshBuffer(i)->getVertexType() == irr::video::EVT_STANDARD, "Expected EVT_STANDARD vertex type.");
 
@@ -197,21 +229,18 @@ std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vec
             if(forceAllUpNormals)
                 vertex.Normal = {0.f, 1.f, 0.f};
 
-            m_meshes.back().vertices.push_back(vertex);
+            newMesh.vertices.push_back(vertex);
 
-            if(!m_recalculateMeshBuffer) {
-                irr::video::S3DVertex vertex2{vertex};
-                transformVertex(vertex2.Pos, vertex2.Normal, m_meshes.back());
-                m_meshBuffer.Vertices.push_back(vertex2);
-            }
+            untransformed.posX.push_back(vertex.Pos.X);
+            untransformed.posY.push_back(vertex.Pos.Y);
+            untransformed.posZ.push_back(vertex.Pos.Z);
+            untransformed.normalX.push_back(vertex.Normal.X);
+            untransformed.normalY.push_back(vertex.Normal.Y);
+            untransformed.normalZ.push_back(vertex.Normal.Z);
         }
 
         for(irr::u32 j = 0; j < mesh.getMeshBuffer(i)->getIndexCount(); ++j) {
-            auto index = static_cast <irr::u16> (totalVertexCount) + mesh.getMeshBuffer(i)->getIndices()[j];
-            m_meshes.back().indices.push_back(index);
-
-            if(!m_recalculateMeshBuffer)
-                m_meshBuffer.Indices.push_back(index + m_meshes.back().verticesStartIndex);
+            newMesh.indices.push_back(static_cast <irr::u32> (totalVertexCount) + mesh.getMeshBuffer(i)->getIndices()[j]);
         }
 
         totalVertexCount += mesh.getMeshBuffer(i)->getVertexCount();
@@ -226,11 +255,17 @@ std::shared_ptr <int> MeshBatch::addMesh(irr::scene::IMesh &mesh, const std::vec
         m_reportedBadTexCoords = true;
     }
 
-    m_meshes.back().verticesEndIndex = static_cast <int> (m_meshBuffer.Vertices.size());
+    // if the whole buffer is going to be rebuilt anyway, then ranges are assigned there
+    if(!m_recalculateMeshBuffer) {
+        allocateMeshRanges(newMesh);
+        writeMeshVertices(newMesh);
+        writeMeshIndices(newMesh);
 
-    m_meshBuffer.setDirty();
+        m_meshBuffer.setDirty();
+        m_boundingBoxDirty = true;
+    }
 
-    return m_meshes.back().index;
+    return newMesh.index;
 }
 
 void MeshBatch::setMeshPosition(int index, const irr::core::vector3df &pos)
@@ -244,22 +279,10 @@ void MeshBatch::setMeshPosition(int index, const irr::core::vector3df &pos)
         m_meshes[index].pos = pos;
 
         if(!m_recalculateMeshBuffer) {
-            E_DASSERT(static_cast <int> (m_meshes[index].vertices.size()) == m_meshes[index].verticesEndIndex - m_meshes[index].verticesStartIndex,
-                      "Invalid mesh vertices count.");
-
-            E_DASSERT(m_meshes[index].verticesStartIndex >= 0 && static_cast <size_t> (m_meshes[index].verticesEndIndex) <= m_meshBuffer.Vertices.size(),
-                      "Mesh vertex index out of bounds while accessing batch mesh buffer.");
-
-            for(int i = m_meshes[index].verticesStartIndex, j = 0; i < m_meshes[index].verticesEndIndex; ++i, ++j) {
-                irr::core::vector3df verPos{m_meshes[index].vertices[j].Pos};
-                irr::core::vector3df verNormal{m_meshes[index].vertices[j].Normal};
-                transformVertex(verPos, verNormal, m_meshes[index]);
-                m_meshBuffer.Vertices[i].Pos = verPos;
-                m_meshBuffer.Vertices[i].Normal = verNormal;
-            }
+            transformMeshVertices(m_meshes[index]);
+            m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
+            m_boundingBoxDirty = true;
         }
-
-        m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
     }
 }
 
@@ -279,22 +302,10 @@ void MeshBatch::setMeshRotation(int index, const irr::core::vector3df &rot)
         m_meshes[index].rotationMatrix = mp;
 
         if(!m_recalculateMeshBuffer) {
-            E_DASSERT(static_cast <int> (m_meshes[index].vertices.size()) == m_meshes[index].verticesEndIndex - m_meshes[index].verticesStartIndex,
-                      "Invalid mesh vertices count.");
-
-            E_DASSERT(m_meshes[index].verticesStartIndex >= 0 && static_cast <size_t> (m_meshes[index].verticesEndIndex) <= m_meshBuffer.Vertices.size(),
-                      "Mesh vertex index out of bounds while accessing batch mesh buffer.");
-
-            for(int i = m_meshes[index].verticesStartIndex, j = 0; i < m_meshes[index].verticesEndIndex; ++i, ++j) {
-                irr::core::vector3df verPos{m_meshes[index].vertices[j].Pos};
-                irr::core::vector3df verNormal{m_meshes[index].vertices[j].Normal};
-                transformVertex(verPos, verNormal, m_meshes[index]);
-                m_meshBuffer.Vertices[i].Pos = verPos;
-                m_meshBuffer.Vertices[i].Normal = verNormal;
-            }
+            transformMeshVertices(m_meshes[index]);
+            m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
+            m_boundingBoxDirty = true;
         }
-
-        m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
     }
 }
 
@@ -309,16 +320,10 @@ void MeshBatch::setMeshScale(int index, const irr::core::vector3df &scale)
         m_meshes[index].scale = scale;
 
         if(!m_recalculateMeshBuffer) {
-            for(int i = m_meshes[index].verticesStartIndex, j = 0; i < m_meshes[index].verticesEndIndex; ++i, ++j) {
-                irr::core::vector3df verPos{m_meshes[index].vertices[j].Pos};
-                irr::core::vector3df verNormal{m_meshes[index].vertices[j].Normal};
-                transformVertex(verPos, verNormal, m_meshes[index]);
-                m_meshBuffer.Vertices[i].Pos = verPos;
-                m_meshBuffer.Vertices[i].Normal = verNormal;
-            }
+            transformMeshVertices(m_meshes[index]);
+            m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
+            m_boundingBoxDirty = true;
         }
-
-        m_meshBuffer.setDirty(irr::scene::EBT_VERTEX);
     }
 }
 
@@ -329,6 +334,21 @@ void MeshBatch::removeMesh(int index)
     if(index < 0 || static_cast <size_t> (index) >= m_meshes.size())
         return;
 
+    if(!m_recalculateMeshBuffer) {
+        auto vertexBufferSize = m_meshBuffer.getVertexBuffer().size();
+
+        freeMeshRanges(m_meshes[index]);
+
+        // compact lazily, only when holes take most of the buffer
+        if(m_freeVerticesCount * 2 > static_cast <int> (m_meshBuffer.getVertexBuffer().size()) ||
+           m_freeIndicesCount * 2 > static_cast <int> (m_meshBuffer.getIndexBuffer().size()))
+            m_recalculateMeshBuffer = true;
+        else if(m_meshBuffer.getVertexBuffer().size() != vertexBufferSize)
+            m_meshBuffer.setDirty();
+        else
+            m_meshBuffer.setDirty(irr::scene::EBT_INDEX);
+    }
+
     size_t lastIndex{m_meshes.size() - 1};
     std::swap(m_meshes[index], m_meshes[lastIndex]);
 
@@ -338,12 +358,10 @@ void MeshBatch::removeMesh(int index)
     *m_meshes[lastIndex].index = -1;
     m_meshes.pop_back();
 
+    m_boundingBoxDirty = true;
+
     if(static_cast <size_t> (index) != lastIndex)
         *m_meshes[index].index = index;
-
-    m_recalculateMeshBuffer = true;
-
-    m_meshBuffer.setDirty();
 }
 
 int MeshBatch::getMeshCount() const
@@ -361,7 +379,7 @@ int MeshBatch::getVertexCount() const
         });
     }
     else
-        return m_meshBuffer.Vertices.size();
+        return static_cast <int> (m_meshBuffer.getVertexBuffer().size()) - m_freeVerticesCount;
 }
 
 irr::video::E_MATERIAL_TYPE MeshBatch::getDefaultMaterialType() const
@@ -377,72 +395,364 @@ irr::video::E_MATERIAL_TYPE MeshBatch::getDefaultDeferredRenderingMaterialType()
 MeshBatch::Mesh::Mesh()
     : scale{1.f, 1.f, 1.f},
       verticesStartIndex{},
-      verticesEndIndex{}
+      verticesEndIndex{},
+      indicesStartIndex{},
+      indicesEndIndex{}
 {
     rotationMatrix.setRotationDegrees({0.f, 0.f, 0.f});
 }
 
-void MeshBatch::transformVertex(irr::core::vector3df &ver, irr::core::vector3df &normal, const Mesh &mesh)
+irr::core::aabbox3df MeshBatch::transformVertices(const VerticesSoA &vertices, const irr::core::vector3df &pos, const irr::core::matrix4 &rotationMatrix, const irr::core::vector3df &scale, irr::video::S3DVertex *outVertices, bool allowSSE)
 {
-    ver *= mesh.scale;
-    mesh.rotationMatrix.rotateVect(ver);
-    ver += mesh.pos;
+    if(vertices.posX.empty())
+        return irr::core::aabbox3df{pos};
+
+    // same as scaling, then matrix4::rotateVect and translating, but with scale folded into the rotation;
+    // normals are only rotated
+
+    const auto &r = rotationMatrix;
+
+    const float m[9]{r[0] * scale.X, r[4] * scale.Y, r[8] * scale.Z,
+                     r[1] * scale.X, r[5] * scale.Y, r[9] * scale.Z,
+                     r[2] * scale.X, r[6] * scale.Y, r[10] * scale.Z};
+
+    irr::core::vector3df min{std::numeric_limits <float>::max()};
+    irr::core::vector3df max{-std::numeric_limits <float>::max()};
+
+    int count{static_cast <int> (vertices.posX.size())};
+    int i{};
+
+#ifdef __SSE__
+    if(allowSSE) {
+        const __m128 m00{_mm_set1_ps(m[0])}, m01{_mm_set1_ps(m[1])}, m02{_mm_set1_ps(m[2])};
+        const __m128 m10{_mm_set1_ps(m[3])}, m11{_mm_set1_ps(m[4])}, m12{_mm_set1_ps(m[5])};
+        const __m128 m20{_mm_set1_ps(m[6])}, m21{_mm_set1_ps(m[7])}, m22{_mm_set1_ps(m[8])};
+        const __m128 r00{_mm_set1_ps(r[0])}, r01{_mm_set1_ps(r[4])}, r02{_mm_set1_ps(r[8])};
+        const __m128 r10{_mm_set1_ps(r[1])}, r11{_mm_set1_ps(r[5])}, r12{_mm_set1_ps(r[9])};
+        const __m128 r20{_mm_set1_ps(r[2])}, r21{_mm_set1_ps(r[6])}, r22{_mm_set1_ps(r[10])};
+        const __m128 tx{_mm_set1_ps(pos.X)}, ty{_mm_set1_ps(pos.Y)}, tz{_mm_set1_ps(pos.Z)};
+
+        __m128 minX{_mm_set1_ps(min.X)}, minY{minX}, minZ{minX};
+        __m128 maxX{_mm_set1_ps(max.X)}, maxY{maxX}, maxZ{maxX};
+
+        alignas(16) float out[6][4];
+
+        for(; i + 4 <= count; i += 4) {
+            __m128 x{_mm_loadu_ps(&vertices.posX[i])};
+            __m128 y{_mm_loadu_ps(&vertices.posY[i])};
+            __m128 z{_mm_loadu_ps(&vertices.posZ[i])};
+
+            __m128 px{_mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_add_ps(_mm_mul_ps(m02, z), tx))};
+            __m128 py{_mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m12, z), ty))};
+            __m128 pz{_mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), _mm_add_ps(_mm_mul_ps(m22, z), tz))};
+
+            x = _mm_loadu_ps(&vertices.normalX[i]);
+            y = _mm_loadu_ps(&vertices.normalY[i]);
+            z = _mm_loadu_ps(&vertices.normalZ[i]);
+
+            __m128 nx{_mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, x), _mm_mul_ps(r01, y)), _mm_mul_ps(r02, z))};
+            __m128 ny{_mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, x), _mm_mul_ps(r11, y)), _mm_mul_ps(r12, z))};
+            __m128 nz{_mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, x), _mm_mul_ps(r21, y)), _mm_mul_ps(r22, z))};
+
+            minX = _mm_min_ps(minX, px);
+            minY = _mm_min_ps(minY, py);
+            minZ = _mm_min_ps(minZ, pz);
+            maxX = _mm_max_ps(maxX, px);
+            maxY = _mm_max_ps(maxY, py);
+            maxZ = _mm_max_ps(maxZ, pz);
+
+            _mm_store_ps(out[0], px);
+            _mm_store_ps(out[1], py);
+            _mm_store_ps(out[2], pz);
+            _mm_store_ps(out[3], nx);
+            _mm_store_ps(out[4], ny);
+            _mm_store_ps(out[5], nz);
+
+            // vertex buffer is AoS, so results are scattered back
+            for(int j = 0; j < 4; ++j) {
+                outVertices[i + j].Pos.set(out[0][j], out[1][j], out[2][j]);
+                outVertices[i + j].Normal.set(out[3][j], out[4][j], out[5][j]);
+            }
+        }
+
+        _mm_store_ps(out[0], minX);
+        _mm_store_ps(out[1], minY);
+        _mm_store_ps(out[2], minZ);
+        _mm_store_ps(out[3], maxX);
+        _mm_store_ps(out[4], maxY);
+        _mm_store_ps(out[5], maxZ);
 
-    mesh.rotationMatrix.rotateVect(normal);
+        for(int j = 0; j < 4; ++j) {
+            min.set(std::min(min.X, out[0][j]), std::min(min.Y, out[1][j]), std::min(min.Z, out[2][j]));
+            max.set(std::max(max.X, out[3][j]), std::max(max.Y, out[4][j]), std::max(max.Z, out[5][j]));
+        }
+    }
+#endif
+
+    // remaining vertices (or all of them without SSE)
+    for(; i < count; ++i) {
+        float x{vertices.posX[i]}, y{vertices.posY[i]}, z{vertices.posZ[i]};
+
+        auto &outPos = outVertices[i].Pos;
+
+        outPos.set(m[0] * x + m[1] * y + m[2] * z + pos.X,
+                   m[3] * x + m[4] * y + m[5] * z + pos.Y,
+                   m[6] * x + m[7] * y + m[8] * z + pos.Z);
+
+        x = vertices.normalX[i];
+        y = vertices.normalY[i];
+        z = vertices.normalZ[i];
+
+        outVertices[i].Normal.set(r[0] * x + r[4] * y + r[8] * z,
+                                  r[1] * x + r[5] * y + r[9] * z,
+                                  r[2] * x + r[6] * y + r[10] * z);
+
+        min.set(std::min(min.X, outPos.X), std::min(min.Y, outPos.Y), std::min(min.Z, outPos.Z));
+        max.set(std::max(max.X, outPos.X), std::max(max.Y, outPos.Y), std::max(max.Z, outPos.Z));
+    }
+
+    irr::core::aabbox3df boundingBox{min};
+    boundingBox.addInternalPoint(max);
+
+    return boundingBox;
 }
 
-void MeshBatch::updateMeshes()
+int MeshBatch::takeFreeRange(std::vector <FreeRange> &freeRanges, int count, int bufferSize)
 {
-    TRACK;
+    // first fit; if no hole is big enough, then the range is appended at the end of the buffer
 
-    if(m_recalculateMeshBuffer) {
-        // in order to avoid reallocation, we overwrite mesh buffer vertices and indices
+    for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        if(it->end - it->start >= count) {
+            int start{it->start};
+
+            it->start += count;
 
-        size_t currentVertexIndex{};
-        size_t currentIndexIndex{};
+            if(it->start == it->end)
+                freeRanges.erase(it);
 
-        for(size_t i = 0; i < m_meshes.size(); ++i) {
-            m_meshes[i].verticesStartIndex = currentVertexIndex;
+            return start;
+        }
+    }
+
+    return bufferSize;
+}
 
-            for(size_t j = 0; j < m_meshes[i].vertices.size(); ++j) {
-                irr::video::S3DVertex newVertex{m_meshes[i].vertices[j]};
+void MeshBatch::addFreeRange(std::vector <FreeRange> &freeRanges, int start, int end)
+{
+    if(start == end)
+        return;
 
-                transformVertex(newVertex.Pos, newVertex.Normal, m_meshes[i]);
+    // sorted by start, adjacent ranges are merged
 
-                if(currentVertexIndex < m_meshBuffer.Vertices.size())
-                    m_meshBuffer.Vertices[currentVertexIndex] = newVertex;
-                else
-                    m_meshBuffer.Vertices.push_back(newVertex);
+    auto it = std::lower_bound(freeRanges.begin(), freeRanges.end(), start, [](const FreeRange &range, int value) {
+        return range.start < value;
+    });
 
-                ++currentVertexIndex;
-            }
+    it = freeRanges.insert(it, FreeRange{start, end});
 
-            m_meshes[i].verticesEndIndex = currentVertexIndex;
+    auto next = it + 1;
 
-            for(size_t j = 0; j < m_meshes[i].indices.size(); ++j) {
-                auto index = static_cast <irr::u16> (m_meshes[i].indices[j] + (m_meshes[i].verticesStartIndex));
+    if(next != freeRanges.end() && next->start == it->end) {
+        it->end = next->end;
+        freeRanges.erase(next);
+    }
 
-                if(currentIndexIndex < m_meshBuffer.Indices.size())
-                    m_meshBuffer.Indices[currentIndexIndex] = index;
-                else
-                    m_meshBuffer.Indices.push_back(index);
+    if(it != freeRanges.begin()) {
+        auto prev = it - 1;
 
-                ++currentIndexIndex;
-            }
+        if(prev->end == it->start) {
+            prev->end = it->end;
+            freeRanges.erase(it);
         }
+    }
+}
+
+void MeshBatch::allocateMeshRanges(Mesh &mesh)
+{
+    auto &vertexBuffer = m_meshBuffer.getVertexBuffer();
+    auto &indexBuffer = m_meshBuffer.getIndexBuffer();
 
-        if(currentVertexIndex < m_meshBuffer.Vertices.size())
-            m_meshBuffer.Vertices.erase(currentVertexIndex, m_meshBuffer.Vertices.size() - currentVertexIndex);
+    int verticesCount{static_cast <int> (mesh.vertices.size())};
+    int indicesCount{static_cast <int> (mesh.indices.size())};
+    int vertexBufferSize{static_cast <int> (vertexBuffer.size())};
+    int indexBufferSize{static_cast <int> (indexBuffer.size())};
 
-        if(currentIndexIndex < m_meshBuffer.Indices.size())
-            m_meshBuffer.Indices.erase(currentIndexIndex, m_meshBuffer.Indices.size() - currentIndexIndex);
+    mesh.verticesStartIndex = takeFreeRange(m_freeVertexRanges, verticesCount, vertexBufferSize);
+    mesh.verticesEndIndex = mesh.verticesStartIndex + verticesCount;
+
+    if(mesh.verticesStartIndex < vertexBufferSize)
+        m_freeVerticesCount -= verticesCount;
+    else
+        vertexBuffer.set_used(mesh.verticesEndIndex);
+
+    mesh.indicesStartIndex = takeFreeRange(m_freeIndexRanges, indicesCount, indexBufferSize);
+    mesh.indicesEndIndex = mesh.indicesStartIndex + indicesCount;
+
+    if(mesh.indicesStartIndex < indexBufferSize)
+        m_freeIndicesCount -= indicesCount;
+    else
+        indexBuffer.set_used(mesh.indicesEndIndex);
+
+    updateIndexType();
+}
+
+void MeshBatch::freeMeshRanges(const Mesh &mesh)
+{
+    auto &vertexBuffer = m_meshBuffer.getVertexBuffer();
+    auto &indexBuffer = m_meshBuffer.getIndexBuffer();
+
+    // removed mesh triangles become degenerate, so vertices don't have to be touched
+
+    for(int i = mesh.indicesStartIndex; i < mesh.indicesEndIndex; ++i) {
+        indexBuffer.setValue(i, 0);
+    }
+
+    addFreeRange(m_freeVertexRanges, mesh.verticesStartIndex, mesh.verticesEndIndex);
+    addFreeRange(m_freeIndexRanges, mesh.indicesStartIndex, mesh.indicesEndIndex);
+
+    m_freeVerticesCount += mesh.verticesEndIndex - mesh.verticesStartIndex;
+    m_freeIndicesCount += mesh.indicesEndIndex - mesh.indicesStartIndex;
+
+    // holes at the end of the buffer are simply cut off
+
+    if(!m_freeVertexRanges.empty() && m_freeVertexRanges.back().end == static_cast <int> (vertexBuffer.size())) {
+        m_freeVerticesCount -= m_freeVertexRanges.back().end - m_freeVertexRanges.back().start;
+        vertexBuffer.set_used(m_freeVertexRanges.back().start);
+        m_freeVertexRanges.pop_back();
+    }
+
+    if(!m_freeIndexRanges.empty() && m_freeIndexRanges.back().end == static_cast <int> (indexBuffer.size())) {
+        m_freeIndicesCount -= m_freeIndexRanges.back().end - m_freeIndexRanges.back().start;
+        indexBuffer.set_used(m_freeIndexRanges.back().start);
+        m_freeIndexRanges.pop_back();
+    }
+}
+
+void MeshBatch::updateIndexType()
+{
+    // 16-bit indices are enough for most batches, but holes can push the buffer past their range
+
+    auto indexType = m_meshBuffer.getVertexBuffer().size() > static_cast <irr::u32> (k_max16BitIndexedVertices) ? irr::video::EIT_32BIT : irr::video::EIT_16BIT;
+
+    if(m_meshBuffer.getIndexBuffer().getType() != indexType)
+        m_meshBuffer.getIndexBuffer().setType(indexType);
+}
+
+void MeshBatch::writeMeshVertices(Mesh &mesh)
+{
+    E_DASSERT(static_cast <int> (mesh.vertices.size()) == mesh.verticesEndIndex - mesh.verticesStartIndex,
+              "Invalid mesh vertices count.");
+
+    E_DASSERT(mesh.verticesStartIndex >= 0 && static_cast <irr::u32> (mesh.verticesEndIndex) <= m_meshBuffer.getVertexBuffer().size(),
+              "Mesh vertex index out of bounds while accessing batch mesh buffer.");
+
+    if(!mesh.vertices.empty()) {
+        auto *vertices = static_cast <irr::video::S3DVertex*> (m_meshBuffer.getVertexBuffer().getData());
+        std::copy(mesh.vertices.begin(), mesh.vertices.end(), vertices + mesh.verticesStartIndex);
+    }
+
+    transformMeshVertices(mesh);
+}
+
+void MeshBatch::transformMeshVertices(Mesh &mesh)
+{
+    E_DASSERT(mesh.verticesStartIndex >= 0 && static_cast <irr::u32> (mesh.verticesEndIndex) <= m_meshBuffer.getVertexBuffer().size(),
+              "Mesh vertex index out of bounds while accessing batch mesh buffer.");
+
+    int count{mesh.verticesEndIndex - mesh.verticesStartIndex};
+
+    if(!count) {
+        mesh.boundingBox.reset(mesh.pos);
+        return;
+    }
+
+    E_DASSERT(static_cast <int> (mesh.untransformedVertices.posX.size()) == count, "Invalid mesh vertices count.");
+
+    auto *vertices = static_cast <irr::video::S3DVertex*> (m_meshBuffer.getVertexBuffer().getData()) + mesh.verticesStartIndex;
+
+    mesh.boundingBox = transformVertices(mesh.untransformedVertices, mesh.pos, mesh.rotationMatrix, mesh.scale, vertices);
+}
+
+void MeshBatch::writeMeshIndices(const Mesh &mesh)
+{
+    E_DASSERT(static_cast <int> (mesh.indices.size()) == mesh.indicesEndIndex - mesh.indicesStartIndex,
+              "Invalid mesh indices count.");
+
+    E_DASSERT(mesh.indicesStartIndex >= 0 && static_cast <irr::u32> (mesh.indicesEndIndex) <= m_meshBuffer.getIndexBuffer().size(),
+              "Mesh index out of bounds while accessing batch mesh buffer.");
+
+    auto &indexBuffer = m_meshBuffer.getIndexBuffer();
+
+    for(int i = mesh.indicesStartIndex, j = 0; i < mesh.indicesEndIndex; ++i, ++j) {
+        indexBuffer.setValue(i, mesh.indices[j] + mesh.verticesStartIndex);
+    }
+}
+
+void MeshBatch::updateMeshes()
+{
+    TRACK;
+
+    if(m_recalculateMeshBuffer) {
+        // meshes are packed tightly again; set_used doesn't shrink the capacity, so there is no reallocation
+
+        int currentVertexIndex{};
+        int currentIndexIndex{};
+
+        for(auto &elem : m_meshes) {
+            elem.verticesStartIndex = currentVertexIndex;
+            currentVertexIndex += elem.vertices.size();
+            elem.verticesEndIndex = currentVertexIndex;
+
+            elem.indicesStartIndex = currentIndexIndex;
+            currentIndexIndex += elem.indices.size();
+            elem.indicesEndIndex = currentIndexIndex;
+        }
+
+        m_meshBuffer.getVertexBuffer().set_used(currentVertexIndex);
+        m_meshBuffer.getIndexBuffer().set_used(currentIndexIndex);
+
+        m_freeVertexRanges.clear();
+        m_freeIndexRanges.clear();
+        m_freeVerticesCount = 0;
+        m_freeIndicesCount = 0;
+
+        updateIndexType();
+
+        for(auto &elem : m_meshes) {
+            writeMeshVertices(elem);
+            writeMeshIndices(elem);
+        }
 
         m_recalculateMeshBuffer = false;
         m_meshBuffer.setDirty();
+        m_boundingBoxDirty = true;
+
+        E_COUNTER_ADD("Mesh batch rebuilds", 1);
+        E_COUNTER_ADD("Mesh batch rebuilt vertices", currentVertexIndex);
+    }
+}
+
+void MeshBatch::updateBoundingBox()
+{
+    if(!m_boundingBoxDirty)
+        return;
+
+    m_boundingBoxDirty = false;
+
+    if(m_meshes.empty()) {
+        m_boundingBox.reset(0.f, 0.f, 0.f);
+        return;
+    }
+
+    m_boundingBox = m_meshes[0].boundingBox;
+
+    for(size_t i = 1; i < m_meshes.size(); ++i) {
+        m_boundingBox.addInternalBox(m_meshes[i].boundingBox);
     }
 }
 
-int MeshBatch::k_maxVertices{50000};
+int MeshBatch::k_maxVertices{200000};
+const int MeshBatch::k_max16BitIndexedVertices{65536};
 
 } // namespace irrNodes
 } // namespace app3D
@@ -19,6 +19,13 @@ namespace irrNodes
 class MeshBatch : public irr::scene::ISceneNode, public Tracked <MeshBatch>
 {
 public:
+    // untransformed positions and normals as SoA, so they can be transformed 4 at a time
+    struct VerticesSoA
+    {
+        std::vector <float> posX, posY, posZ;
+        std::vector <float> normalX, normalY, normalZ;
+    };
+
     MeshBatch(irr::scene::ISceneManager &sceneManager, irr::video::ITexture &textureAtlas, irr::video::E_MATERIAL_TYPE defaultMaterialType, irr::video::E_MATERIAL_TYPE defaultDeferredRenderingMaterialType);
 
     void OnRegisterSceneNode() override;
@@ -27,7 +34,7 @@ public:
     irr::u32 getMaterialCount() const override;
     const irr::core::aabbox3df &getBoundingBox() const override;
     void updateMaterial(bool useDeferredRendering);
-    std::shared_ptr <int> addMesh(irr::scene::IMesh &mesh, const std::vector <FloatRect> &textureAtlasRects, bool forceAllUpNormals);
+    std::shared_ptr <int> addMesh(irr::scene::IMesh &mesh, const std::vector <FloatRect> &textureAtlasRects, bool forceAllUpNormals, const irr::core::vector3df &pos, const irr::core::vector3df &rot, const irr::core::vector3df &scale);
     void setMeshPosition(int index, const irr::core::vector3df &pos);
     void setMeshRotation(int index, const irr::core::vector3df &rot);
     void setMeshScale(int index, const irr::core::vector3df &scale);
@@ -37,6 +44,10 @@ public:
     irr::video::E_MATERIAL_TYPE getDefaultMaterialType() const;
     irr::video::E_MATERIAL_TYPE getDefaultDeferredRenderingMaterialType() const;
 
+    // scales, rotates and translates positions, rotates normals, and writes them to outVertices;
+    // returns bounding box of transformed positions; without allowSSE only the scalar path is used
+    static irr::core::aabbox3df transformVertices(const VerticesSoA &vertices, const irr::core::vector3df &pos, const irr::core::matrix4 &rotationMatrix, const irr::core::vector3df &scale, irr::video::S3DVertex *outVertices, bool allowSSE = true);
+
 private:
     struct Mesh
     {
@@ -46,16 +57,36 @@ private:
         irr::core::vector3df pos, rot, scale;
         int verticesStartIndex;
         int verticesEndIndex;
+        int indicesStartIndex;
+        int indicesEndIndex;
         irr::core::matrix4 rotationMatrix;
+        irr::core::aabbox3df boundingBox; // transformed
         std::vector <irr::video::S3DVertex> vertices;
-        std::vector <irr::u16> indices;
+        std::vector <irr::u32> indices; // relative to verticesStartIndex
+        VerticesSoA untransformedVertices;
+    };
+
+    // [start, end) range of unused vertices or indices in the mesh buffer
+    struct FreeRange
+    {
+        int start;
+        int end;
     };
 
-    static void transformVertex(irr::core::vector3df &ver, irr::core::vector3df &normal, const Mesh &mesh);
+    static int takeFreeRange(std::vector <FreeRange> &freeRanges, int count, int bufferSize);
+    static void addFreeRange(std::vector <FreeRange> &freeRanges, int start, int end);
 
+    void allocateMeshRanges(Mesh &mesh);
+    void freeMeshRanges(const Mesh &mesh);
+    void updateIndexType();
+    void writeMeshVertices(Mesh &mesh);
+    void transformMeshVertices(Mesh &mesh);
+    void writeMeshIndices(const Mesh &mesh);
     void updateMeshes();
+    void updateBoundingBox();
 
     static int k_maxVertices;
+    static const int k_max16BitIndexedVertices;
 
     bool m_deferredRendering;
     irr::video::E_MATERIAL_TYPE m_defaultMaterialType;
@@ -63,8 +94,14 @@ private:
     bool m_recalculateMeshBuffer;
     bool m_reportedBadTexCoords;
     std::vector <Mesh> m_meshes;
+    std::vector <FreeRange> m_freeVertexRanges;
+    std::vector <FreeRange> m_freeIndexRanges;
+    int m_freeVerticesCount;
+    int m_freeIndicesCount;
+    irr::core::aabbox3df m_boundingBox;
+    bool m_boundingBoxDirty;
     irr::video::SMaterial m_material;
-    irr::scene::SMeshBuffer m_meshBuffer;
+    irr::scene::CDynamicMeshBuffer m_meshBuffer;
 };
 
 } // namespace irrNodes
@@ -257,9 +257,11 @@ bool BillboardBatchManager::packTextures(const std::vector <irr::video::ITexture
     }
 
     std::vector <FloatRect> billboardTexCoords;
-    auto *billboardTextureAtlas = m_device.getResourcesManager().getPackedTexture(billboardTextures, billboardTexCoords);
+    std::vector <int> billboardTexturePages;
 
-    if(!billboardTextureAtlas) {
+    const auto &billboardTextureAtlases = m_device.getResourcesManager().getPackedTextures(billboardTextures, batchTag, billboardTexCoords, billboardTexturePages);
+
+    if(billboardTextureAtlases.empty()) {
         int count{to - from + 1};
         int leftCount{count / 2};
         int rightCount{count - leftCount};
@@ -278,31 +280,37 @@ bool BillboardBatchManager::packTextures(const std::vector <irr::video::ITexture
             return false;
     }
     else {
-        E_RASSERT(billboardTexCoords.size() == billboardTextures.size(),
+        E_RASSERT(billboardTexCoords.size() == billboardTextures.size() && billboardTexturePages.size() == billboardTextures.size(),
                   "Billboard tex coords count does not equal billboard textures count.");
 
-        m_batches.emplace_back();
+        // one batch per atlas page
+        int firstBatchIndex{static_cast <int> (m_batches.size())};
 
-        auto &back = m_batches.back();
+        for(auto *atlas : billboardTextureAtlases) {
+            E_DASSERT(atlas, "Texture atlas is nullptr.");
 
-        back.reserve(10);
-        back.push_back(new irrNodes::BillboardBatch{*m_device.getIrrDevice().getSceneManager(),
-                                                    *billboardTextureAtlas,
-                                                    irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL,
-                                                    irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL});
+            m_batches.emplace_back();
 
-        // it's added to the Irrlicht scene manager, so we can drop it
-        back.back()->drop();
+            auto &back = m_batches.back();
+
+            back.reserve(10);
+            back.push_back(new irrNodes::BillboardBatch{*m_device.getIrrDevice().getSceneManager(),
+                                                        *atlas,
+                                                        irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL,
+                                                        irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL});
+
+            // it's added to the Irrlicht scene manager, so we can drop it
+            back.back()->drop();
+        }
 
         for(int i = from; i <= to; ++i) {
             auto &m = m_registeredBillboards[std::make_pair(billboards[i], batchTag)];
 
-            m.batchIndex = m_batches.size() - 1;
-
             bool found{};
 
             for(size_t j = 0; j < billboardTextures.size(); ++j) {
                 if(billboards[i] == billboardTextures[j]) {
+                    m.batchIndex = firstBatchIndex + billboardTexturePages[j];
                     m.textureAtlasRect = billboardTexCoords[j];
                     found = true;
                     break;
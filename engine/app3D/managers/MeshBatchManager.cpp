@@ -7,6 +7,8 @@
 #include "../IrrlichtConversions.hpp"
 #include "ResourcesManager.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 namespace engine
@@ -31,63 +33,30 @@ void MeshBatchManager::registerMesh(irr::scene::IMesh &mesh, const std::string &
         m_registeredMeshes.emplace(key, RegisteredMesh{});
 }
 
-std::shared_ptr <int> MeshBatchManager::addMesh(irr::scene::IMesh &mesh, const std::string &batchTag, bool forceAllUpNormals)
+std::shared_ptr <int> MeshBatchManager::addMesh(irr::scene::IMesh &mesh, const std::string &batchTag, const FloatVec3 &pos, const FloatVec3 &rot, const FloatVec3 &scale, bool forceAllUpNormals)
 {
     TRACK;
 
-    auto &m = m_registeredMeshes[std::make_pair(&mesh, batchTag)];
+    const auto &m = m_registeredMeshes[std::make_pair(&mesh, batchTag)];
 
     // if this mesh hasn't been added to any batch yet, then recreate all batches
     if(m.batchIndex < 0)
         createBatches();
 
-    E_DASSERT(m.batchIndex >= 0 && static_cast <size_t> (m.batchIndex) < m_batches.size(), "Batch index out of bounds.");
-    E_DASSERT(!m_batches[m.batchIndex].empty(), "There must be at least one batch available.");
-    E_DASSERT(m_batches[m.batchIndex][0], "First batch is nullptr.");
-
-    int batchSecondLevelIndex{-1};
-
-    for(size_t i = 0; i < m_batches[m.batchIndex].size(); ++i) {
-        E_DASSERT(m_batches[m.batchIndex][i], "Batch is nullptr.");
-
-        if(m_batches[m.batchIndex][i]->getVertexCount() < k_maxVerticesPerBatch) {
-            batchSecondLevelIndex = static_cast <int> (i);
-            break;
-        }
-    }
-
-    if(batchSecondLevelIndex < 0) {
-        auto &batch = *m_batches[m.batchIndex][0];
-        auto *tex = batch.getMaterial(0).TextureLayer[0].Texture;
-        auto matType1 = batch.getDefaultMaterialType();
-        auto matType2 = batch.getDefaultDeferredRenderingMaterialType();
-
-        E_DASSERT(tex, "Mesh batch texture is nullptr.");
-
-        m_batches[m.batchIndex].push_back(new irrNodes::MeshBatch{*m_device.getIrrDevice().getSceneManager(),
-                                                                  *tex,
-                                                                  matType1,
-                                                                  matType2});
-
-        // it's added to the Irrlicht scene manager, so we can drop it
-        m_batches[m.batchIndex].back()->drop();
-        batchSecondLevelIndex = static_cast <int> (m_batches[m.batchIndex].size() - 1);
-    }
-
-    const auto &batchedMeshIndex = m_batches[m.batchIndex][batchSecondLevelIndex]->addMesh(mesh, m.textureAtlasRects, forceAllUpNormals);
-
     m_batchedMeshes.emplace_back();
 
     auto &added = m_batchedMeshes.back();
 
     added.mesh = &mesh;
     added.batchTag = batchTag;
-    added.batchIndex = m.batchIndex;
-    added.batchSecondLevelIndex = batchSecondLevelIndex;
-    added.batchedMeshIndex = batchedMeshIndex;
+    added.pos = pos;
+    added.rot = rot;
+    added.scale = scale;
     added.index = std::make_shared <int> (m_batchedMeshes.size() - 1);
     added.forceAllUpNormals = forceAllUpNormals;
 
+    addToBatch(added);
+
     return added.index;
 }
 
@@ -100,19 +69,17 @@ void MeshBatchManager::setMeshPosition(int index, const FloatVec3 &pos)
 
     auto &batchedMesh = m_batchedMeshes[index];
 
-    E_DASSERT(batchedMesh.batchIndex >= 0 && static_cast <size_t> (batchedMesh.batchIndex) < m_batches.size(),
-              "Batched mesh batch index out of bounds.");
-
-    E_DASSERT(batchedMesh.batchedMeshIndex, "Batched mesh index is nullptr.");
-
-    E_DASSERT(batchedMesh.batchSecondLevelIndex >= 0 && static_cast <size_t> (batchedMesh.batchSecondLevelIndex) < m_batches[batchedMesh.batchIndex].size(),
-              "Batched mesh batch second level index out of bounds.");
-
-    E_DASSERT(m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex],
-              "Batch is nullptr.");
+    batchedMesh.pos = pos;
 
-    const auto &irrPos = IrrlichtConversions::toVector(pos);
-    m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex]->setMeshPosition(*batchedMesh.batchedMeshIndex, irrPos);
+    // moved to another chunk
+    if(getChunk(pos) != batchedMesh.chunk) {
+        removeFromBatch(batchedMesh);
+        addToBatch(batchedMesh);
+    }
+    else {
+        const auto &irrPos = IrrlichtConversions::toVector(pos);
+        getBatch(batchedMesh).setMeshPosition(*batchedMesh.batchedMeshIndex, irrPos);
+    }
 }
 
 void MeshBatchManager::setMeshRotation(int index, const FloatVec3 &rot)
@@ -124,19 +91,10 @@ void MeshBatchManager::setMeshRotation(int index, const FloatVec3 &rot)
 
     auto &batchedMesh = m_batchedMeshes[index];
 
-    E_DASSERT(batchedMesh.batchIndex >= 0 && static_cast <size_t> (batchedMesh.batchIndex) < m_batches.size(),
-              "Batched mesh batch index out of bounds.");
-
-    E_DASSERT(batchedMesh.batchedMeshIndex, "Batched mesh index is nullptr.");
-
-    E_DASSERT(batchedMesh.batchSecondLevelIndex >= 0 && static_cast <size_t> (batchedMesh.batchSecondLevelIndex) < m_batches[batchedMesh.batchIndex].size(),
-              "Batched mesh batch second level index out of bounds.");
-
-    E_DASSERT(m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex],
-              "Batch is nullptr.");
+    batchedMesh.rot = rot;
 
     const auto &irrRot = IrrlichtConversions::toVector(rot);
-    m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex]->setMeshRotation(*batchedMesh.batchedMeshIndex, irrRot);
+    getBatch(batchedMesh).setMeshRotation(*batchedMesh.batchedMeshIndex, irrRot);
 }
 
 void MeshBatchManager::setMeshScale(int index, const FloatVec3 &scale)
@@ -148,19 +106,10 @@ void MeshBatchManager::setMeshScale(int index, const FloatVec3 &scale)
 
     auto &batchedMesh = m_batchedMeshes[index];
 
-    E_DASSERT(batchedMesh.batchIndex >= 0 && static_cast <size_t> (batchedMesh.batchIndex) < m_batches.size(),
-              "Batched mesh batch index out of bounds.");
-
-    E_DASSERT(batchedMesh.batchedMeshIndex, "Batched mesh index is nullptr.");
-
-    E_DASSERT(batchedMesh.batchSecondLevelIndex >= 0 && static_cast <size_t> (batchedMesh.batchSecondLevelIndex) < m_batches[batchedMesh.batchIndex].size(),
-              "Batched mesh batch second level index out of bounds.");
-
-    E_DASSERT(m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex],
-              "Batch is nullptr.");
+    batchedMesh.scale = scale;
 
     const auto &irrScale = IrrlichtConversions::toVector(scale);
-    m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex]->setMeshScale(*batchedMesh.batchedMeshIndex, irrScale);
+    getBatch(batchedMesh).setMeshScale(*batchedMesh.batchedMeshIndex, irrScale);
 }
 
 void MeshBatchManager::removeMesh(int index)
@@ -170,22 +119,7 @@ void MeshBatchManager::removeMesh(int index)
     if(index < 0 || static_cast <size_t> (index) >= m_batchedMeshes.size())
        return;
 
-    auto &batchedMesh = m_batchedMeshes[index];
-
-    E_DASSERT(batchedMesh.batchIndex >= 0 && static_cast <size_t> (batchedMesh.batchIndex) < m_batches.size(),
-              "Batched mesh batch index out of bounds.");
-
-    E_DASSERT(batchedMesh.batchedMeshIndex, "Batched mesh index is nullptr.");
-
-    E_DASSERT(batchedMesh.batchSecondLevelIndex >= 0 && static_cast <size_t> (batchedMesh.batchSecondLevelIndex) < m_batches[batchedMesh.batchIndex].size(),
-              "Batched mesh batch second level index out of bounds.");
-
-    E_DASSERT(m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex],
-              "Batch is nullptr.");
-
-    m_batches[batchedMesh.batchIndex][batchedMesh.batchSecondLevelIndex]->removeMesh(*batchedMesh.batchedMeshIndex);
-
-    // batchedMesh variable invalidated
+    removeFromBatch(m_batchedMeshes[index]);
 
     size_t lastIndex{m_batchedMeshes.size() - 1};
     std::swap(m_batchedMeshes[index], m_batchedMeshes[lastIndex]);
@@ -211,10 +145,12 @@ void MeshBatchManager::createBatches()
         *elem.batchedMeshIndex = -1;
     }
 
-    for(auto &elem1 : m_batches) {
-        for(auto &elem2 : elem1) {
-            E_DASSERT(elem2, "Batch is nullptr.");
-            elem2->remove();
+    for(auto &group : m_batches) {
+        for(auto &chunk : group.chunks) {
+            for(auto &elem : chunk.second) {
+                E_DASSERT(elem, "Batch is nullptr.");
+                elem->remove();
+            }
         }
     }
 
@@ -241,7 +177,7 @@ void MeshBatchManager::createBatches()
             }
 
             if(!meshes.empty()) {
-                if(!packTextures(meshes, 0, meshes.size() - 1, b)) {
+                if(!packTextures(meshes, b)) {
                     if(b.empty())
                         throw Exception{"Textures did not fit in packed textures."};
                     else
@@ -250,118 +186,272 @@ void MeshBatchManager::createBatches()
             }
         }
 
-        E_INFO("Mesh batches count: %d.", static_cast <int> (m_batches.size()));
+        E_INFO("Mesh batch groups count: %d.", static_cast <int> (m_batches.size()));
     }
 
     for(auto &elem : m_batchedMeshes) {
         E_DASSERT(elem.mesh, "Mesh is nullptr.");
-        elem.batchedMeshIndex = addMesh(*elem.mesh, elem.batchTag, elem.forceAllUpNormals);
+        addToBatch(elem);
     }
 }
 
-bool MeshBatchManager::packTextures(const std::vector <irr::scene::IMesh *> &meshes, int from, int to, const std::string &batchTag)
+bool MeshBatchManager::packTextures(const std::vector <irr::scene::IMesh *> &meshes, const std::string &batchTag)
 {
     TRACK;
 
-    E_DASSERT(to - from >= 0, "Empty range.");
+    E_DASSERT(!meshes.empty(), "Empty range.");
 
     std::set <irr::video::ITexture *> meshTexturesSet;
-    bool wantsTransparency{};
 
-    for(int i = from; i <= to; ++i) {
-        E_DASSERT(meshes[i], "Mesh is nullptr.");
+    for(const auto *mesh : meshes) {
+        E_DASSERT(mesh, "Mesh is nullptr.");
 
-        for(irr::u32 j = 0; j < meshes[i]->getMeshBufferCount(); ++j) {
-            auto &mat = meshes[i]->getMeshBuffer(j)->getMaterial();
-            auto *meshTex = mat.TextureLayer[0].Texture;
+        for(irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+            auto *meshTex = mesh->getMeshBuffer(i)->getMaterial().TextureLayer[0].Texture;
 
-            if(meshTex) {
+            if(meshTex)
                 meshTexturesSet.insert(meshTex);
+        }
+    }
 
-                if(mat.MaterialType == irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL ||
-                   mat.MaterialType == irr::video::EMT_TRANSPARENT_ADD_COLOR ||
-                   mat.MaterialType == irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF)
-                    wantsTransparency = true;
-            }
+    // sorted, so textures can be found using binary search
+    std::vector <irr::video::ITexture *> meshTextures(meshTexturesSet.begin(), meshTexturesSet.end());
+    std::vector <FloatRect> meshTexCoords;
+    std::vector <int> meshTexturePages;
+
+    const auto &meshTextureAtlases = m_device.getResourcesManager().getPackedTextures(meshTextures, batchTag, meshTexCoords, meshTexturePages);
+
+    if(meshTextureAtlases.empty())
+        return packTexturesInHalves(meshes, batchTag);
+
+    E_RASSERT(meshTexCoords.size() == meshTextures.size() && meshTexturePages.size() == meshTextures.size(),
+              "Mesh tex coords count does not equal mesh textures count.");
+
+    // every mesh is batched with the atlas page which contains its textures,
+    // meshes with textures spread over multiple pages are packed again on their own
+
+    std::vector <std::vector <irr::scene::IMesh *>> meshesByPage(meshTextureAtlases.size());
+    std::vector <irr::scene::IMesh *> meshesInMultiplePages;
+
+    for(auto *mesh : meshes) {
+        int page{-1};
+        bool multiplePages{};
+
+        for(irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+            auto *meshTex = mesh->getMeshBuffer(i)->getMaterial().TextureLayer[0].Texture;
+
+            if(!meshTex)
+                continue;
+
+            auto it = std::lower_bound(meshTextures.begin(), meshTextures.end(), meshTex);
+
+            E_DASSERT(it != meshTextures.end() && *it == meshTex, "No texture found.");
+
+            int texturePage{meshTexturePages[it - meshTextures.begin()]};
+
+            if(page < 0)
+                page = texturePage;
+            else if(page != texturePage)
+                multiplePages = true;
         }
+
+        if(multiplePages)
+            meshesInMultiplePages.push_back(mesh);
+        else
+            meshesByPage[page < 0 ? 0 : page].push_back(mesh);
     }
 
-    std::vector <irr::video::ITexture *> meshTextures;
+    if(meshesInMultiplePages.size() == meshes.size())
+        return packTexturesInHalves(meshes, batchTag);
 
-    for(auto &elem : meshTexturesSet) {
-        meshTextures.push_back(elem);
+    for(size_t i = 0; i < meshesByPage.size(); ++i) {
+        if(!meshesByPage[i].empty()) {
+            E_DASSERT(meshTextureAtlases[i], "Texture atlas is nullptr.");
+            addBatchesGroup(*meshTextureAtlases[i], meshesByPage[i], meshTextures, meshTexCoords, batchTag);
+        }
     }
 
-    std::vector <FloatRect> meshTexCoords;
-    auto *meshTextureAtlas = m_device.getResourcesManager().getPackedTexture(meshTextures, meshTexCoords);
+    if(!meshesInMultiplePages.empty())
+        return packTextures(meshesInMultiplePages, batchTag);
 
-    if(!meshTextureAtlas) {
-        int count{to - from + 1};
-        int leftCount{count / 2};
-        int rightCount{count - leftCount};
+    return true;
+}
 
-        if(!leftCount || !rightCount)
-            return false;
+bool MeshBatchManager::packTexturesInHalves(const std::vector <irr::scene::IMesh *> &meshes, const std::string &batchTag)
+{
+    TRACK;
 
-        bool leftStatus{packTextures(meshes, from, from + leftCount - 1, batchTag)};
+    size_t leftCount{meshes.size() / 2};
 
-        if(!leftStatus)
-            return false;
+    if(!leftCount)
+        return false;
 
-        bool rightStatus{packTextures(meshes, from + leftCount, from + leftCount + rightCount - 1, batchTag)};
+    std::vector <irr::scene::IMesh *> left(meshes.begin(), meshes.begin() + leftCount);
+    std::vector <irr::scene::IMesh *> right(meshes.begin() + leftCount, meshes.end());
 
-        if(!rightStatus)
-            return false;
-    }
-    else {
-        E_RASSERT(meshTexCoords.size() == meshTextures.size(),
-                  "Mesh tex coords count does not equal mesh textures count.");
+    return packTextures(left, batchTag) && packTextures(right, batchTag);
+}
 
-        m_batches.resize(m_batches.size() + 1);
+void MeshBatchManager::addBatchesGroup(irr::video::ITexture &textureAtlas, const std::vector <irr::scene::IMesh *> &meshes, const std::vector <irr::video::ITexture *> &textures, const std::vector <FloatRect> &texCoords, const std::string &batchTag)
+{
+    TRACK;
 
-        auto &back = m_batches.back();
-        auto matType = wantsTransparency ? irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF : irr::video::EMT_SOLID;
+    bool wantsTransparency{};
 
-        back.reserve(10);
-        back.push_back(new irrNodes::MeshBatch{*m_device.getIrrDevice().getSceneManager(),
-                                               *meshTextureAtlas,
-                                               matType,
-                                               matType});
+    for(const auto *mesh : meshes) {
+        for(irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+            auto &mat = mesh->getMeshBuffer(i)->getMaterial();
 
-        // it's added to the Irrlicht scene manager, so we can drop it
-        back.back()->drop();
+            if(mat.TextureLayer[0].Texture &&
+               (mat.MaterialType == irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL ||
+                mat.MaterialType == irr::video::EMT_TRANSPARENT_ADD_COLOR ||
+                mat.MaterialType == irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF))
+                wantsTransparency = true;
+        }
+    }
 
-        for(int i = from; i <= to; ++i) {
-            auto &m = m_registeredMeshes[std::make_pair(meshes[i], batchTag)];
+    // batches are created when meshes are added to chunks
+    m_batches.emplace_back();
 
-            m.batchIndex = m_batches.size() - 1;
+    auto &back = m_batches.back();
 
-            for(irr::u32 j = 0; j < meshes[i]->getMeshBufferCount(); ++j) {
-                auto *meshTex = meshes[i]->getMeshBuffer(j)->getMaterial().TextureLayer[0].Texture;
+    back.textureAtlas = &textureAtlas;
+    back.materialType = wantsTransparency ? irr::video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF : irr::video::EMT_SOLID;
 
-                if(!meshTex)
-                    m.textureAtlasRects.emplace_back();
-                else {
-                    bool found{};
+    for(auto *mesh : meshes) {
+        auto &m = m_registeredMeshes[std::make_pair(mesh, batchTag)];
 
-                    for(size_t k = 0; k < meshTextures.size(); ++k) {
-                        if(meshTex == meshTextures[k]) {
-                            m.textureAtlasRects.push_back(meshTexCoords[k]);
-                            found = true;
-                            break;
-                        }
-                    }
+        m.batchIndex = m_batches.size() - 1;
 
-                    E_DASSERT(found, "No texture found.");
-                }
+        for(irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i) {
+            auto *meshTex = mesh->getMeshBuffer(i)->getMaterial().TextureLayer[0].Texture;
+
+            if(!meshTex)
+                m.textureAtlasRects.emplace_back();
+            else {
+                auto it = std::lower_bound(textures.begin(), textures.end(), meshTex);
+
+                E_DASSERT(it != textures.end() && *it == meshTex, "No texture found.");
+
+                m.textureAtlasRects.push_back(texCoords[it - textures.begin()]);
             }
         }
     }
+}
 
-    return true;
+void MeshBatchManager::addToBatch(BatchedMeshInfo &batchedMesh)
+{
+    TRACK;
+
+    E_DASSERT(batchedMesh.mesh, "Mesh is nullptr.");
+
+    const auto &m = m_registeredMeshes[std::make_pair(batchedMesh.mesh, batchedMesh.batchTag)];
+
+    E_DASSERT(m.batchIndex >= 0 && static_cast <size_t> (m.batchIndex) < m_batches.size(), "Batch index out of bounds.");
+
+    auto &group = m_batches[m.batchIndex];
+
+    batchedMesh.batchIndex = m.batchIndex;
+    batchedMesh.chunk = getChunk(batchedMesh.pos);
+
+    auto &batches = group.chunks[batchedMesh.chunk];
+    int batchSecondLevelIndex{findBatchWithFreeSpace(batches)};
+
+    if(batchSecondLevelIndex < 0) {
+        E_DASSERT(group.textureAtlas, "Mesh batch texture is nullptr.");
+
+        batches.push_back(new irrNodes::MeshBatch{*m_device.getIrrDevice().getSceneManager(),
+                                                  *group.textureAtlas,
+                                                  group.materialType,
+                                                  group.materialType});
+
+        // it's added to the Irrlicht scene manager, so we can drop it
+        batches.back()->drop();
+        batchSecondLevelIndex = static_cast <int> (batches.size() - 1);
+    }
+
+    auto &batch = *batches[batchSecondLevelIndex];
+
+    batchedMesh.batchSecondLevelIndex = batchSecondLevelIndex;
+    batchedMesh.batchedMeshIndex = batch.addMesh(*batchedMesh.mesh,
+                                                 m.textureAtlasRects,
+                                                 batchedMesh.forceAllUpNormals,
+                                                 IrrlichtConversions::toVector(batchedMesh.pos),
+                                                 IrrlichtConversions::toVector(batchedMesh.rot),
+                                                 IrrlichtConversions::toVector(batchedMesh.scale));
+}
+
+void MeshBatchManager::removeFromBatch(const BatchedMeshInfo &batchedMesh)
+{
+    TRACK;
+
+    getBatch(batchedMesh).removeMesh(*batchedMesh.batchedMeshIndex);
+
+    // Meshes moved across the map would otherwise leave batches (scene nodes) in every chunk they passed.
+    // Empty batches in the middle are kept, because meshes refer to the batches after them by index,
+    // and they are reused by the next mesh added to this chunk.
+
+    auto &chunks = m_batches[batchedMesh.batchIndex].chunks;
+    const auto &it = chunks.find(batchedMesh.chunk);
+
+    E_DASSERT(it != chunks.end(), "Batched mesh chunk not found.");
+
+    removeEmptyBatchesAtEnd(it->second);
+
+    if(it->second.empty())
+        chunks.erase(it);
+}
+
+irrNodes::MeshBatch &MeshBatchManager::getBatch(const BatchedMeshInfo &batchedMesh)
+{
+    E_DASSERT(batchedMesh.batchIndex >= 0 && static_cast <size_t> (batchedMesh.batchIndex) < m_batches.size(),
+              "Batched mesh batch index out of bounds.");
+
+    E_DASSERT(batchedMesh.batchedMeshIndex, "Batched mesh index is nullptr.");
+
+    const auto &chunks = m_batches[batchedMesh.batchIndex].chunks;
+    const auto &it = chunks.find(batchedMesh.chunk);
+
+    E_DASSERT(it != chunks.end(), "Batched mesh chunk not found.");
+
+    E_DASSERT(batchedMesh.batchSecondLevelIndex >= 0 && static_cast <size_t> (batchedMesh.batchSecondLevelIndex) < it->second.size(),
+              "Batched mesh batch second level index out of bounds.");
+
+    E_DASSERT(it->second[batchedMesh.batchSecondLevelIndex],
+              "Batch is nullptr.");
+
+    return *it->second[batchedMesh.batchSecondLevelIndex];
+}
+
+std::pair <int, int> MeshBatchManager::getChunk(const FloatVec3 &pos)
+{
+    return {static_cast <int> (std::floor(pos.x / k_chunkSize)),
+            static_cast <int> (std::floor(pos.z / k_chunkSize))};
+}
+
+int MeshBatchManager::findBatchWithFreeSpace(const std::vector <irrNodes::MeshBatch *> &batches)
+{
+    for(size_t i = 0; i < batches.size(); ++i) {
+        E_DASSERT(batches[i], "Batch is nullptr.");
+
+        if(batches[i]->getVertexCount() < k_maxVerticesPerBatch)
+            return static_cast <int> (i);
+    }
+
+    return -1;
+}
+
+void MeshBatchManager::removeEmptyBatchesAtEnd(std::vector <irrNodes::MeshBatch *> &batches)
+{
+    while(!batches.empty() && !batches.back()->getMeshCount()) {
+        // owned by the Irrlicht scene manager
+        batches.back()->remove();
+        batches.pop_back();
+    }
 }
 
 const int MeshBatchManager::k_maxVerticesPerBatch{10000};
+const float MeshBatchManager::k_chunkSize{50.f};
 
 } // namespace app3D
 } // namespace engine
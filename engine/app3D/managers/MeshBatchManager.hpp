@@ -25,12 +25,22 @@ public:
     MeshBatchManager(Device &device);
 
     void registerMesh(irr::scene::IMesh &mesh, const std::string &batchTag);
-    std::shared_ptr <int> addMesh(irr::scene::IMesh &mesh, const std::string &batchTag, bool forceAllUpNormals);
+    std::shared_ptr <int> addMesh(irr::scene::IMesh &mesh, const std::string &batchTag, const FloatVec3 &pos, const FloatVec3 &rot, const FloatVec3 &scale, bool forceAllUpNormals);
     void setMeshPosition(int index, const FloatVec3 &pos);
     void setMeshRotation(int index, const FloatVec3 &rot);
     void setMeshScale(int index, const FloatVec3 &scale);
     void removeMesh(int index);
 
+    // meshes in different chunks never share a batch, a new mesh goes to the first batch
+    // of its chunk below the vertices limit (returns -1 if a new batch is needed)
+    static std::pair <int, int> getChunk(const FloatVec3 &pos);
+    static int findBatchWithFreeSpace(const std::vector <irrNodes::MeshBatch *> &batches);
+
+    // removes empty batches from the end of the chunk's batches
+    static void removeEmptyBatchesAtEnd(std::vector <irrNodes::MeshBatch *> &batches);
+
+    static const int k_maxVerticesPerBatch;
+
 private:
     struct RegisteredMesh
     {
@@ -38,26 +48,44 @@ private:
         std::vector <FloatRect> textureAtlasRects;
     };
 
+    // meshes sharing the same texture atlas; every spatial chunk gets its own batches,
+    // so whole chunks can be culled
+    struct BatchesGroup
+    {
+        irr::video::ITexture *textureAtlas{};
+        irr::video::E_MATERIAL_TYPE materialType{irr::video::EMT_SOLID};
+        std::map <std::pair <int, int>, std::vector <irrNodes::MeshBatch *>> chunks;
+    };
+
     struct BatchedMeshInfo
     {
         irr::scene::IMesh *mesh{};
         std::string batchTag;
         std::shared_ptr <int> index;
+        FloatVec3 pos;
+        FloatVec3 rot;
+        FloatVec3 scale{1.f, 1.f, 1.f};
         int batchIndex{-1};
+        std::pair <int, int> chunk;
         int batchSecondLevelIndex{-1};
         std::shared_ptr <int> batchedMeshIndex;
         bool forceAllUpNormals{};
     };
 
     void createBatches();
-    bool packTextures(const std::vector <irr::scene::IMesh *> &meshes, int from, int to, const std::string &batchTag);
+    bool packTextures(const std::vector <irr::scene::IMesh *> &meshes, const std::string &batchTag);
+    bool packTexturesInHalves(const std::vector <irr::scene::IMesh *> &meshes, const std::string &batchTag);
+    void addBatchesGroup(irr::video::ITexture &textureAtlas, const std::vector <irr::scene::IMesh *> &meshes, const std::vector <irr::video::ITexture *> &textures, const std::vector <FloatRect> &texCoords, const std::string &batchTag);
+    void addToBatch(BatchedMeshInfo &batchedMesh);
+    void removeFromBatch(const BatchedMeshInfo &batchedMesh);
+    irrNodes::MeshBatch &getBatch(const BatchedMeshInfo &batchedMesh);
 
-    static const int k_maxVerticesPerBatch;
+    static const float k_chunkSize;
 
     Device &m_device;
     std::map <std::pair <irr::scene::IMesh *, std::string>, RegisteredMesh> m_registeredMeshes;
     std::vector <BatchedMeshInfo> m_batchedMeshes;
-    std::vector <std::vector <irrNodes::MeshBatch *>> m_batches;
+    std::vector <BatchesGroup> m_batches;
 };
 
 } // namespace app3D
@@ -11,6 +11,7 @@
 #include "../physics/Armature.hpp"
 #include "../physics/ConeTwistConstraint.hpp"
 #include "../Device.hpp"
+#include "../../util/Metrics.hpp"
 
 namespace engine
 {
@@ -63,6 +64,9 @@ void PhysicsManager::update(const AppTime &appTime)
     }
 
     E_DASSERT(m_dynamicsWorld, "Dynamics world is nullptr.");
+    E_DASSERT(m_movedRigidBodiesUserIndices, "Moved rigid bodies user indices vector is nullptr.");
+
+    m_movedRigidBodiesUserIndices->clear();
 
     m_dynamicsWorld->stepSimulation(appTime.getDeltaAsSeconds(), k_maxPhysicsSubSteps);
 }
@@ -82,6 +86,7 @@ bool PhysicsManager::rayTest(const FloatVec3 &start, const FloatVec3 &end, Colli
     resultCallback.m_collisionFilterMask = static_cast <short> (withWhatCollide);
 
     m_dynamicsWorld->rayTest(btFrom, btTo, resultCallback);
+    E_COUNTER_ADD("Raycasts", 1);
 
     if(resultCallback.hasHit()) {
         const auto &btPos = resultCallback.m_hitPointWorld;
@@ -116,6 +121,7 @@ bool PhysicsManager::rayTest_notMe(const FloatVec3 &start, const FloatVec3 &end,
     resultCallback.m_collisionFilterMask = static_cast <short> (withWhatCollide);
 
     m_dynamicsWorld->rayTest(btFrom, btTo, resultCallback);
+    E_COUNTER_ADD("Raycasts", 1);
 
     if(resultCallback.hasHit()) {
         const auto &btPos = resultCallback.m_hitPointWorld;
@@ -139,9 +145,16 @@ btDynamicsWorld &PhysicsManager::getDynamicsWorld()
     return *m_dynamicsWorld;
 }
 
+const std::vector <int> &PhysicsManager::getMovedRigidBodiesUserIndices() const
+{
+    E_DASSERT(m_movedRigidBodiesUserIndices, "Moved rigid bodies user indices vector is nullptr.");
+
+    return *m_movedRigidBodiesUserIndices;
+}
+
 std::shared_ptr <RigidBody> PhysicsManager::addRigidBody(const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex, const FloatVec3 &posOffset, CollisionFilter additionalWhatAmIFlags)
 {
-    const auto &rigidBody = std::make_shared <RigidBody> (m_dynamicsWorld, shape, mass, userIndex, posOffset, additionalWhatAmIFlags);
+    const auto &rigidBody = std::make_shared <RigidBody> (m_dynamicsWorld, m_movedRigidBodiesUserIndices, shape, mass, userIndex, posOffset, additionalWhatAmIFlags);
     return rigidBody;
 }
 
@@ -195,6 +208,7 @@ const float PhysicsManager::k_gravity{-9.81f};
 
 void PhysicsManager::init()
 {
+    m_movedRigidBodiesUserIndices = std::make_shared <std::vector <int>> ();
     m_ghostPairCallback = std::make_unique <btGhostPairCallback> ();
     m_broadphase = std::make_unique <btDbvtBroadphase> ();
     m_broadphase->getOverlappingPairCache()->setInternalGhostPairCallback(m_ghostPairCallback.get());
@@ -41,6 +41,10 @@ public:
 
     btDynamicsWorld &getDynamicsWorld();
 
+    // user indices (may repeat) of rigid bodies which were active (moved by simulation) during last update,
+    // or which were moved manually since then
+    const std::vector <int> &getMovedRigidBodiesUserIndices() const;
+
     std::shared_ptr <RigidBody> addRigidBody(const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex = -1, const FloatVec3 &posOffset = {}, CollisionFilter additionalWhatAmIFlags = CollisionFilter::None);
     std::shared_ptr <GhostObject> addGhostObject(const std::shared_ptr <CollisionShape> &shape, CollisionFilter whatAmI, CollisionFilter withWhatCollide, const FloatVec3 &posOffset = {});
     std::shared_ptr <CollisionDetector> addCollisionDetector(const std::shared_ptr <CollisionShape> &shape, CollisionFilter whatAmI, CollisionFilter withWhatCollide, const FloatVec3 &posOffset = {});
@@ -65,6 +69,7 @@ private:
     std::unique_ptr <btSequentialImpulseConstraintSolver> m_solver;
     std::shared_ptr <btDiscreteDynamicsWorld> m_dynamicsWorld;
     std::unique_ptr <btGhostPairCallback> m_ghostPairCallback;
+    std::shared_ptr <std::vector <int>> m_movedRigidBodiesUserIndices; // shared with rigid bodies' motion states
 
     std::vector <std::shared_ptr <DynamicCharacterController>> m_dynamicCharacterControllers;
 };
@@ -2,13 +2,21 @@
 
 #include "../../util/Exception.hpp"
 #include "../../util/LogManager.hpp"
-#include "../../util/RectPacker.hpp"
+#include "../../util/MaxRectsPacker.hpp"
+#include "../../util/Util.hpp"
 #include "../ext/CGUITTFont.h"
 #include "../sceneNodes/Model.hpp"
 #include "../sceneNodes/Terrain.hpp"
 #include "../sceneNodes/Light.hpp"
 #include "../Device.hpp"
 
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
 #include <sstream>
 
 namespace engine
@@ -362,7 +370,7 @@ irr::gui::CGUITTFont &ResourcesManager::loadIrrFont(const std::string &path, int
     return *font;
 }
 
-irr::video::ITexture *ResourcesManager::getPackedTexture(const std::vector <irr::video::ITexture*> &textures, std::vector <FloatRect> &outTexCoords) const
+std::vector <irr::video::ITexture*> ResourcesManager::getPackedTextures(const std::vector <irr::video::ITexture*> &textures, const std::string &batchTag, std::vector <FloatRect> &outTexCoords, std::vector <int> &outPages) const
 {
     TRACK;
 
@@ -370,25 +378,61 @@ irr::video::ITexture *ResourcesManager::getPackedTexture(const std::vector <irr:
     // TODO: Fix potential memory leaks (createImage allocates memory for new image).
 
     outTexCoords.clear();
+    outPages.clear();
 
     if(textures.empty())
-        return &m_device.getResourcesManager().getWhiteTexture();
-
-    irr::video::ITexture *newTexture{};
-    irr::core::dimension2d <irr::u32> textureSize(k_packedTextureSize, k_packedTextureSize);
-    int texturePadding{20};
-
-    RectPacker packer{k_packedTextureSize};
+        return {&m_device.getResourcesManager().getWhiteTexture()};
 
     for(const auto &elem : textures) {
         if(!elem)
             throw Exception{"Texture is nullptr."};
+    }
+
+    // textures are packed (and cached) in the order of their paths, because the input order
+    // can depend on pointer values
+
+    std::vector <size_t> order(textures.size());
+
+    for(size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&textures](size_t lhs, size_t rhs) {
+        return textures[lhs]->getName().getPath() < textures[rhs]->getName().getPath();
+    });
+
+    const auto &cachePath = getPackedTextureCachePath(textures, order, batchTag);
+
+    if(!cachePath.empty()) {
+        std::vector <int> pages;
+        const auto &cachedTextures = tryLoadCachedPackedTextures(cachePath, textures.size(), outTexCoords, pages);
+
+        if(!cachedTextures.empty()) {
+            std::vector <FloatRect> texCoords(textures.size());
+            outPages.resize(textures.size());
 
-        packer.add(elem->getSize().Width + texturePadding, elem->getSize().Height + texturePadding);
+            for(size_t i = 0; i < order.size(); ++i) {
+                texCoords[order[i]] = outTexCoords[i];
+                outPages[order[i]] = pages[i];
+            }
+
+            outTexCoords.swap(texCoords);
+
+            return cachedTextures;
+        }
+    }
+
+    irr::core::dimension2d <irr::u32> textureSize(k_packedTextureSize, k_packedTextureSize);
+
+    // rotation is disabled, because tex coords rects can't express it
+    MaxRectsPacker packer{k_packedTextureSize, k_packedTexturePadding, false, k_maxPackedTexturePagesCount};
+
+    for(auto index : order) {
+        packer.add(textures[index]->getSize().Width, textures[index]->getSize().Height);
     }
 
     if(!packer.pack())
-        return nullptr;
+        return {};
 
     const auto &rects = packer.getAll();
 
@@ -396,67 +440,103 @@ irr::video::ITexture *ResourcesManager::getPackedTexture(const std::vector <irr:
               static_cast <int> (textures.size()),
               static_cast <int> (rects.size()));
 
+    E_INFO("Packed %d textures into %d texture atlas pages (occupancy: %.1f%%).",
+           static_cast <int> (textures.size()),
+           packer.getPagesCount(),
+           packer.getOccupancy() * 100.f);
+
     auto &driver = *m_device.getIrrDevice().getVideoDriver();
-    auto *packedImage = driver.createImage(textures[0]->getColorFormat(), textureSize);
+    std::vector <irr::video::IImage *> packedImages;
 
-    E_RASSERT(packedImage, "Created image is nullptr (tried to create texture with size: %d).", k_packedTextureSize);
+    for(int i = 0; i < packer.getPagesCount(); ++i) {
+        packedImages.push_back(driver.createImage(textures[0]->getColorFormat(), textureSize));
+        E_RASSERT(packedImages.back(), "Created image is nullptr (tried to create texture with size: %d).", k_packedTextureSize);
+    }
 
     std::vector <irr::video::IImage *> textureImages;
     textureImages.resize(textures.size());
 
     for(size_t i = 0; i < textureImages.size(); ++i) {
-        textureImages[i] = driver.createImage(textures[i], irr::core::vector2di{0, 0}, textures[i]->getSize());
+        auto *texture = textures[order[i]];
+
+        textureImages[i] = driver.createImage(texture, irr::core::vector2di{0, 0}, texture->getSize());
         E_RASSERT(textureImages[i], "Created image is nullptr.");
     }
 
-    outTexCoords.resize(textures.size());
+    // in packing order, until cached
+    std::vector <FloatRect> texCoords(textures.size());
+    std::vector <int> pages(textures.size());
 
     for(size_t i = 0; i < rects.size(); ++i) {
         auto *im = textureImages[i];
+        auto *packedImage = packedImages[rects[i].page];
+        const auto *texture = textures[order[i]];
 
-        int xPos{rects[i].rect.pos.x + texturePadding / 2};
-        int yPos{rects[i].rect.pos.y + texturePadding / 2};
+        int xPos{rects[i].rect.pos.x};
+        int yPos{rects[i].rect.pos.y};
 
         im->copyTo(packedImage, {xPos, yPos});
 
-        auto textureWidth = static_cast <int> (textures[i]->getSize().Width);
-        auto textureHeight = static_cast <int> (textures[i]->getSize().Height);
+        auto textureWidth = static_cast <int> (texture->getSize().Width);
+        auto textureHeight = static_cast <int> (texture->getSize().Height);
 
-        for(int j = 0; j < texturePadding / 2; ++j) {
+        for(int j = 0; j < k_packedTexturePadding / 2; ++j) {
             im->copyTo(packedImage, {xPos - j, yPos}, {0, 0, 1, textureHeight});
             im->copyTo(packedImage, {xPos + j + textureWidth, yPos}, {textureWidth - 1, 0, textureWidth, textureHeight});
             im->copyTo(packedImage, {xPos, yPos - j}, {0, 0, textureWidth, 1});
             im->copyTo(packedImage, {xPos, yPos + j + textureHeight}, {0, textureHeight - 1, textureWidth, textureHeight});
         }
 
-        outTexCoords[i].pos.set(static_cast <float> (xPos) / textureSize.Width,
-                                static_cast <float> (yPos) / textureSize.Height);
+        texCoords[i].pos.set(static_cast <float> (xPos) / textureSize.Width,
+                             static_cast <float> (yPos) / textureSize.Height);
+
+        texCoords[i].size.set(static_cast <float> (textureWidth) / textureSize.Width,
+                              static_cast <float> (textureHeight) / textureSize.Height);
 
-        outTexCoords[i].size.set(static_cast <float> (textures[i]->getSize().Width) / textureSize.Width,
-                                 static_cast <float> (textures[i]->getSize().Height) / textureSize.Height);
+        pages[i] = rects[i].page;
     }
 
-    irr::core::stringc textureName = "packedTexture";
+    std::vector <irr::video::ITexture *> newTextures;
     static int globalPackedTexturesCount;
-    textureName += globalPackedTexturesCount;
 
-    newTexture = driver.addTexture(textureName, packedImage);
+    for(size_t i = 0; i < packedImages.size(); ++i) {
+        irr::core::stringc textureName = "packedTexture";
 
-    E_RASSERT(newTexture, "Added texture is nullptr.");
+        // cached ones are named after their cache path, so they can be reused when batches are recreated
+        if(cachePath.empty())
+            textureName += globalPackedTexturesCount;
+        else
+            textureName = getPackedTexturePagePath(cachePath, i).c_str();
 
-    newTexture->regenerateMipMapLevels();
-    ++globalPackedTexturesCount;
+        auto *newTexture = driver.addTexture(textureName, packedImages[i]);
 
-    // debug write to file
-    m_device.getIrrDevice().getVideoDriver()->writeImageToFile(packedImage, ("atlas" + std::to_string(globalPackedTexturesCount) + ".png").c_str());
+        E_RASSERT(newTexture, "Added texture is nullptr.");
+
+        newTexture->regenerateMipMapLevels();
+        newTextures.push_back(newTexture);
+        ++globalPackedTexturesCount;
+    }
+
+    if(!cachePath.empty())
+        cachePackedTextures(cachePath, packedImages, texCoords, pages);
+
+    outTexCoords.resize(textures.size());
+    outPages.resize(textures.size());
+
+    for(size_t i = 0; i < order.size(); ++i) {
+        outTexCoords[order[i]] = texCoords[i];
+        outPages[order[i]] = pages[i];
+    }
 
     for(auto &elem : textureImages) {
         elem->drop();
     }
 
-    packedImage->drop();
+    for(auto &elem : packedImages) {
+        elem->drop();
+    }
 
-    return newTexture;
+    return newTextures;
 }
 
 irr::scene::IMesh &ResourcesManager::getSimplePlaneMesh() const
@@ -519,6 +599,158 @@ void ResourcesManager::processMeshMaterial(irr::video::SMaterial &material)
     material.GouraudShading = true;
 }
 
+std::string ResourcesManager::getPackedTextureCachePath(const std::vector <irr::video::ITexture*> &textures, const std::vector <size_t> &order, const std::string &batchTag) const
+{
+    TRACK;
+
+    std::uint64_t hash{Util::getHash(batchTag.data(), batchTag.size())};
+    std::int32_t params[]{k_packedTextureSize, k_packedTexturePadding, k_maxPackedTexturePagesCount};
+
+    hash = Util::getHash(params, sizeof(params), hash);
+
+    for(auto index : order) {
+        const auto *texture = textures[index];
+        std::string path{texture->getName().getPath().c_str()};
+
+        // textures which weren't loaded from files can't be cached
+        if(!QFileInfo{path.c_str()}.isFile())
+            return {};
+
+        std::uint32_t info[]{texture->getSize().Width,
+                             texture->getSize().Height,
+                             static_cast <std::uint32_t> (texture->getColorFormat())};
+
+        hash = Util::getHash(path.c_str(), path.size() + 1, hash);
+        hash = Util::getHash(info, sizeof(info), hash);
+        hash = Util::getFileHash(path, hash);
+    }
+
+    std::ostringstream oss;
+    oss << k_packedTexturesCacheDirectory << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    return oss.str();
+}
+
+std::string ResourcesManager::getPackedTexturePagePath(const std::string &cachePath, size_t page) const
+{
+    return cachePath + '_' + std::to_string(page);
+}
+
+std::vector <irr::video::ITexture*> ResourcesManager::tryLoadCachedPackedTextures(const std::string &cachePath, size_t texturesCount, std::vector <FloatRect> &outTexCoords, std::vector <int> &outPages) const
+{
+    TRACK;
+
+    std::ifstream in{cachePath + k_packedTextureTexCoordsExtension, std::ios::binary};
+
+    if(!in.is_open())
+        return {};
+
+    std::uint32_t count{};
+    std::uint32_t pagesCount{};
+    std::vector <std::int32_t> pages;
+    std::vector <float> values;
+
+    if(!in.read(reinterpret_cast <char*> (&count), sizeof(count)) || count != texturesCount)
+        return {};
+
+    if(!in.read(reinterpret_cast <char*> (&pagesCount), sizeof(pagesCount)) || !pagesCount || pagesCount > static_cast <std::uint32_t> (k_maxPackedTexturePagesCount))
+        return {};
+
+    pages.resize(count);
+    values.resize(count * 4);
+
+    if(!in.read(reinterpret_cast <char*> (pages.data()), pages.size() * sizeof(std::int32_t)) ||
+       !in.read(reinterpret_cast <char*> (values.data()), values.size() * sizeof(float)))
+        return {};
+
+    for(auto page : pages) {
+        if(page < 0 || static_cast <std::uint32_t> (page) >= pagesCount)
+            return {};
+    }
+
+    auto &driver = *m_device.getIrrDevice().getVideoDriver();
+    std::vector <irr::video::ITexture *> textures;
+
+    for(std::uint32_t i = 0; i < pagesCount; ++i) {
+        const auto &pagePath = getPackedTexturePagePath(cachePath, i);
+        auto *texture = driver.findTexture(pagePath.c_str());
+
+        if(!texture) {
+            auto *image = driver.createImageFromFile((pagePath + k_packedTextureImageExtension).c_str());
+
+            if(!image)
+                return {};
+
+            if(image->getDimension() != irr::core::dimension2d <irr::u32> (k_packedTextureSize, k_packedTextureSize)) {
+                image->drop();
+                return {};
+            }
+
+            texture = driver.addTexture(pagePath.c_str(), image);
+            image->drop();
+
+            if(!texture)
+                return {};
+
+            texture->regenerateMipMapLevels();
+        }
+
+        textures.push_back(texture);
+    }
+
+    outTexCoords.resize(count);
+    outPages.assign(pages.begin(), pages.end());
+
+    for(size_t i = 0; i < count; ++i) {
+        outTexCoords[i].pos.set(values[i * 4], values[i * 4 + 1]);
+        outTexCoords[i].size.set(values[i * 4 + 2], values[i * 4 + 3]);
+    }
+
+    E_INFO("Loaded packed texture \"%s\" (%d pages) from cache.", cachePath.c_str(), static_cast <int> (pagesCount));
+
+    return textures;
+}
+
+void ResourcesManager::cachePackedTextures(const std::string &cachePath, const std::vector <irr::video::IImage *> &images, const std::vector <FloatRect> &texCoords, const std::vector <int> &pages) const
+{
+    TRACK;
+
+    if(!QDir{}.mkpath(k_packedTexturesCacheDirectory.c_str())) {
+        E_WARNING("Could not create packed textures cache directory \"%s\".", k_packedTexturesCacheDirectory.c_str());
+        return;
+    }
+
+    // images first, so tex coords file existence means that everything is complete
+    for(size_t i = 0; i < images.size(); ++i) {
+        E_DASSERT(images[i], "Image is nullptr.");
+
+        if(!m_device.getIrrDevice().getVideoDriver()->writeImageToFile(images[i], (getPackedTexturePagePath(cachePath, i) + k_packedTextureImageExtension).c_str())) {
+            E_WARNING("Could not write packed texture to cache \"%s\".", cachePath.c_str());
+            return;
+        }
+    }
+
+    std::vector <float> values;
+    values.reserve(texCoords.size() * 4);
+
+    for(const auto &elem : texCoords) {
+        values.push_back(elem.pos.x);
+        values.push_back(elem.pos.y);
+        values.push_back(elem.size.x);
+        values.push_back(elem.size.y);
+    }
+
+    std::vector <std::int32_t> pagesToWrite(pages.begin(), pages.end());
+    auto count = static_cast <std::uint32_t> (texCoords.size());
+    auto pagesCount = static_cast <std::uint32_t> (images.size());
+    std::ofstream out{cachePath + k_packedTextureTexCoordsExtension, std::ios::binary};
+
+    out.write(reinterpret_cast <const char*> (&count), sizeof(count));
+    out.write(reinterpret_cast <const char*> (&pagesCount), sizeof(pagesCount));
+    out.write(reinterpret_cast <const char*> (pagesToWrite.data()), pagesToWrite.size() * sizeof(std::int32_t));
+    out.write(reinterpret_cast <const char*> (values.data()), values.size() * sizeof(float));
+}
+
 irr::scene::IMesh *ResourcesManager::tryLoadIrrMesh_internal(const std::string &fullPath)
 {
     auto &irrDevice = m_device.getIrrDevice();
@@ -570,6 +802,11 @@ irr::gui::CGUITTFont *ResourcesManager::tryLoadIrrFont_internal(const std::strin
 }
 
 const int ResourcesManager::k_packedTextureSize{2048};
+const int ResourcesManager::k_packedTexturePadding{20};
+const int ResourcesManager::k_maxPackedTexturePagesCount{16};
+const std::string ResourcesManager::k_packedTexturesCacheDirectory{"cache/packedTextures/"};
+const std::string ResourcesManager::k_packedTextureImageExtension{".png"};
+const std::string ResourcesManager::k_packedTextureTexCoordsExtension{".texCoords"};
 const int ResourcesManager::k_anisotropicFilterLevel{8};
 
 } // namespace app3D
@@ -45,7 +45,9 @@ public:
     irr::video::IImage &loadIrrImage(const std::string &path, const std::string &preferredModPath = "core");
     irr::gui::CGUITTFont &loadIrrFont(const std::string &path, int size, const std::string &preferredModPath = "core");
 
-    irr::video::ITexture *getPackedTexture(const std::vector <irr::video::ITexture*> &textures, std::vector <FloatRect> &outTexCoords) const;
+    // returns atlas pages (empty if textures did not fit), outPages contains page index for every texture;
+    // packed textures are cached on disk, keyed by batch tag and contents of the source texture files
+    std::vector <irr::video::ITexture*> getPackedTextures(const std::vector <irr::video::ITexture*> &textures, const std::string &batchTag, std::vector <FloatRect> &outTexCoords, std::vector <int> &outPages) const;
     irr::scene::IMesh &getSimplePlaneMesh() const;
     irr::video::ITexture &getWhiteTexture() const;
     irr::video::ITexture &getBlackTexture() const;
@@ -59,7 +61,17 @@ private:
     irr::video::IImage *tryLoadIrrImage_internal(const std::string &fullPath);
     irr::gui::CGUITTFont *tryLoadIrrFont_internal(const std::string &fullPath, int size);
 
+    std::string getPackedTextureCachePath(const std::vector <irr::video::ITexture*> &textures, const std::vector <size_t> &order, const std::string &batchTag) const;
+    std::string getPackedTexturePagePath(const std::string &cachePath, size_t page) const;
+    std::vector <irr::video::ITexture*> tryLoadCachedPackedTextures(const std::string &cachePath, size_t texturesCount, std::vector <FloatRect> &outTexCoords, std::vector <int> &outPages) const;
+    void cachePackedTextures(const std::string &cachePath, const std::vector <irr::video::IImage *> &images, const std::vector <FloatRect> &texCoords, const std::vector <int> &pages) const;
+
     static const int k_packedTextureSize;
+    static const int k_packedTexturePadding;
+    static const int k_maxPackedTexturePagesCount;
+    static const std::string k_packedTexturesCacheDirectory;
+    static const std::string k_packedTextureImageExtension;
+    static const std::string k_packedTextureTexCoordsExtension;
     static const int k_anisotropicFilterLevel;
 
     Device &m_device;
@@ -1,6 +1,7 @@
 #include "SceneManager.hpp"
 
 #include "../../util/Exception.hpp"
+#include "../../util/AppTime.hpp"
 #include "../managers/ShadersManager.hpp"
 #include "../sceneNodes/SceneNode.hpp"
 #include "../sceneNodes/Model.hpp"
@@ -198,6 +199,9 @@ void SceneManager::update(const AppTime &appTime)
     const auto &irrCameraPos = m_device.getSceneManager().getIrrCamera().getPosition();
     FloatVec3 cameraPos{irrCameraPos.X, irrCameraPos.Y, irrCameraPos.Z};
 
+    // scene nodes moved during fixed time steps are rendered between last two simulation states
+    bool interpolate{appTime.isFixedTimeStepEnabled()};
+
     for(size_t i = 0; i < m_sceneNodes_wantUpdate.size();) {
         E_DASSERT(m_sceneNodes_wantUpdate[i], "Scene node is nullptr.");
 
@@ -206,6 +210,9 @@ void SceneManager::update(const AppTime &appTime)
             m_sceneNodes_wantUpdate.pop_back();
         }
         else {
+            if(interpolate)
+                m_sceneNodes_wantUpdate[i]->updateInterpolation(appTime);
+
             m_sceneNodes_wantUpdate[i]->update(cameraPos, appTime);
             ++i;
         }
@@ -218,8 +225,12 @@ void SceneManager::update(const AppTime &appTime)
             std::swap(m_sceneNodes_dontWantUpdate[i], m_sceneNodes_dontWantUpdate.back());
             m_sceneNodes_dontWantUpdate.pop_back();
         }
-        else
+        else {
+            if(interpolate)
+                m_sceneNodes_dontWantUpdate[i]->updateInterpolation(appTime);
+
             ++i;
+        }
     }
 }
 
@@ -355,6 +366,20 @@ std::shared_ptr <Model> SceneManager::addModel(const std::shared_ptr <ModelDef>
     return sceneNode;
 }
 
+std::shared_ptr <Model> SceneManager::addModel(const std::shared_ptr <ModelDef> &modelDef, const FloatVec3 &pos, const FloatVec3 &rot)
+{
+    TRACK;
+
+    if(!modelDef)
+        throw Exception{"Model def is nullptr."};
+
+    // the render is created in the constructor, so batched meshes go straight to the right chunk
+    const auto &sceneNode = std::make_shared <Model> (modelDef, m_device.getPtr(), pos, rot);
+    addSceneNode(sceneNode);
+
+    return sceneNode;
+}
+
 std::shared_ptr <Terrain> SceneManager::addTerrain(const std::shared_ptr <TerrainDef> &terrainDef)
 {
     TRACK;
@@ -57,6 +57,7 @@ public:
     void draw3DLine(const FloatVec3 &from, const FloatVec3 &to, const Color &color) const;
 
     std::shared_ptr <Model> addModel(const std::shared_ptr <ModelDef> &modelDef, bool isFPP = false);
+    std::shared_ptr <Model> addModel(const std::shared_ptr <ModelDef> &modelDef, const FloatVec3 &pos, const FloatVec3 &rot);
     std::shared_ptr <Terrain> addTerrain(const std::shared_ptr <TerrainDef> &terrainDef);
     std::shared_ptr <Water> addWater(const std::shared_ptr <TerrainDef> &terrainDef);
     std::shared_ptr <Light> addLight(const std::shared_ptr <LightDef> &lightDef);
@@ -329,7 +329,9 @@ ShadersManager::ShadersManager(Device &device, const Settings &settings)
       m_outlineShaderOutlineColor{Color::k_white},
       m_skyColor{m_device.getFogColor()}
 {
+#ifndef ENGINE_HEADLESS
     compileAllShaders();
+#endif
 
     m_timer.start();
 }
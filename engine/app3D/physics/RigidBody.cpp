@@ -7,7 +7,39 @@ namespace engine
 namespace app3D
 {
 
-RigidBody::RigidBody(const std::weak_ptr <btDynamicsWorld> &dynamicsWorld, const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex, const FloatVec3 &posOffset, CollisionFilter additionalWhatAmIFlags)
+// Bullet sets world transform of motion state only for active (not sleeping) bodies,
+// so it tells us which bodies were moved by the simulation
+class RigidBody::MotionState : public btDefaultMotionState
+{
+public:
+    MotionState(const std::weak_ptr <std::vector <int>> &movedBodiesUserIndices, int userIndex)
+        : btDefaultMotionState{btTransform{btQuaternion{0.f, 0.f, 0.f, 1.f}, btVector3{0.f, 0.f, 0.f}}},
+          m_movedBodiesUserIndices{movedBodiesUserIndices},
+          m_userIndex{userIndex}
+    {
+    }
+
+    void setWorldTransform(const btTransform &transform) override
+    {
+        base::setWorldTransform(transform);
+
+        if(m_userIndex < 0)
+            return;
+
+        const auto &shared = m_movedBodiesUserIndices.lock();
+
+        if(shared)
+            shared->push_back(m_userIndex);
+    }
+
+private:
+    typedef btDefaultMotionState base;
+
+    std::weak_ptr <std::vector <int>> m_movedBodiesUserIndices;
+    int m_userIndex;
+};
+
+RigidBody::RigidBody(const std::weak_ptr <btDynamicsWorld> &dynamicsWorld, const std::weak_ptr <std::vector <int>> &movedBodiesUserIndices, const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex, const FloatVec3 &posOffset, CollisionFilter additionalWhatAmIFlags)
     : m_dynamicsWorld{dynamicsWorld},
       m_shape{shape},
       m_mass{mass},
@@ -25,7 +57,7 @@ RigidBody::RigidBody(const std::weak_ptr <btDynamicsWorld> &dynamicsWorld, const
     if(m_mass < 0.f)
         throw Exception{"Mass can't be negative."};
 
-    m_motionState = std::make_unique <btDefaultMotionState> (btTransform{btQuaternion{0.f, 0.f, 0.f, 1.f}, btVector3{0.f, 0.f, 0.f}});
+    m_motionState = std::make_unique <MotionState> (movedBodiesUserIndices, m_userIndex);
 
     btVector3 fallInertia{0.f, 0.f, 0.f};
 
@@ -155,6 +187,13 @@ btCollisionObject &RigidBody::getBtCollisionObject()
     return *m_rigidBody;
 }
 
+bool RigidBody::isActive() const
+{
+    E_DASSERT(m_rigidBody, "Rigid body is nullptr.");
+
+    return m_rigidBody->isActive();
+}
+
 FloatVec3 RigidBody::getPosition() const
 {
     TRACK;
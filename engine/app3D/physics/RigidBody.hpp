@@ -7,6 +7,7 @@
 #include "CollisionFilter.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace engine
 {
@@ -16,7 +17,7 @@ namespace app3D
 class RigidBody : public Tracked <RigidBody>
 {
 public:
-    RigidBody(const std::weak_ptr <btDynamicsWorld> &dynamicsWorld, const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex, const FloatVec3 &posOffset, CollisionFilter additionalWhatAmIFlags);
+    RigidBody(const std::weak_ptr <btDynamicsWorld> &dynamicsWorld, const std::weak_ptr <std::vector <int>> &movedBodiesUserIndices, const std::shared_ptr <CollisionShape> &shape, float mass, int userIndex, const FloatVec3 &posOffset, CollisionFilter additionalWhatAmIFlags);
 
     void setPosition(const FloatVec3 &pos);
     void setRotation(const FloatVec3 &rot);
@@ -29,6 +30,7 @@ public:
     void lockFallingOver();
     void disableDeactivationState();
     btCollisionObject &getBtCollisionObject();
+    bool isActive() const;
     FloatVec3 getPosition() const;
     FloatVec3 getRotation() const;
     FloatVec3 getLinearVelocity() const;
@@ -41,13 +43,15 @@ public:
     ~RigidBody();
 
 private:
+    class MotionState;
+
     FloatVec3 rotateAsBody(const FloatVec3 &vec) const;
     CollisionFilter getCollisionGroupForBtRigidBody(const btRigidBody &body, CollisionFilter additionalWhatAmIFlags) const;
     CollisionFilter getCollisionMaskForBtRigidBody(const btRigidBody &body) const;
 
     std::weak_ptr <btDynamicsWorld> m_dynamicsWorld;
     std::shared_ptr <CollisionShape> m_shape;
-    std::unique_ptr <btDefaultMotionState> m_motionState;
+    std::unique_ptr <MotionState> m_motionState;
     std::unique_ptr <btRigidBody> m_rigidBody;
     float m_mass;
     int m_userIndex;
@@ -14,9 +14,31 @@ namespace app3D
 {
 
 Model::Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, bool isFPP)
+    : Model{modelDef, device, {}, {}, false, isFPP}
+{
+}
+
+Model::Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, const FloatVec3 &pos, const FloatVec3 &rot)
+    : Model{modelDef, device, pos, rot, true, false}
+{
+}
+
+Model::Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, const FloatVec3 &pos, const FloatVec3 &rot, bool hasPosition, bool isFPP)
     : SceneNode{device},
       m_currentRender{},
       m_modelDef{modelDef},
+      m_pos{pos},
+      m_rot{rot},
+      m_previousPos{pos},
+      m_renderPos{pos},
+      m_previousRot{rot},
+      m_renderRot{rot},
+      m_lastPositionFixedStepIndex{},
+      m_lastRotationFixedStepIndex{},
+      m_isInterpolatingPosition{},
+      m_isInterpolatingRotation{},
+      m_appTime{},
+      m_hasPosition{hasPosition},
       m_isFPP{isFPP},
       m_animationKind{AnimationKind::None},
       m_irrAnimationEndCallback{*this},
@@ -27,6 +49,9 @@ Model::Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <De
     if(!m_modelDef)
         throw Exception{"Model def is nullptr."};
 
+    // AppTime outlives Device, so we can keep it instead of locking Device on every setPosition()
+    m_appTime = &getDevice_slow().getAppTime();
+
     // force update to create render now
     update(getDevice_slow().getSceneManager().getCameraPosition(), {});
 }
@@ -91,6 +116,33 @@ void Model::update(const FloatVec3 &cameraPos, const AppTime &appTime)
     createRender(LOD);
 }
 
+void Model::updateInterpolation(const AppTime &appTime)
+{
+    // if position or rotation wasn't changed in the last fixed step, then newest state is the current state
+
+    if(m_isInterpolatingPosition) {
+        if(m_lastPositionFixedStepIndex != appTime.getFixedStepIndex()) {
+            m_isInterpolatingPosition = false;
+            m_renderPos = m_pos;
+        }
+        else
+            m_renderPos = FloatVec3::lerped(m_previousPos, m_pos, appTime.getInterpolationAlpha());
+
+        updateCurrentRenderPosition();
+    }
+
+    if(m_isInterpolatingRotation) {
+        if(m_lastRotationFixedStepIndex != appTime.getFixedStepIndex()) {
+            m_isInterpolatingRotation = false;
+            m_renderRot = m_rot;
+        }
+        else
+            m_renderRot = FloatVec3::loopedLerped(m_previousRot, m_rot, appTime.getInterpolationAlpha(), {0.f, 360.f});
+
+        updateCurrentRenderRotation();
+    }
+}
+
 void Model::enableManualJointManipulation()
 {
     m_manualJointManipulation = true;
@@ -202,16 +254,65 @@ void Model::highlightNextFrame(const Color &color)
 
 void Model::setPosition(const FloatVec3 &pos)
 {
-    if(pos != m_pos) {
+    if(!m_hasPosition) {
+        // there is nothing to interpolate from yet, otherwise the model would fly in from the origin
+        m_hasPosition = true;
+        m_pos = pos;
+        m_previousPos = pos;
+        m_renderPos = pos;
+        m_isInterpolatingPosition = false;
+        updateCurrentRenderPosition();
+        return;
+    }
+
+    if(pos == m_pos)
+        return;
+
+    E_DASSERT(m_appTime, "App time is nullptr.");
+
+    if(m_appTime->isInFixedStep()) {
+        // m_pos is still the state from the end of the previous step (even if it was set a few steps ago),
+        // render position will be interpolated in updateInterpolation()
+
+        if(m_lastPositionFixedStepIndex != m_appTime->getFixedStepIndex()) {
+            m_previousPos = m_pos;
+            m_lastPositionFixedStepIndex = m_appTime->getFixedStepIndex();
+        }
+
         m_pos = pos;
+        m_isInterpolatingPosition = true;
+    }
+    else {
+        // set outside of simulation (or without fixed time step), so no interpolation
+        m_pos = pos;
+        m_renderPos = pos;
+        m_isInterpolatingPosition = false;
         updateCurrentRenderPosition();
     }
 }
 
 void Model::setRotation(const FloatVec3 &rot)
 {
-    if(rot != m_rot) {
+    if(rot == m_rot)
+        return;
+
+    E_DASSERT(m_appTime, "App time is nullptr.");
+
+    // the same as in setPosition(), rotation is interpolated in updateInterpolation()
+
+    if(m_appTime->isInFixedStep()) {
+        if(m_lastRotationFixedStepIndex != m_appTime->getFixedStepIndex()) {
+            m_previousRot = m_rot;
+            m_lastRotationFixedStepIndex = m_appTime->getFixedStepIndex();
+        }
+
         m_rot = rot;
+        m_isInterpolatingRotation = true;
+    }
+    else {
+        m_rot = rot;
+        m_renderRot = rot;
+        m_isInterpolatingRotation = false;
         updateCurrentRenderRotation();
     }
 }
@@ -389,9 +490,12 @@ void Model::createRender(const ModelDef::LOD &LOD)
     else if(renderTechnique == ModelDef::RenderTechnique::MeshBatched) {
         auto &meshBatchManager = resourcesManager.getMeshBatchManager();
 
-        m_currentRender.batchedMeshIndex = meshBatchManager.addMesh(LOD.getIrrMesh(), LOD.getBatchTag(), LOD.getForceAllUpNormalsWhenBatched());
-
-        meshBatchManager.setMeshScale(*m_currentRender.batchedMeshIndex, {scale, scale, scale});
+        m_currentRender.batchedMeshIndex = meshBatchManager.addMesh(LOD.getIrrMesh(),
+                                                                    LOD.getBatchTag(),
+                                                                    m_renderPos,
+                                                                    m_renderRot,
+                                                                    {scale, scale, scale},
+                                                                    LOD.getForceAllUpNormalsWhenBatched());
 
         if(m_isFPP) {
             E_WARNING("First person perspective nodes are not supported by batches.");
@@ -497,12 +601,12 @@ void Model::updateCurrentRenderPosition()
     auto &billboardNode = m_currentRender.billboardNode;
 
     if(meshNode) {
-        const auto &irrPos = IrrlichtConversions::toVector(m_pos);
+        const auto &irrPos = IrrlichtConversions::toVector(m_renderPos);
         meshNode->setPosition(irrPos);
     }
 
     if(animatedMeshNode) {
-        const auto &irrPos = IrrlichtConversions::toVector(m_pos);
+        const auto &irrPos = IrrlichtConversions::toVector(m_renderPos);
         animatedMeshNode->setPosition(irrPos);
     }
 
@@ -510,21 +614,21 @@ void Model::updateCurrentRenderPosition()
         irr::core::vector3df irrPos;
 
         if(m_currentRender.useCenterAsOriginForBillboard)
-            irrPos = IrrlichtConversions::toVector(m_pos);
+            irrPos = IrrlichtConversions::toVector(m_renderPos);
         else
-            irrPos = IrrlichtConversions::toVector(m_pos.movedY(m_currentRender.scale * 0.5f));
+            irrPos = IrrlichtConversions::toVector(m_renderPos.movedY(m_currentRender.scale * 0.5f));
 
         billboardNode->setPosition(irrPos);
     }
 
     if(m_currentRender.batchedMeshIndex) {
         auto &meshBatchManager = getDevice_slow().getResourcesManager().getMeshBatchManager();
-        meshBatchManager.setMeshPosition(*m_currentRender.batchedMeshIndex, m_pos);
+        meshBatchManager.setMeshPosition(*m_currentRender.batchedMeshIndex, m_renderPos);
     }
 
     if(m_currentRender.batchedBillboardIndex) {
         auto &billboardBatchManager = getDevice_slow().getResourcesManager().getBillboardBatchManager();
-        billboardBatchManager.setBillboardPosition(*m_currentRender.batchedBillboardIndex, m_pos.movedY(m_currentRender.scale * 0.5f));
+        billboardBatchManager.setBillboardPosition(*m_currentRender.batchedBillboardIndex, m_renderPos.movedY(m_currentRender.scale * 0.5f));
     }
 }
 
@@ -536,18 +640,18 @@ void Model::updateCurrentRenderRotation()
     auto &animatedMeshNode = m_currentRender.animatedMeshNode;
 
     if(meshNode) {
-        const auto &irrRot = IrrlichtConversions::toVector(m_rot);
+        const auto &irrRot = IrrlichtConversions::toVector(m_renderRot);
         meshNode->setRotation(irrRot);
     }
 
     if(animatedMeshNode) {
-        const auto &irrRot = IrrlichtConversions::toVector(m_rot);
+        const auto &irrRot = IrrlichtConversions::toVector(m_renderRot);
         animatedMeshNode->setRotation(irrRot);
     }
 
     if(m_currentRender.batchedMeshIndex) {
         auto &meshBatchManager = getDevice_slow().getResourcesManager().getMeshBatchManager();
-        meshBatchManager.setMeshRotation(*m_currentRender.batchedMeshIndex, m_rot);
+        meshBatchManager.setMeshRotation(*m_currentRender.batchedMeshIndex, m_renderRot);
     }
 }
 
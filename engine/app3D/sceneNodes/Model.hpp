@@ -10,6 +10,7 @@
 
 #include <irrlicht/irrlicht.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <functional>
@@ -23,11 +24,13 @@ class Model : public SceneNode, public Tracked <Model>
 {
 public:
     Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, bool isFPP);
+    Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, const FloatVec3 &pos, const FloatVec3 &rot);
 
     void dropIrrObjects() override;
     void reloadIrrObjects() override;
     bool wantsEverUpdate() const override;
     void update(const FloatVec3 &cameraPos, const AppTime &appTime) override;
+    void updateInterpolation(const AppTime &appTime) override;
 
     void enableManualJointManipulation();
     bool hasAnyJointsCurrently() const;
@@ -90,6 +93,8 @@ private:
         SingleAndThenLoop
     };
 
+    Model(const std::shared_ptr <ModelDef> &modelDef, const std::weak_ptr <Device> &device, const FloatVec3 &pos, const FloatVec3 &rot, bool hasPosition, bool isFPP);
+
     int getCurrentAnimationFrame() const;
     void createRender(const ModelDef::LOD &LOD);
     void removeCurrentRender();
@@ -101,8 +106,18 @@ private:
     static const Color k_defaultHighlightColor;
 
     std::shared_ptr <ModelDef> m_modelDef;
-    FloatVec3 m_pos;
-    FloatVec3 m_rot;
+    FloatVec3 m_pos; // newest state (if set during fixed time step)
+    FloatVec3 m_rot; // newest state (if set during fixed time step)
+    FloatVec3 m_previousPos; // state from before last fixed step which changed position
+    FloatVec3 m_renderPos;
+    FloatVec3 m_previousRot; // state from before last fixed step which changed rotation
+    FloatVec3 m_renderRot;
+    std::uint64_t m_lastPositionFixedStepIndex;
+    std::uint64_t m_lastRotationFixedStepIndex;
+    bool m_isInterpolatingPosition;
+    bool m_isInterpolatingRotation;
+    const AppTime *m_appTime;
+    bool m_hasPosition;
     IntRange m_animationFrameLoop;
     IntRange m_singleAnimationFrames;
     const bool m_isFPP;
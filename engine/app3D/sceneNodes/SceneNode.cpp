@@ -22,6 +22,10 @@ void SceneNode::update(const FloatVec3 &cameraPos, const AppTime &appTime)
 {
 }
 
+void SceneNode::updateInterpolation(const AppTime &appTime)
+{
+}
+
 bool SceneNode::deviceExpired() const
 {
     return m_device.expired();
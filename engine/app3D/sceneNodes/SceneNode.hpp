@@ -27,6 +27,7 @@ public:
 
     virtual bool wantsEverUpdate() const = 0;
     virtual void update(const FloatVec3 &cameraPos, const AppTime &appTime);
+    virtual void updateInterpolation(const AppTime &appTime); // called each frame if fixed time step is enabled
 
     virtual ~SceneNode() = default;
 
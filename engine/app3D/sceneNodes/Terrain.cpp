@@ -1,6 +1,5 @@
 #include "Terrain.hpp"
 
-#include "../../ext/PerlinNoise.hpp"
 #include "../../util/WindGenerator.hpp"
 #include "../../util/Exception.hpp"
 #include "../managers/ResourcesManager.hpp"
@@ -68,9 +67,6 @@ std::vector <float> Terrain::getHeightGrid() const
                         "This exception was thrown to avoid potential performance loss "
                         "due to creating high poly physics engine body for flat terrain."};
 
-    if(!m_currentRender.terrainNode)
-        throw Exception{"Couldn't get height grid because terrain node is nullptr."};
-
     std::vector <float> vec;
 
     // old method (quite bad):
@@ -115,32 +111,18 @@ std::vector <float> Terrain::getHeightGrid() const
     }
     */
 
-    // new method (more accurate):
-
-    auto *mesh = m_currentRender.terrainNode->getMesh();
-
-    if(!mesh->getMeshBufferCount())
-        throw engine::Exception{"Mesh has no mesh buffers."};
-
-    auto *meshBuffer = mesh->getMeshBuffer(0);
-
-    E_DASSERT(meshBuffer->getVertexType() == irr::video::EVT_2TCOORDS, "Expected EVT_2TCOORDS vertex type.");
-
-    std::vector <FloatVec3> vertices;
+    // new method (more accurate, and doesn't need terrain node):
 
-    for(irr::u32 i = 0; i < meshBuffer->getVertexCount(); ++i) {
-        auto &vertex = static_cast <irr::video::S3DVertex2TCoords*> (meshBuffer->getVertices())[i];
-        vertices.emplace_back(vertex.Pos.X, vertex.Pos.Y, vertex.Pos.Z);
-    }
-
-    std::sort(vertices.begin(), vertices.end(), [](const auto &lhs, const auto &rhs) {
-        return std::tie(lhs.z, lhs.x) < std::tie(rhs.z, rhs.x);
-    });
+    const auto &heightField = m_terrainDef->getHeightField();
+    int size{m_terrainDef->getHeightFieldSize()};
+    float yScale{m_terrainDef->getHeightFieldScale().y};
 
-    float nodeYScale{m_currentRender.terrainNode->getScale().Y};
+    vec.reserve(heightField.size());
 
-    for(const auto &elem : vertices) {
-        vec.push_back(elem.y * nodeYScale);
+    for(int z = 0; z < size; ++z) {
+        for(int x = 0; x < size; ++x) {
+            vec.push_back(heightField[x * size + z] * yScale);
+        }
     }
 
     return vec;
@@ -168,12 +150,7 @@ float Terrain::getHeight(const FloatVec2 &pos) const
     if(m_terrainDef->isFlat())
         return 0.f;
 
-    if(!m_currentRender.terrainNode)
-        throw Exception{"Terrain node is nullptr."};
-
-    // TODO: add boundaries check (include +eps and -eps for border cases)
-
-    return m_currentRender.terrainNode->getHeight(m_pos.x + pos.x, m_pos.z + pos.y);
+    return m_pos.y + m_terrainDef->getHeight(pos);
 }
 
 TerrainDef &Terrain::getDef() const
@@ -204,6 +181,11 @@ void Terrain::createRender()
 
     removeCurrentRender();
 
+#ifdef ENGINE_HEADLESS
+    // nothing is rendered, heights are taken from TerrainDef's height field
+    return;
+#endif
+
     auto &device = getDevice_slow();
     auto &scene = *device.getIrrDevice().getSceneManager();
     auto &resourcesManager = device.getResourcesManager();
@@ -231,9 +213,7 @@ void Terrain::createRender()
         if(!m_currentRender.terrainNode)
             throw Exception{"Could not add terrain scene node."};
 
-        m_currentRender.terrainNode->setScale({m_terrainDef->getScale() / static_cast <float> (m_terrainDef->getHeightMap().getSize().Width),
-                                               m_terrainDef->getScale() / 1024.f,
-                                               m_terrainDef->getScale() / static_cast <float> (m_terrainDef->getHeightMap().getSize().Height)});
+        m_currentRender.terrainNode->setScale(IrrlichtConversions::toVector(m_terrainDef->getHeightFieldScale()));
 
         m_currentRender.terrainNode->setMaterialTexture(0, &m_terrainDef->getTexture1());
         m_currentRender.terrainNode->setMaterialTexture(1, &m_terrainDef->getTexture2());
@@ -260,44 +240,23 @@ void Terrain::createRender()
         m_currentRender.terrainNode->setMaterialFlag(irr::video::EMF_LIGHTING, false);
         m_currentRender.terrainNode->setMaterialFlag(irr::video::EMF_FOG_ENABLE, false);
 
-        if(!Math::fuzzyCompare(m_terrainDef->getSlopeDistortion(), 0.f)) {
-            // second value: higher - more pointy, third: height
-            PerlinNoise noise{0.5f, 0.08f, m_terrainDef->getSlopeDistortion(), 3, 34573}; // 34573 is arbitrarly chosen seed
+        // render mesh uses heights from CPU height field (slope distortion is applied there),
+        // so rendered terrain always matches Terrain::getHeight() and physics
+        auto *mesh = m_currentRender.terrainNode->getMesh();
 
-            auto *mesh = m_currentRender.terrainNode->getMesh();
+        if(mesh->getMeshBufferCount()) {
+            auto *meshBuffer = mesh->getMeshBuffer(0);
 
-            if(mesh->getMeshBufferCount()) {
-                auto *meshBuffer = mesh->getMeshBuffer(0);
+            E_DASSERT(meshBuffer->getVertexType() == irr::video::EVT_2TCOORDS, "Expected EVT_2TCOORDS vertex type.");
 
-                E_DASSERT(meshBuffer->getVertexType() == irr::video::EVT_2TCOORDS, "Expected EVT_2TCOORDS vertex type.");
+            const auto &heightField = m_terrainDef->getHeightField();
 
-                const auto &normalMap = m_terrainDef->getNormalMapImage();
+            if(meshBuffer->getVertexCount() != heightField.size())
+                throw Exception{"Terrain mesh vertex count does not match height field size."};
 
-                for(irr::u32 i = 0; i < meshBuffer->getVertexCount(); ++i) {
-                    auto &vertex = static_cast <irr::video::S3DVertex2TCoords*> (meshBuffer->getVertices())[i];
-
-                    auto normalMapXPos = static_cast <int> (normalMap.getDimension().Width - vertex.Pos.X);
-
-                    if(normalMapXPos >= static_cast <int> (normalMap.getDimension().Width))
-                        --normalMapXPos;
-
-                    auto normalMapZPos = static_cast <int> (vertex.Pos.Z);
-
-                    E_DASSERT(normalMapXPos >= 0 && normalMapXPos < static_cast <int> (normalMap.getDimension().Width) &&
-                              normalMapZPos >= 0 && normalMapZPos < static_cast <int> (normalMap.getDimension().Height), "Pixel coords out of bounds.");
-
-                    auto normal = static_cast <int> (normalMap.getPixel(normalMapXPos, normalMapZPos).getBlue());
-
-                    if(normal > k_slopeDistortionNormalMapBlueColorTransitionRange.to)
-                        continue;
-
-                    float factor{1.f};
-
-                    if(normal > k_slopeDistortionNormalMapBlueColorTransitionRange.from)
-                        factor = (k_slopeDistortionNormalMapBlueColorTransitionRange.to - normal) / static_cast <float> (k_slopeDistortionNormalMapBlueColorTransitionRange.getLength());
-
-                    vertex.Pos.Y += std::fabs(noise.GetHeight(vertex.Pos.X, vertex.Pos.Z)) * factor;
-                }
+            for(irr::u32 i = 0; i < meshBuffer->getVertexCount(); ++i) {
+                auto &vertex = static_cast <irr::video::S3DVertex2TCoords*> (meshBuffer->getVertices())[i];
+                vertex.Pos.Y = heightField[i];
             }
         }
 
@@ -319,13 +278,15 @@ void Terrain::createRender()
             auto xCount = static_cast <int> (m_terrainDef->getScale() / irrNodes::GrassPatch::k_grassPatchSize) + 1;
             auto yCount = static_cast <int> (m_terrainDef->getScale() / irrNodes::GrassPatch::k_grassPatchSize) + 1;
 
+            auto grassVerticesGenerator = std::make_shared <irrNodes::GrassPatch::VerticesGenerator> ();
+
             for(int i = 0; i < xCount; ++i) {
                 for(int j = 0; j < yCount; ++j) {
                     m_currentRender.grassPatches.push_back(new irrNodes::GrassPatch{
                         scene, *m_currentRender.terrainNode, *m_currentRender.terrainNode_helper,
                         {(i + 0.5f) * irrNodes::GrassPatch::k_grassPatchSize, (j + 0.5f) * irrNodes::GrassPatch::k_grassPatchSize}, {m_terrainDef->getScale(), m_terrainDef->getScale()},
                         m_terrainDef->getNormalMapImage(), m_terrainDef->getSplatMapImage(),
-                        m_terrainDef->getGrassColor(), k_grassTexturesInTexture, m_windGenerator
+                        m_terrainDef->getGrassColor(), k_grassTexturesInTexture, m_windGenerator, grassVerticesGenerator
                     });
 
                     auto *grass = m_currentRender.grassPatches.back();
@@ -440,7 +401,6 @@ const float Terrain::k_windStrength{4.f};
 const float Terrain::k_windRegularity{5.f};
 const std::string Terrain::k_grassTexturePath = "grassMesh.png";
 const IntVec2 Terrain::k_grassTexturesInTexture{3, 1};
-const IntRange Terrain::k_slopeDistortionNormalMapBlueColorTransitionRange{175, 225};
 
 } // namespace app3D
 } // namespace engine
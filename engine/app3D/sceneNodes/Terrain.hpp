@@ -62,7 +62,6 @@ private:
     static const float k_windRegularity;
     static const std::string k_grassTexturePath;
     static const IntVec2 k_grassTexturesInTexture;
-    static const IntRange k_slopeDistortionNormalMapBlueColorTransitionRange;
 
     std::shared_ptr <TerrainDef> m_terrainDef;
     FloatVec3 m_pos;
@@ -1,6 +1,9 @@
 #include "AppTime.hpp"
 
 #include "Math.hpp"
+#include "Exception.hpp"
+
+#include <algorithm>
 
 namespace engine
 {
@@ -8,7 +11,13 @@ namespace engine
 AppTime::AppTime()
     : m_prevNsecs{0},
       m_elapsedMs{0.0},
-      m_deltaMs{0.0}
+      m_deltaMs{0.0},
+      m_fixedTimeStepMs{0.0},
+      m_accumulatedMs{0.0},
+      m_simulationElapsedMs{0.0},
+      m_frameDeltaMs{0.0},
+      m_fixedStepIndex{},
+      m_isInFixedStep{}
 {
     m_elapsedTimer.start();
 }
@@ -27,9 +36,79 @@ void AppTime::update()
 
     m_deltaMs = (nowNsecs - m_prevNsecs) * 0.000001;
     m_deltaMs = Math::clamp(m_deltaMs, k_minDelta, k_maxDelta);
-
-    m_elapsedMs += m_deltaMs;
     m_prevNsecs = nowNsecs;
+
+    if(isFixedTimeStepEnabled()) {
+        // if we can't keep up, we drop time instead of running more and more steps each frame
+        m_accumulatedMs = std::min(m_accumulatedMs + m_deltaMs, m_fixedTimeStepMs * k_maxFixedStepsPerFrame);
+        m_frameDeltaMs = m_deltaMs;
+
+        // outside of fixed steps the time is ahead of the simulation by the accumulated time
+        m_elapsedMs = m_simulationElapsedMs + m_accumulatedMs;
+    }
+    else
+        m_elapsedMs += m_deltaMs;
+}
+
+void AppTime::setFixedTimeStep(double ms)
+{
+    if(m_isInFixedStep)
+        throw Exception{"Can't change fixed time step during fixed step."};
+
+    m_fixedTimeStepMs = std::max(ms, 0.0);
+    m_accumulatedMs = 0.0;
+    m_simulationElapsedMs = m_elapsedMs;
+}
+
+bool AppTime::isFixedTimeStepEnabled() const
+{
+    return m_fixedTimeStepMs > 0.0;
+}
+
+bool AppTime::beginFixedStep()
+{
+    E_DASSERT(!m_isInFixedStep, "Already in fixed step.");
+
+    if(!isFixedTimeStepEnabled() || m_accumulatedMs < m_fixedTimeStepMs)
+        return false;
+
+    m_accumulatedMs -= m_fixedTimeStepMs;
+    m_simulationElapsedMs += m_fixedTimeStepMs;
+    ++m_fixedStepIndex;
+
+    // everything updated during fixed step sees constant delta and simulation time
+    m_deltaMs = m_fixedTimeStepMs;
+    m_elapsedMs = m_simulationElapsedMs;
+    m_isInFixedStep = true;
+
+    return true;
+}
+
+void AppTime::endFixedStep()
+{
+    E_DASSERT(m_isInFixedStep, "Not in fixed step.");
+
+    m_deltaMs = m_frameDeltaMs;
+    m_elapsedMs = m_simulationElapsedMs + m_accumulatedMs;
+    m_isInFixedStep = false;
+}
+
+bool AppTime::isInFixedStep() const
+{
+    return m_isInFixedStep;
+}
+
+std::uint64_t AppTime::getFixedStepIndex() const
+{
+    return m_fixedStepIndex;
+}
+
+float AppTime::getInterpolationAlpha() const
+{
+    if(!isFixedTimeStepEnabled())
+        return 1.f;
+
+    return Math::clamp01(static_cast <float> (m_accumulatedMs / m_fixedTimeStepMs));
 }
 
 double AppTime::getElapsedMs() const
@@ -49,5 +128,6 @@ double AppTime::getDeltaAsSeconds() const
 
 const double AppTime::k_minDelta{0.1};
 const double AppTime::k_maxDelta{50.0};
+const int AppTime::k_maxFixedStepsPerFrame{5};
 
 } // namespace engine
@@ -7,6 +7,8 @@
 
 #include <QElapsedTimer>
 
+#include <cstdint>
+
 namespace engine
 {
 
@@ -19,6 +21,15 @@ public:
 
     void update();
 
+    // fixed time step simulation, 0 disables it (then simulation runs once per frame with variable delta)
+    void setFixedTimeStep(double ms);
+    bool isFixedTimeStepEnabled() const;
+    bool beginFixedStep();
+    void endFixedStep();
+    bool isInFixedStep() const;
+    std::uint64_t getFixedStepIndex() const;
+    float getInterpolationAlpha() const;
+
     double getElapsedMs() const;
     double getDelta() const;
     double getDeltaAsSeconds() const;
@@ -26,11 +37,20 @@ public:
 private:
     static const double k_minDelta;
     static const double k_maxDelta;
+    static const int k_maxFixedStepsPerFrame;
 
     QElapsedTimer m_elapsedTimer;
     qint64 m_prevNsecs;
     double m_elapsedMs;
     double m_deltaMs;
+
+    // fixed time step state
+    double m_fixedTimeStepMs;
+    double m_accumulatedMs;
+    double m_simulationElapsedMs;
+    double m_frameDeltaMs;
+    std::uint64_t m_fixedStepIndex;
+    bool m_isInFixedStep;
 };
 
 } // namespace engine
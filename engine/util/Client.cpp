@@ -2,6 +2,7 @@
 
 #include "../EngineStaticInfo.hpp"
 #include "LogManager.hpp"
+#include "Metrics.hpp"
 
 #include <enet/enet.h>
 
@@ -193,6 +194,9 @@ void Client::sendPacket(const Packet &packet)
         return;
     }
 
+    E_COUNTER_ADD("Packets sent", 1);
+    E_COUNTER_ADD("Bytes sent", size);
+
     enet_host_flush(m_host);
 }
 
@@ -258,6 +262,9 @@ void Client::sendEnginePacket(const Packet &packet)
         return;
     }
 
+    E_COUNTER_ADD("Packets sent", 1);
+    E_COUNTER_ADD("Bytes sent", size);
+
     enet_host_flush(m_host);
 }
 
@@ -30,7 +30,11 @@ void operator >> (const YAML::Node &node, bool &val)
 DataFile::Activity::Activity(Type type, const std::string &filePath)
     : m_type{type},
       m_filePath{filePath},
-      m_error{}
+      m_error{},
+      m_recording{},
+      m_replayData{},
+      m_replaySize{},
+      m_replayPos{}
 {
 }
 
@@ -54,6 +58,51 @@ bool DataFile::Activity::getError() const
     return m_error;
 }
 
+void DataFile::Activity::setRecording(std::string *recording)
+{
+    m_recording = recording;
+}
+
+void DataFile::Activity::setReplay(const char *data, size_t size)
+{
+    m_replayData = data;
+    m_replaySize = size;
+    m_replayPos = 0;
+}
+
+bool DataFile::Activity::isRecording() const
+{
+    return m_recording;
+}
+
+bool DataFile::Activity::isReplaying() const
+{
+    return m_replayData;
+}
+
+bool DataFile::Activity::isReplayFinished() const
+{
+    return m_replayPos == m_replaySize;
+}
+
+void DataFile::Activity::record(const void *data, size_t size)
+{
+    E_DASSERT(m_recording, "Recording is nullptr.");
+
+    m_recording->append(static_cast <const char*> (data), size);
+}
+
+void DataFile::Activity::replay(void *data, size_t size)
+{
+    E_DASSERT(m_replayData, "Replay data is nullptr.");
+
+    if(size > m_replaySize - m_replayPos)
+        throw Exception{"Recorded data for \"" + m_filePath + "\" ended unexpectedly."};
+
+    std::memcpy(data, m_replayData + m_replayPos, size);
+    m_replayPos += size;
+}
+
 DataFile::Node::Node(Activity &activity, const std::string &key, const YAML::Node *YAMLNode, bool isSequence, int sequenceElementIndex)
     : m_activity{activity},
       m_key{key},
@@ -116,6 +165,23 @@ bool DataFile::Node::isSequenceElement()
     return m_sequenceElementIndex >= 0;
 }
 
+void DataFile::Node::recordValue(const std::string &v)
+{
+    recordValue(static_cast <std::uint32_t> (v.size()));
+    m_activity.record(v.data(), v.size());
+}
+
+void DataFile::Node::replayValue(std::string &v)
+{
+    std::uint32_t size{};
+    replayValue(size);
+
+    v.resize(size);
+
+    if(size)
+        m_activity.replay(&v[0], size);
+}
+
 const std::string DataFile::Node::k_indentation{"    "};
 
 DataFile::DataFile()
@@ -177,7 +243,7 @@ void DataFile::save(Saveable &entry, const std::string &entryKey)
     out << m_data;
 }
 
-void DataFile::load(Saveable &entry, const std::string &entryKey)
+void DataFile::load(Saveable &entry, const std::string &entryKey, std::string *outRecording)
 {
     TRACK;
 
@@ -199,6 +265,11 @@ void DataFile::load(Saveable &entry, const std::string &entryKey)
         Activity activity{Activity::Type::Loading, m_path};
         Node node{activity, entryKey, YAMLNode};
 
+        if(outRecording) {
+            outRecording->clear();
+            activity.setRecording(outRecording);
+        }
+
         try {
             entry.expose(node);
         }
@@ -209,24 +280,57 @@ void DataFile::load(Saveable &entry, const std::string &entryKey)
         if(activity.getError())
             throw Exception{"Could not load DataFile \"" + m_path + "\"."};
 
-        Activity initActivity{Activity::Type::PostLoadInit, m_path};
-        Node initNode{initActivity, entryKey, nullptr};
-
-        try {
-            entry.expose(initNode);
-        }
-        catch(const std::exception &e) {
-            throw Exception{"An exception was thrown in expose method (" + std::string(e.what()) + ") for \"" + m_path + "\"."};
-        }
-
-        if(initActivity.getError())
-            throw Exception{"Could not init all nodes in DataFile \"" + m_path + "\"."};
+        postLoadInit(entry, entryKey, m_path);
     }
     catch(const YAML::Exception &e) {
         throw Exception{"Could not parse DataFile file \"" + m_path + "\" (" + e.what() + ")."};
     }
 }
 
+void DataFile::loadRecorded(Saveable &entry, const std::string &entryKey, const char *recording, size_t recordingSize, const std::string &sourcePath)
+{
+    TRACK;
+
+    if(!recording)
+        throw Exception{"Tried to load recorded data which is nullptr for \"" + sourcePath + "\"."};
+
+    Activity activity{Activity::Type::Loading, sourcePath};
+    Node node{activity, entryKey, nullptr};
+
+    activity.setReplay(recording, recordingSize);
+
+    try {
+        entry.expose(node);
+    }
+    catch(const std::exception &e) {
+        throw Exception{"An exception was thrown in expose method (" + std::string{e.what()} + ") for recorded \"" + sourcePath + "\"."};
+    }
+
+    if(activity.getError())
+        throw Exception{"Could not load recorded DataFile \"" + sourcePath + "\"."};
+
+    if(!activity.isReplayFinished())
+        throw Exception{"Recorded data for \"" + sourcePath + "\" was not fully read, it does not match expose methods."};
+
+    postLoadInit(entry, entryKey, sourcePath);
+}
+
+void DataFile::postLoadInit(Saveable &entry, const std::string &entryKey, const std::string &path)
+{
+    Activity initActivity{Activity::Type::PostLoadInit, path};
+    Node initNode{initActivity, entryKey, nullptr};
+
+    try {
+        entry.expose(initNode);
+    }
+    catch(const std::exception &e) {
+        throw Exception{"An exception was thrown in expose method (" + std::string(e.what()) + ") for \"" + path + "\"."};
+    }
+
+    if(initActivity.getError())
+        throw Exception{"Could not init all nodes in DataFile \"" + path + "\"."};
+}
+
 std::string DataFile::getFormattedKey(const std::string &str)
 {
     return getQuotedString(str);
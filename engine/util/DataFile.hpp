@@ -9,6 +9,8 @@
 #include <yaml-cpp/yaml.h>
 
 #include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <map>
 #include <sstream>
 #include <string>
@@ -50,10 +52,24 @@ public:
         void setError(bool error);
         bool getError() const;
 
+        // recording stores everything read while loading from YAML, so it can be
+        // replayed later (loading the same values without parsing YAML)
+        void setRecording(std::string *recording);
+        void setReplay(const char *data, size_t size);
+        bool isRecording() const;
+        bool isReplaying() const;
+        bool isReplayFinished() const;
+        void record(const void *data, size_t size);
+        void replay(void *data, size_t size);
+
     private:
         Type m_type;
         std::string m_filePath;
         bool m_error;
+        std::string *m_recording;
+        const char *m_replayData;
+        size_t m_replaySize;
+        size_t m_replayPos;
     };
 
     class Node
@@ -91,6 +107,13 @@ public:
     private:
         bool isSequenceElement();
 
+        template <typename T, typename std::enable_if <std::is_arithmetic <T>::value, T>::type * = nullptr> void recordValue(const T &v);
+        template <typename T, typename std::enable_if <!std::is_arithmetic <T>::value, T>::type * = nullptr> void recordValue(const T &v);
+        void recordValue(const std::string &v);
+        template <typename T, typename std::enable_if <std::is_arithmetic <T>::value, T>::type * = nullptr> void replayValue(T &v);
+        template <typename T, typename std::enable_if <!std::is_arithmetic <T>::value, T>::type * = nullptr> void replayValue(T &v);
+        void replayValue(std::string &v);
+
         // 'var' version for non-Saveable instances with or without default value
         template <typename T, typename std::enable_if <!std::is_base_of <Saveable, T>::value, T>::type * = nullptr>
         void var_nonSaveableWithOptional(T &v, const std::string &key, const std::experimental::optional <T> &defaultValue);
@@ -113,9 +136,14 @@ public:
 
     bool open(const std::string &path, bool mustExist);
     void save(Saveable &entry, const std::string &entryKey);
-    void load(Saveable &entry, const std::string &entryKey);
+    void load(Saveable &entry, const std::string &entryKey, std::string *outRecording = nullptr);
+
+    // loads entry from data recorded by load(), doesn't touch YAML at all
+    static void loadRecorded(Saveable &entry, const std::string &entryKey, const char *recording, size_t recordingSize, const std::string &sourcePath);
 
 private:
+    static void postLoadInit(Saveable &entry, const std::string &entryKey, const std::string &path);
+
     static std::string getFormattedKey(const std::string &str);
     static std::string getFormattedStrValue(const std::string &str);
     static std::string getQuotedString(const std::string &str);
@@ -146,6 +174,12 @@ void DataFile::Node::var(T &v, const std::string &key)
         }
     }
     else if(activityType == Activity::Type::Loading) {
+        if(m_activity.isReplaying()) {
+            Node node{m_activity, key, nullptr};
+            v.expose(node);
+            return;
+        }
+
         E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
 
         try {
@@ -203,6 +237,20 @@ void DataFile::Node::var(T &v, const std::string &key, const typename std::commo
         }
     }
     else if(activityType == Activity::Type::Loading) {
+        if(m_activity.isReplaying()) {
+            bool present{};
+            replayValue(present);
+
+            if(present) {
+                Node node{m_activity, key, nullptr};
+                v.expose(node);
+            }
+            else
+                v = defaultValue;
+
+            return;
+        }
+
         E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
 
         try {
@@ -220,10 +268,16 @@ void DataFile::Node::var(T &v, const std::string &key, const typename std::commo
 
             m_nodes.emplace_back(m_activity, key, &node);
 
+            if(m_activity.isRecording())
+                recordValue(true);
+
             v.expose(m_nodes.back());
         }
         catch(const YAML::Exception &e) {
             v = defaultValue;
+
+            if(m_activity.isRecording())
+                recordValue(false);
         }
     }
 }
@@ -254,9 +308,26 @@ template <typename T> void DataFile::Node::var(std::vector <T> &v, const std::st
         }
     }
     else if(activityType == Activity::Type::Loading) {
+        v.clear();
+
+        if(m_activity.isReplaying()) {
+            std::uint32_t size{};
+            replayValue(size);
+
+            v.reserve(size);
+
+            for(std::uint32_t i = 0; i < size; ++i) {
+                T tmp{};
+                var(tmp, "-");
+                v.emplace_back(std::move(tmp));
+            }
+
+            return;
+        }
+
         E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
 
-        v.clear();
+        bool sizeRecorded{};
 
         try {
             const auto &node = isSequenceElement() ? (*m_YAMLNode)[m_sequenceElementIndex] : (*m_YAMLNode)[key];
@@ -271,6 +342,11 @@ template <typename T> void DataFile::Node::var(std::vector <T> &v, const std::st
                 return;
             }
 
+            if(m_activity.isRecording()) {
+                recordValue(static_cast <std::uint32_t> (node.size()));
+                sizeRecorded = true;
+            }
+
             v.reserve(node.size());
 
             for(size_t i = 0; i < node.size(); ++i) {
@@ -282,6 +358,9 @@ template <typename T> void DataFile::Node::var(std::vector <T> &v, const std::st
         }
         catch(const YAML::Exception &e) {
             // vector is always optional
+
+            if(m_activity.isRecording() && !sizeRecorded)
+                recordValue(std::uint32_t{});
         }
     }
 }
@@ -302,10 +381,29 @@ template <typename T1, typename T2> void DataFile::Node::var(std::map <T1, T2> &
         }
     }
     else if(activityType == Activity::Type::Loading) {
-        E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
-
         v.clear();
 
+        if(m_activity.isReplaying()) {
+            // each element is preceded by 'true', the last one is followed by 'false'
+            bool next{};
+            replayValue(next);
+
+            while(next) {
+                T1 elementKey{};
+                replayValue(elementKey);
+
+                T2 tmp{};
+                var(tmp, "-");
+                v.emplace(elementKey, std::move(tmp));
+
+                replayValue(next);
+            }
+
+            return;
+        }
+
+        E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
+
         try {
             const auto &node = isSequenceElement() ? (*m_YAMLNode)[m_sequenceElementIndex] : (*m_YAMLNode)[key];
 
@@ -328,6 +426,11 @@ template <typename T1, typename T2> void DataFile::Node::var(std::map <T1, T2> &
 
                 const auto &elementKeyStr = oss.str();
 
+                if(m_activity.isRecording()) {
+                    recordValue(true);
+                    recordValue(elementKey);
+                }
+
                 T2 tmp{};
                 m_nodes.emplace_back(m_activity, elementKeyStr, &node);
                 m_nodes.back().var(tmp, elementKeyStr);
@@ -337,6 +440,9 @@ template <typename T1, typename T2> void DataFile::Node::var(std::map <T1, T2> &
         catch(const YAML::Exception &e) {
             // map is always optional
         }
+
+        if(m_activity.isRecording())
+            recordValue(false);
     }
 }
 
@@ -356,18 +462,41 @@ void DataFile::Node::var_nonSaveableWithOptional(T &v, const std::string &key, c
         m_nodes.back().m_value = getFormattedStrValue(oss.str());
     }
     else if(activityType == Activity::Type::Loading) {
-        E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
-
         v = T{};
 
+        if(m_activity.isReplaying()) {
+            bool present{};
+            replayValue(present);
+
+            if(present)
+                replayValue(v);
+            else if(defaultValue)
+                v = *defaultValue;
+            else
+                throw Exception{"Recorded data does not match \"" + key + "\" key."};
+
+            return;
+        }
+
+        E_DASSERT(m_YAMLNode, "m_YAMLNode is nullptr.");
+
         try {
             const auto &node = isSequenceElement() ? (*m_YAMLNode)[m_sequenceElementIndex] : (*m_YAMLNode)[key];
 
             node >> v;
+
+            if(m_activity.isRecording()) {
+                recordValue(true);
+                recordValue(v);
+            }
         }
         catch(const YAML::Exception &e) {
-            if(defaultValue)
+            if(defaultValue) {
                 v = *defaultValue;
+
+                if(m_activity.isRecording())
+                    recordValue(false);
+            }
             else {
                 const auto &filePath = m_activity.getFilePath();
 
@@ -380,6 +509,37 @@ void DataFile::Node::var_nonSaveableWithOptional(T &v, const std::string &key, c
     }
 }
 
+template <typename T, typename std::enable_if <std::is_arithmetic <T>::value, T>::type *>
+void DataFile::Node::recordValue(const T &v)
+{
+    m_activity.record(&v, sizeof(T));
+}
+
+template <typename T, typename std::enable_if <!std::is_arithmetic <T>::value, T>::type *>
+void DataFile::Node::recordValue(const T &v)
+{
+    // other types go through their text representation
+    std::ostringstream oss;
+    oss << v;
+    recordValue(oss.str());
+}
+
+template <typename T, typename std::enable_if <std::is_arithmetic <T>::value, T>::type *>
+void DataFile::Node::replayValue(T &v)
+{
+    m_activity.replay(&v, sizeof(T));
+}
+
+template <typename T, typename std::enable_if <!std::is_arithmetic <T>::value, T>::type *>
+void DataFile::Node::replayValue(T &v)
+{
+    std::string str;
+    replayValue(str);
+
+    std::istringstream iss{str};
+    iss >> v;
+}
+
 } // namespace engine
 
 #endif // ENGINE_DATA_FILE_HPP
@@ -20,6 +20,10 @@ void Def::expose(DataFile::Node &node)
         m_capitalizedLabel = createCapitalizedLabel();
 }
 
+void Def::onAddedToDatabase(DefDatabase &defDatabase)
+{
+}
+
 void Def::onLoadedAllDefs(DefDatabase &defDatabase)
 {
 }
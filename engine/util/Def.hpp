@@ -18,6 +18,9 @@ public:
 
     void expose(DataFile::Node &node) override;
 
+    // defs can be loaded on worker threads; this is called on the main thread when the def is added
+    // to the database, so resources which aren't thread-safe to acquire (textures, meshes) belong here
+    virtual void onAddedToDatabase(DefDatabase &defDatabase);
     virtual void onLoadedAllDefs(DefDatabase &defDatabase);
 
     const std::string &getDefName() const;
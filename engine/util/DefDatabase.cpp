@@ -1,13 +1,63 @@
 #include "DefDatabase.hpp"
 
+#include "ThreadPool.hpp"
+#include "Util.hpp"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 namespace engine
 {
 
+DefDatabase::DefDatabase()
+    : m_defsGeneration{}
+{
+}
+
+void DefDatabase::loadQueuedDefs()
+{
+    TRACK;
+
+    std::vector <QueuedDefsFile> files;
+
+    files.swap(m_queuedDefsFiles);
+
+    loadQueuedDefsFiles(files);
+}
+
+void DefDatabase::setParallelLoading(bool parallelLoading)
+{
+    TRACK;
+
+    if(!parallelLoading) {
+        m_threadPool.reset();
+        return;
+    }
+
+    if(m_threadPool)
+        return;
+
+    m_threadPool = std::make_unique <ThreadPool> (ThreadPool::getDefaultWorkerThreadsCount());
+
+    E_INFO("Loading defs using %d worker threads.", m_threadPool->getWorkerThreadsCount());
+}
+
 void DefDatabase::callOnLoadedAllDefs()
 {
-    for(auto &elem : m_defs) {
-        E_DASSERT(elem.second, "Def is nullptr.");
-        elem.second->onLoadedAllDefs(*this);
+    // def types queried since defs were loaded are also known from now on
+    updateDerivedDefTypes();
+
+    for(auto &defs : m_defsByType) {
+        for(auto &elem : defs) {
+            E_DASSERT(elem, "Def is nullptr.");
+            elem->onLoadedAllDefs(*this);
+        }
     }
 }
 
@@ -18,8 +68,377 @@ void DefDatabase::dropAllDefs()
     E_INFO("Dropping %d defs.", static_cast <int> (m_defs.size()));
 
     m_defs.clear();
+    m_defsByType.clear();
+    m_derivedDefTypes.clear();
+    ++m_defsGeneration;
+}
+
+void DefDatabase::openCompiledDefsCache(const std::string &path)
+{
+    TRACK;
+
+    m_compiledDefsCachePath = path;
+    m_compiledDefsCacheFile.reset();
+    m_cachedCompiledDefsFiles.clear();
+    m_compiledDefsFiles.clear();
+
+    auto file = std::make_unique <QFile> (path.c_str());
+
+    if(!file->open(QIODevice::ReadOnly)) {
+        E_INFO("Compiled defs cache \"%s\" does not exist yet.", path.c_str());
+        return;
+    }
+
+    auto size = static_cast <size_t> (file->size());
+    const auto *data = reinterpret_cast <const char*> (file->map(0, file->size()));
+
+    if(!data) {
+        E_WARNING("Could not map compiled defs cache \"%s\".", path.c_str());
+        return;
+    }
+
+    size_t pos{};
+
+    // returns nullptr if there is not enough data left
+    const auto read = [&](size_t bytes) -> const char* {
+        if(bytes > size - pos)
+            return nullptr;
+
+        const char *ret{data + pos};
+        pos += bytes;
+        return ret;
+    };
+
+    const auto readValue = [&](auto &outValue) {
+        const char *ptr{read(sizeof(outValue))};
+
+        if(ptr)
+            std::memcpy(&outValue, ptr, sizeof(outValue));
+
+        return ptr != nullptr;
+    };
+
+    const auto readString = [&](std::string &outString) {
+        std::uint32_t length{};
+
+        if(!readValue(length))
+            return false;
+
+        const char *ptr{read(length)};
+
+        if(ptr)
+            outString.assign(ptr, length);
+
+        return ptr != nullptr;
+    };
+
+    const char *magic{read(sizeof(k_compiledDefsCacheMagic))};
+    std::uint32_t version{};
+    std::string buildID;
+    std::uint32_t filesCount{};
+
+    // recordings are only valid for the same expose methods, so the cache is bound to the executable which created it
+    const auto &currentBuildID = getBuildID();
+
+    if(!magic || std::memcmp(magic, k_compiledDefsCacheMagic, sizeof(k_compiledDefsCacheMagic)) ||
+       !readValue(version) || version != k_compiledDefsCacheVersion ||
+       !readString(buildID) || buildID.empty() || buildID != currentBuildID || !readValue(filesCount)) {
+        E_INFO("Compiled defs cache \"%s\" is outdated, it will be recreated.", path.c_str());
+        return;
+    }
+
+    for(std::uint32_t i = 0; i < filesCount; ++i) {
+        std::string filePath;
+        CompiledDefsFile compiled;
+        std::uint64_t recordingSize{};
+
+        bool ok{readString(filePath) &&
+                readString(compiled.dataFileRootName) &&
+                readValue(compiled.size) &&
+                readValue(compiled.lastModified) &&
+                readValue(compiled.hash) &&
+                readValue(recordingSize)};
+
+        if(ok)
+            compiled.recording = read(recordingSize);
+
+        if(!compiled.recording) {
+            E_WARNING("Compiled defs cache \"%s\" is corrupted, it will be recreated.", path.c_str());
+            m_cachedCompiledDefsFiles.clear();
+            return;
+        }
+
+        compiled.recordingSize = recordingSize;
+        m_cachedCompiledDefsFiles.emplace(filePath, std::move(compiled));
+    }
+
+    m_compiledDefsCacheFile = std::move(file);
+
+    E_INFO("Opened compiled defs cache \"%s\" (%d files).", path.c_str(), static_cast <int> (m_cachedCompiledDefsFiles.size()));
+}
+
+void DefDatabase::saveCompiledDefsCache()
+{
+    TRACK;
+
+    if(m_compiledDefsCachePath.empty())
+        return;
+
+    // everything is serialized before the old file is unmapped, because recordings can point to it
+
+    std::string data;
+
+    const auto writeValue = [&data](const auto &value) {
+        data.append(reinterpret_cast <const char*> (&value), sizeof(value));
+    };
+
+    const auto writeString = [&](const std::string &str) {
+        writeValue(static_cast <std::uint32_t> (str.size()));
+        data.append(str);
+    };
+
+    data.append(k_compiledDefsCacheMagic, sizeof(k_compiledDefsCacheMagic));
+    writeValue(k_compiledDefsCacheVersion);
+    writeString(getBuildID());
+    writeValue(static_cast <std::uint32_t> (m_compiledDefsFiles.size()));
+
+    for(const auto &elem : m_compiledDefsFiles) {
+        writeString(elem.first);
+        writeString(elem.second.dataFileRootName);
+        writeValue(elem.second.size);
+        writeValue(elem.second.lastModified);
+        writeValue(elem.second.hash);
+        writeValue(static_cast <std::uint64_t> (elem.second.recordingSize));
+        data.append(elem.second.recording, elem.second.recordingSize);
+    }
+
+    m_compiledDefsFiles.clear();
+    m_cachedCompiledDefsFiles.clear();
+    m_compiledDefsCacheFile.reset();
+
+    const auto &tmpPath = m_compiledDefsCachePath + ".tmp";
+
+    {
+        std::ofstream out{tmpPath, std::ios::binary};
+
+        if(!out.is_open()) {
+            E_WARNING("Could not save compiled defs cache to \"%s\".", tmpPath.c_str());
+            return;
+        }
+
+        out.write(data.data(), data.size());
+    }
+
+    std::remove(m_compiledDefsCachePath.c_str());
+
+    if(std::rename(tmpPath.c_str(), m_compiledDefsCachePath.c_str()))
+        E_WARNING("Could not rename \"%s\" to \"%s\".", tmpPath.c_str(), m_compiledDefsCachePath.c_str());
+
+    m_compiledDefsCachePath.clear();
+}
+
+DefDatabase::~DefDatabase()
+{
+}
+
+void DefDatabase::loadQueuedDefsFiles(std::vector <QueuedDefsFile> &files)
+{
+    TRACK;
+
+    if(!m_threadPool || files.size() <= 1) {
+        // the same as parallel loading, but defs loaded from one file are visible while loading the next one
+        for(auto &file : files) {
+            (this->*file.load)(file);
+            addLoadedDefs(file);
+        }
+
+        updateDerivedDefTypes();
+        return;
+    }
+
+    m_threadPool->parallelFor(files.size(), [this, &files](size_t index) {
+        auto &file = files[index];
+
+        try {
+            (this->*file.load)(file);
+        }
+        catch(...) {
+            file.error = std::current_exception();
+        }
+    });
+
+    // merged in order, so the first error (if any) is the same as it would be when loading sequentially
+    for(auto &file : files) {
+        if(file.error)
+            std::rethrow_exception(file.error);
+
+        addLoadedDefs(file);
+    }
+
+    updateDerivedDefTypes();
+}
+
+void DefDatabase::addLoadedDefs(QueuedDefsFile &file)
+{
+    TRACK;
+
+    if(static_cast <size_t> (file.defTypeIndex) >= m_defsByType.size())
+        m_defsByType.resize(file.defTypeIndex + 1);
+
+    auto &defs = m_defsByType[file.defTypeIndex];
+
+    for(auto &elem : file.defs) {
+        E_DASSERT(elem, "Def is nullptr.");
+
+        const auto &inserted = m_defs.emplace(elem->getDefName(), DefLocation{file.defTypeIndex, static_cast <int> (defs.size())});
+
+        if(!inserted.second) {
+            E_ERROR("Could not add def with defName: \"%s\" because def with this defName already exists.",
+                    elem->getDefName().c_str());
+        }
+        else {
+            defs.push_back(std::move(elem));
+            defs.back()->onAddedToDatabase(*this);
+        }
+    }
+
+    if(file.hasCompiled) {
+        auto &compiled = m_compiledDefsFiles[file.filePath];
+
+        compiled = std::move(file.compiled);
+
+        // recordings not from the cache file are owned, and their pointer could have been invalidated by moving
+        if(!compiled.recording) {
+            compiled.recording = compiled.ownRecording.data();
+            compiled.recordingSize = compiled.ownRecording.size();
+        }
+    }
+
+    E_INFO("Loaded %d defs from \"%s\".", static_cast <int> (file.defs.size()), file.filePath.c_str());
+
+    file.defs.clear();
+}
+
+int DefDatabase::createDefTypeIndex(IsDefTypeFunc isDefTypeFunc)
+{
+    std::lock_guard <std::mutex> lock{m_isDefTypeFuncsMutex};
+
+    m_isDefTypeFuncs.push_back(isDefTypeFunc);
+
+    return m_isDefTypeFuncs.size() - 1;
+}
+
+void DefDatabase::updateDerivedDefTypes()
+{
+    TRACK;
+
+    // type indices can be created by other threads at any time, but only the ones
+    // registered so far are needed
+    std::vector <IsDefTypeFunc> isDefTypeFuncs;
+
+    {
+        std::lock_guard <std::mutex> lock{m_isDefTypeFuncsMutex};
+        isDefTypeFuncs = m_isDefTypeFuncs;
+    }
+
+    m_derivedDefTypes.resize(isDefTypeFuncs.size());
+
+    for(size_t i = 0; i < m_derivedDefTypes.size(); ++i) {
+        auto &derived = m_derivedDefTypes[i];
+
+        derived.resize(m_defsByType.size(), -1);
+
+        for(size_t j = 0; j < derived.size(); ++j) {
+            if(derived[j] < 0 && !m_defsByType[j].empty())
+                derived[j] = isDefTypeFuncs[i](*m_defsByType[j].front()) ? 1 : 0;
+        }
+    }
+}
+
+const std::shared_ptr <Def> &DefDatabase::getDefAt(const DefLocation &location) const
+{
+    E_DASSERT(location.defTypeIndex >= 0 && static_cast <size_t> (location.defTypeIndex) < m_defsByType.size(), "Def type index out of bounds.");
+
+    const auto &defs = m_defsByType[location.defTypeIndex];
+
+    E_DASSERT(location.index >= 0 && static_cast <size_t> (location.index) < defs.size(), "Def index out of bounds.");
+
+    return defs[location.index];
+}
+
+bool DefDatabase::findUpToDateCompiledDefsFile(const std::string &filePath, const std::string &dataFileRootName, CompiledDefsFile &outCompiled) const
+{
+    TRACK;
+
+    auto it = m_cachedCompiledDefsFiles.find(filePath);
+
+    if(it == m_cachedCompiledDefsFiles.end() || it->second.dataFileRootName != dataFileRootName)
+        return false;
+
+    outCompiled = it->second;
+
+    if(!getFileInfo(filePath, outCompiled.size, outCompiled.lastModified) || outCompiled.size != it->second.size)
+        return false;
+
+    // modification time can change without changing the content (e.g. after checkout)
+    if(outCompiled.lastModified != it->second.lastModified && Util::getFileHash(filePath) != it->second.hash)
+        return false;
+
+    return true;
+}
+
+bool DefDatabase::createCompiledDefsFile(const std::string &filePath, const std::string &dataFileRootName, std::string &&recording, CompiledDefsFile &outCompiled)
+{
+    TRACK;
+
+    outCompiled = {};
+
+    if(!getFileInfo(filePath, outCompiled.size, outCompiled.lastModified))
+        return false;
+
+    outCompiled.dataFileRootName = dataFileRootName;
+    outCompiled.hash = Util::getFileHash(filePath);
+    outCompiled.ownRecording = std::move(recording);
+
+    return true;
+}
+
+bool DefDatabase::getFileInfo(const std::string &filePath, std::int64_t &outSize, std::int64_t &outLastModified)
+{
+    QFileInfo fileInfo{filePath.c_str()};
+
+    if(!fileInfo.exists())
+        return false;
+
+    outSize = fileInfo.size();
+    outLastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    return true;
+}
+
+std::string DefDatabase::getBuildID()
+{
+    // size and modification time of the executable change with every relink, which is much cheaper than hashing it
+
+    if(!QCoreApplication::instance())
+        return {};
+
+    std::int64_t size{};
+    std::int64_t lastModified{};
+
+    if(!getFileInfo(QCoreApplication::applicationFilePath().toStdString(), size, lastModified))
+        return {};
+
+    return std::to_string(size) + ':' + std::to_string(lastModified);
 }
 
 const std::string DefDatabase::k_directoryScanDataFileExtension = "yaml";
+const char DefDatabase::k_compiledDefsCacheMagic[4]{'E', 'D', 'C', 'C'};
+
+// must be increased whenever the cache file format changes (changed expose methods are detected by build ID)
+const std::uint32_t DefDatabase::k_compiledDefsCacheVersion{2};
+
+std::mutex DefDatabase::m_isDefTypeFuncsMutex;
+std::vector <DefDatabase::IsDefTypeFunc> DefDatabase::m_isDefTypeFuncs;
 
 } // namespace engine
@@ -7,13 +7,24 @@
 
 #include <QDirIterator>
 
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <map>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+
+class QFile;
 
 namespace engine
 {
 
+class ThreadPool;
+
 class DefDatabase : public Tracked <DefDatabase>
 {
 public:
@@ -24,25 +35,142 @@ public:
         std::vector <T> defs;
     };
 
-    DefDatabase() = default;
+    // interned def, resolved by index without hashing defName; after defs are dropped
+    // it's stale and doesn't resolve anymore, so it can be kept across reloads and refreshed
+    template <class T> class Handle
+    {
+    public:
+        Handle() = default;
+
+        bool isValid() const;
+
+    private:
+        friend class DefDatabase;
+
+        Handle(int defTypeIndex, int index, int defsGeneration);
+
+        int m_defTypeIndex{-1};
+        int m_index{-1};
+        int m_defsGeneration{-1};
+    };
+
+    DefDatabase();
     DefDatabase(const DefDatabase &) = delete;
 
     DefDatabase &operator = (const DefDatabase &) = delete;
 
     template <class T> std::shared_ptr <T> getDef(const std::string &defName) const;
     template <class T> std::shared_ptr <T> tryGetDef(const std::string &defName) const;
-    template <class T> std::unordered_map <std::string, std::shared_ptr <T>> getDefs() const;
+    template <class T> std::shared_ptr <T> getDef(const Handle <T> &handle) const;
+    template <class T> std::shared_ptr <T> tryGetDef(const Handle <T> &handle) const; // nullptr if handle is invalid or stale
+    template <class T> Handle <T> getHandle(const std::string &defName) const;
+    template <class T> Handle <T> tryGetHandle(const std::string &defName) const;
+
+    // resolves by cachedHandle, and by defName only if it's invalid or stale (then cachedHandle is updated)
+    template <class T> std::shared_ptr <T> getDef(const std::string &defName, Handle <T> &cachedHandle) const;
+
+    // func is called with const std::shared_ptr <T> & for every def which is T (or derived from T),
+    // in load order of each def type
+    template <class T, class Func> void forEachDef(Func &&func) const;
 
     template <class T> void loadDefs_file(const std::string &filePath, const std::string &dataFileRootName);
     template <class T> void loadDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName);
 
+    // queued directories are loaded together by loadQueuedDefs(), with files parsed in parallel
+    // if parallel loading is enabled, and merged in queue order (so errors like duplicated defNames
+    // don't depend on timing); while being loaded, defs can only refer to defs loaded before
+    template <class T> void queueDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName);
+    void loadQueuedDefs();
+
+    // worker threads are kept until parallel loading is disabled
+    void setParallelLoading(bool parallelLoading);
+
     void callOnLoadedAllDefs();
     void dropAllDefs();
 
+    // compiled defs cache: while it's open, every def file loaded from YAML is recorded,
+    // so next time it can be loaded without parsing YAML if the source file didn't change
+    void openCompiledDefsCache(const std::string &path);
+    void saveCompiledDefsCache();
+
+    ~DefDatabase();
+
 private:
-    static const std::string k_directoryScanDataFileExtension;
+    struct CompiledDefsFile
+    {
+        std::string dataFileRootName;
+        std::int64_t size{};
+        std::int64_t lastModified{};
+        std::uint64_t hash{};
+
+        // points to either mapped cache file or 'ownRecording'
+        const char *recording{};
+        size_t recordingSize{};
+        std::string ownRecording;
+    };
+
+    struct QueuedDefsFile
+    {
+        std::string filePath;
+        std::string dataFileRootName;
+        void (DefDatabase::*load)(QueuedDefsFile &) const;
+        int defTypeIndex{};
+
+        // results, set by load
+        std::vector <std::shared_ptr <Def>> defs;
+        CompiledDefsFile compiled;
+        bool hasCompiled{};
+        std::exception_ptr error;
+    };
+
+    struct DefLocation
+    {
+        int defTypeIndex{}; // type def was loaded as
+        int index{};
+    };
 
-    std::unordered_map <std::string, std::shared_ptr <Def>> m_defs;
+    typedef bool (*IsDefTypeFunc)(const Def &def);
+
+    template <class T> static int getDefTypeIndex();
+    static int createDefTypeIndex(IsDefTypeFunc isDefTypeFunc);
+    template <class T> static bool isDefType(const Def &def);
+    template <class T> bool isDefType(int defTypeIndex) const;
+    void updateDerivedDefTypes();
+    const std::shared_ptr <Def> &getDefAt(const DefLocation &location) const;
+
+    template <class T> void queueDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName, std::vector <QueuedDefsFile> &outFiles) const;
+    template <class T> void loadQueuedDefsFile(QueuedDefsFile &file) const;
+    void loadQueuedDefsFiles(std::vector <QueuedDefsFile> &files);
+    void addLoadedDefs(QueuedDefsFile &file);
+
+    bool findUpToDateCompiledDefsFile(const std::string &filePath, const std::string &dataFileRootName, CompiledDefsFile &outCompiled) const;
+    static bool createCompiledDefsFile(const std::string &filePath, const std::string &dataFileRootName, std::string &&recording, CompiledDefsFile &outCompiled);
+    static bool getFileInfo(const std::string &filePath, std::int64_t &outSize, std::int64_t &outLastModified);
+    static std::string getBuildID();
+
+    static const std::string k_directoryScanDataFileExtension;
+    static const char k_compiledDefsCacheMagic[4];
+    static const std::uint32_t k_compiledDefsCacheVersion;
+
+    // index: def type index
+    static std::mutex m_isDefTypeFuncsMutex;
+    static std::vector <IsDefTypeFunc> m_isDefTypeFuncs;
+
+    std::unordered_map <std::string, DefLocation> m_defs; // key: defName
+    std::vector <std::vector <std::shared_ptr <Def>>> m_defsByType; // index: def type index
+    std::vector <QueuedDefsFile> m_queuedDefsFiles;
+
+    // whether defs loaded as one type are also another type (derived from it), updated on the main thread
+    // after defs are loaded and read-only otherwise, index: [queried def type index][loaded def type index],
+    // -1 means unknown (no defs of this type were loaded yet)
+    std::vector <std::vector <signed char>> m_derivedDefTypes;
+    int m_defsGeneration; // incremented when defs are dropped, so handles to them become stale
+    std::unique_ptr <ThreadPool> m_threadPool;
+
+    std::string m_compiledDefsCachePath;
+    std::unique_ptr <QFile> m_compiledDefsCacheFile;
+    std::unordered_map <std::string, CompiledDefsFile> m_cachedCompiledDefsFiles; // from cache file, key: file path
+    std::map <std::string, CompiledDefsFile> m_compiledDefsFiles; // loaded in this session, key: file path
 };
 
 template <class T> void DefDatabase::DefsList <T>::expose(DataFile::Node &node)
@@ -50,6 +178,18 @@ template <class T> void DefDatabase::DefsList <T>::expose(DataFile::Node &node)
     node.var(defs, "list");
 }
 
+template <class T> bool DefDatabase::Handle <T>::isValid() const
+{
+    return m_index >= 0;
+}
+
+template <class T> DefDatabase::Handle <T>::Handle(int defTypeIndex, int index, int defsGeneration)
+    : m_defTypeIndex{defTypeIndex},
+      m_index{index},
+      m_defsGeneration{defsGeneration}
+{
+}
+
 template <class T> std::shared_ptr <T> DefDatabase::getDef(const std::string &defName) const
 {
     TRACK;
@@ -68,58 +208,116 @@ template <class T> std::shared_ptr <T> DefDatabase::tryGetDef(const std::string
 
     const auto &it = m_defs.find(defName);
 
-    if(it == m_defs.end())
+    if(it == m_defs.end() || !isDefType <T> (it->second.defTypeIndex))
         return nullptr;
 
-    const auto &ret = std::dynamic_pointer_cast <T> (it->second);
+    return std::static_pointer_cast <T> (getDefAt(it->second));
+}
+
+template <class T> std::shared_ptr <T> DefDatabase::getDef(const Handle <T> &handle) const
+{
+    const auto &ret = tryGetDef(handle);
+
+    if(!ret)
+        throw Exception{"Def handle is invalid or stale."};
 
     return ret;
 }
 
-template <class T> std::unordered_map <std::string, std::shared_ptr <T>> DefDatabase::getDefs() const
+template <class T> std::shared_ptr <T> DefDatabase::tryGetDef(const Handle <T> &handle) const
 {
-    std::unordered_map <std::string, std::shared_ptr <T>> ret;
+    // defs are only appended until they are dropped, so a handle from this generation is always in bounds
+    if(!handle.isValid() || handle.m_defsGeneration != m_defsGeneration)
+        return nullptr;
 
-    for(const auto &it : m_defs) {
-        const auto &def = std::dynamic_pointer_cast <T> (it.second);
+    return std::static_pointer_cast <T> (getDefAt({handle.m_defTypeIndex, handle.m_index}));
+}
 
-        if(def)
-            ret[it.first] = def;
-    }
+template <class T> DefDatabase::Handle <T> DefDatabase::getHandle(const std::string &defName) const
+{
+    TRACK;
+
+    const auto &ret = tryGetHandle <T> (defName);
+
+    if(!ret.isValid())
+        throw Exception{"Could not find def named \"" + defName + "\"."};
 
     return ret;
 }
 
-template <class T> void DefDatabase::loadDefs_file(const std::string &filePath, const std::string &dataFileRootName)
+template <class T> DefDatabase::Handle <T> DefDatabase::tryGetHandle(const std::string &defName) const
 {
     TRACK;
 
-    DefsList <T> defsList;
+    const auto &it = m_defs.find(defName);
 
-    DataFile dataFile;
+    if(it == m_defs.end() || !isDefType <T> (it->second.defTypeIndex))
+        return {};
 
-    dataFile.open(filePath, true);
-    dataFile.load(defsList, dataFileRootName);
+    return {it->second.defTypeIndex, it->second.index, m_defsGeneration};
+}
 
-    for(auto &elem : defsList.defs) {
-        std::string defName = elem.getDefName(); // we need a copy
+template <class T> std::shared_ptr <T> DefDatabase::getDef(const std::string &defName, Handle <T> &cachedHandle) const
+{
+    const auto &ret = tryGetDef(cachedHandle);
 
-        if(m_defs.find(defName) != m_defs.end()) {
-            E_ERROR("Could not add def with defName: \"%s\" because def with this defName already exists.",
-                    defName.c_str());
-        }
-        else {
-            m_defs.emplace(defName, std::make_shared <T> (std::move(elem)));
+    if(ret)
+        return ret;
+
+    cachedHandle = getHandle <T> (defName);
+
+    return getDef(cachedHandle);
+}
+
+template <class T, class Func> void DefDatabase::forEachDef(Func &&func) const
+{
+    TRACK;
+
+    for(size_t i = 0; i < m_defsByType.size(); ++i) {
+        if(m_defsByType[i].empty() || !isDefType <T> (static_cast <int> (i)))
+            continue;
+
+        for(const auto &elem : m_defsByType[i]) {
+            E_DASSERT(elem, "Def is nullptr.");
+            func(std::static_pointer_cast <T> (elem));
         }
     }
+}
+
+template <class T> void DefDatabase::loadDefs_file(const std::string &filePath, const std::string &dataFileRootName)
+{
+    TRACK;
+
+    std::vector <QueuedDefsFile> files(1);
 
-    E_INFO("Loaded %d defs from \"%s\".", static_cast <int> (defsList.defs.size()), filePath.c_str());
+    files[0].filePath = filePath;
+    files[0].dataFileRootName = dataFileRootName;
+    files[0].load = &DefDatabase::loadQueuedDefsFile <T>;
+    files[0].defTypeIndex = getDefTypeIndex <T> ();
+
+    loadQueuedDefsFiles(files);
 }
 
 template <class T> void DefDatabase::loadDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName)
 {
     TRACK;
 
+    std::vector <QueuedDefsFile> files;
+
+    queueDefs_directory <T> (directoryPath, dataFileRootName, files);
+    loadQueuedDefsFiles(files);
+}
+
+template <class T> void DefDatabase::queueDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName)
+{
+    TRACK;
+
+    queueDefs_directory <T> (directoryPath, dataFileRootName, m_queuedDefsFiles);
+}
+
+template <class T> void DefDatabase::queueDefs_directory(const std::string &directoryPath, const std::string &dataFileRootName, std::vector <QueuedDefsFile> &outFiles) const
+{
+    std::vector <std::string> filePaths;
     QDirIterator dirIt{directoryPath.c_str(), QDirIterator::Subdirectories};
 
     while(dirIt.hasNext()) {
@@ -128,8 +326,101 @@ template <class T> void DefDatabase::loadDefs_directory(const std::string &direc
         const auto &fileInfo = dirIt.fileInfo();
 
         if(fileInfo.isFile() && fileInfo.suffix().toStdString() == k_directoryScanDataFileExtension)
-            loadDefs_file <T> (dirIt.filePath().toStdString(), dataFileRootName);
+            filePaths.push_back(dirIt.filePath().toStdString());
+    }
+
+    // iteration order depends on file system
+    std::sort(filePaths.begin(), filePaths.end());
+
+    for(auto &elem : filePaths) {
+        outFiles.emplace_back();
+
+        auto &file = outFiles.back();
+
+        file.filePath = std::move(elem);
+        file.dataFileRootName = dataFileRootName;
+        file.load = &DefDatabase::loadQueuedDefsFile <T>;
+        file.defTypeIndex = getDefTypeIndex <T> ();
+    }
+}
+
+template <class T> void DefDatabase::loadQueuedDefsFile(QueuedDefsFile &file) const
+{
+    TRACK;
+
+    // may be called from worker threads, so nothing here can modify the database
+
+    DefsList <T> defsList;
+    bool loadedFromCache{};
+
+    if(!m_compiledDefsCachePath.empty() && findUpToDateCompiledDefsFile(file.filePath, file.dataFileRootName, file.compiled)) {
+        try {
+            DataFile::loadRecorded(defsList, file.dataFileRootName, file.compiled.recording, file.compiled.recordingSize, file.filePath);
+            loadedFromCache = true;
+            file.hasCompiled = true;
+        }
+        catch(const std::exception &e) {
+            E_WARNING("Could not load compiled defs for \"%s\", loading source file instead (%s).", file.filePath.c_str(), e.what());
+            defsList.defs.clear();
+        }
+    }
+
+    if(!loadedFromCache) {
+        DataFile dataFile;
+
+        dataFile.open(file.filePath, true);
+
+        if(!m_compiledDefsCachePath.empty()) {
+            std::string recording;
+            dataFile.load(defsList, file.dataFileRootName, &recording);
+            file.hasCompiled = createCompiledDefsFile(file.filePath, file.dataFileRootName, std::move(recording), file.compiled);
+        }
+        else
+            dataFile.load(defsList, file.dataFileRootName);
+    }
+
+    file.defs.reserve(defsList.defs.size());
+
+    for(auto &elem : defsList.defs) {
+        file.defs.push_back(std::make_shared <T> (std::move(elem)));
+    }
+}
+
+template <class T> int DefDatabase::getDefTypeIndex()
+{
+    static_assert(std::is_base_of <Def, T>::value, "T must be a def.");
+
+    // type tag, assigned once per type, so no RTTI is needed to check the exact type
+    static const int defTypeIndex{createDefTypeIndex(&DefDatabase::isDefType <T>)};
+
+    return defTypeIndex;
+}
+
+template <class T> bool DefDatabase::isDefType(const Def &def)
+{
+    return dynamic_cast <const T*> (&def);
+}
+
+template <class T> bool DefDatabase::isDefType(int defTypeIndex) const
+{
+    int queriedDefTypeIndex{getDefTypeIndex <T> ()};
+
+    if(defTypeIndex == queriedDefTypeIndex)
+        return true;
+
+    // T is a base type (e.g. ResourceDef); the table isn't modified while defs can be queried, so no locking
+    // is needed, even when called from worker threads during parallel loading
+
+    if(static_cast <size_t> (queriedDefTypeIndex) < m_derivedDefTypes.size()) {
+        const auto &derived = m_derivedDefTypes[queriedDefTypeIndex];
+
+        if(static_cast <size_t> (defTypeIndex) < derived.size() && derived[defTypeIndex] >= 0)
+            return derived[defTypeIndex] > 0;
     }
+
+    // T wasn't queried before defs were last loaded
+    E_DASSERT(static_cast <size_t> (defTypeIndex) < m_defsByType.size() && !m_defsByType[defTypeIndex].empty(), "There are no defs of this type.");
+    return isDefType <T> (*m_defsByType[defTypeIndex].front());
 }
 
 } // namespace engine
@@ -10,11 +10,167 @@
 #include <QtWidgets/QMessageBox>
 #include <QApplication>
 
+#include <chrono>
 #include <cstdarg>
+#include <cstdio>
+#include <functional>
+#include <thread>
 
 namespace engine
 {
 
+/* Bounded lock-free MPSC ring of preformatted records (Vyukov's bounded queue), consumed
+ * by a background thread which writes records in batches. Producers never block,
+ * if the ring is full the record is dropped (and the number of dropped records is reported).
+ */
+class LogManager::AsyncWriter
+{
+public:
+    AsyncWriter();
+
+    AsyncWriter(const AsyncWriter &) = delete;
+
+    AsyncWriter &operator = (const AsyncWriter &) = delete;
+
+    void push(const std::string &text);
+    void flush();
+
+    ~AsyncWriter();
+
+private:
+    static const size_t k_capacity{1024}; // must be power of 2
+    static const size_t k_slotSize{2560};
+    static const std::chrono::milliseconds k_idleSleep;
+
+    struct Slot
+    {
+        std::atomic <size_t> sequence;
+        size_t length{};
+        char text[k_slotSize];
+    };
+
+    void run();
+    bool tryPop(std::string &outBatch);
+
+    std::unique_ptr <Slot[]> m_slots;
+    std::atomic <size_t> m_enqueuePos;
+    size_t m_dequeuePos;
+    std::atomic <size_t> m_writtenPos;
+    std::atomic <size_t> m_droppedCount;
+    std::atomic <bool> m_stop;
+    std::thread m_thread;
+};
+
+LogManager::AsyncWriter::AsyncWriter()
+    : m_slots{new Slot[k_capacity]},
+      m_enqueuePos{},
+      m_dequeuePos{},
+      m_writtenPos{},
+      m_droppedCount{},
+      m_stop{}
+{
+    for(size_t i = 0; i < k_capacity; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread{&AsyncWriter::run, this};
+}
+
+void LogManager::AsyncWriter::push(const std::string &text)
+{
+    size_t pos{m_enqueuePos.load(std::memory_order_relaxed)};
+    Slot *slot{};
+
+    while(true) {
+        slot = &m_slots[pos & (k_capacity - 1)];
+
+        size_t sequence{slot->sequence.load(std::memory_order_acquire)};
+        auto diff = static_cast <std::intptr_t> (sequence) - static_cast <std::intptr_t> (pos);
+
+        if(!diff) {
+            if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if(diff < 0) {
+            // full
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    slot->length = text.size() < k_slotSize ? text.size() : k_slotSize; // longer records are truncated
+    std::copy(text.begin(), text.begin() + slot->length, slot->text);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void LogManager::AsyncWriter::flush()
+{
+    size_t target{m_enqueuePos.load(std::memory_order_acquire)};
+
+    while(m_writtenPos.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+LogManager::AsyncWriter::~AsyncWriter()
+{
+    m_stop.store(true, std::memory_order_release);
+
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+void LogManager::AsyncWriter::run()
+{
+    // no TRACK here, trackers can't be used from other threads
+
+    std::string batch;
+
+    while(true) {
+        // stop flag has to be read before the last drain, so nothing pushed before stopping is lost
+        bool stop{m_stop.load(std::memory_order_acquire)};
+
+        batch.clear();
+
+        while(tryPop(batch)) {
+        }
+
+        auto dropped = m_droppedCount.exchange(0, std::memory_order_relaxed);
+
+        if(dropped)
+            batch += "[warning] [log] " + std::to_string(dropped) + " log records dropped (ring buffer full).\n";
+
+        if(!batch.empty()) {
+            write(batch);
+            m_writtenPos.store(m_dequeuePos, std::memory_order_release);
+        }
+        else if(stop)
+            break;
+        else
+            std::this_thread::sleep_for(k_idleSleep);
+    }
+}
+
+bool LogManager::AsyncWriter::tryPop(std::string &outBatch)
+{
+    auto &slot = m_slots[m_dequeuePos & (k_capacity - 1)];
+
+    if(slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+        return false;
+
+    outBatch.append(slot.text, slot.length);
+
+    slot.sequence.store(m_dequeuePos + k_capacity, std::memory_order_release);
+    ++m_dequeuePos;
+
+    return true;
+}
+
+const std::chrono::milliseconds LogManager::AsyncWriter::k_idleSleep{5};
+
 void LogManager::create(const AppInfo &appInfo)
 {
     TRACK;
@@ -57,6 +213,30 @@ void LogManager::create(const AppInfo &appInfo)
     E_LOG("%s", initialTextStr.c_str());
 }
 
+void LogManager::setAsyncMode(bool async)
+{
+    if(async == isAsyncMode())
+        return;
+
+    if(async)
+        m_asyncWriter = std::make_unique <AsyncWriter> ();
+    else {
+        // writes everything left and joins the thread
+        m_asyncWriter.reset();
+    }
+}
+
+bool LogManager::isAsyncMode()
+{
+    return static_cast <bool> (m_asyncWriter);
+}
+
+void LogManager::flush()
+{
+    if(m_asyncWriter)
+        m_asyncWriter->flush();
+}
+
 void LogManager::info(const char *functionName, int line, const char *format, ...)
 {
     TRACK;
@@ -77,6 +257,11 @@ void LogManager::error(const char *functionName, int line, const char *format, .
 {
     TRACK;
 
+    int suppressedCount{};
+
+    if(isRateLimited(format, line, suppressedCount))
+        return;
+
     char text[k_maxLogEntrySize + 1];
     if(format) {
         va_list va;
@@ -86,13 +271,18 @@ void LogManager::error(const char *functionName, int line, const char *format, .
     }
     else text[0] = '\0';
 
-    log(functionName, line, nullptr, nullptr, false, "error", text);
+    log(functionName, line, nullptr, nullptr, false, "error", text, suppressedCount);
 }
 
 void LogManager::warning(const char *functionName, int line, const char *format, ...)
 {
     TRACK;
 
+    int suppressedCount{};
+
+    if(isRateLimited(format, line, suppressedCount))
+        return;
+
     char text[k_maxLogEntrySize + 1];
     if(format) {
         va_list va;
@@ -102,13 +292,18 @@ void LogManager::warning(const char *functionName, int line, const char *format,
     }
     else text[0] = '\0';
 
-    log(functionName, line, nullptr, nullptr, false, "warning", text);
+    log(functionName, line, nullptr, nullptr, false, "warning", text, suppressedCount);
 }
 
 void LogManager::debug(const char *functionName, int line, const char *format, ...)
 {
     TRACK;
 
+    int suppressedCount{};
+
+    if(isRateLimited(format, line, suppressedCount))
+        return;
+
     char text[k_maxLogEntrySize + 1];
     if(format) {
         va_list va;
@@ -118,7 +313,7 @@ void LogManager::debug(const char *functionName, int line, const char *format, .
     }
     else text[0] = '\0';
 
-    log(functionName, line, nullptr, nullptr, false, "debug", text);
+    log(functionName, line, nullptr, nullptr, false, "debug", text, suppressedCount);
 }
 
 void LogManager::dassert(const char *functionName, int line, const char *expression, const char *format, ...)
@@ -175,7 +370,8 @@ void LogManager::log(const char *functionName,
                      const char *msgBoxDesc,
                      bool isCritical,
                      const char *tag,
-                     const char *text)
+                     const char *text,
+                     int suppressedCount)
 {
     TRACK;
 
@@ -193,21 +389,21 @@ void LogManager::log(const char *functionName,
     if(text)
         logText << text;
 
-    logText << std::endl;
+    if(suppressedCount > 0)
+        logText << " (" << suppressedCount << " similar records suppressed)";
 
-    const auto &logTextStr = logText.str();
+    logText << '\n';
 
-    printf("%s", logTextStr.c_str());
-    fflush(stdout);
+    const auto &logTextStr = logText.str();
 
-    if(m_logFile.is_open()) {
-        m_logFile << logTextStr;
-        m_logFile.flush();
+    if(m_asyncWriter && !isCritical)
+        m_asyncWriter->push(logTextStr);
+    else {
+        // everything logged before has to be written first
+        flush();
+        write(logTextStr);
     }
 
-    m_log << logTextStr;
-    m_log.flush();
-
     if(isCritical) {
         if(qApp) {
             std::ostringstream msgBoxText;
@@ -243,12 +439,65 @@ void LogManager::log(const char *functionName,
 
 std::string LogManager::getLog()
 {
-    return m_log.str();
+    std::lock_guard <std::mutex> lock{m_writeMutex};
+
+    return m_logTail;
+}
+
+bool LogManager::isRateLimited(const char *format, int line, int &outSuppressedCount)
+{
+    // call site is identified by format string address (it's a literal) and line
+    size_t hash{std::hash <const void*> {}(format) ^ (static_cast <size_t> (line) * 2654435761u)};
+    auto &callSite = m_callSiteRates[hash % m_callSiteRates.size()];
+
+    auto nowMs = std::chrono::duration_cast <std::chrono::milliseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    auto windowStartMs = callSite.windowStartMs.load(std::memory_order_relaxed);
+
+    if(nowMs - windowStartMs >= k_rateLimitWindowMs &&
+       callSite.windowStartMs.compare_exchange_strong(windowStartMs, nowMs, std::memory_order_relaxed)) {
+        callSite.count.store(0, std::memory_order_relaxed);
+    }
+
+    if(callSite.count.fetch_add(1, std::memory_order_relaxed) >= k_maxRecordsPerCallSitePerWindow) {
+        callSite.suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    outSuppressedCount = callSite.suppressedCount.exchange(0, std::memory_order_relaxed);
+    return false;
+}
+
+void LogManager::write(const std::string &text)
+{
+    // called from caller's thread in sync mode, and from writer thread in async mode
+    // (except critical records, which are written after flush())
+
+    std::lock_guard <std::mutex> lock{m_writeMutex};
+
+    fwrite(text.data(), 1, text.size(), stdout);
+    fflush(stdout);
+
+    if(m_logFile.is_open()) {
+        m_logFile << text;
+        m_logFile.flush();
+    }
+
+    m_logTail += text;
+
+    // erase in bigger chunks, so we don't move the whole string on every record
+    if(m_logTail.size() > k_maxLogTailSize * 2)
+        m_logTail.erase(0, m_logTail.size() - k_maxLogTailSize);
 }
 
 const size_t LogManager::k_maxLogEntrySize{2048};
+const size_t LogManager::k_maxLogTailSize{256 * 1024};
 const std::string LogManager::k_logFilePath = "log.txt";
+const std::int64_t LogManager::k_rateLimitWindowMs{1000};
+const int LogManager::k_maxRecordsPerCallSitePerWindow{20};
 std::ofstream LogManager::m_logFile;
-std::ostringstream LogManager::m_log;
+std::string LogManager::m_logTail;
+std::mutex LogManager::m_writeMutex;
+std::array <LogManager::CallSiteRate, 1024> LogManager::m_callSiteRates;
+std::unique_ptr <LogManager::AsyncWriter> LogManager::m_asyncWriter;
 
 } // namespace engine
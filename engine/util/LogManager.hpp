@@ -1,7 +1,12 @@
 #ifndef ENGINE_LOG_MANAGER_HPP
 #define ENGINE_LOG_MANAGER_HPP
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -47,6 +52,13 @@ public:
     LogManager &operator = (const LogManager &) = delete;
 
     static void create(const AppInfo &appInfo);
+
+    // in async mode records are formatted on caller's thread and written by background thread,
+    // critical records (assertions) are still written synchronously
+    static void setAsyncMode(bool async);
+    static bool isAsyncMode();
+    static void flush();
+
     static void info(const char *functionName, int line, const char *format, ...);
     static void error(const char *functionName, int line, const char *format, ...);
     static void warning(const char *functionName, int line, const char *format, ...);
@@ -54,22 +66,41 @@ public:
     static void dassert(const char *functionName, int line, const char *expression, const char *format, ...);
     static void rassert(const char *functionName, int line, const char *expression, const char *format, ...);
     static void custom(const char *functionName, int line, const char *tag, const char *format, ...);
-    static std::string getLog();
+    static std::string getLog(); // only the last k_maxLogTailSize characters
 
 private:
+    class AsyncWriter;
+
+    struct CallSiteRate
+    {
+        std::atomic <std::int64_t> windowStartMs;
+        std::atomic <int> count;
+        std::atomic <int> suppressedCount;
+    };
+
     static void log(const char *functionName,
                     int line,
                     const char *expression,
                     const char *msgBoxDesc,
                     bool isCritical,
                     const char *tag,
-                    const char *text);
+                    const char *text,
+                    int suppressedCount = 0);
+
+    static bool isRateLimited(const char *format, int line, int &outSuppressedCount);
+    static void write(const std::string &text);
 
     static const size_t k_maxLogEntrySize;
+    static const size_t k_maxLogTailSize;
     static const std::string k_logFilePath;
+    static const std::int64_t k_rateLimitWindowMs;
+    static const int k_maxRecordsPerCallSitePerWindow;
 
     static std::ofstream m_logFile;
-    static std::ostringstream m_log;
+    static std::string m_logTail;
+    static std::mutex m_writeMutex; // guards log file, stdout and log tail
+    static std::array <CallSiteRate, 1024> m_callSiteRates; // indexed by call site hash, collisions share limit
+    static std::unique_ptr <AsyncWriter> m_asyncWriter;
 };
 
 } // namespace engine
@@ -0,0 +1,231 @@
+#include "MaxRectsPacker.hpp"
+
+#include "Exception.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace engine
+{
+
+MaxRectsPacker::MaxRectsPacker(int pageSize, int padding, bool allowRotation, int maxPagesCount)
+    : m_pageSize{pageSize},
+      m_padding{padding},
+      m_allowRotation{allowRotation},
+      m_maxPagesCount{maxPagesCount}
+{
+    if(m_pageSize < 0)
+        throw Exception{"Max rects packer page size can't be negative."};
+
+    if(m_padding < 0)
+        throw Exception{"Max rects packer padding can't be negative."};
+
+    if(m_maxPagesCount <= 0)
+        throw Exception{"Max rects packer max pages count must be positive."};
+}
+
+void MaxRectsPacker::add(int w, int h)
+{
+    if(w < 0 || h < 0)
+        throw Exception{"Rect added to max rects packer can't have negative dimensions."};
+
+    m_sizes.emplace_back(w, h);
+}
+
+bool MaxRectsPacker::pack()
+{
+    TRACK;
+
+    m_rects.clear();
+    m_rects.resize(m_sizes.size());
+    m_pages.clear();
+
+    // the biggest rects first, ties are broken by index, so the result is deterministic
+
+    std::vector <int> order(m_sizes.size());
+
+    for(size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast <int> (i);
+    }
+
+    std::sort(order.begin(), order.end(), [this](int lhs, int rhs) {
+        const auto &l = m_sizes[lhs];
+        const auto &r = m_sizes[rhs];
+
+        int lMax{std::max(l.x, l.y)};
+        int rMax{std::max(r.x, r.y)};
+
+        if(lMax != rMax)
+            return lMax > rMax;
+
+        if(l.x * l.y != r.x * r.y)
+            return l.x * l.y > r.x * r.y;
+
+        return lhs < rhs;
+    });
+
+    for(int index : order) {
+        int w{m_sizes[index].x + m_padding};
+        int h{m_sizes[index].y + m_padding};
+
+        int page{-1};
+        IntRect rect;
+        bool rotated{};
+
+        if(!findPosition(w, h, page, rect, rotated)) {
+            if(static_cast <int> (m_pages.size()) >= m_maxPagesCount)
+                return false;
+
+            m_pages.emplace_back();
+            m_pages.back().freeRects.emplace_back(0, 0, m_pageSize, m_pageSize);
+
+            // doesn't fit even in an empty page
+            if(!findPosition(w, h, page, rect, rotated))
+                return false;
+        }
+
+        place(m_pages[page], rect);
+
+        auto &packed = m_rects[index];
+
+        packed.rect.pos = {rect.pos.x + m_padding / 2, rect.pos.y + m_padding / 2};
+        packed.rect.size = rotated ? IntVec2{m_sizes[index].y, m_sizes[index].x} : m_sizes[index];
+        packed.page = page;
+        packed.rotated = rotated;
+    }
+
+    return true;
+}
+
+const std::vector <MaxRectsPacker::PackedRect> &MaxRectsPacker::getAll() const
+{
+    return m_rects;
+}
+
+int MaxRectsPacker::getPagesCount() const
+{
+    return static_cast <int> (m_pages.size());
+}
+
+float MaxRectsPacker::getOccupancy() const
+{
+    if(m_pages.empty() || !m_pageSize)
+        return 0.f;
+
+    double usedArea{};
+
+    for(const auto &elem : m_rects) {
+        if(elem.page >= 0)
+            usedArea += static_cast <double> (elem.rect.size.x) * elem.rect.size.y;
+    }
+
+    return static_cast <float> (usedArea / (static_cast <double> (m_pageSize) * m_pageSize * m_pages.size()));
+}
+
+bool MaxRectsPacker::findPosition(int w, int h, int &outPage, IntRect &outRect, bool &outRotated) const
+{
+    int bestShortSideFit{std::numeric_limits <int>::max()};
+    int bestLongSideFit{std::numeric_limits <int>::max()};
+    bool found{};
+
+    for(size_t i = 0; i < m_pages.size(); ++i) {
+        for(int rotation = 0; rotation < (m_allowRotation && w != h ? 2 : 1); ++rotation) {
+            IntRect rect;
+            int shortSideFit{};
+            int longSideFit{};
+
+            if(!findPositionInPage(m_pages[i], rotation ? h : w, rotation ? w : h, rect, shortSideFit, longSideFit))
+                continue;
+
+            if(shortSideFit < bestShortSideFit || (shortSideFit == bestShortSideFit && longSideFit < bestLongSideFit)) {
+                bestShortSideFit = shortSideFit;
+                bestLongSideFit = longSideFit;
+                outPage = static_cast <int> (i);
+                outRect = rect;
+                outRotated = rotation;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+bool MaxRectsPacker::findPositionInPage(const Page &page, int w, int h, IntRect &outRect, int &outShortSideFit, int &outLongSideFit) const
+{
+    bool found{};
+
+    for(const auto &elem : page.freeRects) {
+        if(elem.size.x < w || elem.size.y < h)
+            continue;
+
+        int leftoverX{elem.size.x - w};
+        int leftoverY{elem.size.y - h};
+        int shortSideFit{std::min(leftoverX, leftoverY)};
+        int longSideFit{std::max(leftoverX, leftoverY)};
+
+        if(!found || shortSideFit < outShortSideFit || (shortSideFit == outShortSideFit && longSideFit < outLongSideFit)) {
+            outRect = {elem.pos.x, elem.pos.y, w, h};
+            outShortSideFit = shortSideFit;
+            outLongSideFit = longSideFit;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void MaxRectsPacker::place(Page &page, const IntRect &rect)
+{
+    std::vector <IntRect> newFreeRects;
+
+    for(auto it = page.freeRects.begin(); it != page.freeRects.end();) {
+        if(it->intersects(rect)) {
+            splitFreeRect(*it, rect, newFreeRects);
+            it = page.freeRects.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    page.freeRects.insert(page.freeRects.end(), newFreeRects.begin(), newFreeRects.end());
+
+    pruneFreeRects(page.freeRects);
+}
+
+void MaxRectsPacker::splitFreeRect(const IntRect &freeRect, const IntRect &usedRect, std::vector <IntRect> &outFreeRects)
+{
+    // up to 4 maximal rects around usedRect, they can overlap each other
+
+    if(usedRect.pos.x > freeRect.pos.x)
+        outFreeRects.emplace_back(freeRect.pos.x, freeRect.pos.y, usedRect.pos.x - freeRect.pos.x, freeRect.size.y);
+
+    if(usedRect.getMaxX() < freeRect.getMaxX())
+        outFreeRects.emplace_back(usedRect.getMaxX(), freeRect.pos.y, freeRect.getMaxX() - usedRect.getMaxX(), freeRect.size.y);
+
+    if(usedRect.pos.y > freeRect.pos.y)
+        outFreeRects.emplace_back(freeRect.pos.x, freeRect.pos.y, freeRect.size.x, usedRect.pos.y - freeRect.pos.y);
+
+    if(usedRect.getMaxY() < freeRect.getMaxY())
+        outFreeRects.emplace_back(freeRect.pos.x, usedRect.getMaxY(), freeRect.size.x, freeRect.getMaxY() - usedRect.getMaxY());
+}
+
+void MaxRectsPacker::pruneFreeRects(std::vector <IntRect> &freeRects)
+{
+    // removes rects contained in other rects (only one of equal rects is kept)
+
+    for(size_t i = 0; i < freeRects.size(); ++i) {
+        for(size_t j = i + 1; j < freeRects.size();) {
+            if(freeRects[i].fullyContains(freeRects[j]))
+                freeRects.erase(freeRects.begin() + j);
+            else if(freeRects[j].fullyContains(freeRects[i])) {
+                freeRects.erase(freeRects.begin() + i);
+                j = i + 1;
+            }
+            else
+                ++j;
+        }
+    }
+}
+
+} // namespace engine
@@ -0,0 +1,63 @@
+#ifndef ENGINE_MAX_RECTS_PACKER_HPP
+#define ENGINE_MAX_RECTS_PACKER_HPP
+
+#include "Trace.hpp"
+#include "Rect.hpp"
+
+#include <vector>
+
+namespace engine
+{
+
+/* MaxRects packer (best short side fit). Every page keeps a list of maximal free rects,
+ * so space left next to bigger rects is still used, unlike in RectPacker.
+ * Rects which don't fit in already opened pages open a new one (up to maxPagesCount).
+ * Padding is reserved around every rect (half of it on each side), returned rects don't include it.
+ */
+class MaxRectsPacker : public Tracked <MaxRectsPacker>
+{
+public:
+    struct PackedRect
+    {
+        IntRect rect; // if rotated, then size is swapped
+        int page{-1};
+        bool rotated{};
+    };
+
+    MaxRectsPacker(int pageSize, int padding, bool allowRotation, int maxPagesCount);
+
+    void add(int w, int h);
+    bool pack();
+
+    // in the order of adding
+    const std::vector <PackedRect> &getAll() const;
+
+    int getPagesCount() const;
+
+    // area of packed rects (without padding) divided by the area of all pages
+    float getOccupancy() const;
+
+private:
+    struct Page
+    {
+        std::vector <IntRect> freeRects;
+    };
+
+    bool findPosition(int w, int h, int &outPage, IntRect &outRect, bool &outRotated) const;
+    bool findPositionInPage(const Page &page, int w, int h, IntRect &outRect, int &outShortSideFit, int &outLongSideFit) const;
+    void place(Page &page, const IntRect &rect);
+    static void splitFreeRect(const IntRect &freeRect, const IntRect &usedRect, std::vector <IntRect> &outFreeRects);
+    static void pruneFreeRects(std::vector <IntRect> &freeRects);
+
+    int m_pageSize;
+    int m_padding;
+    bool m_allowRotation;
+    int m_maxPagesCount;
+    std::vector <IntVec2> m_sizes;
+    std::vector <PackedRect> m_rects;
+    std::vector <Page> m_pages;
+};
+
+} // namespace engine
+
+#endif // ENGINE_MAX_RECTS_PACKER_HPP
@@ -0,0 +1,152 @@
+#include "Metrics.hpp"
+
+#include "LogManager.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+
+namespace engine
+{
+
+int Metrics::registerMetric(const char *name, Type type)
+{
+    std::lock_guard <std::mutex> lock{m_registerMutex};
+
+    int count{m_metricsCount.load(std::memory_order_relaxed)};
+
+    // metrics with the same name share the same value (e.g. multiple call sites)
+    for(int i = 0; i < count; ++i) {
+        if(m_metrics[i].name == name)
+            return i;
+    }
+
+    if(static_cast <size_t> (count) >= k_maxMetrics) {
+        E_WARNING("Too many metrics registered, ignoring \"%s\".", name);
+        return -1;
+    }
+
+    m_metrics.push_back({name, type});
+    m_history.emplace_back();
+    m_history.back().fill(0);
+
+    m_metricsCount.store(count + 1, std::memory_order_release);
+
+    return count;
+}
+
+void Metrics::frameLap()
+{
+#ifdef METRICS_ENABLED
+    updateTrackedObjectsCount();
+
+    std::lock_guard <std::mutex> lock{m_registerMutex};
+
+    int count{m_metricsCount.load(std::memory_order_acquire)};
+    size_t historyIndex{m_frameIndex % k_rollingWindowFrames};
+    size_t framesInWindow{m_frameIndex + 1 < k_rollingWindowFrames ? static_cast <size_t> (m_frameIndex + 1) : k_rollingWindowFrames};
+
+    for(int i = 0; i < count; ++i) {
+        auto &metric = m_metrics[i];
+        auto &history = m_history[i];
+
+        if(metric.type == Type::Counter)
+            metric.value = m_values[i].exchange(0, std::memory_order_relaxed);
+        else
+            metric.value = m_values[i].load(std::memory_order_relaxed);
+
+        history[historyIndex] = metric.value;
+
+        // metrics registered later have zeros in history before that, which is fine for counters
+        metric.min = metric.max = history[0];
+        std::int64_t sum{};
+
+        for(size_t j = 0; j < framesInWindow; ++j) {
+            metric.min = std::min(metric.min, history[j]);
+            metric.max = std::max(metric.max, history[j]);
+            sum += history[j];
+        }
+
+        metric.avg = static_cast <double> (sum) / framesInWindow;
+    }
+
+    if(m_CSVFile.is_open() && m_frameIndex % m_CSVDumpIntervalFrames == 0)
+        writeCSV();
+
+    m_lastFrameMetrics = m_metrics;
+
+    ++m_frameIndex;
+#endif
+}
+
+const std::vector <Metrics::MetricInfo> &Metrics::getMetrics()
+{
+    return m_lastFrameMetrics;
+}
+
+void Metrics::startCSVDump(const std::string &path, int everyNFrames)
+{
+#ifdef METRICS_ENABLED
+    if(everyNFrames <= 0) {
+        E_WARNING("Invalid metrics CSV dump interval (%d).", everyNFrames);
+        return;
+    }
+
+    stopCSVDump();
+
+    m_CSVFile.open(path);
+
+    if(!m_CSVFile.is_open()) {
+        E_ERROR("Could not open metrics CSV file \"%s\".", path.c_str());
+        return;
+    }
+
+    E_INFO("Dumping metrics to \"%s\" every %d frames.", path.c_str(), everyNFrames);
+
+    // long format, so metrics registered later don't change the header
+    m_CSVFile << "frame,metric,value,min,avg,max\n";
+    m_CSVDumpIntervalFrames = everyNFrames;
+#else
+    E_WARNING("Can't dump metrics because metrics are disabled.");
+#endif
+}
+
+void Metrics::stopCSVDump()
+{
+    if(m_CSVFile.is_open())
+        m_CSVFile.close();
+}
+
+bool Metrics::isDumpingCSV()
+{
+    return m_CSVFile.is_open();
+}
+
+void Metrics::updateTrackedObjectsCount()
+{
+    E_GAUGE_SET("Tracked objects", Trace::getLivingObjectsCount());
+}
+
+void Metrics::writeCSV()
+{
+    for(const auto &elem : m_metrics) {
+        m_CSVFile << m_frameIndex << ",\"" << elem.name << "\"," << elem.value << ','
+                  << elem.min << ',' << elem.avg << ',' << elem.max << '\n';
+    }
+
+    m_CSVFile.flush();
+}
+
+const std::string Metrics::k_defaultCSVPath = "metrics.csv";
+const int Metrics::k_defaultCSVDumpIntervalFrames{60};
+
+std::mutex Metrics::m_registerMutex;
+std::atomic <int> Metrics::m_metricsCount{};
+std::array <std::atomic <std::int64_t>, Metrics::k_maxMetrics> Metrics::m_values{};
+std::vector <Metrics::MetricInfo> Metrics::m_metrics;
+std::vector <Metrics::MetricInfo> Metrics::m_lastFrameMetrics;
+std::vector <std::array <std::int64_t, Metrics::k_rollingWindowFrames>> Metrics::m_history;
+std::uint64_t Metrics::m_frameIndex{};
+std::ofstream Metrics::m_CSVFile;
+int Metrics::m_CSVDumpIntervalFrames{};
+
+} // namespace engine
@@ -0,0 +1,111 @@
+#ifndef ENGINE_METRICS_HPP
+#define ENGINE_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define METRICS_ENABLED // comment to disable
+
+#ifdef METRICS_ENABLED
+#  define E_COUNTER_ADD(name, value)                                                                                                      \
+       do {                                                                                                                               \
+           static const int E_METRICS_ID{::engine::Metrics::registerMetric(name, ::engine::Metrics::Type::Counter)};                     \
+           ::engine::Metrics::add(E_METRICS_ID, value);                                                                                   \
+       } while(0)
+#  define E_GAUGE_SET(name, value)                                                                                                        \
+       do {                                                                                                                               \
+           static const int E_METRICS_ID{::engine::Metrics::registerMetric(name, ::engine::Metrics::Type::Gauge)};                       \
+           ::engine::Metrics::set(E_METRICS_ID, value);                                                                                   \
+       } while(0)
+#else
+#  define E_COUNTER_ADD(name, value) do {} while(0)
+#  define E_GAUGE_SET(name, value) do {} while(0)
+#endif
+
+namespace engine
+{
+
+/* Registry of per-frame counters and gauges. Counters are summed during a frame and reset
+ * in frameLap, gauges keep the last set value. Metrics are registered on first use
+ * (use E_COUNTER_ADD and E_GAUGE_SET macros) and can be updated from any thread.
+ * frameLap (called once per frame from the main thread) computes rolling min/avg/max
+ * over the last k_rollingWindowFrames frames and optionally appends them to CSV file.
+ */
+class Metrics
+{
+public:
+    enum class Type
+    {
+        Counter,
+        Gauge
+    };
+
+    struct MetricInfo
+    {
+        std::string name;
+        Type type;
+        std::int64_t value{}; // last frame
+        std::int64_t min{};
+        double avg{};
+        std::int64_t max{};
+    };
+
+    static int registerMetric(const char *name, Type type);
+    static void add(int ID, std::int64_t value);
+    static void set(int ID, std::int64_t value);
+
+    static void frameLap();
+
+    // only from the main thread, snapshot taken in frameLap
+    static const std::vector <MetricInfo> &getMetrics();
+
+    // appends all metrics to CSV file every everyNFrames frames
+    static void startCSVDump(const std::string &path, int everyNFrames);
+    static void stopCSVDump();
+    static bool isDumpingCSV();
+
+    static const std::string k_defaultCSVPath;
+    static const int k_defaultCSVDumpIntervalFrames;
+
+private:
+    static void updateTrackedObjectsCount();
+    static void writeCSV();
+
+    static constexpr size_t k_maxMetrics{256};
+    static constexpr size_t k_rollingWindowFrames{120};
+
+    static std::mutex m_registerMutex;
+    static std::atomic <int> m_metricsCount;
+    static std::array <std::atomic <std::int64_t>, k_maxMetrics> m_values;
+
+    // guarded by m_registerMutex
+    static std::vector <MetricInfo> m_metrics;
+    static std::vector <std::array <std::int64_t, k_rollingWindowFrames>> m_history;
+
+    // main thread only
+    static std::vector <MetricInfo> m_lastFrameMetrics;
+    static std::uint64_t m_frameIndex;
+    static std::ofstream m_CSVFile;
+    static int m_CSVDumpIntervalFrames;
+};
+
+inline void Metrics::add(int ID, std::int64_t value)
+{
+    if(ID >= 0)
+        m_values[ID].fetch_add(value, std::memory_order_relaxed);
+}
+
+inline void Metrics::set(int ID, std::int64_t value)
+{
+    if(ID >= 0)
+        m_values[ID].store(value, std::memory_order_relaxed);
+}
+
+} // namespace engine
+
+#endif // ENGINE_METRICS_HPP
@@ -2,6 +2,7 @@
 
 #include "../EngineStaticInfo.hpp"
 #include "LogManager.hpp"
+#include "Metrics.hpp"
 
 #include <enet/enet.h>
 
@@ -159,6 +160,9 @@ void Server::sendPacket(int ID, const Packet &packet)
         return;
     }
 
+    E_COUNTER_ADD("Packets sent", 1);
+    E_COUNTER_ADD("Bytes sent", size);
+
     enet_host_flush(m_host);
 }
 
@@ -316,6 +320,9 @@ void Server::sendEnginePacket(ENetPeer &peer, const Packet &packet)
         return;
     }
 
+    E_COUNTER_ADD("Packets sent", 1);
+    E_COUNTER_ADD("Bytes sent", size);
+
     enet_host_flush(m_host);
 }
 
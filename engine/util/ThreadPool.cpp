@@ -0,0 +1,129 @@
+#include "ThreadPool.hpp"
+
+#include "Exception.hpp"
+#include "LogManager.hpp"
+
+namespace engine
+{
+
+ThreadPool::ThreadPool(int workerThreadsCount)
+    : m_job{},
+      m_jobsCount{},
+      m_nextJob{},
+      m_batchIndex{},
+      m_busyThreadsCount{},
+      m_stop{}
+{
+    TRACK;
+
+    if(workerThreadsCount < 0)
+        throw Exception{"Worker threads count can't be negative."};
+
+    for(int i = 0; i < workerThreadsCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+void ThreadPool::parallelFor(size_t jobsCount, const std::function <void(size_t)> &job)
+{
+    TRACK;
+
+    if(m_threads.empty() || jobsCount <= 1) {
+        for(size_t i = 0; i < jobsCount; ++i) {
+            job(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock{m_mutex};
+
+        m_job = &job;
+        m_jobsCount = jobsCount;
+        m_nextJob.store(0, std::memory_order_relaxed);
+        m_busyThreadsCount = static_cast <int> (m_threads.size());
+        ++m_batchIndex;
+    }
+
+    m_batchStarted.notify_all();
+
+    runJobs();
+
+    std::unique_lock <std::mutex> lock{m_mutex};
+
+    m_batchFinished.wait(lock, [this]() {
+        return !m_busyThreadsCount;
+    });
+
+    m_job = nullptr;
+}
+
+int ThreadPool::getWorkerThreadsCount() const
+{
+    return static_cast <int> (m_threads.size());
+}
+
+int ThreadPool::getDefaultWorkerThreadsCount()
+{
+    // may return 0 if unknown
+    int hardwareThreadsCount{static_cast <int> (std::thread::hardware_concurrency())};
+
+    return hardwareThreadsCount > 1 ? hardwareThreadsCount - 1 : 0;
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard <std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+
+    m_batchStarted.notify_all();
+
+    for(auto &thread : m_threads) {
+        if(thread.joinable())
+            thread.join();
+    }
+}
+
+void ThreadPool::run()
+{
+    std::uint64_t lastBatchIndex{};
+
+    while(true) {
+        {
+            std::unique_lock <std::mutex> lock{m_mutex};
+
+            m_batchStarted.wait(lock, [this, lastBatchIndex]() {
+                return m_stop || m_batchIndex != lastBatchIndex;
+            });
+
+            if(m_stop)
+                return;
+
+            lastBatchIndex = m_batchIndex;
+        }
+
+        runJobs();
+
+        bool lastOne{};
+
+        {
+            std::lock_guard <std::mutex> lock{m_mutex};
+            lastOne = !--m_busyThreadsCount;
+        }
+
+        if(lastOne)
+            m_batchFinished.notify_one();
+    }
+}
+
+void ThreadPool::runJobs()
+{
+    for(size_t i = m_nextJob.fetch_add(1, std::memory_order_relaxed); i < m_jobsCount; i = m_nextJob.fetch_add(1, std::memory_order_relaxed)) {
+        (*m_job)(i);
+    }
+}
+
+} // namespace engine
@@ -0,0 +1,58 @@
+#ifndef ENGINE_THREAD_POOL_HPP
+#define ENGINE_THREAD_POOL_HPP
+
+#include "Trace.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+/* Fixed set of worker threads which run batches of independent jobs.
+ * parallelFor blocks until all jobs of the batch are finished (calling thread runs jobs too),
+ * jobs are picked in index order, but can finish in any order. Jobs must not throw.
+ */
+class ThreadPool : public Tracked <ThreadPool>
+{
+public:
+    explicit ThreadPool(int workerThreadsCount);
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator = (const ThreadPool &) = delete;
+
+    void parallelFor(size_t jobsCount, const std::function <void(size_t)> &job);
+    int getWorkerThreadsCount() const;
+
+    // hardware threads count minus calling thread
+    static int getDefaultWorkerThreadsCount();
+
+    ~ThreadPool();
+
+private:
+    void run();
+    void runJobs();
+
+    std::vector <std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_batchStarted;
+    std::condition_variable m_batchFinished;
+
+    // set under m_mutex before m_batchIndex changes
+    const std::function <void(size_t)> *m_job;
+    size_t m_jobsCount;
+    std::atomic <size_t> m_nextJob;
+
+    std::uint64_t m_batchIndex;
+    int m_busyThreadsCount;
+    bool m_stop;
+};
+
+} // namespace engine
+
+#endif // ENGINE_THREAD_POOL_HPP
@@ -2,24 +2,43 @@
 
 #include "LogManager.hpp"
 
+#include <algorithm>
+#include <iomanip>
 #include <utility>
 #include <sstream>
 
 namespace engine
 {
 
+Trace::ThreadState::ThreadState(int index, size_t eventsCapacity)
+    : index{index},
+      events(eventsCapacity)
+{
+}
+
 void Trace::initProfiler()
 {
 #ifdef TRACE_PROFILE
     m_elapsedTimer.start();
 #endif
+
+    // first registered thread is considered the main thread
+    getCurrentThreadState();
 }
 
 void Trace::profilerLap()
 {
 #ifdef TRACE_PROFILE
-    m_currentTrackersDepth = 0;
-    m_trackersFrameHistoryCurrentIndex = 0;
+    collectFrameEvents();
+
+    if(m_chromeTraceFile.is_open()) {
+        writeChromeTraceFrame();
+
+        if(--m_chromeTraceFramesLeft <= 0)
+            stopChromeTraceRecording();
+    }
+
+    m_frameStartNsecs = getElapsedNsecs();
 #endif
 }
 
@@ -28,10 +47,19 @@ std::string Trace::getTrace()
     std::ostringstream oss;
 
 #ifdef TRACE_USE_TRACKERS
-    for(int i = static_cast <int> (m_activeTrackersIndex) - 1; i >= 0; --i) {
-        oss << allTrackers[m_activeTrackers[i]].file
+    if(!m_currentThreadState)
+        return {};
+
+    const auto &state = *m_currentThreadState;
+    std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+    // (std::min would odr-use k_maxActiveTrackers)
+    size_t activeTrackersCount{state.activeTrackersIndex < k_maxActiveTrackers ? state.activeTrackersIndex : k_maxActiveTrackers};
+
+    for(int i = static_cast <int> (activeTrackersCount) - 1; i >= 0; --i) {
+        oss << allTrackers[state.activeTrackers[i]].file
             << ": "
-            << allTrackers[m_activeTrackers[i]].function;
+            << allTrackers[state.activeTrackers[i]].function;
 
         if(i)
             oss << std::endl;
@@ -43,16 +71,27 @@ std::string Trace::getTrace()
 
 void Trace::checkMemoryLeaks()
 {
-    E_INFO("Checking memory leaks. Registered classes: %d.", static_cast <int> (allClasses.size()));
+    // copied, because logging registers trackers, which locks m_trackersMutex
+    std::vector <std::pair <std::string, int>> classes;
+
+    {
+        std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+        for(const auto &elem : allClasses) {
+            classes.emplace_back(elem.name, elem.livingObjectsCount);
+        }
+    }
+
+    E_INFO("Checking memory leaks. Registered classes: %d.", static_cast <int> (classes.size()));
 
     bool OK{true};
 
-    for(const auto &elem : allClasses) {
-        if(elem.livingObjectsCount < 0) {
-            E_WARNING("Negative living objects count: \"%s\", objects count: %d.", elem.name.c_str(), elem.livingObjectsCount);
+    for(const auto &elem : classes) {
+        if(elem.second < 0) {
+            E_WARNING("Negative living objects count: \"%s\", objects count: %d.", elem.first.c_str(), elem.second);
         }
-        else if(elem.livingObjectsCount > 0) {
-            E_WARNING("Memory leak: \"%s\", objects count: %d.", elem.name.c_str(), elem.livingObjectsCount);
+        else if(elem.second > 0) {
+            E_WARNING("Memory leak: \"%s\", objects count: %d.", elem.first.c_str(), elem.second);
             OK = false;
         }
     }
@@ -65,54 +104,72 @@ void Trace::checkMemoryLeaks()
     }
 }
 
+int Trace::getLivingObjectsCount()
+{
+    std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+    int count{};
+
+    for(const auto &elem : allClasses) {
+        count += elem.livingObjectsCount;
+    }
+
+    return count;
+}
+
 std::string Trace::getProfilerResults()
 {
     std::string res;
 
 #ifdef TRACE_PROFILE
     res += "--- Call History ---\n\n";
-    res += "History is in reverse order.\n";
-
-    size_t currentIndex{m_trackersFrameHistoryCurrentIndex};
+    res += "History of the last frame is in reverse order, grouped by thread.\n";
 
-    if(m_trackersFrameHistoryCurrentIndex >= k_maxTrackersPerFrame) {
+    if(m_frameEventsDropped)
         res += "Trackers per frame count exceeded limit. Profiler results can be incomplete.\n";
-        currentIndex = k_maxTrackersPerFrame;
-    }
+
+    const auto &functions = getTrackerFunctions();
 
     std::vector <std::string> m_records;
 
     int minDepth{};
-    bool first{};
+    bool first{true};
 
-    for(size_t i = 0; i < currentIndex; ++i) {
-        if(m_trackersFrameHistoryNsecsElapsed[i] < k_minNsecsToShowInHistory)
+    for(const auto &elem : m_frameEvents) {
+        if(elem.event.nsecsElapsed < k_minNsecsToShowInHistory)
             continue;
 
-        if(first || m_trackersFrameHistoryDepth[i] < minDepth) {
+        if(first || elem.event.depth < minDepth) {
             first = false;
-            minDepth = m_trackersFrameHistoryDepth[i];
+            minDepth = elem.event.depth;
         }
     }
 
-    for(size_t i = 0; i < currentIndex; ++i) {
-        if(m_trackersFrameHistoryNsecsElapsed[i] < k_minNsecsToShowInHistory)
+    int lastThreadIndex{-1};
+
+    for(const auto &elem : m_frameEvents) {
+        if(elem.event.nsecsElapsed < k_minNsecsToShowInHistory)
             continue;
 
-        int curDepth{m_trackersFrameHistoryDepth[i] - minDepth};
+        if(elem.threadIndex != lastThreadIndex) {
+            lastThreadIndex = elem.threadIndex;
+            m_records.push_back("Thread " + std::to_string(elem.threadIndex) + ':');
+        }
+
+        int curDepth{elem.event.depth - minDepth};
 
         m_records.resize(m_records.size() + 1);
         for(int j = 0; j < curDepth; ++j) {
             m_records.back() += ' ';
         }
 
-        int index{m_trackersFrameHistoryTrackerID[i]};
+        int index{elem.event.trackerID};
 
-        E_DASSERT(index >= 0 && static_cast <size_t> (index) < allTrackers.size(), "Index out of bounds.");
+        E_DASSERT(index >= 0 && static_cast <size_t> (index) < functions.size(), "Index out of bounds.");
 
-        m_records.back() += allTrackers[index].function + ' ';
+        m_records.back() += functions[index] + ' ';
 
-        auto nano = m_trackersFrameHistoryNsecsElapsed[i];
+        auto nano = elem.event.nsecsElapsed;
         auto micro = nano / 1000;
 
         m_records.back() += std::to_string(micro / 1000);
@@ -133,22 +190,20 @@ std::string Trace::getProfilerResults()
 
     res += "\n--- Total Time Taken ---\n\n";
 
-    for(auto &elem : allTrackers) {
-        elem.totalMsWorkingVar = 0.f;
-    }
+    std::vector <float> totalMs(functions.size()); // in milliseconds
 
-    for(size_t i = 0; i < currentIndex; ++i) {
-        auto micro = m_trackersFrameHistoryNsecsElapsed[i] / 1000;
+    for(const auto &elem : m_frameEvents) {
+        auto micro = elem.event.nsecsElapsed / 1000;
         float milli{micro / 1000.f};
 
-        allTrackers[m_trackersFrameHistoryTrackerID[i]].totalMsWorkingVar += milli;
+        totalMs[elem.event.trackerID] += milli;
     }
 
     std::vector <std::pair <float, size_t>> total;
 
-    for(size_t i = 0; i < allTrackers.size(); ++i) {
-        if(allTrackers[i].totalMsWorkingVar > 0.f)
-            total.push_back(std::make_pair(allTrackers[i].totalMsWorkingVar, i));
+    for(size_t i = 0; i < totalMs.size(); ++i) {
+        if(totalMs[i] > 0.f)
+            total.push_back(std::make_pair(totalMs[i], i));
     }
 
     std::sort(total.begin(), total.end(), [](const auto &first, const auto &second) {
@@ -156,7 +211,7 @@ std::string Trace::getProfilerResults()
     });
 
     for(const auto &elem : total) {
-        res += allTrackers[elem.second].function + ' ';
+        res += functions[elem.second] + ' ';
         res += std::to_string(elem.first) + " ms\n";
     }
 
@@ -165,18 +220,201 @@ std::string Trace::getProfilerResults()
     return res;
 }
 
-std::vector <Trace::TrackerInfo> Trace::allTrackers;
-std::vector <Trace::ClassInfo> Trace::allClasses;
+void Trace::startChromeTraceRecording(const std::string &path, int framesCount)
+{
+#ifdef TRACE_PROFILE
+    if(m_chromeTraceFile.is_open()) {
+        E_WARNING("Chrome trace is already being recorded.");
+        return;
+    }
+
+    if(framesCount <= 0) {
+        E_WARNING("Invalid Chrome trace frames count (%d).", framesCount);
+        return;
+    }
+
+    m_chromeTraceFile.open(path);
+
+    if(!m_chromeTraceFile.is_open()) {
+        E_ERROR("Could not open Chrome trace file \"%s\".", path.c_str());
+        return;
+    }
+
+    E_INFO("Recording Chrome trace of next %d frames to \"%s\".", framesCount, path.c_str());
+
+    m_chromeTraceFile << std::fixed << std::setprecision(3);
+    m_chromeTraceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    m_chromeTraceFramesLeft = framesCount;
+    m_chromeTraceAnyEventWritten = false;
+#else
+    E_WARNING("Can't record Chrome trace because profiler is disabled.");
+#endif
+}
+
+void Trace::stopChromeTraceRecording()
+{
+#ifdef TRACE_PROFILE
+    if(!m_chromeTraceFile.is_open())
+        return;
+
+    m_chromeTraceFile << "\n]}\n";
+    m_chromeTraceFile.close();
+    m_chromeTraceFramesLeft = 0;
+
+    E_INFO("Chrome trace recording finished.");
+#endif
+}
+
+bool Trace::isRecordingChromeTrace()
+{
+#ifdef TRACE_PROFILE
+    return m_chromeTraceFile.is_open();
+#else
+    return false;
+#endif
+}
+
+int Trace::registerTracker(const char *function, const char *file, const char *shortFunction)
+{
+    std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+    allTrackers.push_back({function, file, shortFunction});
+
+    return allTrackers.size() - 1;
+}
+
+Trace::ClassInfo &Trace::registerClass(const std::string &name)
+{
+    std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+    for(auto &elem : allClasses) {
+        if(elem.name == name)
+            return elem;
+    }
+
+    allClasses.emplace_back();
+    allClasses.back().name = name;
+
+    return allClasses.back();
+}
+
+std::vector <std::string> Trace::getTrackerFunctions()
+{
+    std::lock_guard <std::mutex> lock{m_trackersMutex};
+
+    std::vector <std::string> functions;
+    functions.reserve(allTrackers.size());
+
+    for(const auto &elem : allTrackers) {
+        functions.push_back(elem.function);
+    }
+
+    return functions;
+}
+
+void Trace::registerCurrentThread()
+{
+    std::lock_guard <std::mutex> lock{m_threadStatesMutex};
+
+#ifdef TRACE_PROFILE
+    size_t eventsCapacity{m_threadStates.empty() ? k_mainThreadEventsCapacity : k_otherThreadEventsCapacity};
+#else
+    size_t eventsCapacity{}; // events are recorded only when profiling
+#endif
+
+    m_threadStates.push_back(std::make_unique <ThreadState> (m_threadStates.size(), eventsCapacity));
+    m_currentThreadState = m_threadStates.back().get();
+}
+
+void Trace::collectFrameEvents()
+{
+#ifdef TRACE_PROFILE
+    m_frameEvents.clear();
+    m_frameEventsDropped = 0;
+
+    std::lock_guard <std::mutex> lock{m_threadStatesMutex};
+
+    for(const auto &state : m_threadStates) {
+        size_t read{state->eventsRead.load(std::memory_order_relaxed)};
+        size_t written{state->eventsWritten.load(std::memory_order_acquire)};
+        size_t mask{state->events.size() - 1};
+
+        for(size_t i = read; i != written; ++i) {
+            m_frameEvents.push_back({state->events[i & mask], state->index});
+        }
+
+        // frees the slots for the owning thread
+        state->eventsRead.store(written, std::memory_order_release);
+
+        m_frameEventsDropped += state->eventsDropped.exchange(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void Trace::writeChromeTraceFrame()
+{
+#ifdef TRACE_PROFILE
+    // whole frame as a separate event, so frame boundaries are visible in the timeline
+    writeChromeTraceEvent("Frame", m_frameStartNsecs, getElapsedNsecs() - m_frameStartNsecs, 0);
+
+    const auto &functions = getTrackerFunctions();
+
+    for(const auto &elem : m_frameEvents) {
+        if(elem.event.nsecsElapsed < k_minNsecsToRecordInChromeTrace)
+            continue;
+
+        int index{elem.event.trackerID};
+
+        E_DASSERT(index >= 0 && static_cast <size_t> (index) < functions.size(), "Index out of bounds.");
+
+        writeChromeTraceEvent(functions[index], elem.event.startNsecs, elem.event.nsecsElapsed, elem.threadIndex);
+    }
+#endif
+}
+
+void Trace::writeChromeTraceEvent(const std::string &name, qint64 startNsecs, qint64 durationNsecs, int threadIndex)
+{
+#ifdef TRACE_PROFILE
+    if(m_chromeTraceAnyEventWritten)
+        m_chromeTraceFile << ",\n";
+
+    m_chromeTraceAnyEventWritten = true;
+
+    m_chromeTraceFile << "{\"name\":\"";
+
+    for(char c : name) {
+        if(c == '"' || c == '\\')
+            m_chromeTraceFile << '\\';
+
+        m_chromeTraceFile << c;
+    }
+
+    // complete event, timestamps in microseconds
+    m_chromeTraceFile << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadIndex + 1
+                      << ",\"ts\":" << startNsecs / 1000.0
+                      << ",\"dur\":" << durationNsecs / 1000.0 << '}';
+#endif
+}
+
+const std::string Trace::k_defaultChromeTracePath = "trace.json";
+const int Trace::k_defaultChromeTraceFramesCount{300};
+
 QElapsedTimer Trace::m_elapsedTimer;
-int Trace::m_activeTrackers[k_maxActiveTrackers]{};
-size_t Trace::m_activeTrackersIndex{};
+std::mutex Trace::m_trackersMutex;
+std::vector <Trace::TrackerInfo> Trace::allTrackers;
+std::deque <Trace::ClassInfo> Trace::allClasses;
+std::mutex Trace::m_threadStatesMutex;
+std::vector <std::unique_ptr <Trace::ThreadState>> Trace::m_threadStates;
+thread_local Trace::ThreadState *Trace::m_currentThreadState{};
 
 #ifdef TRACE_PROFILE
-int Trace::m_currentTrackersDepth{};
-size_t Trace::m_trackersFrameHistoryCurrentIndex{};
-int Trace::m_trackersFrameHistoryTrackerID[k_maxTrackersPerFrame]{};
-int Trace::m_trackersFrameHistoryDepth[k_maxTrackersPerFrame]{};
-qint64 Trace::m_trackersFrameHistoryNsecsElapsed[k_maxTrackersPerFrame]{};
+std::vector <Trace::FrameEvent> Trace::m_frameEvents;
+size_t Trace::m_frameEventsDropped{};
+qint64 Trace::m_frameStartNsecs{};
+std::ofstream Trace::m_chromeTraceFile;
+int Trace::m_chromeTraceFramesLeft{};
+bool Trace::m_chromeTraceAnyEventWritten{};
 #endif
 
 } // namespace engine
@@ -3,7 +3,12 @@
 
 #include <QElapsedTimer>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <typeinfo>
@@ -15,15 +20,9 @@
 #define unlikely(x) __builtin_expect((x), 0)
 
 #ifdef TRACE_USE_TRACKERS
-#  define TRACK                                                                                              \
-       static int TRACK_trackerID{};                                                                         \
-       static bool TRACK_initialize{true};                                                                   \
-       if(unlikely(TRACK_initialize)) {                                                                      \
-           TRACK_initialize = false;                                                                         \
-           TRACK_trackerID = ::engine::Trace::allTrackers.size();                                            \
-           ::engine::Trace::allTrackers.push_back( { __PRETTY_FUNCTION__, __FILE__, __func__, 0.f } );       \
-       }                                                                                                     \
-       ::engine::Trace::Tracker TRACK_tracker{TRACK_trackerID};                                              \
+#  define TRACK                                                                                                     \
+       static const int TRACK_trackerID{::engine::Trace::registerTracker(__PRETTY_FUNCTION__, __FILE__, __func__)}; \
+       ::engine::Trace::Tracker TRACK_tracker{TRACK_trackerID};                                                     \
        do {} while(0)
 #else
 #  define TRACK do {} while(0)
@@ -32,8 +31,16 @@
 namespace engine
 {
 
+/* Each thread has its own tracker stack and its own event buffer (single producer, single consumer
+ * ring), so instrumented code can run on any thread without locking. Events of all threads
+ * are collected in profilerLap (called from the main thread once per frame), which is the only
+ * consumer of these buffers. Events which don't fit into the buffer before the next lap are dropped.
+ */
 class Trace
 {
+private:
+    struct ThreadState;
+
 public:
     class Tracker
     {
@@ -49,24 +56,18 @@ public:
         void startProfile();
         void endProfile();
 
+        ThreadState *m_threadState;
+
 #ifdef TRACE_PROFILE
         int m_trackerID;
         qint64 m_startNsecs;
 #endif
     };
 
-    struct TrackerInfo
-    {
-        std::string function;
-        std::string file;
-        std::string shortFunction;
-        float totalMsWorkingVar; // in milliseconds
-    };
-
     struct ClassInfo
     {
         std::string name;
-        int livingObjectsCount = {};
+        std::atomic <int> livingObjectsCount{};
     };
 
     static void initProfiler();
@@ -74,27 +75,93 @@ public:
     static std::string getTrace();
     static void checkMemoryLeaks();
     static std::string getProfilerResults();
+    static int getLivingObjectsCount(); // of all Tracked classes
     static qint64 getElapsedNsecs();
 
-    // exception to encapsulation rule for speed (probably not needed anyway)
-    static std::vector <TrackerInfo> allTrackers;
-    static std::vector <ClassInfo> allClasses;
+    // records tracked scopes of the next framesCount frames to Chrome trace event JSON file
+    // (can be opened in chrome://tracing or Perfetto UI)
+    static void startChromeTraceRecording(const std::string &path, int framesCount);
+    static void stopChromeTraceRecording();
+    static bool isRecordingChromeTrace();
+
+    // these can be called from any thread, returned ID and reference are valid forever
+    static int registerTracker(const char *function, const char *file, const char *shortFunction);
+    static ClassInfo &registerClass(const std::string &name);
+
+    static const std::string k_defaultChromeTracePath;
+    static const int k_defaultChromeTraceFramesCount;
 
 private:
+    struct TrackerInfo
+    {
+        std::string function;
+        std::string file;
+        std::string shortFunction;
+    };
+
+    struct Event
+    {
+        int trackerID{};
+        int depth{};
+        qint64 startNsecs{};
+        qint64 nsecsElapsed{};
+    };
+
+    struct FrameEvent
+    {
+        Event event;
+        int threadIndex{};
+    };
+
     static constexpr size_t k_maxActiveTrackers{200};
-    static constexpr size_t k_maxTrackersPerFrame{750000};
+
+    struct ThreadState
+    {
+        ThreadState(int index, size_t eventsCapacity);
+
+        int index;
+        int activeTrackers[k_maxActiveTrackers]{};
+        size_t activeTrackersIndex{};
+        int currentTrackersDepth{};
+
+        std::vector <Event> events; // ring buffer, size is power of 2
+        std::atomic <size_t> eventsWritten{}; // written only by owning thread
+        std::atomic <size_t> eventsRead{}; // written only by profilerLap
+        std::atomic <size_t> eventsDropped{};
+    };
+
+    static ThreadState &getCurrentThreadState();
+
+    // copied under m_trackersMutex, so the caller can log or assert without holding it
+    static std::vector <std::string> getTrackerFunctions();
+    static void registerCurrentThread();
+    static void collectFrameEvents();
+    static void writeChromeTraceFrame();
+    static void writeChromeTraceEvent(const std::string &name, qint64 startNsecs, qint64 durationNsecs, int threadIndex);
+
+    static constexpr size_t k_mainThreadEventsCapacity{1 << 20};
+    static constexpr size_t k_otherThreadEventsCapacity{1 << 16};
     static constexpr qint64 k_minNsecsToShowInHistory{1000000};
+    static constexpr qint64 k_minNsecsToRecordInChromeTrace{10000}; // so the file doesn't grow by tens of MB per frame
 
     static QElapsedTimer m_elapsedTimer;
-    static int m_activeTrackers[k_maxActiveTrackers];
-    static size_t m_activeTrackersIndex;
+
+    static std::mutex m_trackersMutex; // guards allTrackers and allClasses
+    static std::vector <TrackerInfo> allTrackers;
+    static std::deque <ClassInfo> allClasses; // deque, because returned references must stay valid
+
+    static std::mutex m_threadStatesMutex;
+    static std::vector <std::unique_ptr <ThreadState>> m_threadStates; // states of finished threads are kept too
+    static thread_local ThreadState *m_currentThreadState;
 
 #ifdef TRACE_PROFILE
-    static int m_currentTrackersDepth;
-    static size_t m_trackersFrameHistoryCurrentIndex;
-    static int m_trackersFrameHistoryTrackerID[k_maxTrackersPerFrame];
-    static int m_trackersFrameHistoryDepth[k_maxTrackersPerFrame];
-    static qint64 m_trackersFrameHistoryNsecsElapsed[k_maxTrackersPerFrame];
+    // events of the last finished frame, from all threads
+    static std::vector <FrameEvent> m_frameEvents;
+    static size_t m_frameEventsDropped;
+    static qint64 m_frameStartNsecs;
+    static std::ofstream m_chromeTraceFile;
+    static int m_chromeTraceFramesLeft;
+    static bool m_chromeTraceAnyEventWritten;
 #endif
 };
 
@@ -111,17 +178,15 @@ public:
     ~Tracked();
 
 private:
-    void constructed();
-
-    static int m_classID;
-    static bool m_initialized;
+    static Trace::ClassInfo &getClassInfo();
 };
 
 inline Trace::Tracker::Tracker(int ID)
+    : m_threadState{&getCurrentThreadState()}
 {
-    if(likely(m_activeTrackersIndex < k_maxActiveTrackers))
-        m_activeTrackers[m_activeTrackersIndex] = ID;
-    ++m_activeTrackersIndex;
+    if(likely(m_threadState->activeTrackersIndex < k_maxActiveTrackers))
+        m_threadState->activeTrackers[m_threadState->activeTrackersIndex] = ID;
+    ++m_threadState->activeTrackersIndex;
 
 #ifdef TRACE_PROFILE
     m_trackerID = ID;
@@ -131,7 +196,7 @@ inline Trace::Tracker::Tracker(int ID)
 
 inline Trace::Tracker::~Tracker()
 {
-    --m_activeTrackersIndex;
+    --m_threadState->activeTrackersIndex;
 
 #ifdef TRACE_PROFILE
     endProfile();
@@ -141,7 +206,7 @@ inline Trace::Tracker::~Tracker()
 inline void Trace::Tracker::startProfile()
 {
 #ifdef TRACE_PROFILE
-    ++m_currentTrackersDepth;
+    ++m_threadState->currentTrackersDepth;
     m_startNsecs = getElapsedNsecs();
 #endif
 }
@@ -149,13 +214,24 @@ inline void Trace::Tracker::startProfile()
 inline void Trace::Tracker::endProfile()
 {
 #ifdef TRACE_PROFILE
-    --m_currentTrackersDepth;
-    if(likely(m_trackersFrameHistoryCurrentIndex < k_maxTrackersPerFrame)) {
-        m_trackersFrameHistoryTrackerID[m_trackersFrameHistoryCurrentIndex] = m_trackerID;
-        m_trackersFrameHistoryDepth[m_trackersFrameHistoryCurrentIndex] = m_currentTrackersDepth;
-        m_trackersFrameHistoryNsecsElapsed[m_trackersFrameHistoryCurrentIndex] = getElapsedNsecs() - m_startNsecs;
+    auto &state = *m_threadState;
+
+    --state.currentTrackersDepth;
+
+    size_t written{state.eventsWritten.load(std::memory_order_relaxed)};
+
+    if(likely(written - state.eventsRead.load(std::memory_order_acquire) < state.events.size())) {
+        auto &event = state.events[written & (state.events.size() - 1)];
+
+        event.trackerID = m_trackerID;
+        event.depth = state.currentTrackersDepth;
+        event.startNsecs = m_startNsecs;
+        event.nsecsElapsed = getElapsedNsecs() - m_startNsecs;
+
+        state.eventsWritten.store(written + 1, std::memory_order_release);
     }
-    ++m_trackersFrameHistoryCurrentIndex;
+    else
+        state.eventsDropped.fetch_add(1, std::memory_order_relaxed);
 #endif
 }
 
@@ -164,52 +240,40 @@ inline qint64 Trace::getElapsedNsecs()
     return m_elapsedTimer.nsecsElapsed();
 }
 
+inline Trace::ThreadState &Trace::getCurrentThreadState()
+{
+    if(unlikely(!m_currentThreadState))
+        registerCurrentThread();
+
+    return *m_currentThreadState;
+}
+
 template <typename T> Tracked <T>::Tracked()
 {
-    constructed();
+    getClassInfo().livingObjectsCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 template <typename T> Tracked <T>::Tracked(const Tracked &)
 {
-    constructed();
+    getClassInfo().livingObjectsCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 template <typename T> Tracked <T>::Tracked(Tracked &&)
 {
-    constructed();
+    getClassInfo().livingObjectsCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 template <typename T> Tracked <T>::~Tracked()
 {
-    --Trace::allClasses[m_classID].livingObjectsCount;
+    getClassInfo().livingObjectsCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
-template <typename T> inline void Tracked <T>::constructed()
+template <typename T> Trace::ClassInfo &Tracked <T>::getClassInfo()
 {
-    if(unlikely(!m_initialized)) {
-        m_initialized = true;
-        m_classID = -1;
-
-        const std::string &typeName{typeid(T).name()};
-
-        for(size_t i = 0; i < Trace::allClasses.size(); ++i) {
-            if(Trace::allClasses[i].name == typeName)
-                m_classID = i;
-        }
-
-        if(m_classID < 0) {
-            Trace::allClasses.resize(Trace::allClasses.size() + 1);
-            Trace::allClasses.back().name = typeName;
-            m_classID = Trace::allClasses.size() - 1;
-        }
-    }
-
-    ++Trace::allClasses[m_classID].livingObjectsCount;
+    static auto &classInfo = Trace::registerClass(typeid(T).name());
+    return classInfo;
 }
 
-template <typename T> int Tracked <T>::m_classID{-1};
-template <typename T> bool Tracked <T>::m_initialized{};
-
 } // namespace engine
 
 #endif // ENGINE_TRACE_HPP
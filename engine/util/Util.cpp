@@ -4,6 +4,8 @@
 
 #include <irrlicht.h>
 
+#include <fstream>
+
 namespace engine
 {
 
@@ -51,4 +53,30 @@ FloatVec3 Util::getRandomPointOnSpherePart(const FloatVec3 &point, float maxAngl
     return {result.X, result.Y, result.Z};
 }
 
+std::uint64_t Util::getHash(const void *data, size_t size, std::uint64_t hash)
+{
+    const auto *bytes = static_cast <const unsigned char*> (data);
+
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::uint64_t Util::getFileHash(const std::string &path, std::uint64_t hash)
+{
+    std::ifstream in{path, std::ios::binary};
+    char buffer[4096];
+
+    while(in.read(buffer, sizeof(buffer)) || in.gcount()) {
+        hash = getHash(buffer, in.gcount(), hash);
+    }
+
+    return hash;
+}
+
+const std::uint64_t Util::k_initialHash{14695981039346656037ull};
+
 } // namespace engine
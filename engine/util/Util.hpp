@@ -3,6 +3,9 @@
 
 #include "Vec3.hpp"
 
+#include <cstdint>
+#include <string>
+
 namespace engine
 {
 
@@ -10,6 +13,12 @@ class Util
 {
 public:
     static FloatVec3 getRandomPointOnSpherePart(const FloatVec3 &point, float maxAngle);
+
+    // FNV-1a, previous result can be passed as 'hash' to hash multiple chunks together
+    static std::uint64_t getHash(const void *data, size_t size, std::uint64_t hash = k_initialHash);
+    static std::uint64_t getFileHash(const std::string &path, std::uint64_t hash = k_initialHash);
+
+    static const std::uint64_t k_initialHash;
 };
 
 } // namespace engine